@@ -263,7 +263,8 @@ CREATE TABLE collection_tag (
 
 -- Image belonging to a collection
 CREATE TABLE collection_image ( 
-    -- Orders the images in a collection
+    -- Orders the images in a collection. Values are spaced with gaps (DATABASE_SHOW_ORDER_GAP) so
+    -- that images can be inserted between others without renumbering the whole collection
     show_order INTEGER DEFAULT 1,
     image NOT NULL REFERENCES pictures(id) ON DELETE CASCADE,
     collection NOT NULL REFERENCES collections(id) ON DELETE CASCADE,
@@ -272,6 +273,9 @@ CREATE TABLE collection_image (
     -- Doesn't need deleted column as this can be saved in text form for undo
 );
 
+-- Lets the images of a collection be read in show order without scanning the whole table
+CREATE INDEX collection_image_order ON collection_image(collection, show_order, image);
+
 -- Virtual folders table. These contain collections and other folders. Base structure for browsing
 -- folders can be added to multiple folders so there is no simple parent folder other than that all folders
 -- must eventually be children of the Root folder
@@ -0,0 +1,4 @@
+-- Migration from database version 26 to 27 --
+
+-- Lets the images of a collection be read in show order without scanning all of collection_image
+CREATE INDEX IF NOT EXISTS collection_image_order ON collection_image(collection, show_order, image);
@@ -0,0 +1,5 @@
+-- Migration from database version 27 to 28 --
+
+-- Collection images are now numbered with gaps between them so that images can be inserted and
+-- moved without changing the show_order of the other images. Multiplying keeps the existing order
+UPDATE collection_image SET show_order = show_order * 1024;
@@ -0,0 +1,13 @@
+-- Migration from signatures database version 1 to 2 --
+
+-- Signature words are now stored as integers instead of formatted strings. The words are
+-- recreated from the signatures after this
+DROP TABLE picture_signature_words;
+
+CREATE TABLE picture_signature_words (
+    picture_id INTEGER NOT NULL,
+    sig_word INTEGER NOT NULL,
+    FOREIGN KEY (picture_id) REFERENCES pictures(id) ON DELETE CASCADE
+);
+
+CREATE INDEX IF NOT EXISTS position_sig ON picture_signature_words(picture_id, sig_word);
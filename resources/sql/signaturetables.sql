@@ -12,9 +12,10 @@ CREATE TABLE pictures (
 );    
 
 -- Duplicate image checking support
+-- sig_word has the word position in the upper 32 bits and the packed signature values in the lower bits
 CREATE TABLE picture_signature_words (
     picture_id INTEGER NOT NULL,
-    sig_word TEXT NOT NULL,
+    sig_word INTEGER NOT NULL,
     FOREIGN KEY (picture_id) REFERENCES pictures(id) ON DELETE CASCADE
 );
 
@@ -0,0 +1,185 @@
+// ------------------------------------ //
+#include "AnimationFrameBuffer.h"
+
+#include "Common.h"
+#include "DualView.h"
+
+#include <glib.h>
+#include <Magick++.h>
+
+using namespace DV;
+// ------------------------------------ //
+namespace
+{
+size_t CalculateCapacity(const std::vector<Magick::Image>& frames, size_t memoryBudget)
+{
+    size_t largest = 1;
+
+    for (const auto& frame : frames)
+        largest = std::max<size_t>(largest, frame.columns() * frame.rows() * 4);
+
+    // At least the shown and the next frame are always kept
+    return std::max<size_t>(memoryBudget / largest, 2);
+}
+} // namespace
+
+// ------------------------------------ //
+AnimationFrameBuffer::AnimationFrameBuffer(
+    std::shared_ptr<std::vector<Magick::Image>> frames, size_t memoryBudget, size_t startFrame) :
+    Frames(std::move(frames)),
+    Ring(Frames->size(), CalculateCapacity(*Frames, memoryBudget))
+{
+    // The start frame is already shown so converting it would be wasted
+    Ring.Take(startFrame + 1);
+}
+
+// ------------------------------------ //
+AnimationFrameBuffer::FramePtr AnimationFrameBuffer::GetFrame(size_t frame)
+{
+    std::unique_lock<std::mutex> lock(Mutex);
+
+    auto result = Ring.Take(frame);
+
+    if (result)
+    {
+        ++Shown;
+    }
+    else if (LastMissedFrame != frame)
+    {
+        LastMissedFrame = frame;
+        ++Dropped;
+    }
+
+    return result;
+}
+
+void AnimationFrameBuffer::RequestConversion()
+{
+    {
+        std::unique_lock<std::mutex> lock(Mutex);
+
+        size_t next;
+
+        if (ConversionQueued || Stopped || !Ring.GetNextToConvert(next))
+            return;
+
+        ConversionQueued = true;
+    }
+
+    // Conversion of the next frame should happen before thumbnails and other background work
+    DualView::Get().QueueWorkerFunction(
+        std::bind(&AnimationFrameBuffer::_ConvertAhead, shared_from_this()), EXECUTOR_PRIORITY_IMMEDIATE);
+}
+
+void AnimationFrameBuffer::Stop()
+{
+    Stopped = true;
+}
+
+AnimationFrameBuffer::Stats AnimationFrameBuffer::GetStats() const
+{
+    std::unique_lock<std::mutex> lock(Mutex);
+
+    Stats stats;
+    stats.Capacity = Ring.GetCapacity();
+    stats.Buffered = Ring.GetBufferedCount();
+    stats.Converted = Converted;
+    stats.Shown = Shown;
+    stats.Dropped = Dropped;
+    return stats;
+}
+
+// ------------------------------------ //
+void AnimationFrameBuffer::_ConvertAhead()
+{
+    while (!Stopped)
+    {
+        size_t frame;
+
+        {
+            std::unique_lock<std::mutex> lock(Mutex);
+
+            if (!Ring.GetNextToConvert(frame))
+            {
+                ConversionQueued = false;
+                return;
+            }
+        }
+
+        // The playhead can move while this is converting, in which case Store ignores the frame
+        // if it was passed
+        auto converted = ConvertFrame(Frames->at(frame));
+
+        std::unique_lock<std::mutex> lock(Mutex);
+
+        Ring.Store(frame, std::move(converted));
+        ++Converted;
+    }
+
+    std::unique_lock<std::mutex> lock(Mutex);
+    ConversionQueued = false;
+}
+
+// ------------------------------------ //
+AnimationFrameBuffer::FramePtr AnimationFrameBuffer::ConvertFrame(Magick::Image& image)
+{
+    const int width = static_cast<int>(image.columns());
+    const int height = static_cast<int>(image.rows());
+
+    auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+
+    surface->flush();
+
+    unsigned char* data = surface->get_data();
+    const int stride = surface->get_stride();
+
+    // FORMAT_ARGB32 is stored as native endian 32-bit values
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    const char* const map = "BGRA";
+#else
+    const char* const map = "ARGB";
+#endif
+
+    if (stride == width * 4)
+    {
+        image.write(0, 0, width, height, map, Magick::CharPixel, data);
+    }
+    else
+    {
+        for (int y = 0; y < height; ++y)
+            image.write(0, y, width, 1, map, Magick::CharPixel, data + y * stride);
+    }
+
+    // Cairo expects premultiplied alpha
+    if (image.alpha())
+    {
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+        constexpr int alphaOffset = 3;
+#else
+        constexpr int alphaOffset = 0;
+#endif
+
+        for (int y = 0; y < height; ++y)
+        {
+            unsigned char* row = data + y * stride;
+
+            for (int x = 0; x < width; ++x)
+            {
+                unsigned char* pixel = row + x * 4;
+                const unsigned alpha = pixel[alphaOffset];
+
+                if (alpha == 255)
+                    continue;
+
+                for (int channel = 0; channel < 4; ++channel)
+                {
+                    if (channel != alphaOffset)
+                        pixel[channel] = static_cast<unsigned char>((pixel[channel] * alpha + 127) / 255);
+                }
+            }
+        }
+    }
+
+    surface->mark_dirty();
+    return surface;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "FrameRing.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <cairomm/surface.h>
+
+namespace Magick
+{
+class Image;
+}
+
+namespace DV
+{
+//! \brief Converts the frames of an animated image to Cairo surfaces on a worker thread ahead
+//! of the shown frame
+//!
+//! The number of converted frames kept is limited by a memory budget. SuperViewer takes the
+//! frames when they are due and draws them without converting anything on the main thread.
+class AnimationFrameBuffer : public std::enable_shared_from_this<AnimationFrameBuffer>
+{
+public:
+    using FramePtr = Cairo::RefPtr<Cairo::ImageSurface>;
+
+    struct Stats
+    {
+        //! The number of frames that fit in the memory budget
+        size_t Capacity = 0;
+
+        //! Converted frames currently in the buffer
+        size_t Buffered = 0;
+
+        uint64_t Converted = 0;
+
+        //! Frames that were taken from the buffer
+        uint64_t Shown = 0;
+
+        //! Frames that weren't converted when they were due, so the animation was held back
+        uint64_t Dropped = 0;
+    };
+
+public:
+    //! \param frames The decoded frames, these are kept alive by this
+    //! \param memoryBudget Maximum size of the converted frames in bytes
+    //! \param startFrame The currently shown frame, conversion starts from the frame after it
+    AnimationFrameBuffer(
+        std::shared_ptr<std::vector<Magick::Image>> frames, size_t memoryBudget, size_t startFrame);
+
+    //! \brief Returns a converted frame and moves the conversion to continue from it
+    //! \returns Null if the frame isn't converted yet. The conversion is restarted from the frame
+    //! if it wasn't going to be converted soon
+    FramePtr GetFrame(size_t frame);
+
+    //! \brief Starts converting frames on a worker thread if not already running
+    void RequestConversion();
+
+    //! \brief Stops the conversion, called when the image is no longer shown
+    void Stop();
+
+    Stats GetStats() const;
+
+    //! \brief Converts an image to a Cairo surface with premultiplied alpha
+    static FramePtr ConvertFrame(Magick::Image& image);
+
+private:
+    //! \brief Converts frames until the ring is full, ran on a worker thread
+    void _ConvertAhead();
+
+private:
+    const std::shared_ptr<std::vector<Magick::Image>> Frames;
+
+    mutable std::mutex Mutex;
+
+    FrameRing<FramePtr> Ring;
+
+    //! True while a worker is converting frames
+    bool ConversionQueued = false;
+
+    //! Used to count each late frame only once
+    size_t LastMissedFrame = -1;
+
+    uint64_t Converted = 0;
+    uint64_t Shown = 0;
+    uint64_t Dropped = 0;
+
+    std::atomic<bool> Stopped{false};
+};
+
+} // namespace DV
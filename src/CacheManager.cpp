@@ -2,6 +2,7 @@
 #include "CacheManager.h"
 
 #include <boost/filesystem.hpp>
+#include <cstring>
 #include <gtkmm.h>
 #include <Magick++.h>
 
@@ -11,20 +12,41 @@
 #include "Common/StringOperations.h"
 
 #include "Exceptions.h"
+#include "ImageProbe.h"
 #include "Settings.h"
+#include "ThumbnailPack.h"
 
 using namespace DV;
 
 // ------------------------------------ //
-CacheManager::CacheManager()
+CacheManager::CacheManager(
+    size_t imageCacheBudget /*= DUALVIEW_SETTINGS_DEFAULT_IMAGE_CACHE_MEGABYTES * 1024 * 1024*/,
+    int fullLoaderThreads /*= 0*/, int thumbnailThreads /*= 0*/) :
+    ImageCache(imageCacheBudget, DUALVIEW_SETTINGS_MAX_CACHED_IMAGES)
 {
     Magick::InitializeMagick(Glib::get_current_dir().c_str());
 
-    FullLoaderThread = std::thread(std::bind<void>(&CacheManager::_RunFullSizeLoaderThread, this));
+    // Decoding uses a lot of memory so this doesn't go all the way up to the core count
+    if (fullLoaderThreads < 1)
+        fullLoaderThreads = std::clamp(static_cast<int>(std::thread::hardware_concurrency()) / 2, 1, 4);
+
+    for (int i = 0; i < fullLoaderThreads; ++i)
+        FullLoaderThreads.emplace_back(std::bind<void>(&CacheManager::_RunFullSizeLoaderThread, this));
 
     CacheCleanupThread = std::thread(std::bind<void>(&CacheManager::_RunCacheCleanupThread, this));
 
-    ThumbnailGenerationThread = std::thread(std::bind<void>(&CacheManager::_RunThumbnailGenerationThread, this));
+    // Existing thumbnails are loaded by a separate thread so that they don't need to wait for the
+    // generation of new thumbnails
+    ThumbnailLoaderThread = std::thread(std::bind<void>(&CacheManager::_RunThumbnailLoaderThread, this));
+
+    if (thumbnailThreads < 1)
+        thumbnailThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    for (int i = 0; i < thumbnailThreads; ++i)
+    {
+        ThumbnailGenerationThreads.emplace_back(
+            std::bind<void>(&CacheManager::_RunThumbnailGenerationThread, this));
+    }
 }
 
 CacheManager::~CacheManager()
@@ -37,18 +59,25 @@ CacheManager::~CacheManager()
 
     NotifyFullLoaderThread.notify_all();
     NotifyCacheCleanup.notify_all();
+    NotifyThumbnailLoaderThread.notify_all();
     NotifyThumbnailGenerationThread.notify_all();
 
     // Wait for threads to quit //
-    FullLoaderThread.join();
+    for (auto& thread : FullLoaderThreads)
+        thread.join();
+
     CacheCleanupThread.join();
-    ThumbnailGenerationThread.join();
+    ThumbnailLoaderThread.join();
+
+    for (auto& thread : ThumbnailGenerationThreads)
+        thread.join();
 
     // Make sure all resources that use imagemagick are closed //
     // Clear cache //
-    ImageCache.clear();
+    ImageCache.Clear();
     LoadQueue.Clear();
     ThumbQueue.Clear();
+    ThumbGenerationQueue.Clear();
 }
 
 // ------------------------------------ //
@@ -66,8 +95,8 @@ std::shared_ptr<LoadedImage> CacheManager::LoadFullImage(const std::string& file
 
     LOG_INFO("Opening full size image: " + file);
 
-    // Add to cache //
-    ImageCache.push_back(created);
+    // Add to cache. The size is updated once loaded //
+    ImageCache.Insert(created, file);
 
     // Add it to load queue //
     {
@@ -101,7 +130,7 @@ std::shared_ptr<LoadedImage> CacheManager::LoadThumbImage(const std::string& fil
     }
 
     // Notify loader thread //
-    NotifyThumbnailGenerationThread.notify_all();
+    NotifyThumbnailLoaderThread.notify_all();
 
     return created;
 }
@@ -117,25 +146,30 @@ std::shared_ptr<LoadedImage> CacheManager::CreateImageLoadFailure(const std::str
 std::shared_ptr<LoadedImage> CacheManager::GetCachedImage(
     const std::lock_guard<std::mutex>& lock, const std::string& file)
 {
-    for (const auto& cachedImage : ImageCache)
-    {
-        if (cachedImage->PathMatches(file))
-            return cachedImage;
-    }
-
-    return nullptr;
+    return ImageCache.Get(file);
 }
 
 // ------------------------------------ //
+void CacheManager::UpdateImageSize(const LoadedImage& image)
+{
+    const auto decodedSize = image.GetDecodedSize();
+
+    std::lock_guard<std::mutex> lock(ImageCacheLock);
+    ImageCache.UpdateSize(image, decodedSize);
+}
+
 void CacheManager::NotifyMovedFile(const std::string& oldfile, const std::string& newfile)
 {
     std::lock_guard<std::mutex> lock(ImageCacheLock);
 
-    for (const auto& cachedImage : ImageCache)
-    {
-        if (cachedImage->PathMatches(oldfile))
-            cachedImage->OnMoved(newfile);
-    }
+    ImageCache.OnMoved(oldfile, newfile);
+}
+
+void CacheManager::SetImageCacheBudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(ImageCacheLock);
+
+    ImageCache.SetMemoryBudget(bytes);
 }
 
 // ------------------------------------ //
@@ -213,9 +247,32 @@ void CacheManager::_RunFullSizeLoaderThread()
             // Unlock while loading the image file
             guard.unlock();
 
+            // Skip images the user has already moved past. The image is removed from the cache
+            // at the same time so that it can't be handed out without being loaded
+            bool cancelled;
+
+            {
+                std::lock_guard<std::mutex> lock(ImageCacheLock);
+                cancelled = ImageCache.RemoveIfUnused(current->Task, 1);
+            }
+
+            if (cancelled)
+            {
+                // This also breaks the reference cycle between the image and the task
+                current->Task->OnLoadFail("Load cancelled");
+                current->OnDone();
+                ++CancelledFullLoads;
+
+                guard.lock();
+                continue;
+            }
+
             current->Task->DoLoad();
             current->OnDone();
 
+            // Now the real size is known which may push the cache over budget
+            UpdateImageSize(*current->Task);
+
             guard.lock();
         }
     }
@@ -244,89 +301,137 @@ void CacheManager::_RunCacheCleanupThread()
                     previous, time, std::memory_order_acquire, std::memory_order_consume);
             }
 
-            for (auto iter = ImageCache.begin(); iter != ImageCache.end();)
+            // Eviction by size is handled on insert so this just drops images that aren't used
+            ImageCache.RemoveExpired(time, std::chrono::milliseconds(DUALVIEW_SETTINGS_UNLOAD_TIME_MS),
+                useUnloadAnyway ? std::chrono::milliseconds(unloadAnywayTime) : std::chrono::milliseconds(0));
+
+            if (SHOW_IMAGE_CACHE_SIZE)
             {
-                const auto age = (time - (*iter)->GetLastUsed());
+                Logger::Get()->Info("Current image cache size is: " + std::to_string(ImageCache.GetCount()) +
+                    " images, " + std::to_string(ImageCache.GetTotalBytes() / (1024 * 1024)) +
+                    " MiB, cancelled loads: " + std::to_string(CancelledFullLoads));
 
-                // Expire //
-                if ((*iter).use_count() == 1 && age > std::chrono::milliseconds(DUALVIEW_SETTINGS_UNLOAD_TIME_MS))
-                {
-                    // Unload it //
-                    iter = ImageCache.erase(iter);
-                }
-                else if (useUnloadAnyway && age > unloadAnywayTime)
-                {
-                    iter = ImageCache.erase(iter);
-                    // Only one per cycle
-                    useUnloadAnyway = false;
-                }
-                else
+                for (const auto& timing : GetThumbnailStageTimings())
                 {
-                    ++iter;
+                    if (timing.Count < 1)
+                        continue;
+
+                    Logger::Get()->Info("Thumbnail " + std::string(GetThumbnailStageName(timing.Stage)) + ": " +
+                        std::to_string(timing.Count) + " times, average " +
+                        std::to_string(timing.Total.count() / timing.Count) + " us");
                 }
             }
+        }
+    }
+}
 
-            // Force unload if too many
-            int unloadsRemaining = 40;
-
-            while (ImageCache.size() > DUALVIEW_SETTINGS_MAX_CACHED_IMAGES && unloadsRemaining > 0)
-            {
-                // TODO: not the optimal algorithm but oh well, this is run in the background
-                auto oldest = ImageCache.begin();
-                auto oldestAge = time - (*oldest)->GetLastUsed();
+void CacheManager::_RunThumbnailLoaderThread()
+{
+    GUARD_LOCK_OTHER(ThumbQueue);
 
-                for (auto iter = ImageCache.begin() + 1; iter != ImageCache.end(); ++iter)
-                {
-                    const auto age = (time - (*iter)->GetLastUsed());
+    while (!Quitting)
+    {
+        // Wait for more work //
+        if (ThumbQueue.Empty(guard))
+            NotifyThumbnailLoaderThread.wait(guard);
 
-                    if (age > oldestAge)
-                    {
-                        oldest = iter;
-                        oldestAge = age;
-                    }
-                }
+        // Process whole queue //
+        while (auto current = ThumbQueue.Pop(guard))
+        {
+            // Unlock while loading the image file
+            guard.unlock();
 
-                ImageCache.erase(oldest);
-                --unloadsRemaining;
+            if (_LoadExistingThumbnail(*std::get<0>(current->Task), std::get<1>(current->Task)))
+            {
+                current->OnDone();
             }
-
-            if (SHOW_IMAGE_CACHE_SIZE)
+            else
             {
-                Logger::Get()->Info("Current image cache size is: " + std::to_string(ImageCache.size()));
+                // Needs to be generated. The same task is moved so that bumping the priority
+                // still works
+                GUARD_LOCK_OTHER_NAME(ThumbGenerationQueue, lock2);
+                ThumbGenerationQueue.Push(lock2, current);
+                NotifyThumbnailGenerationThread.notify_one();
             }
+
+            guard.lock();
         }
     }
 }
 
 void CacheManager::_RunThumbnailGenerationThread()
 {
-    GUARD_LOCK_OTHER(ThumbQueue);
+    GUARD_LOCK_OTHER(ThumbGenerationQueue);
 
     while (!Quitting)
     {
         // Wait for more work //
-        if (ThumbQueue.Empty(guard))
+        if (ThumbGenerationQueue.Empty(guard))
             NotifyThumbnailGenerationThread.wait(guard);
 
         // Process whole queue //
-        while (auto current = ThumbQueue.Pop(guard))
+        while (auto current = ThumbGenerationQueue.Pop(guard))
         {
+            auto& thumb = *std::get<0>(current->Task);
+            const auto& hash = std::get<1>(current->Task);
+
+            std::string extension;
+            const auto name = _GetThumbnailPath(thumb, hash, extension).filename().string();
+
+            // Another thread is already creating the same file or pack entry, this gets a copy of
+            // its result once it is done
+            if (const auto inProgress = ThumbnailsInProgress.find(name); inProgress != ThumbnailsInProgress.end())
+            {
+                inProgress->second.push_back(current);
+                continue;
+            }
+
+            ThumbnailsInProgress[name];
+
             // Unlock while loading the image file
             guard.unlock();
 
-            _LoadThumbnail(*std::get<0>(current->Task), std::get<1>(current->Task));
+            // The same thumbnail may have been queued again after the loader thread checked for
+            // it but before an earlier generation finished writing it
+            if (!_LoadExistingThumbnail(thumb, hash))
+                _GenerateThumbnail(thumb, hash);
+
             current->OnDone();
 
             guard.lock();
+
+            const auto waiting = std::move(ThumbnailsInProgress[name]);
+            ThumbnailsInProgress.erase(name);
+
+            guard.unlock();
+
+            for (const auto& duplicate : waiting)
+            {
+                auto& other = *std::get<0>(duplicate->Task);
+
+                if (thumb.IsValid())
+                {
+                    other.OnLoadSuccess(thumb.MagickImage);
+                }
+                else
+                {
+                    other.OnLoadFail(thumb.GetError());
+                }
+
+                duplicate->OnDone();
+            }
+
+            guard.lock();
         }
     }
 }
 
 // ------------------------------------ //
-void CacheManager::_LoadThumbnail(LoadedImage& thumb, const std::string& hash) const
+boost::filesystem::path CacheManager::_GetThumbnailPath(
+    const LoadedImage& thumb, const std::string& hash, std::string& extension) const
 {
     // Get the thumbnail folder //
-    auto extension = boost::filesystem::path(thumb.FromPath).extension().string();
+    extension = boost::filesystem::path(thumb.FromPath).extension().string();
 
     if (extension.empty())
     {
@@ -344,26 +449,94 @@ void CacheManager::_LoadThumbnail(LoadedImage& thumb, const std::string& hash) c
         extension = ".jpg";
     }
 
-    const auto target =
-        boost::filesystem::path(DualView::Get().GetThumbnailFolder()) / boost::filesystem::path(hash + extension);
+    return boost::filesystem::path(DualView::Get().GetThumbnailFolder()) / boost::filesystem::path(hash + extension);
+}
+
+bool CacheManager::_LoadExistingThumbnail(LoadedImage& thumb, const std::string& hash)
+{
+    std::string extension;
+    const auto target = _GetThumbnailPath(thumb, hash, extension);
+
+    if (const auto pack = GetThumbnailPack(); pack)
+    {
+        if (_LoadPackedThumbnail(*pack, thumb, target.filename().string()))
+            return true;
+
+        // Not packed yet, check for a separate file
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    const bool exists = boost::filesystem::exists(target);
+
+    _AddThumbnailStageTime(THUMBNAIL_STAGE::ExistenceCheck, start);
 
     // Use already created thumbnail if one exists //
-    if (boost::filesystem::exists(target))
+    if (!exists)
+        return false;
+
+    start = std::chrono::high_resolution_clock::now();
+
+    // Load the existing thumbnail //
+    // DoLoad replaces the path with an error message on failure, so it is restored for
+    // generating the thumbnail again
+    const auto originalPath = thumb.FromPath;
+    thumb.DoLoad(target.string());
+
+    _AddThumbnailStageTime(THUMBNAIL_STAGE::LoadExisting, start);
+
+    if (!thumb.IsValid())
     {
-        // Load the existing thumbnail //
-        thumb.DoLoad(target.string());
+        LOG_WARNING("Deleting invalid thumbnail: " + std::string(target.c_str()));
+        boost::filesystem::remove(target);
 
-        if (!thumb.IsValid())
-        {
-            LOG_WARNING("Deleting invalid thumbnail: " + std::string(target.c_str()));
-            boost::filesystem::remove(target);
+        thumb.FromPath = originalPath;
+        thumb.Status = LoadedImage::IMAGE_LOAD_STATUS::Waiting;
+        return false;
+    }
 
-            // TODO: avoid infinite recursion
-            _LoadThumbnail(thumb, hash);
-        }
+    return true;
+}
 
-        return;
+bool CacheManager::_LoadPackedThumbnail(ThumbnailPack& pack, LoadedImage& thumb, const std::string& name)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::string data;
+    const bool found = pack.Read(name, data);
+
+    _AddThumbnailStageTime(THUMBNAIL_STAGE::ExistenceCheck, start);
+
+    if (!found)
+        return false;
+
+    start = std::chrono::high_resolution_clock::now();
+
+    std::shared_ptr<std::vector<Magick::Image>> image;
+
+    try
+    {
+        LoadedImage::LoadImageFromMemory(data, image);
     }
+    catch (const Leviathan::InvalidArgument& e)
+    {
+        LOG_WARNING("Removing invalid thumbnail from pack: " + name + ", error: " + e.what());
+        pack.Remove(name);
+        return false;
+    }
+
+    thumb.OnLoadSuccess(image);
+
+    _AddThumbnailStageTime(THUMBNAIL_STAGE::LoadExisting, start);
+    return true;
+}
+
+void CacheManager::_GenerateThumbnail(LoadedImage& thumb, const std::string& hash)
+{
+    std::string extension;
+    const auto target = _GetThumbnailPath(thumb, hash, extension);
+
+    auto start = std::chrono::high_resolution_clock::now();
 
     // Load the full file //
     std::shared_ptr<std::vector<Magick::Image>> FullImage;
@@ -383,6 +556,9 @@ void CacheManager::_LoadThumbnail(LoadedImage& thumb, const std::string& hash) c
         return;
     }
 
+    _AddThumbnailStageTime(THUMBNAIL_STAGE::DecodeFull, start);
+    start = std::chrono::high_resolution_clock::now();
+
     // Dispose of the actual image and store the thumbnail in memory //
     std::string resizeSize{"?"};
 
@@ -438,7 +614,7 @@ void CacheManager::_LoadThumbnail(LoadedImage& thumb, const std::string& hash) c
         if (extension == ".jpg")
         {
             LOG_WARNING(
-                "CacheManager: _LoadThumbnail: accidentally made animated image save as jpg: " + thumb.FromPath);
+                "CacheManager: _GenerateThumbnail: accidentally made animated image save as jpg: " + thumb.FromPath);
         }
 
         // This will remove the optimization and change the image to how it looks at that point
@@ -501,19 +677,53 @@ void CacheManager::_LoadThumbnail(LoadedImage& thumb, const std::string& hash) c
         thumb.OnLoadSuccess(FullImage);
     }
 
-    // Save it to a file //
-    Magick::writeImages(FullImage->begin(), FullImage->end(), target.c_str());
+    _AddThumbnailStageTime(THUMBNAIL_STAGE::Resize, start);
+    start = std::chrono::high_resolution_clock::now();
 
     double size;
 
-    try
+    if (const auto pack = GetThumbnailPack(); pack)
     {
-        size = static_cast<double>(boost::filesystem::file_size(target));
+        // The format is normally picked from the file extension, so that is set on copies of the
+        // frames as the frames are already shared with thumb
+        std::vector<Magick::Image> frames(FullImage->begin(), FullImage->end());
+
+        for (auto& frame : frames)
+            frame.magick(extension.substr(1));
+
+        Magick::Blob blob;
+
+        try
+        {
+            Magick::writeImages(frames.begin(), frames.end(), &blob);
+            pack->Add(target.filename().string(), blob.data(), blob.length());
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR("Failed to store generated thumbnail in pack: " + std::string(e.what()));
+            return;
+        }
+
+        _AddThumbnailStageTime(THUMBNAIL_STAGE::Write, start);
+
+        size = static_cast<double>(blob.length());
     }
-    catch (const boost::filesystem::filesystem_error& e)
+    else
     {
-        LOG_ERROR("Failed to get generated thumbnail size: " + std::string(e.what()));
-        return;
+        // Save it to a file //
+        Magick::writeImages(FullImage->begin(), FullImage->end(), target.c_str());
+
+        _AddThumbnailStageTime(THUMBNAIL_STAGE::Write, start);
+
+        try
+        {
+            size = static_cast<double>(boost::filesystem::file_size(target));
+        }
+        catch (const boost::filesystem::filesystem_error& e)
+        {
+            LOG_ERROR("Failed to get generated thumbnail size: " + std::string(e.what()));
+            return;
+        }
     }
 
     const auto sizeStr = std::to_string(static_cast<uint64_t>(std::round(size / 1024.0)));
@@ -522,6 +732,65 @@ void CacheManager::_LoadThumbnail(LoadedImage& thumb, const std::string& hash) c
         "Generated thumbnail for: " + thumb.GetPath() + " resolution: " + resizeSize + " size: " + sizeStr + " KiB");
 }
 
+void CacheManager::EnableThumbnailPack(const std::string& folder)
+{
+    auto pack = std::make_shared<ThumbnailPack>(folder);
+
+    LOG_INFO("Using thumbnail pack with " + std::to_string(pack->GetCount()) + " thumbnails in " +
+        std::to_string(pack->GetSegmentCount()) + " segments");
+
+    std::lock_guard<std::mutex> lock(ThumbnailStoreMutex);
+    ThumbnailStore = std::move(pack);
+}
+
+std::shared_ptr<ThumbnailPack> CacheManager::GetThumbnailPack() const
+{
+    std::lock_guard<std::mutex> lock(ThumbnailStoreMutex);
+    return ThumbnailStore;
+}
+
+void CacheManager::_AddThumbnailStageTime(
+    THUMBNAIL_STAGE stage, std::chrono::high_resolution_clock::time_point start)
+{
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - start);
+
+    const auto index = static_cast<size_t>(stage);
+
+    ThumbnailStageCounts[index].fetch_add(1, std::memory_order_relaxed);
+    ThumbnailStageMicroseconds[index].fetch_add(elapsed.count(), std::memory_order_relaxed);
+}
+
+std::vector<ThumbnailStageTiming> CacheManager::GetThumbnailStageTimings() const
+{
+    std::vector<ThumbnailStageTiming> result;
+    result.reserve(static_cast<size_t>(THUMBNAIL_STAGE::Count));
+
+    for (size_t i = 0; i < static_cast<size_t>(THUMBNAIL_STAGE::Count); ++i)
+    {
+        result.push_back(ThumbnailStageTiming{static_cast<THUMBNAIL_STAGE>(i),
+            ThumbnailStageCounts[i].load(std::memory_order_relaxed),
+            std::chrono::microseconds(ThumbnailStageMicroseconds[i].load(std::memory_order_relaxed))});
+    }
+
+    return result;
+}
+
+const char* CacheManager::GetThumbnailStageName(THUMBNAIL_STAGE stage)
+{
+    switch (stage)
+    {
+        case THUMBNAIL_STAGE::ExistenceCheck: return "existence check";
+        case THUMBNAIL_STAGE::LoadExisting: return "load existing";
+        case THUMBNAIL_STAGE::DecodeFull: return "decode full image";
+        case THUMBNAIL_STAGE::Resize: return "resize";
+        case THUMBNAIL_STAGE::Write: return "write";
+        case THUMBNAIL_STAGE::Count: break;
+    }
+
+    return "unknown";
+}
+
 // ------------------------------------ //
 std::string CacheManager::CreateResizeSizeForImage(
     const int currentWidth, const int currentHeight, int targetWidth, int targetHeight)
@@ -573,6 +842,19 @@ std::string CacheManager::CreateResizeSizeForImage(const Magick::Image& image, i
 
 bool CacheManager::GetImageSize(const std::string& image, int& width, int& height, std::string& extension)
 {
+    ImageHeaderInfo info;
+
+    if (ProbeImageFile(image, info))
+    {
+        if (boost::filesystem::path(image).extension().empty())
+            extension = info.Format;
+
+        width = info.Width;
+        height = info.Height;
+        return true;
+    }
+
+    // Other formats need to be opened with Magick
     try
     {
         Magick::Image img(image);
@@ -599,6 +881,15 @@ bool CacheManager::GetImageSize(const std::string& image, int& width, int& heigh
 
 bool CacheManager::CheckIsBytesAnImage(const std::string& imagedata)
 {
+    ImageHeaderInfo info;
+
+    // Incomplete data is checked by Magick as it might still be possible to open it
+    if (ProbeImageHeader(imagedata.data(), imagedata.size(), info) == IMAGE_PROBE_RESULT::Success &&
+        HasImageEndMarker(imagedata.data(), imagedata.size(), imagedata.size(), info))
+    {
+        return true;
+    }
+
     try
     {
         Magick::Blob data(imagedata.c_str(), imagedata.size());
@@ -798,10 +1089,37 @@ void LoadedImage::UnloadImage()
 {
     Status = IMAGE_LOAD_STATUS::Error;
     FromPath = "Forced unload";
+
+    std::lock_guard<std::mutex> lock(PyramidMutex);
     MagickImage.reset();
+    Pyramid.clear();
+    PyramidWidth = 0;
+    PyramidRequested = false;
 }
 
 // ------------------------------------ //
+//! \brief Checks a newly read image and coalesces it if it is animated
+static void FinishImageLoad(
+    const std::shared_ptr<std::vector<Magick::Image>>& createdImage, std::shared_ptr<std::vector<Magick::Image>>& image)
+{
+    if (createdImage->empty())
+        throw Leviathan::InvalidArgument("Loaded image is empty");
+
+    // Coalesce animated images //
+    if (createdImage->size() > 1)
+    {
+        image = std::make_shared<std::vector<Magick::Image>>();
+        coalesceImages(image.get(), createdImage->begin(), createdImage->end());
+
+        if (image->empty())
+            throw Leviathan::InvalidArgument("Coalesced image is empty");
+    }
+    else
+    {
+        image = createdImage;
+    }
+}
+
 void LoadedImage::LoadImage(const std::string& file, std::shared_ptr<std::vector<Magick::Image>>& image)
 {
     if (!boost::filesystem::exists(file))
@@ -828,22 +1146,27 @@ void LoadedImage::LoadImage(const std::string& file, std::shared_ptr<std::vector
         throw Leviathan::InvalidArgument("Loaded image is invalid/unsupported (W): " + std::string(e.what()));
     }
 
-    if (createdImage->empty())
-        throw Leviathan::InvalidArgument("Loaded image is empty");
+    FinishImageLoad(createdImage, image);
+}
 
-    // Coalesce animated images //
-    if (createdImage->size() > 1)
-    {
-        image = std::make_shared<std::vector<Magick::Image>>();
-        coalesceImages(image.get(), createdImage->begin(), createdImage->end());
+void LoadedImage::LoadImageFromMemory(const std::string& data, std::shared_ptr<std::vector<Magick::Image>>& image)
+{
+    auto createdImage = std::make_shared<std::vector<Magick::Image>>();
 
-        if (image->empty())
-            throw Leviathan::InvalidArgument("Coalesced image is empty");
+    try
+    {
+        readImages(createdImage.get(), Magick::Blob(data.data(), data.size()));
     }
-    else
+    catch (const Magick::Error& e)
     {
-        image = createdImage;
+        throw Leviathan::InvalidArgument("Image data is invalid/unsupported: " + std::string(e.what()));
+    }
+    catch (const Magick::Warning& e)
+    {
+        throw Leviathan::InvalidArgument("Image data is invalid/unsupported (W): " + std::string(e.what()));
     }
+
+    FinishImageLoad(createdImage, image);
 }
 
 void LoadedImage::DoLoad()
@@ -935,6 +1258,24 @@ size_t LoadedImage::GetFrameCount() const
     return MagickImage->size();
 }
 
+size_t LoadedImage::GetDecodedSize() const
+{
+    if (!IsImageObjectLoaded())
+        return 0;
+
+    size_t size = 0;
+
+    for (const auto& frame : *MagickImage)
+        size += frame.columns() * frame.rows() * frame.channels() * sizeof(Magick::Quantum);
+
+    std::lock_guard<std::mutex> lock(PyramidMutex);
+
+    for (const auto& level : Pyramid)
+        size += level->get_byte_length();
+
+    return size;
+}
+
 std::chrono::duration<float> LoadedImage::GetAnimationTime(size_t page) const
 {
     if (!IsImageObjectLoaded())
@@ -962,14 +1303,18 @@ Glib::RefPtr<Gdk::Pixbuf> LoadedImage::CreateGtkImage(size_t page /*= 0*/) const
     if (page >= MagickImage->size())
         throw Leviathan::InvalidArgument("page is outside valid range");
 
-    Magick::Image& image = MagickImage->at(page);
+    return ConvertToPixbuf(MagickImage->at(page));
+}
 
+Glib::RefPtr<Gdk::Pixbuf> LoadedImage::ConvertToPixbuf(Magick::Image& image, bool allowWholeFrame /*= true*/)
+{
     const bool hasAlpha = image.alpha();
     const auto bitsPerSample = 8;
     const int width = image.columns();
     const int height = image.rows();
 
-    const size_t stride = (bitsPerSample / 8) * 3 * width;
+    const int channels = hasAlpha ? 4 : 3;
+    const size_t stride = (bitsPerSample / 8) * channels * width;
 
     // Create buffer //
     auto pixbuf = Gdk::Pixbuf::create(Gdk::Colorspace::COLORSPACE_RGB, hasAlpha, bitsPerSample, width, height);
@@ -990,31 +1335,133 @@ Glib::RefPtr<Gdk::Pixbuf> LoadedImage::CreateGtkImage(size_t page /*= 0*/) const
 
     // Copy data //
     unsigned char* destination = pixbuf->get_pixels();
+    const char* const map = hasAlpha ? "RGBA" : "RGB";
 
-    if (hasAlpha)
+    const auto rowstride = static_cast<size_t>(pixbuf->get_rowstride());
+
+    if (allowWholeFrame)
     {
-        for (int y = 0; y < height; ++y)
-        {
-            image.write(0, y, width, 1, "RGBA", Magick::CharPixel, destination);
+        // Exporting the whole frame with one call is a lot faster than a call per row. Gtk pads
+        // RGB rows to 4 bytes so then the rows are written packed and moved to their padded
+        // positions. Moving starts from the bottom so that no row is overwritten before it is
+        // moved
+        image.write(0, 0, width, height, map, Magick::CharPixel, destination);
 
-            // destination += stride;
-            destination += pixbuf->get_rowstride();
+        if (rowstride != stride)
+        {
+            for (int y = height - 1; y > 0; --y)
+            {
+                const auto row = static_cast<size_t>(y);
+                std::memmove(destination + row * rowstride, destination + row * stride, stride);
+            }
         }
     }
     else
     {
         for (int y = 0; y < height; ++y)
         {
-            image.write(0, y, width, 1, "RGB", Magick::CharPixel, destination);
-
-            // destination += stride;
-            destination += pixbuf->get_rowstride();
+            image.write(0, y, width, 1, map, Magick::CharPixel, destination);
+            destination += rowstride;
         }
     }
 
     return pixbuf;
 }
 
+// ------------------------------------ //
+void LoadedImage::RequestPyramid()
+{
+    if (!IsValid() || PyramidRequested.exchange(true))
+        return;
+
+    const auto image = MagickImage;
+
+    if (!WantsPyramid(*image))
+        return;
+
+    std::weak_ptr<LoadedImage> weak = weak_from_this();
+
+    DualView::Get().QueueWorkerFunction([weak, image]()
+    {
+        const auto self = weak.lock();
+
+        // The copies count towards the memory budget of the image cache
+        if (self && self->_BuildPyramid(image))
+            DualView::Get().GetCacheManager().UpdateImageSize(*self);
+    });
+}
+
+Glib::RefPtr<Gdk::Pixbuf> LoadedImage::GetPyramidLevel(float zoom) const
+{
+    std::lock_guard<std::mutex> lock(PyramidMutex);
+
+    const auto neededWidth = PyramidWidth * zoom;
+
+    Glib::RefPtr<Gdk::Pixbuf> best;
+
+    for (const auto& level : Pyramid)
+    {
+        if (level->get_width() < neededWidth)
+            break;
+
+        best = level;
+    }
+
+    return best;
+}
+
+bool LoadedImage::WantsPyramid(const std::vector<Magick::Image>& image)
+{
+    return image.size() == 1 &&
+        std::max(image.front().columns(), image.front().rows()) >= static_cast<size_t>(PYRAMID_IMAGE_THRESHOLD);
+}
+
+std::vector<Glib::RefPtr<Gdk::Pixbuf>> LoadedImage::CreatePyramidLevels(const Magick::Image& image)
+{
+    std::vector<Glib::RefPtr<Gdk::Pixbuf>> levels;
+
+    Magick::Image level = image;
+
+    while (std::max(level.columns(), level.rows()) / 2 >= static_cast<size_t>(PYRAMID_SMALLEST_LEVEL))
+    {
+        Magick::Geometry size(std::max<size_t>(level.columns() / 2, 1), std::max<size_t>(level.rows() / 2, 1));
+        size.aspect(true);
+
+        // Each level is made from the previous one, averaging when halving is both fast and good enough
+        level.scale(size);
+
+        levels.push_back(ConvertToPixbuf(level));
+    }
+
+    return levels;
+}
+
+bool LoadedImage::_BuildPyramid(const std::shared_ptr<std::vector<Magick::Image>>& image)
+{
+    std::vector<Glib::RefPtr<Gdk::Pixbuf>> levels;
+
+    try
+    {
+        levels = CreatePyramidLevels(image->front());
+    }
+    catch (const std::exception& e)
+    {
+        // FromPath isn't used here as UnloadImage can change it at the same time
+        LOG_WARNING("Failed to create downscaled copies of an image: " + std::string(e.what()));
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(PyramidMutex);
+
+    // UnloadImage was called while this was running
+    if (MagickImage != image)
+        return false;
+
+    Pyramid = std::move(levels);
+    PyramidWidth = image->front().columns();
+    return true;
+}
+
 void LoadedImage::LoadFromGtkImage(Glib::RefPtr<Gdk::Pixbuf> image)
 {
     LEVIATHAN_ASSERT(image->get_colorspace() == Gdk::COLORSPACE_RGB, "pixbuf format is different from expected");
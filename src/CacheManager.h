@@ -1,17 +1,22 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <list>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include <boost/filesystem/path.hpp>
 #include <gdkmm/pixbuf.h>
 #include <Magick++/Color.h>
 
+#include "Common.h"
 #include "Exceptions.h"
+#include "ImageCache.h"
 #include "TaskListWithPriority.h"
 
 namespace Magick
@@ -36,10 +41,41 @@ constexpr float TALL_ASPECT_RATIO_THRESHOLD = 0.49f;
 constexpr const char* THUMBNAIL_BACKGROUND_COLOUR = "#FFFFFF";
 constexpr int THUMBNAIL_JPG_QUALITY = 70;
 
+//! Single frame images with a side at least this long get downscaled copies for zoomed out drawing
+constexpr int PYRAMID_IMAGE_THRESHOLD = 3000;
+//! Downscaled copies are halved until their longer side would be smaller than this
+constexpr int PYRAMID_SMALLEST_LEVEL = 512;
+
 class CacheManager;
+class ThumbnailPack;
+
+//! \brief The parts of thumbnail loading that have their time tracked
+enum class THUMBNAIL_STAGE
+{
+    //! Checking if a thumbnail file already exists
+    ExistenceCheck = 0,
+    //! Loading an already created thumbnail
+    LoadExisting,
+    //! Loading the full image to create a thumbnail from
+    DecodeFull,
+    //! Resizing the full image down
+    Resize,
+    //! Writing the created thumbnail to disk
+    Write,
+
+    Count
+};
+
+//! \brief Cumulative timing of a single THUMBNAIL_STAGE
+struct ThumbnailStageTiming
+{
+    THUMBNAIL_STAGE Stage;
+    int64_t Count;
+    std::chrono::microseconds Total;
+};
 
 //! \brief Holds an image that has been loaded into memory
-class LoadedImage
+class LoadedImage : public std::enable_shared_from_this<LoadedImage>
 {
     friend CacheManager;
 
@@ -139,6 +175,9 @@ public:
     //! \exception Leviathan::InvalidState if no image loaded
     size_t GetFrameCount() const;
 
+    //! \brief Returns the approximate memory use of the decoded frames in bytes, 0 if not loaded
+    size_t GetDecodedSize() const;
+
     //! \brief Returns the time current frame should be shown for
     std::chrono::duration<float> GetAnimationTime(size_t page) const;
 
@@ -152,6 +191,31 @@ public:
     //! \todo Alpha support
     Glib::RefPtr<Gdk::Pixbuf> CreateGtkImage(size_t page = 0) const;
 
+    //! \brief Converts a single frame to a pixbuf
+    //!
+    //! The pixels are exported with a single call. If the pixbuf rows are padded they are then
+    //! moved in place to their padded positions
+    //! \param allowWholeFrame If false the pixels are always exported row by row. Used to check
+    //! that both ways give the same result
+    //! \exception Leviathan::Exception if the pixbuf can't be created
+    static Glib::RefPtr<Gdk::Pixbuf> ConvertToPixbuf(Magick::Image& image, bool allowWholeFrame = true);
+
+    //! \brief Starts building downscaled copies of a big image on a worker thread
+    //!
+    //! The copies are halved in size until they are small, like mipmaps. This is only done once
+    //! and only for single frame images bigger than PYRAMID_IMAGE_THRESHOLD
+    void RequestPyramid();
+
+    //! \brief Returns the smallest downscaled copy that can be drawn at zoom without losing detail
+    //! \returns Null if the full size image needs to be drawn or the copies aren't ready yet
+    Glib::RefPtr<Gdk::Pixbuf> GetPyramidLevel(float zoom) const;
+
+    //! \returns True if RequestPyramid creates downscaled copies of image
+    static bool WantsPyramid(const std::vector<Magick::Image>& image);
+
+    //! \brief Creates the downscaled copies of image from half size to the smallest
+    static std::vector<Glib::RefPtr<Gdk::Pixbuf>> CreatePyramidLevels(const Magick::Image& image);
+
     //! \brief Registers the task this waits on
     void RegisterLoadTask(std::shared_ptr<BaseTaskItem> loadTask);
 
@@ -168,6 +232,10 @@ public:
     //! \exception Leviathan::InvalidArgument If the file couldn't be loaded
     static void LoadImage(const std::string& file, std::shared_ptr<std::vector<Magick::Image>>& image);
 
+    //! \brief Loads an image from the contents of an image file
+    //! \exception Leviathan::InvalidArgument If the data couldn't be loaded
+    static void LoadImageFromMemory(const std::string& data, std::shared_ptr<std::vector<Magick::Image>>& image);
+
 public:
     //! \brief Create new LoadedImage
     //! \protected
@@ -199,6 +267,11 @@ protected:
     //! Sets error to "Force unloaded"
     void UnloadImage();
 
+    //! \brief Creates the downscaled copies of image, called on a worker thread
+    //! \returns False if image was unloaded while the copies were being created, in which case
+    //! they are discarded
+    bool _BuildPyramid(const std::shared_ptr<std::vector<Magick::Image>>& image);
+
 protected:
     //! Used to unload old images
     std::chrono::high_resolution_clock::time_point LastUsed = std::chrono::high_resolution_clock::now();
@@ -213,6 +286,19 @@ protected:
     //! The magick image objects
     //! \todo Check if std::vector gives better performance
     std::shared_ptr<std::vector<Magick::Image>> MagickImage;
+
+    //! Set once the downscaled copies have been requested
+    std::atomic<bool> PyramidRequested{false};
+
+    //! Guards Pyramid and PyramidWidth as they are set from a worker thread. UnloadImage also
+    //! holds this so that a finishing build can't store copies of an unloaded image
+    mutable std::mutex PyramidMutex;
+
+    //! The downscaled copies, from half size to the smallest
+    std::vector<Glib::RefPtr<Gdk::Pixbuf>> Pyramid;
+
+    //! Width of the image the copies were made from
+    size_t PyramidWidth = 0;
 };
 
 //! \brief Manages loading images
@@ -221,7 +307,11 @@ class CacheManager
 {
 public:
     //! \brief Readies ImageMagick to be used by this instance
-    CacheManager();
+    //! \param imageCacheBudget Maximum memory use of cached full size images in bytes
+    //! \param fullLoaderThreads Number of threads loading full size images, 0 for automatic
+    //! \param thumbnailThreads Number of threads generating thumbnails, 0 for the core count
+    explicit CacheManager(size_t imageCacheBudget = DUALVIEW_SETTINGS_DEFAULT_IMAGE_CACHE_MEGABYTES * 1024 * 1024,
+        int fullLoaderThreads = 0, int thumbnailThreads = 0);
 
     //! \note It seems that there is no close method in Magick++ so that isn't called
     ~CacheManager();
@@ -246,9 +336,29 @@ public:
         return GetCachedImage(lock, file);
     }
 
+    //! \brief Updates the memory use of a cached image after it has created extra data
+    void UpdateImageSize(const LoadedImage& image);
+
     //! \brief Called when a file is moved, updates cache references to that file
     void NotifyMovedFile(const std::string& oldfile, const std::string& newfile);
 
+    //! \brief Changes the maximum memory use of cached full size images
+    void SetImageCacheBudget(size_t bytes);
+
+    //! \brief Starts storing thumbnails in a ThumbnailPack in folder
+    //!
+    //! Thumbnails that are still stored as separate files are still loaded from them
+    //! \exception Leviathan::InvalidArgument if the pack can't be opened
+    void EnableThumbnailPack(const std::string& folder);
+
+    //! \returns The thumbnail pack or null if thumbnails are stored as separate files
+    std::shared_ptr<ThumbnailPack> GetThumbnailPack() const;
+
+    //! \brief Returns how much time has been spent in each of the thumbnail stages
+    std::vector<ThumbnailStageTiming> GetThumbnailStageTimings() const;
+
+    static const char* GetThumbnailStageName(THUMBNAIL_STAGE stage);
+
     // Resource loading
 
     //! Icon for folders
@@ -269,13 +379,15 @@ public:
     //! \brief Helper variant that extracts image size from image
     static std::string CreateResizeSizeForImage(const Magick::Image& image, int targetWidth, int targetHeight);
 
-    //! \brief Loads an image and looks up the size then unloads it
+    //! \brief Looks up the size of an image
+    //!
+    //! Common formats are read from the file header, other formats are loaded with Magick
     //! \returns False if the image cannot be opened
     static bool GetImageSize(const std::string& image, int& width, int& height, std::string& extension);
 
     //! \brief Returns true if a byte string is an image
-    //! \note Probably not the worlds fastest implementation as this opens the whole thing
-    //! as a Magick::Image
+    //! \note Only complete images of the formats supported by ProbeImageHeader are checked
+    //! quickly, everything else is opened as a Magick::Image
     static bool CheckIsBytesAnImage(const std::string& imagedata);
 
     //! \brief Returns the actual path for loading an image. This takes the database directory
@@ -297,20 +409,38 @@ protected:
 
     void _RunCacheCleanupThread();
 
+    //! \brief Loads thumbnails that already exist, others are moved to ThumbGenerationQueue
+    void _RunThumbnailLoaderThread();
+
     void _RunThumbnailGenerationThread();
 
-    //! \brief Loads a thumbnail
-    //!
-    //! The thumnail will be created if it doesn't exist already
-    void _LoadThumbnail(LoadedImage& thumb, const std::string& hash) const;
+    //! \brief Returns the path a thumbnail should be stored at
+    //! \param extension Set to the extension the thumbnail is saved with
+    boost::filesystem::path _GetThumbnailPath(
+        const LoadedImage& thumb, const std::string& hash, std::string& extension) const;
+
+    //! \brief Loads a thumbnail if it has been created already
+    //! \returns False if the thumbnail needs to be created
+    bool _LoadExistingThumbnail(LoadedImage& thumb, const std::string& hash);
+
+    //! \brief Loads a thumbnail from the pack
+    //! \returns False if the thumbnail isn't in the pack or is invalid (in which case it is removed)
+    bool _LoadPackedThumbnail(ThumbnailPack& pack, LoadedImage& thumb, const std::string& name);
+
+    //! \brief Creates a thumbnail from the full image and saves it
+    void _GenerateThumbnail(LoadedImage& thumb, const std::string& hash);
+
+    //! \brief Adds time to a thumbnail stage
+    void _AddThumbnailStageTime(THUMBNAIL_STAGE stage, std::chrono::high_resolution_clock::time_point start);
 
 protected:
     //! When set to true the loader threads will quit
     std::atomic<bool> Quitting = {false};
 
     //! Contains recently open images and maybe the next image if the user hasn't
-    //! changed an image in a while. Will be periodically cleared by _RunCacheCleanupThread
-    std::vector<std::shared_ptr<LoadedImage>> ImageCache;
+    //! changed an image in a while. Evicts images when over budget and is also periodically
+    //! cleared by _RunCacheCleanupThread
+    DV::ImageCache ImageCache;
 
     //! Lock when using ImageCache
     std::mutex ImageCacheLock;
@@ -321,7 +451,10 @@ protected:
     // FullLoader //
     //! Uses LoadQueueMutex for locking
     std::condition_variable NotifyFullLoaderThread;
-    std::thread FullLoaderThread;
+    std::vector<std::thread> FullLoaderThreads;
+
+    //! Number of loads skipped because nothing needed the image anymore
+    std::atomic<int64_t> CancelledFullLoads{0};
 
     TaskListWithPriority<std::shared_ptr<LoadedImage>> LoadQueue;
 
@@ -330,15 +463,38 @@ protected:
     std::thread CacheCleanupThread;
     std::mutex CacheCleanupMutex;
 
-    // Thumbnail Generator //
-    //! Uses ThumbQueueMutex for locking
-    std::condition_variable NotifyThumbnailGenerationThread;
-    std::thread ThumbnailGenerationThread;
+    // Thumbnail Loader //
+    //! Uses ThumbQueue for locking
+    std::condition_variable NotifyThumbnailLoaderThread;
+    std::thread ThumbnailLoaderThread;
 
     //! List of thumbnails that need to be loaded. The string in the tuple is the
     //! file hash
     TaskListWithPriority<std::tuple<std::shared_ptr<LoadedImage>, std::string>> ThumbQueue;
 
+    // Thumbnail Generator //
+    //! Uses ThumbGenerationQueue for locking
+    std::condition_variable NotifyThumbnailGenerationThread;
+    std::vector<std::thread> ThumbnailGenerationThreads;
+
+    //! Thumbnails that don't exist yet. The tasks are moved here from ThumbQueue so that
+    //! existing thumbnails don't need to wait for the slow generation
+    TaskListWithPriority<std::tuple<std::shared_ptr<LoadedImage>, std::string>> ThumbGenerationQueue;
+
+    //! Names of the thumbnails being generated right now and the other tasks for the same
+    //! thumbnails that wait for them. This stops two threads writing the same file or pack
+    //! entry. Uses ThumbGenerationQueue for locking
+    std::unordered_map<std::string,
+        std::vector<std::shared_ptr<decltype(ThumbGenerationQueue)::TaskItem>>>
+        ThumbnailsInProgress;
+
+    //! Set when thumbnails are stored in pack files
+    std::shared_ptr<ThumbnailPack> ThumbnailStore;
+    mutable std::mutex ThumbnailStoreMutex;
+
+    std::array<std::atomic<int64_t>, static_cast<size_t>(THUMBNAIL_STAGE::Count)> ThumbnailStageCounts{};
+    std::array<std::atomic<int64_t>, static_cast<size_t>(THUMBNAIL_STAGE::Count)> ThumbnailStageMicroseconds{};
+
     // Resource managing //
 
     // For simplicity resources are loaded the first time they are requested
@@ -14,6 +14,9 @@ enum class CHANGED_EVENT : uint32_t {
     //! Fired when a new Collection is inserted
     COLLECTION_CREATED,
 
+    //! Fired when the name or an alias of a tag, modifier or break rule changes
+    TAGS_CHANGED,
+
     MAX
 };
 
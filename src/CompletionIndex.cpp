@@ -0,0 +1,216 @@
+// ------------------------------------ //
+#include "CompletionIndex.h"
+
+#include <algorithm>
+
+using namespace DV;
+// ------------------------------------ //
+namespace
+{
+constexpr size_t TRIGRAM_LENGTH = 3;
+
+//! Removed entries are left in place until there are this many of them and they are more than
+//! half of all the entries
+constexpr size_t COMPACT_AFTER_REMOVED = 1024;
+
+uint32_t GetTrigram(const std::string& text, size_t position)
+{
+    return (static_cast<uint32_t>(static_cast<uint8_t>(text[position])) << 16) |
+        (static_cast<uint32_t>(static_cast<uint8_t>(text[position + 1])) << 8) |
+        static_cast<uint32_t>(static_cast<uint8_t>(text[position + 2]));
+}
+} // namespace
+
+// ------------------------------------ //
+void CompletionIndex::Clear()
+{
+    Entries.clear();
+    EntryByText.clear();
+    Trigrams.clear();
+    RemovedCount = 0;
+}
+
+// ------------------------------------ //
+void CompletionIndex::Add(const std::string& text, const std::string& key, int64_t uses)
+{
+    const auto existing = EntryByText.find(text);
+
+    if (existing != EntryByText.end())
+    {
+        auto& entry = Entries[existing->second];
+        uses = std::max(uses, entry.Uses);
+
+        if (entry.Key == key)
+        {
+            entry.Uses = uses;
+            return;
+        }
+
+        Remove(text);
+    }
+
+    const auto index = static_cast<uint32_t>(Entries.size());
+
+    Entries.push_back(Entry{text, key, uses, false});
+    EntryByText[text] = index;
+
+    _AddTrigrams(index);
+}
+
+void CompletionIndex::Remove(const std::string& text)
+{
+    const auto found = EntryByText.find(text);
+
+    if (found == EntryByText.end())
+        return;
+
+    auto& entry = Entries[found->second];
+    entry.Removed = true;
+    entry.Text.clear();
+    entry.Key.clear();
+
+    EntryByText.erase(found);
+    ++RemovedCount;
+
+    if (RemovedCount >= COMPACT_AFTER_REMOVED && RemovedCount > Entries.size() / 2)
+        _Compact();
+}
+
+void CompletionIndex::SetUses(const std::string& text, int64_t uses)
+{
+    const auto found = EntryByText.find(text);
+
+    if (found != EntryByText.end())
+        Entries[found->second].Uses = uses;
+}
+
+// ------------------------------------ //
+void CompletionIndex::Find(std::vector<std::string>& result, const std::string& pattern, size_t max) const
+{
+    if (max < 1)
+        return;
+
+    // Ranking values are calculated once for each match so that sorting doesn't need to
+    // compare the strings
+    struct Match
+    {
+        //! 0 for an exact match, 1 for a prefix match and 2 for other matches
+        int Group;
+        int64_t Uses;
+        size_t LengthDifference;
+        uint32_t Index;
+    };
+
+    std::vector<Match> matches;
+
+    const auto check = [&](uint32_t index)
+    {
+        const auto& entry = Entries[index];
+
+        if (entry.Removed)
+            return;
+
+        const auto position = entry.Key.find(pattern);
+
+        if (position == std::string::npos)
+            return;
+
+        const int group = position != 0 ? 2 : (entry.Key.size() == pattern.size() ? 0 : 1);
+
+        matches.push_back(Match{group, entry.Uses, entry.Key.size() - pattern.size(), index});
+    };
+
+    if (pattern.size() < TRIGRAM_LENGTH)
+    {
+        for (uint32_t i = 0; i < Entries.size(); ++i)
+            check(i);
+    }
+    else
+    {
+        // Every match contains all the trigrams of the pattern so only the entries of the rarest
+        // one need to be checked
+        const std::vector<uint32_t>* rarest = nullptr;
+
+        for (size_t i = 0; i + TRIGRAM_LENGTH <= pattern.size(); ++i)
+        {
+            const auto found = Trigrams.find(GetTrigram(pattern, i));
+
+            if (found == Trigrams.end())
+                return;
+
+            if (!rarest || found->second.size() < rarest->size())
+                rarest = &found->second;
+        }
+
+        for (const auto index : *rarest)
+            check(index);
+    }
+
+    const auto compare = [&](const Match& left, const Match& right)
+    {
+        if (left.Group != right.Group)
+            return left.Group < right.Group;
+
+        if (left.Uses != right.Uses)
+            return left.Uses > right.Uses;
+
+        // Closer in length to the pattern first
+        if (left.LengthDifference != right.LengthDifference)
+            return left.LengthDifference < right.LengthDifference;
+
+        const auto& leftEntry = Entries[left.Index];
+        const auto& rightEntry = Entries[right.Index];
+
+        if (leftEntry.Key != rightEntry.Key)
+            return leftEntry.Key < rightEntry.Key;
+
+        return leftEntry.Text < rightEntry.Text;
+    };
+
+    const auto count = std::min(max, matches.size());
+
+    std::partial_sort(matches.begin(), matches.begin() + count, matches.end(), compare);
+
+    result.reserve(result.size() + count);
+
+    for (size_t i = 0; i < count; ++i)
+        result.push_back(Entries[matches[i].Index].Text);
+}
+
+// ------------------------------------ //
+void CompletionIndex::_AddTrigrams(uint32_t entry)
+{
+    const auto& key = Entries[entry].Key;
+
+    for (size_t i = 0; i + TRIGRAM_LENGTH <= key.size(); ++i)
+    {
+        auto& list = Trigrams[GetTrigram(key, i)];
+
+        // The same trigram can be in a key multiple times
+        if (list.empty() || list.back() != entry)
+            list.push_back(entry);
+    }
+}
+
+void CompletionIndex::_Compact()
+{
+    std::vector<Entry> entries;
+    entries.reserve(Entries.size() - RemovedCount);
+
+    for (auto& entry : Entries)
+    {
+        if (!entry.Removed)
+            entries.push_back(std::move(entry));
+    }
+
+    Entries = std::move(entries);
+    EntryByText.clear();
+    Trigrams.clear();
+    RemovedCount = 0;
+
+    for (uint32_t i = 0; i < Entries.size(); ++i)
+    {
+        EntryByText[Entries[i].Text] = i;
+        _AddTrigrams(i);
+    }
+}
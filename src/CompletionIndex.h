@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Common.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace DV
+{
+//! \brief In-memory trigram index for finding texts that contain a typed string
+//!
+//! Every three byte sequence of the matched keys points to the entries containing it. A search
+//! only checks the entries of the rarest trigram of the pattern instead of all the texts, like a
+//! LIKE '%pattern%' query would. Patterns shorter than a trigram check all entries.
+//!
+//! Results are ranked by exact match, then prefix match, then the use count of the entries.
+class CompletionIndex
+{
+public:
+    void Clear();
+
+    //! \brief Adds a text that can be suggested
+    //! \param text The suggested text
+    //! \param key The lowercase text matched against the patterns
+    //! \param uses How many times the text has been used, more used texts are suggested first
+    //! \note If the text has already been added the larger use count is kept
+    void Add(const std::string& text, const std::string& key, int64_t uses);
+
+    //! \brief Removes a text added with Add, does nothing if it isn't in this index
+    void Remove(const std::string& text);
+
+    //! \brief Changes the use count of a text, does nothing if it isn't in this index
+    void SetUses(const std::string& text, int64_t uses);
+
+    //! \brief Finds texts whose key contains pattern
+    //! \param pattern The lowercase text to find
+    //! \param max The maximum number of texts to add to result
+    //! \param result The texts are added to the end of this in ranked order
+    void Find(std::vector<std::string>& result, const std::string& pattern, size_t max) const;
+
+    size_t GetCount() const
+    {
+        return EntryByText.size();
+    }
+
+private:
+    struct Entry
+    {
+        std::string Text;
+        std::string Key;
+        int64_t Uses;
+
+        //! Removed entries are skipped until the index is compacted
+        bool Removed;
+    };
+
+    void _AddTrigrams(uint32_t entry);
+
+    //! \brief Drops removed entries and rebuilds the trigram lists
+    void _Compact();
+
+private:
+    std::vector<Entry> Entries;
+
+    //! Index of the entry for each text in Entries
+    std::unordered_map<std::string, uint32_t> EntryByText;
+
+    //! Sorted lists of entries that contain each trigram
+    std::unordered_map<uint32_t, std::vector<uint32_t>> Trigrams;
+
+    size_t RemovedCount = 0;
+};
+
+} // namespace DV
@@ -21,6 +21,57 @@ CurlWrapper::~CurlWrapper(){
     WrappedObject = nullptr;
 }
 // ------------------------------------ //
+CurlShareWrapper::CurlShareWrapper(){
+
+    CurlWrapper::CheckCurlInit();
+
+    WrappedObject = curl_share_init();
+
+    LEVIATHAN_ASSERT(WrappedObject, "cURL share initialization failed");
+
+    curl_share_setopt(WrappedObject, CURLSHOPT_LOCKFUNC, &CurlShareWrapper::LockCallback);
+    curl_share_setopt(WrappedObject, CURLSHOPT_UNLOCKFUNC, &CurlShareWrapper::UnlockCallback);
+    curl_share_setopt(WrappedObject, CURLSHOPT_USERDATA, this);
+
+    curl_share_setopt(WrappedObject, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(WrappedObject, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+}
+
+CurlShareWrapper::~CurlShareWrapper(){
+
+    // This fails if some easy handle still uses this
+    if(curl_share_cleanup(WrappedObject) != CURLSHE_OK)
+        LOG_ERROR("CurlShareWrapper: share handle is still in use on destruction");
+
+    WrappedObject = nullptr;
+}
+
+void CurlShareWrapper::LockCallback(CURL* handle, curl_lock_data data,
+    curl_lock_access access, void* userptr){
+
+    static_cast<CurlShareWrapper*>(userptr)->Locks[data].lock();
+}
+
+void CurlShareWrapper::UnlockCallback(CURL* handle, curl_lock_data data, void* userptr){
+
+    static_cast<CurlShareWrapper*>(userptr)->Locks[data].unlock();
+}
+// ------------------------------------ //
+CurlMultiWrapper::CurlMultiWrapper(){
+
+    CurlWrapper::CheckCurlInit();
+
+    WrappedObject = curl_multi_init();
+
+    LEVIATHAN_ASSERT(WrappedObject, "cURL multi initialization failed");
+}
+
+CurlMultiWrapper::~CurlMultiWrapper(){
+
+    curl_multi_cleanup(WrappedObject);
+    WrappedObject = nullptr;
+}
+// ------------------------------------ //
 std::mutex CurlWrapper::CurlInitMutex;
 bool CurlWrapper::CurlInitialized;
 
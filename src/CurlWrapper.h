@@ -22,13 +22,67 @@ public:
         return WrappedObject;
     }
 
+    // Global libcurl init code
+    static void CheckCurlInit();
+
 protected:
 
     CURL* WrappedObject = nullptr;
 
-    // Global libcurl init code
-    static void CheckCurlInit();
     static std::mutex CurlInitMutex;
     static bool CurlInitialized;
 };
+
+//! \brief Holds a curl share handle that shares the DNS and TLS session caches between easy
+//! handles
+//!
+//! This is thread safe so the easy handles can be used on different threads
+class CurlShareWrapper{
+public:
+
+    CurlShareWrapper();
+    ~CurlShareWrapper();
+
+    CurlShareWrapper(const CurlShareWrapper& other) = delete;
+    CurlShareWrapper& operator=(const CurlShareWrapper& other) = delete;
+
+    CURLSH* Get(){
+
+        return WrappedObject;
+    }
+
+protected:
+
+    static void LockCallback(CURL* handle, curl_lock_data data, curl_lock_access access,
+        void* userptr);
+    static void UnlockCallback(CURL* handle, curl_lock_data data, void* userptr);
+
+protected:
+
+    CURLSH* WrappedObject = nullptr;
+
+    std::mutex Locks[CURL_LOCK_DATA_LAST];
+};
+
+//! \brief Holds a curl multi handle
+//!
+//! The easy handles running in a multi handle share its connection cache
+class CurlMultiWrapper{
+public:
+
+    CurlMultiWrapper();
+    ~CurlMultiWrapper();
+
+    CurlMultiWrapper(const CurlMultiWrapper& other) = delete;
+    CurlMultiWrapper& operator=(const CurlMultiWrapper& other) = delete;
+
+    CURLM* Get(){
+
+        return WrappedObject;
+    }
+
+protected:
+
+    CURLM* WrappedObject = nullptr;
+};
 }
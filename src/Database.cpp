@@ -2,7 +2,10 @@
 #include "Database.h"
 
 #include <sqlite3.h>
+#include <algorithm>
+#include <limits>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <boost/filesystem.hpp>
@@ -24,6 +27,7 @@
 #include "CurlWrapper.h"
 #include "Exceptions.h"
 #include "PreparedStatement.h"
+#include "SignatureIndex.h"
 #include "TimeHelpers.h"
 #include "UtilityHelpers.h"
 
@@ -111,6 +115,12 @@ Database::Database(std::string dbfile) : DatabaseFile(dbfile)
             "' errorcode: " + Convert::ToString(result) + " message: " + errormessage);
         throw Leviathan::InvalidState("failed to open sqlite database");
     }
+
+    Statements.SetDatabase(SQLiteDb);
+    SignatureStatements.SetDatabase(PictureSignatureDb);
+
+    SQLiteFile = dbfile;
+    PictureSignatureFile = pictureSignatureFile;
 }
 
 Database::Database(bool tests)
@@ -138,6 +148,9 @@ Database::Database(bool tests)
         SQLiteDb = nullptr;
         throw Leviathan::InvalidState("failed to open memory sqlite database");
     }
+
+    Statements.SetDatabase(SQLiteDb);
+    SignatureStatements.SetDatabase(PictureSignatureDb);
 }
 
 Database::~Database()
@@ -150,6 +163,20 @@ Database::~Database()
     // Stop all active operations //
 
     // Release all prepared objects //
+    {
+        std::lock_guard<std::mutex> lock(ReadConnectionMutex);
+
+        if (static_cast<int>(IdleReadConnections.size()) != ReadConnectionCount)
+            LOG_ERROR("Database: read connections are still in use while closing");
+
+        IdleReadConnections.clear();
+        ReadConnectionCount = 0;
+    }
+
+    PrintStatementCacheStats(guard);
+
+    Statements.Clear();
+    SignatureStatements.Clear();
 
     if (SQLiteDb)
     {
@@ -174,6 +201,83 @@ Database::~Database()
     }
 }
 
+// ------------------------------------ //
+void Database::OpenReadConnections(int count)
+{
+    if (SQLiteFile.empty())
+        throw Leviathan::InvalidState("in-memory database can't have read connections");
+
+    std::lock_guard<std::mutex> lock(ReadConnectionMutex);
+
+    for (int i = 0; i < count; ++i)
+    {
+        IdleReadConnections.push_back(std::make_unique<ReadConnection>(SQLiteFile, PictureSignatureFile));
+        ++ReadConnectionCount;
+    }
+
+    LOG_INFO("Database: opened " + std::to_string(count) + " read connection(s)");
+}
+
+DatabaseReadLock Database::AcquireReadLock()
+{
+    std::unique_ptr<ReadConnection> connection;
+
+    {
+        std::unique_lock<std::mutex> lock(ReadConnectionMutex);
+
+        if (ReadConnectionCount < 1)
+        {
+            lock.unlock();
+
+            GUARD_LOCK();
+            return DatabaseReadLock(*this, std::make_unique<RecursiveLock>(std::move(guard)));
+        }
+
+        ReadConnectionNotify.wait(lock, [this]() { return !IdleReadConnections.empty(); });
+
+        connection = std::move(IdleReadConnections.back());
+        IdleReadConnections.pop_back();
+    }
+
+    try
+    {
+        connection->BeginRead();
+    }
+    catch (...)
+    {
+        _ReturnReadConnection(std::move(connection));
+        throw;
+    }
+
+    return DatabaseReadLock(*this, std::move(connection));
+}
+
+void Database::_ReturnReadConnection(std::unique_ptr<ReadConnection>&& connection)
+{
+    {
+        std::lock_guard<std::mutex> lock(ReadConnectionMutex);
+        IdleReadConnections.push_back(std::move(connection));
+    }
+
+    ReadConnectionNotify.notify_one();
+}
+
+// ------------------------------------ //
+void Database::SetStatementCacheSize(LockT& guard, size_t size)
+{
+    Statements.SetMaxSize(size);
+    SignatureStatements.SetMaxSize(size);
+}
+
+void Database::PrintStatementCacheStats(LockT& guard)
+{
+    LOG_INFO("Database: statement cache hits: " + std::to_string(Statements.GetHits()) +
+        " misses: " + std::to_string(Statements.GetMisses()) +
+        " evictions: " + std::to_string(Statements.GetEvictions()) +
+        ", signature db hits: " + std::to_string(SignatureStatements.GetHits()) +
+        " misses: " + std::to_string(SignatureStatements.GetMisses()));
+}
+
 // ------------------------------------ //
 void Database::Init()
 {
@@ -189,7 +293,8 @@ void Database::Init()
     {
         const char str[] = "PRAGMA foreign_keys; PRAGMA recursive_triggers;";
 
-        PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
         auto statementInUse = statementObj.Setup();
 
@@ -294,7 +399,8 @@ void Database::InsertImage(LockT& guard, Image& image)
                        "add_date, last_view, is_private, from_file, file_hash) VALUES "
                        "(?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(CacheManager::GetDatabaseImagePath(image.GetResourcePath()),
         image.GetWidth(), image.GetHeight(), image.GetName(), image.GetExtension(), image.GetAddDateStr(),
@@ -308,7 +414,10 @@ void Database::InsertImage(LockT& guard, Image& image)
     // insert here
     // TODO: this does some extra work when inserting but shouldn't be too bad
     if (!signature.empty())
-        _InsertImageSignatureParts(guard, id, signature);
+        InsertImageSignatures(guard, {std::make_tuple(id, signature)});
+
+    if (ImageTagIndexLoaded)
+        ImageTagIndex.AddImage(id);
 
     image.OnAdopted(id, *this);
 }
@@ -346,7 +455,7 @@ bool Database::UpdateImage(LockT& guard, Image& image)
             // }
 
             // Also insert constituent parts
-            _InsertImageSignatureParts(guard, id, signature);
+            InsertImageSignatures(guard, {std::make_tuple(id, signature)});
         }
     }
     else
@@ -357,7 +466,8 @@ bool Database::UpdateImage(LockT& guard, Image& image)
         const char str[] = "UPDATE pictures SET relative_path = ?2, width = ?3, height = ?4, name = ?5, "
                            "extension = ?6, last_view = ?7, is_private = ?8 WHERE id = ?1;";
 
-        PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
         statementObj.StepAll(statementObj.Setup(id, relativePath, image.GetWidth(), image.GetHeight(), image.GetName(),
             image.GetExtension(), image.GetLastViewStr(), image.GetIsPrivate()));
@@ -368,30 +478,95 @@ bool Database::UpdateImage(LockT& guard, Image& image)
     return true;
 }
 
-void Database::_InsertImageSignatureParts(LockT& guard, DBID image, const std::string& signature)
+//! \brief Creates an insert for count signature words of the same image
+static std::string CreateSignatureWordsInsert(size_t count)
+{
+    std::string sql = "INSERT INTO picture_signature_words (picture_id, sig_word) VALUES ";
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i != 0)
+            sql += ", ";
+
+        // ?1 is the image id
+        sql += "(?1, ?" + std::to_string(i + 2) + ")";
+    }
+
+    return sql + ";";
+}
+
+void Database::InsertImageSignatures(LockT& guard, const std::vector<std::tuple<DBID, std::string>>& signatures)
 {
+    if (signatures.empty())
+        return;
+
+    DoDBSavePoint transaction(*this, guard, "insert_signatures", true);
+
     // This will also clear old entries if there were any with the foreign keys
-    RunOnSignatureDB(guard, "INSERT OR REPLACE INTO pictures (id, signature) VALUES(?, ?);", image, signature);
+    const char pictureStr[] = "INSERT OR REPLACE INTO pictures (id, signature) VALUES(?, ?);";
+
+    PreparedStatement pictureStatement(PictureSignatureDb, pictureStr, sizeof(pictureStr));
 
-    const char str[] = "INSERT INTO picture_signature_words (picture_id, sig_word) VALUES (?, ?);";
+    // Full signatures have all the words inserted with one step, shorter ones one word at a time
+    static const auto fullWordsStr = CreateSignatureWordsInsert(IMAGE_SIGNATURE_WORD_COUNT);
 
-    PreparedStatement statementObj(PictureSignatureDb, str, sizeof(str));
+    PreparedStatement fullWordsStatement(PictureSignatureDb, fullWordsStr);
 
-    // Then insert new
-    if (signature.length() > IMAGE_SIGNATURE_WORD_LENGTH)
+    const char wordStr[] = "INSERT INTO picture_signature_words (picture_id, sig_word) VALUES (?, ?);";
+
+    PreparedStatement wordStatement(PictureSignatureDb, wordStr, sizeof(wordStr));
+
+    for (const auto& [image, signature] : signatures)
     {
-        size_t loopCount =
-            std::min<size_t>(IMAGE_SIGNATURE_WORD_COUNT, signature.length() - IMAGE_SIGNATURE_WORD_LENGTH + 1);
+        pictureStatement.StepAll(pictureStatement.Setup(image, signature));
 
-        for (size_t i = 0; i < loopCount; ++i)
+        const auto words = SignatureIndex::CountWords(signature.size());
+
+        if (words == IMAGE_SIGNATURE_WORD_COUNT)
         {
-            // The index is part of the word key in the table
-            std::string finalKey = std::to_string(i) + "__" + signature.substr(i, IMAGE_SIGNATURE_WORD_LENGTH);
-            auto statementInUse = statementObj.Setup(image, finalKey);
+            auto statementInUse = fullWordsStatement.Setup(image);
 
-            statementObj.StepAll(statementInUse);
+            for (size_t i = 0; i < words; ++i)
+                fullWordsStatement.Bind(SignatureIndex::CreateWordKey(signature, i));
+
+            fullWordsStatement.StepAll(statementInUse);
+        }
+        else
+        {
+            for (size_t i = 0; i < words; ++i)
+                wordStatement.StepAll(wordStatement.Setup(image, SignatureIndex::CreateWordKey(signature, i)));
+        }
+    }
+}
+
+void Database::_RebuildSignatureWords(LockT& guard)
+{
+    _RunSQL(guard, PictureSignatureDb, "DELETE FROM picture_signature_words;");
+
+    std::vector<std::tuple<DBID, std::string>> signatures;
+
+    {
+        const char str[] = "SELECT id, signature FROM pictures WHERE signature IS NOT NULL;";
+
+        auto cachedStatement = _GetSignatureStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            DBID id;
+
+            if (!statementObj.GetObjectIDFromColumn(id, 0))
+                continue;
+
+            signatures.emplace_back(id, statementObj.GetColumnAsBinaryString(1));
         }
     }
+
+    LOG_INFO("Database: recreating signature words for " + std::to_string(signatures.size()) + " images");
+
+    InsertImageSignatures(guard, signatures);
 }
 
 std::shared_ptr<DatabaseAction> Database::DeleteImage(Image& image)
@@ -456,7 +631,8 @@ std::shared_ptr<ImageDeleteAction> Database::SelectImageDeleteActionForImage(Ima
     const char str[] = "SELECT * FROM action_history WHERE json_data LIKE ?1 AND type = ?2 "
                        "AND performed = ?3 ORDER BY id DESC;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup("%" + std::to_string(image.GetID()) + "%",
         static_cast<int>(DATABASE_ACTION_TYPE::ImageDelete), performed ? 1 : 0);
@@ -483,7 +659,8 @@ DBID Database::SelectImageIDByHash(LockT& guard, const std::string& hash)
 {
     const char str[] = "SELECT id FROM pictures WHERE file_hash = ?1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(hash);
 
@@ -501,7 +678,8 @@ std::string Database::SelectImageNameByID(LockT& guard, DBID id)
 {
     const char str[] = "SELECT name FROM pictures WHERE id = ?1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -513,11 +691,12 @@ std::string Database::SelectImageNameByID(LockT& guard, DBID id)
     return "";
 }
 
-size_t Database::SelectImageCount(LockT& guard)
+size_t Database::SelectImageCount(DatabaseReadLock& reader)
 {
     const char str[] = "SELECT COUNT(*) FROM pictures;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = reader.GetStatement(str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -529,13 +708,14 @@ size_t Database::SelectImageCount(LockT& guard)
     return 0;
 }
 
-void Database::SelectImagePaths(LockT& guard, std::vector<ImagePath>& results, int64_t offset, int64_t max /*= 10000 */)
+void Database::SelectImagePaths(DatabaseReadLock& reader, std::vector<ImagePath>& results, int64_t offset, int64_t max /*= 10000 */)
 {
     results.resize(0);
 
     const char str[] = "SELECT id, relative_path, file_hash FROM pictures ORDER BY id LIMIT ? OFFSET ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = reader.GetStatement(str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(max, offset);
 
@@ -553,7 +733,8 @@ std::string Database::SelectImageSignatureByID(LockT& guard, DBID image)
 {
     const char str[] = "SELECT signature FROM pictures WHERE id = ?1;";
 
-    PreparedStatement statementObj(PictureSignatureDb, str, sizeof(str));
+    auto cachedStatement = _GetSignatureStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(image);
 
@@ -565,7 +746,7 @@ std::string Database::SelectImageSignatureByID(LockT& guard, DBID image)
     return "";
 }
 
-std::vector<DBID> Database::SelectImageIDsWithoutSignature(LockT& guard)
+std::vector<DBID> Database::SelectImageIDsWithoutSignature(DatabaseReadLock& reader)
 {
     std::unordered_set<DBID> imagesWithSignature;
 
@@ -575,7 +756,8 @@ std::vector<DBID> Database::SelectImageIDsWithoutSignature(LockT& guard)
     {
         const char str[] = "SELECT id FROM pictures;";
 
-        PreparedStatement statementObj2(PictureSignatureDb, str, sizeof(str));
+        auto cachedStatement = reader.GetSignatureStatement(str, sizeof(str));
+        auto& statementObj2 = *cachedStatement;
 
         auto statementInUse2 = statementObj2.Setup();
 
@@ -591,7 +773,8 @@ std::vector<DBID> Database::SelectImageIDsWithoutSignature(LockT& guard)
 
     const char str[] = "SELECT id FROM pictures WHERE deleted IS NOT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = reader.GetStatement(str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -616,7 +799,8 @@ std::shared_ptr<Image> Database::SelectImageByHash(LockT& guard, const std::stri
 {
     const char str[] = "SELECT * FROM pictures WHERE file_hash = ?1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(hash);
 
@@ -632,7 +816,8 @@ std::shared_ptr<Image> Database::SelectImageByID(LockT& guard, DBID id)
 {
     const char str[] = "SELECT * FROM pictures WHERE id = ?1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -648,7 +833,8 @@ std::shared_ptr<Image> Database::SelectImageByIDSkipDeleted(LockT& guard, DBID i
 {
     const char str[] = "SELECT * FROM pictures WHERE id = ?1 AND deleted IS NOT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -667,7 +853,8 @@ std::vector<std::shared_ptr<Image>> Database::SelectImageByTag(LockT& guard, DBI
     const char str[] = "SELECT * FROM pictures WHERE deleted IS NOT 1 AND pictures.id IN "
                        "(SELECT image_tag.image FROM image_tag WHERE image_tag.tag = ?1);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(tagid);
 
@@ -679,13 +866,73 @@ std::vector<std::shared_ptr<Image>> Database::SelectImageByTag(LockT& guard, DBI
     return result;
 }
 
+std::vector<DBID> Database::SelectImageIDsByTagSearch(LockT& guard, const TagSearchNode& query)
+{
+    if (!ImageTagIndexLoaded)
+        BuildImageTagIndex(guard);
+
+    return ImageTagIndex.Search(query);
+}
+
+std::vector<std::shared_ptr<Image>> Database::SelectImagesByTagSearch(LockT& guard, const TagSearchNode& query)
+{
+    return _SelectImagesByIDs(guard, SelectImageIDsByTagSearch(guard, query));
+}
+
+void Database::BuildImageTagIndex(LockT& guard)
+{
+    std::vector<DBID> images;
+    std::vector<std::tuple<DBID, DBID>> imageTags;
+
+    {
+        const char str[] = "SELECT id FROM pictures WHERE deleted IS NOT 1;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            DBID id;
+            if (statementObj.GetObjectIDFromColumn(id, 0))
+                images.push_back(id);
+        }
+    }
+
+    {
+        const char str[] = "SELECT image, tag FROM image_tag;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            DBID image;
+            DBID tag;
+
+            if (statementObj.GetObjectIDFromColumn(image, 0) && statementObj.GetObjectIDFromColumn(tag, 1))
+                imageTags.emplace_back(image, tag);
+        }
+    }
+
+    ImageTagIndex.Build(std::move(images), imageTags);
+    ImageTagIndexLoaded = true;
+
+    LOG_INFO("Database: image tag index has " + std::to_string(ImageTagIndex.GetImageCount()) +
+        " images and " + std::to_string(ImageTagIndex.GetTagCount()) + " tags");
+}
+
 // ------------------------------------ //
-void Database::SelectOrphanedImages(LockT& guard, std::vector<DBID>& result)
+void Database::SelectOrphanedImages(DatabaseReadLock& reader, std::vector<DBID>& result)
 {
     const char str[] = "SELECT id FROM pictures WHERE NOT EXISTS "
                        "(SELECT COUNT(*) FROM collection_image WHERE image = id);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = reader.GetStatement(str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -697,12 +944,13 @@ void Database::SelectOrphanedImages(LockT& guard, std::vector<DBID>& result)
     }
 }
 
-void Database::SelectIncorrectlyDeletedImages(LockT& guard, std::vector<DBID>& result)
+void Database::SelectIncorrectlyDeletedImages(DatabaseReadLock& reader, std::vector<DBID>& result)
 {
     const char str[] = "SELECT id FROM pictures WHERE deleted = TRUE AND NOT EXISTS "
                        "(SELECT id FROM action_history WHERE json_data LIKE '%' || pictures.id || '%');";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = reader.GetStatement(str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -739,7 +987,8 @@ void Database::SelectImageTags(LockT& guard, std::weak_ptr<Image> image, std::ve
 
     const char str[] = "SELECT tag FROM image_tag WHERE image = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(imageLock->GetID());
 
@@ -779,6 +1028,7 @@ void Database::InsertImageTag(LockT& guard, std::weak_ptr<Image> image, AppliedT
     if (existing)
     {
         InsertTagImage(guard, *imageLock, existing->GetID());
+        _ChangeTagUseCount(guard, tag, 1);
         return;
     }
 
@@ -789,17 +1039,22 @@ void Database::InsertImageTag(LockT& guard, std::weak_ptr<Image> image, AppliedT
     }
 
     InsertTagImage(guard, *imageLock, tag.GetID());
+    _ChangeTagUseCount(guard, tag, 1);
 }
 
 void Database::InsertTagImage(LockT& guard, Image& image, DBID appliedtagid)
 {
     const char str[] = "INSERT INTO image_tag (image, tag) VALUES (?, ?);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(image.GetID(), appliedtagid);
 
     statementObj.StepAll(statementInUse);
+
+    if (ImageTagIndexLoaded)
+        ImageTagIndex.AddTag(image.GetID(), appliedtagid);
 }
 
 void Database::DeleteImageTag(LockT& guard, std::weak_ptr<Image> image, AppliedTag& tag)
@@ -811,68 +1066,92 @@ void Database::DeleteImageTag(LockT& guard, std::weak_ptr<Image> image, AppliedT
 
     const char str[] = "DELETE FROM image_tag WHERE image = ? AND tag = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(imageLock->GetID(), tag.GetID());
 
     statementObj.StepAll(statementInUse);
 
+    if (ImageTagIndexLoaded)
+        ImageTagIndex.RemoveTag(imageLock->GetID(), tag.GetID());
+
+    _ChangeTagUseCount(guard, tag, -1);
+
     // This calls orphan on the tag object
     DeleteAppliedTagIfNotUsed(guard, tag);
 }
 
 std::map<DBID, std::vector<std::tuple<DBID, int>>> Database::SelectPotentialImageDuplicates(int sensitivity /*= 15*/)
 {
-    std::map<DBID, std::vector<std::tuple<DBID, int>>> result;
-
-    // TODO: have a separate lock for PictureSignatureDb as this takes a long, long time to run
-    // TODO: if that change is done then the ignore check step needs to be changed
-    GUARD_LOCK();
+    SignatureIndex index;
 
-    const char checkIgnoreSql[] = "SELECT 1 FROM ignored_duplicates WHERE primary_image = ?1 AND other_image = ?2;";
+    {
+        auto reader = AcquireReadLock();
+        SelectSignatureIndexData(reader, index);
+    }
 
-    PreparedStatement checkStatement(SQLiteDb, checkIgnoreSql, sizeof(checkIgnoreSql));
+    // The rest doesn't need the database so it is done without locking
+    index.BuildPostings();
 
-    const char sql[] = "SELECT isw.picture_id, COUNT(isw.sig_word) as strength, isw_search.picture_id FROM "
-                       "picture_signature_words isw JOIN picture_signature_words isw_search ON isw.sig_word "
-                       "= isw_search.sig_word AND isw.picture_id < isw_search.picture_id GROUP BY "
-                       "isw.picture_id, isw_search.picture_id HAVING strength >= ?;";
+    auto result = index.FindPotentialDuplicates(sensitivity);
 
-    PreparedStatement statementObj(PictureSignatureDb, sql, sizeof(sql));
+    LOG_INFO("Database: searched duplicates from " + std::to_string(index.GetImageCount()) +
+        " signatures, images with duplicates: " + std::to_string(result.size()));
 
-    auto statementInUse = statementObj.Setup(sensitivity);
+    return result;
+}
 
-    while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+void Database::SelectSignatureIndexData(DatabaseReadLock& reader, SignatureIndex& index)
+{
     {
-        DBID original;
-        DBID duplicate;
+        const char str[] = "SELECT COUNT(*) FROM pictures;";
 
-        if (statementObj.GetObjectIDFromColumn(original, 0) && statementObj.GetObjectIDFromColumn(duplicate, 2))
-        {
-            auto usedCheck = checkStatement.Setup(original, duplicate);
+        auto cachedStatement = reader.GetSignatureStatement(str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
-            if (checkStatement.Step(usedCheck) == PreparedStatement::STEP_RESULT::ROW)
-            {
-                // Ignored
-                continue;
-            }
+        auto statementInUse = statementObj.Setup();
+
+        if (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+            index.Reserve(statementObj.GetColumnAsInt64(0));
+    }
 
-            int strength = statementObj.GetColumnAsInt(1);
+    {
+        const char str[] = "SELECT id, signature FROM pictures WHERE signature IS NOT NULL ORDER BY id;";
 
-            auto found = result.find(original);
+        auto cachedStatement = reader.GetSignatureStatement(str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
-            if (found != result.end())
-            {
-                result[original].push_back(std::make_tuple(duplicate, strength));
-            }
-            else
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            DBID id;
+            if (statementObj.GetObjectIDFromColumn(id, 0))
             {
-                result[original] = {std::make_tuple(duplicate, strength)};
+                // The signature can contain null bytes
+                index.AddSignature(id, statementObj.GetColumnAsBinaryString(1));
             }
         }
     }
 
-    return result;
+    {
+        const char str[] = "SELECT primary_image, other_image FROM ignored_duplicates;";
+
+        auto cachedStatement = reader.GetStatement(str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            DBID primary;
+            DBID other;
+
+            if (statementObj.GetObjectIDFromColumn(primary, 0) && statementObj.GetObjectIDFromColumn(other, 1))
+                index.AddIgnoredPair(primary, other);
+        }
+    }
 }
 
 // ------------------------------------ //
@@ -883,7 +1162,8 @@ bool Database::CheckIsCollectionNameInUse(LockT& guard, const std::string& name,
     // delete
     const char str[] = "SELECT id FROM collections WHERE name = ?1 COLLATE NOCASE AND deleted IS NOT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(name);
 
@@ -906,7 +1186,8 @@ std::shared_ptr<Collection> Database::InsertCollection(LockT& guard, const std::
     const char str[] = "INSERT INTO collections (name, is_private, "
                        "add_date, modify_date, last_view) VALUES (?, ?, ?, ?, ?);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     const auto currentTime = TimeHelpers::FormatCurrentTimeAs8601();
     auto statementInUse = statementObj.Setup(name, isprivate, currentTime, currentTime, currentTime);
@@ -924,6 +1205,9 @@ std::shared_ptr<Collection> Database::InsertCollection(LockT& guard, const std::
 
     auto created = SelectCollectionByName(guard, name);
 
+    if (CollectionCompletionsValid)
+        CollectionCompletions.Add(created->GetName(), StringToLower(created->GetName()), 0);
+
     // Add it to the root folder //
     if (!InsertCollectionToFolder(guard, *SelectRootFolder(guard), *created))
     {
@@ -938,12 +1222,18 @@ std::shared_ptr<Collection> Database::InsertCollection(LockT& guard, const std::
 
 bool Database::UpdateCollection(LockT& guard, const Collection& collection)
 {
+    // The old name needs to be removed from the completions before it is changed
+    _UpdateCollectionCompletion(guard, collection.GetID(), true);
+
     const char str[] = "UPDATE collections SET name = ?2, is_private = ?3 WHERE id = ?1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     statementObj.StepAll(statementObj.Setup(collection.GetID(), collection.GetName(), collection.GetIsPrivate()));
 
+    _UpdateCollectionCompletion(guard, collection.GetID(), false);
+
     // TODO: check that this can't result in the collection having the same name as some other
     // one
 
@@ -1003,7 +1293,8 @@ std::shared_ptr<CollectionDeleteAction> Database::SelectCollectionDeleteAction(C
     const char str[] = "SELECT * FROM action_history WHERE json_data LIKE ?1 AND type = ?2 "
                        "AND performed = ?3 ORDER BY id DESC;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup("%" + std::to_string(collection.GetID()) + "%",
         static_cast<int>(DATABASE_ACTION_TYPE::CollectionDelete), performed ? 1 : 0);
@@ -1030,7 +1321,8 @@ std::shared_ptr<Collection> Database::SelectCollectionByID(LockT& guard, DBID id
 {
     const char str[] = "SELECT * FROM collections WHERE id = ?1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -1047,7 +1339,8 @@ std::shared_ptr<Collection> Database::SelectCollectionByName(LockT& guard, const
 {
     const char str[] = "SELECT * FROM collections WHERE name = ?1 COLLATE NOCASE AND deleted IS NOT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(name);
 
@@ -1062,9 +1355,12 @@ std::shared_ptr<Collection> Database::SelectCollectionByName(LockT& guard, const
 
 std::string Database::SelectCollectionNameByID(DBID id)
 {
+    GUARD_LOCK();
+
     const char str[] = "SELECT name FROM collections WHERE id = ?1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -1080,23 +1376,40 @@ std::vector<std::string> Database::SelectCollectionNamesByWildcard(const std::st
 {
     GUARD_LOCK();
 
+    if (!CollectionCompletionsValid)
+        BuildCollectionCompletions(guard);
+
     std::vector<std::string> result;
 
-    const char str[] = "SELECT name FROM collections WHERE name LIKE ?1 AND deleted IS NOT 1 "
-                       "ORDER BY (CASE WHEN name = ?2 THEN 1 WHEN name LIKE ?3 THEN 2 ELSE "
-                       "name END) LIMIT ?4 COLLATE NOCASE;";
+    if (max > 0)
+        CollectionCompletions.Find(result, StringToLower(pattern), static_cast<size_t>(max));
+
+    return result;
+}
+
+void Database::BuildCollectionCompletions(LockT& guard)
+{
+    CollectionCompletions.Clear();
+
+    const char str[] = "SELECT name, (SELECT COUNT(*) FROM collection_image WHERE collection = collections.id) "
+                       "FROM collections WHERE deleted IS NOT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
-    auto statementInUse = statementObj.Setup("%" + pattern + "%", pattern, pattern + "%", max);
+    auto statementInUse = statementObj.Setup();
 
     while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
     {
-        // Found a value //
-        result.push_back(statementObj.GetColumnAsString(0));
+        const auto name = statementObj.GetColumnAsString(0);
+
+        CollectionCompletions.Add(name, StringToLower(name), statementObj.GetColumnAsInt64(1));
     }
 
-    return result;
+    CollectionCompletionsValid = true;
+
+    LOG_INFO("Database: collection completion index has " + std::to_string(CollectionCompletions.GetCount()) +
+        " collections");
 }
 
 int64_t Database::SelectCollectionLargestShowOrder(LockT& guard, const Collection& collection)
@@ -1107,7 +1420,8 @@ int64_t Database::SelectCollectionLargestShowOrder(LockT& guard, const Collectio
     const char str[] = "SELECT show_order FROM collection_image WHERE collection = ?1 "
                        "ORDER BY show_order DESC LIMIT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID());
 
@@ -1126,7 +1440,8 @@ int64_t Database::SelectCollectionImageCount(LockT& guard, const Collection& col
 
     const char str[] = "SELECT COUNT(*) FROM collection_image WHERE collection = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID());
 
@@ -1139,12 +1454,13 @@ int64_t Database::SelectCollectionImageCount(LockT& guard, const Collection& col
 }
 
 // ------------------------------------ //
-void Database::SelectIncorrectlyDeletedCollections(LockT& guard, std::vector<DBID>& result)
+void Database::SelectIncorrectlyDeletedCollections(DatabaseReadLock& reader, std::vector<DBID>& result)
 {
     const char str[] = "SELECT id FROM collections WHERE deleted = TRUE AND NOT EXISTS "
                        "(SELECT id FROM action_history WHERE json_data LIKE '%' || collections.id || '%');";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = reader.GetStatement(str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -1182,7 +1498,8 @@ void Database::SelectCollectionTags(
 
     const char str[] = "SELECT tag FROM collection_tag WHERE collection = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collectionLock->GetID());
 
@@ -1238,7 +1555,8 @@ void Database::InsertTagCollection(LockT& guard, Collection& collection, DBID ap
 {
     const char str[] = "INSERT INTO collection_tag (collection, tag) VALUES (?, ?);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID(), appliedtagid);
 
@@ -1254,7 +1572,8 @@ void Database::DeleteCollectionTag(LockT& guard, std::weak_ptr<Collection> colle
 
     const char str[] = "DELETE FROM collection_tag WHERE collection = ? AND tag = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collectionLock->GetID(), tag.GetID());
 
@@ -1275,17 +1594,18 @@ bool Database::InsertImageToCollection(LockT& guard, DBID collection, DBID image
     if (SelectIsImageInCollection(guard, collection, image))
         return false;
 
-    // Push back all show orders that are equal or more than showorder *if* there is a
-    // duplicate
+    // Place the image before the image that has showorder *if* there is one. This uses the
+    // gap between the show orders so that the other images don't need to be changed
     if (SelectImageIDInCollectionByShowOrder(guard, collection, showorder) != -1)
     {
-        UpdateShowOrdersInCollection(guard, collection, showorder);
+        showorder = _MakeSpaceBeforeShowOrder(guard, collection, showorder);
     }
 
     const char str[] = "INSERT INTO collection_image (collection, image, show_order) VALUES "
                        "(?1, ?2, ?3);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection, image, showorder);
 
@@ -1317,7 +1637,8 @@ bool Database::SelectIsImageInAnyCollection(LockT& guard, const Image& image)
 {
     const char str[] = "SELECT 1 FROM collection_image WHERE image = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(image.GetID());
 
@@ -1333,7 +1654,8 @@ bool Database::SelectIsImageInCollection(LockT& guard, DBID collection, DBID ima
 {
     const char str[] = "SELECT 1 FROM collection_image WHERE collection = ?1 AND image = ?2;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection, image);
 
@@ -1350,7 +1672,8 @@ int64_t Database::SelectCollectionCountImageIsIn(LockT& guard, const Image& imag
     // TODO: check against not deleted collections
     const char str[] = "SELECT COUNT(*) FROM collection_image WHERE image = ?1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(image.GetID());
 
@@ -1369,7 +1692,8 @@ bool Database::DeleteImageFromCollection(LockT& guard, Collection& collection, I
 
     const char str[] = "DELETE FROM collection_image WHERE collection = ?1 AND image = ?2;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID(), image.GetID());
 
@@ -1389,8 +1713,8 @@ bool Database::DeleteImageFromCollection(LockT& guard, Collection& collection, I
         auto uncategorized = SelectCollectionByID(guard, DATABASE_UNCATEGORIZED_COLLECTION_ID);
 
         if (uncategorized)
-            InsertImageToCollection(
-                guard, *uncategorized, image, SelectCollectionLargestShowOrder(guard, *uncategorized) + 1);
+            InsertImageToCollection(guard, *uncategorized, image,
+                SelectCollectionLargestShowOrder(guard, *uncategorized) + DATABASE_SHOW_ORDER_GAP);
     }
 
     return true;
@@ -1461,7 +1785,8 @@ std::vector<DBID> Database::SelectImagesThatWouldBecomeOrphanedWhenRemovedFromCo
     const char str[] = "SELECT a.image FROM collection_image a WHERE collection = ? AND (SELECT COUNT(*) "
                        "FROM collection_image b WHERE a.image == b.image) < 2 ORDER BY show_order ASC;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection);
 
@@ -1484,12 +1809,18 @@ int64_t Database::SelectImageShowOrderInCollection(LockT& guard, const Collectio
     if (!collection.IsInDatabase() || !image.IsInDatabase())
         return -1;
 
+    return SelectImageShowOrderInCollection(guard, collection.GetID(), image.GetID());
+}
+
+int64_t Database::SelectImageShowOrderInCollection(LockT& guard, DBID collection, DBID image)
+{
     const char str[] = "SELECT show_order FROM collection_image WHERE collection = ? AND "
                        "image = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
-    auto statementInUse = statementObj.Setup(collection.GetID(), image.GetID());
+    auto statementInUse = statementObj.Setup(collection, image);
 
     if (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
     {
@@ -1508,7 +1839,8 @@ std::shared_ptr<Image> Database::SelectImageInCollectionByShowOrder(
     const char str[] = "SELECT image FROM collection_image WHERE collection = ? AND "
                        "show_order = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID(), showorder);
 
@@ -1525,9 +1857,10 @@ std::shared_ptr<Image> Database::SelectImageInCollectionByShowOrder(
 DBID Database::SelectImageIDInCollectionByShowOrder(LockT& guard, DBID collection, int64_t showorder)
 {
     const char str[] = "SELECT image FROM collection_image WHERE collection = ? AND "
-                       "show_order = ?;";
+                       "show_order = ? ORDER BY image ASC LIMIT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection, showorder);
 
@@ -1549,23 +1882,21 @@ std::vector<std::shared_ptr<Image>> Database::SelectImagesInCollectionByShowOrde
 
     std::vector<std::shared_ptr<Image>> result;
 
-    const char str[] = "SELECT image FROM collection_image WHERE collection = ? AND "
-                       "show_order = ?;";
+    const char str[] = "SELECT pictures.* FROM collection_image INNER JOIN pictures ON "
+                       "pictures.id = collection_image.image WHERE collection_image.collection = ?1 AND "
+                       "collection_image.show_order = ?2 AND pictures.deleted IS NOT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID(), showorder);
 
     while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
     {
-        DBID id;
-        if (statementObj.GetObjectIDFromColumn(id, 0))
-        {
-            auto image = SelectImageByIDSkipDeleted(guard, id);
+        auto image = _LoadImageFromRow(guard, statementObj);
 
-            if (image)
-                result.push_back(image);
-        }
+        if (image)
+            result.push_back(image);
     }
 
     return result;
@@ -1577,7 +1908,8 @@ std::shared_ptr<Image> Database::SelectCollectionPreviewImage(const Collection&
 
     const char str[] = "SELECT preview_image FROM collections WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID());
 
@@ -1598,50 +1930,36 @@ std::shared_ptr<Image> Database::SelectCollectionPreviewImage(const Collection&
 
 std::shared_ptr<Image> Database::SelectFirstImageInCollection(LockT& guard, const Collection& collection)
 {
-    const char str[] = "SELECT image FROM collection_image WHERE collection = ? "
-                       "ORDER BY show_order ASC;";
+    const char str[] = "SELECT pictures.* FROM collection_image INNER JOIN pictures ON "
+                       "pictures.id = collection_image.image WHERE collection_image.collection = ?1 AND "
+                       "pictures.deleted IS NOT 1 ORDER BY collection_image.show_order ASC, collection_image.image ASC "
+                       "LIMIT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID());
 
-    while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
-    {
-        DBID id;
-
-        if (statementObj.GetObjectIDFromColumn(id, 0))
-        {
-            auto image = SelectImageByIDSkipDeleted(guard, id);
-
-            if (image)
-                return image;
-        }
-    }
+    if (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        return _LoadImageFromRow(guard, statementObj);
 
     return nullptr;
 }
 
 std::shared_ptr<Image> Database::SelectLastImageInCollection(LockT& guard, const Collection& collection)
 {
-    const char str[] = "SELECT image FROM collection_image WHERE collection = ? "
-                       "ORDER BY show_order DESC;";
+    const char str[] = "SELECT pictures.* FROM collection_image INNER JOIN pictures ON "
+                       "pictures.id = collection_image.image WHERE collection_image.collection = ?1 AND "
+                       "pictures.deleted IS NOT 1 ORDER BY collection_image.show_order DESC, "
+                       "collection_image.image DESC LIMIT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID());
 
-    while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
-    {
-        DBID id;
-
-        if (statementObj.GetObjectIDFromColumn(id, 0))
-        {
-            auto image = SelectImageByIDSkipDeleted(guard, id);
-
-            if (image)
-                return image;
-        }
-    }
+    if (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        return _LoadImageFromRow(guard, statementObj);
 
     return nullptr;
 }
@@ -1654,7 +1972,8 @@ int64_t Database::SelectImageShowIndexInCollection(const Collection& collection,
                        "AND show_order < ( SELECT show_order FROM collection_image WHERE collection = ?1 AND "
                        "image = ?2 );";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID(), image.GetID());
 
@@ -1673,7 +1992,8 @@ std::shared_ptr<Image> Database::SelectImageInCollectionByShowIndex(
     const char str[] = "SELECT * FROM collection_image WHERE collection = ? ORDER BY "
                        "show_order LIMIT 1 OFFSET ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID(), index);
 
@@ -1692,25 +2012,18 @@ std::shared_ptr<Image> Database::SelectNextImageInCollectionByShowOrder(const Co
 {
     GUARD_LOCK();
 
-    const char str[] = "SELECT image FROM collection_image WHERE collection = ?1 "
-                       "AND show_order - ?2 > 0 ORDER BY ABS(show_order - ?2);";
+    const char str[] = "SELECT pictures.* FROM collection_image INNER JOIN pictures ON "
+                       "pictures.id = collection_image.image WHERE collection_image.collection = ?1 AND "
+                       "collection_image.show_order > ?2 AND pictures.deleted IS NOT 1 "
+                       "ORDER BY collection_image.show_order ASC, collection_image.image ASC LIMIT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID(), showorder);
 
-    while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
-    {
-        DBID id;
-
-        if (statementObj.GetObjectIDFromColumn(id, 0))
-        {
-            auto image = SelectImageByIDSkipDeleted(guard, id);
-
-            if (image)
-                return image;
-        }
-    }
+    if (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        return _LoadImageFromRow(guard, statementObj);
 
     return nullptr;
 }
@@ -1720,25 +2033,18 @@ std::shared_ptr<Image> Database::SelectPreviousImageInCollectionByShowOrder(
 {
     GUARD_LOCK();
 
-    const char str[] = "SELECT image FROM collection_image WHERE collection = ?1 "
-                       "AND show_order - ?2 < 0 ORDER BY ABS(show_order - ?2);";
+    const char str[] = "SELECT pictures.* FROM collection_image INNER JOIN pictures ON "
+                       "pictures.id = collection_image.image WHERE collection_image.collection = ?1 AND "
+                       "collection_image.show_order < ?2 AND pictures.deleted IS NOT 1 "
+                       "ORDER BY collection_image.show_order DESC, collection_image.image DESC LIMIT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID(), showorder);
 
     if (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
-    {
-        DBID id;
-
-        if (statementObj.GetObjectIDFromColumn(id, 0))
-        {
-            auto image = SelectImageByIDSkipDeleted(guard, id);
-
-            if (image)
-                return image;
-        }
-    }
+        return _LoadImageFromRow(guard, statementObj);
 
     return nullptr;
 }
@@ -1746,51 +2052,73 @@ std::shared_ptr<Image> Database::SelectPreviousImageInCollectionByShowOrder(
 std::vector<std::shared_ptr<Image>> Database::SelectImagesInCollection(
     const Collection& collection, int32_t limit /*= -1*/)
 {
+    if (!collection.IsInDatabase())
+        return {};
+
     GUARD_LOCK();
 
     std::vector<std::shared_ptr<Image>> result;
 
-    const char str[] = "SELECT image FROM collection_image WHERE collection = ? "
-                       "ORDER BY show_order ASC;";
+    int64_t lastShowOrder = std::numeric_limits<int64_t>::min();
+    DBID lastImage = -1;
 
-    const char str2[] = "SELECT image FROM collection_image WHERE collection = ?1 "
-                        "ORDER BY show_order ASC LIMIT ?2;";
+    _SelectImagesInCollectionPage(guard, collection.GetID(), lastShowOrder, lastImage, limit > 0 ? limit : -1, result);
+    return result;
+}
 
-    const auto limitUsed = limit > 0;
+void Database::SelectImagesInCollectionPaged(const Collection& collection, int32_t pageSize,
+    const std::function<bool(std::vector<std::shared_ptr<Image>>&)>& callback)
+{
+    if (!collection.IsInDatabase())
+        return;
 
-    PreparedStatement statementObj(SQLiteDb, limitUsed ? str2 : str, limitUsed ? sizeof(str2) : sizeof(str));
+    if (pageSize < 1)
+        throw Leviathan::InvalidArgument("pageSize must be at least 1");
 
-    auto statementInUse =
-        limitUsed ? statementObj.Setup(collection.GetID(), limit) : statementObj.Setup(collection.GetID());
+    int64_t lastShowOrder = std::numeric_limits<int64_t>::min();
+    DBID lastImage = -1;
 
-    while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+    while (true)
     {
-        DBID id;
+        std::vector<std::shared_ptr<Image>> page;
+        page.reserve(pageSize);
 
-        if (statementObj.GetObjectIDFromColumn(id, 0))
-        {
-            auto image = SelectImageByIDSkipDeleted(guard, id);
+        size_t rows;
 
-            if (image)
-                result.push_back(image);
+        {
+            GUARD_LOCK();
+            rows = _SelectImagesInCollectionPage(guard, collection.GetID(), lastShowOrder, lastImage, pageSize, page);
         }
-    }
 
-    return result;
+        // Decided by the rows and not the loaded images so that a page with broken rows doesn't
+        // end the loading early
+        const auto lastPage = rows < static_cast<size_t>(pageSize);
+
+        if (!page.empty() && !callback(page))
+            return;
+
+        if (lastPage)
+            return;
+    }
 }
 
 std::vector<std::tuple<DBID, int64_t>> Database::SelectImageIDsAndShowOrderInCollection(const Collection& collection)
 {
     GUARD_LOCK();
+    return SelectImageIDsAndShowOrderInCollection(guard, collection.GetID());
+}
 
+std::vector<std::tuple<DBID, int64_t>> Database::SelectImageIDsAndShowOrderInCollection(LockT& guard, DBID collection)
+{
     std::vector<std::tuple<DBID, int64_t>> result;
 
     const char str[] = "SELECT image, show_order FROM collection_image WHERE collection = ? "
-                       "ORDER BY show_order ASC;";
+                       "ORDER BY show_order ASC, image ASC;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
-    auto statementInUse = statementObj.Setup(collection.GetID());
+    auto statementInUse = statementObj.Setup(collection);
 
     while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
     {
@@ -1816,7 +2144,8 @@ std::vector<std::tuple<DBID, int64_t>> Database::SelectCollectionIDsImageIsIn(Lo
 
     const char str[] = "SELECT collection, show_order FROM collection_image WHERE image = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(image);
 
@@ -1838,7 +2167,8 @@ int Database::UpdateShowOrdersInCollection(LockT& guard, DBID collection, int64_
     const char str[] = "UPDATE collection_image SET show_order = show_order + ?3 WHERE "
                        "collection = ?1 AND show_order >= ?2;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     statementObj.StepAll(statementObj.Setup(collection, startpoint, incrementby));
 
@@ -1850,13 +2180,38 @@ bool Database::UpdateCollectionImageShowOrder(LockT& guard, DBID collection, DBI
     const char str[] = "UPDATE collection_image SET show_order = ?3 WHERE "
                        "collection = ?1 AND image = ?2;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     statementObj.StepAll(statementObj.Setup(collection, image, showorder));
 
     return sqlite3_changes(SQLiteDb) == 1;
 }
 
+int Database::UpdateCollectionShowOrdersEvenly(LockT& guard, DBID collection)
+{
+    const auto before = SelectImageIDsAndShowOrderInCollection(guard, collection);
+
+    std::vector<ImageShowOrder> changes;
+    CalculateEvenShowOrders(before, changes);
+
+    if (!changes.empty())
+    {
+        DoDBSavePoint transaction(*this, guard, "renumber_show_orders");
+        transaction.AllowCommit(false);
+
+        _UpdateCollectionShowOrders(guard, collection, changes);
+
+        // Undoing earlier actions must still put the images in the same places
+        _TranslateRenumberedShowOrdersInActions(guard, collection, before);
+
+        transaction.AllowCommit(true);
+    }
+
+    PendingShowOrderRenumbers.erase(collection);
+    return static_cast<int>(changes.size());
+}
+
 std::shared_ptr<DatabaseAction> Database::UpdateCollectionImagesOrder(
     Collection& collection, const std::vector<std::shared_ptr<Image>>& neworder)
 {
@@ -1909,7 +2264,8 @@ size_t Database::CountExistingTags()
 
     const char str[] = "SELECT COUNT(*) FROM tags WHERE deleted IS NOT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -1927,7 +2283,8 @@ size_t Database::CountDatabaseActions()
 
     const char str[] = "SELECT COUNT(*) FROM action_history;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -1945,7 +2302,8 @@ std::shared_ptr<Folder> Database::SelectRootFolder(LockT& guard)
 {
     const char str[] = "SELECT * FROM virtual_folders WHERE id = 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -1962,7 +2320,8 @@ std::shared_ptr<Folder> Database::SelectFolderByID(LockT& guard, DBID id)
 {
     const char str[] = "SELECT * FROM virtual_folders WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -1975,12 +2334,13 @@ std::shared_ptr<Folder> Database::SelectFolderByID(LockT& guard, DBID id)
 }
 
 // ------------------------------------ //
-void Database::SelectIncorrectlyDeletedFolders(LockT& guard, std::vector<DBID>& result)
+void Database::SelectIncorrectlyDeletedFolders(DatabaseReadLock& reader, std::vector<DBID>& result)
 {
     const char str[] = "SELECT id FROM virtual_folders WHERE deleted = TRUE AND NOT EXISTS "
                        "(SELECT id FROM action_history WHERE json_data LIKE '%' || virtual_folders.id || '%');";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = reader.GetStatement(str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -2013,7 +2373,8 @@ std::shared_ptr<Folder> Database::InsertFolder(std::string name, bool isprivate,
     const char str[] = "INSERT INTO virtual_folders (name, is_private) VALUES "
                        "(?1, ?2);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(name, isprivate);
 
@@ -2033,7 +2394,8 @@ bool Database::UpdateFolder(LockT& guard, Folder& folder)
 {
     const char str[] = "UPDATE virtual_folders SET name = ?2, is_private = ?3 WHERE id = ?1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     statementObj.StepAll(statementObj.Setup(folder.GetID(), folder.GetName(), folder.GetIsPrivate()));
 
@@ -2096,7 +2458,8 @@ bool Database::InsertCollectionToFolder(LockT& guard, Folder& folder, const Coll
 
     const char str[] = "INSERT INTO folder_collection (parent, child) VALUES(?, ?);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(folder.GetID(), collection.GetID());
 
@@ -2110,7 +2473,8 @@ void Database::DeleteCollectionFromFolder(LockT& guard, Folder& folder, const Co
 {
     const char str[] = "DELETE FROM folder_collection WHERE parent = ? AND child = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(folder.GetID(), collection.GetID());
 
@@ -2159,7 +2523,8 @@ std::vector<std::shared_ptr<Collection>> Database::SelectCollectionsOnlyInFolder
                        "folder_collection f2 INNER JOIN virtual_folders v2 on f2.parent = "
                        "v2.id WHERE f2.child == f1.child AND v2.deleted IS NOT TRUE) < 2;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(folder.GetID());
 
@@ -2176,7 +2541,8 @@ bool Database::SelectCollectionIsInFolder(LockT& guard, const Collection& collec
 {
     const char str[] = "SELECT 1 FROM folder_collection WHERE child = ? LIMIT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID());
 
@@ -2193,7 +2559,8 @@ bool Database::SelectCollectionIsInAnotherFolder(LockT& guard, const Folder& fol
     const char str[] = "SELECT 1 FROM folder_collection WHERE child = ? AND parent != ? "
                        "LIMIT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID(), folder.GetID());
 
@@ -2213,7 +2580,8 @@ std::vector<DBID> Database::SelectFoldersCollectionIsIn(const Collection& collec
     std::vector<DBID> result;
     const char str[] = "SELECT parent FROM folder_collection WHERE child = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID());
 
@@ -2240,7 +2608,8 @@ void Database::DeleteCollectionFromRootIfInAnotherFolder(const Collection& colle
 
     const char str[] = "DELETE FROM folder_collection WHERE child = ? AND parent = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(collection.GetID(), root.GetID());
 
@@ -2277,7 +2646,8 @@ void Database::InsertFolderToFolder(LockT& guard, Folder& folder, const Folder&
 
     const char str[] = "INSERT INTO folder_folder (parent, child) VALUES(?, ?);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(parent.GetID(), folder.GetID());
 
@@ -2304,7 +2674,8 @@ bool Database::DeleteFolderFromFolder(LockT& guard, Folder& folder, const Folder
 {
     const char str[] = "DELETE FROM folder_folder WHERE parent == ?1 AND child == ?2;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(parent.GetID(), folder.GetID());
 
@@ -2321,7 +2692,8 @@ int64_t Database::SelectFolderParentCount(LockT& guard, Folder& folder)
     const char str[] = "SELECT COUNT(*) FROM folder_folder ff LEFT JOIN virtual_folders vf on "
                        "ff.parent = vf.id WHERE ff.child = ? AND vf.deleted IS NOT TRUE;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(folder.GetID());
 
@@ -2343,7 +2715,8 @@ std::vector<std::shared_ptr<Folder>> Database::SelectFoldersFolderIsIn(LockT& gu
     const char str[] = "SELECT vf.* FROM folder_folder ff INNER JOIN virtual_folders vf on "
                        "ff.parent = vf.id WHERE ff.child = ? AND vf.deleted IS NOT TRUE;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(folder.GetID());
 
@@ -2365,7 +2738,8 @@ std::shared_ptr<Folder> Database::SelectFolderByNameAndParent(
                        "LEFT JOIN virtual_folders ON id = child WHERE parent = ?1 AND name = "
                        "?2 AND DELETED IS NOT TRUE;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(parent.GetID(), name);
 
@@ -2384,7 +2758,8 @@ std::vector<DBID> Database::SelectFolderParents(const Folder& folder)
     std::vector<DBID> result;
     const char str[] = "SELECT parent FROM folder_folder WHERE child = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(folder.GetID());
 
@@ -2405,7 +2780,8 @@ std::shared_ptr<Folder> Database::SelectFirstParentFolderWithChildFolderNamed(
                        "virtual_folders.id WHERE name == ?2 AND (SELECT TRUE FROM folder_folder b WHERE "
                        "b.parent == b.parent AND b.child == ?1);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(parentsOf.GetID(), name);
 
@@ -2460,7 +2836,8 @@ std::vector<std::shared_ptr<Folder>> Database::SelectFoldersOnlyInFolder(LockT&
                        "folder_folder f2 INNER JOIN virtual_folders v2 on f2.parent = v2.id "
                        "WHERE f2.child == f1.child AND v2.deleted IS NOT TRUE) < 2;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(folder.GetID());
 
@@ -2482,20 +2859,36 @@ std::shared_ptr<Tag> Database::InsertTag(
     const char str[] = "INSERT INTO tags (name, category, description, is_private) VALUES "
                        "(?, ?, ?, ?);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(name, static_cast<int64_t>(category), description, isprivate);
 
     statementObj.StepAll(statementInUse);
 
-    return SelectTagByID(guard, sqlite3_last_insert_rowid(SQLiteDb));
+    auto tag = SelectTagByID(guard, sqlite3_last_insert_rowid(SQLiteDb));
+
+    // Added directly so that importing a lot of new tags doesn't rebuild the dictionary each time
+    if (tag && TagNamesValid)
+    {
+        const auto key = StringToLower(tag->GetName());
+
+        TagNames.AddTag(key, tag, false);
+        TagCompletions.Add(tag->GetName(), key, 0);
+    }
+
+    DualView::Get().QueueDBThreadFunction(
+        []() { DualView::Get().GetEvents().FireEvent(CHANGED_EVENT::TAGS_CHANGED); });
+
+    return tag;
 }
 
 std::shared_ptr<Tag> Database::SelectTagByID(LockT& guard, DBID id)
 {
     const char str[] = "SELECT * FROM tags WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -2511,7 +2904,8 @@ std::shared_ptr<Tag> Database::SelectTagByName(LockT& guard, const std::string&
 {
     const char str[] = "SELECT * FROM tags WHERE name = ? AND deleted IS NOT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(name);
 
@@ -2534,7 +2928,8 @@ std::vector<std::shared_ptr<Tag>> Database::SelectTagsWildcard(
         const char str[] = "SELECT * FROM tags WHERE name LIKE ? AND deleted IS NOT 1 "
                            "ORDER BY name LIMIT ?;";
 
-        PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
         auto statementInUse = statementObj.Setup("%" + pattern + "%", max);
 
@@ -2550,7 +2945,8 @@ std::vector<std::shared_ptr<Tag>> Database::SelectTagsWildcard(
                            "tags.id = tag_aliases.meant_tag WHERE tag_aliases.name LIKE ?1 "
                            "ORDER BY tag_aliases.name LIMIT ?2;";
 
-        PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
         // The limit guarantees at least one alias
         auto statementInUse = statementObj.Setup("%" + pattern + "%", static_cast<int64_t>(1 + (max - result.size())));
@@ -2598,7 +2994,8 @@ std::shared_ptr<Tag> Database::SelectTagByAlias(LockT& guard, const std::string&
                        "LEFT JOIN tags ON tags.id = tag_aliases.meant_tag WHERE tag_aliases.name = ? AND "
                        "tags.deleted IS NOT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(alias);
 
@@ -2614,30 +3011,248 @@ std::shared_ptr<Tag> Database::SelectTagByNameOrAlias(const std::string& name)
 {
     GUARD_LOCK();
 
-    auto tag = SelectTagByName(guard, name);
-
-    if (tag)
-        return tag;
+    const auto entry = _FindInTagDictionary(guard, name);
 
-    return SelectTagByAlias(guard, name);
+    return entry ? entry->MatchedTag : nullptr;
 }
 
 std::string Database::SelectTagSuperAlias(const std::string& name)
 {
     GUARD_LOCK();
 
-    const char str[] = "SELECT expanded FROM tag_super_aliases WHERE alias = ?;";
+    const auto entry = _FindInTagDictionary(guard, name);
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    return entry ? entry->SuperAlias : "";
+}
 
-    auto statementInUse = statementObj.Setup(name);
+void Database::_LoadTagUseCounts(LockT& guard)
+{
+    TagUseCounts.clear();
+    ModifierUseCounts.clear();
 
-    if (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
     {
-        return statementObj.GetColumnAsString(0);
+        const char str[] = "SELECT applied_tag.tag, COUNT(*) FROM image_tag "
+                           "JOIN applied_tag ON applied_tag.id = image_tag.tag GROUP BY applied_tag.tag;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            DBID id;
+
+            if (statementObj.GetObjectIDFromColumn(id, 0))
+                TagUseCounts[id] = statementObj.GetColumnAsInt64(1);
+        }
     }
 
-    return "";
+    {
+        const char str[] = "SELECT applied_tag_modifier.modifier, COUNT(*) FROM image_tag "
+                           "JOIN applied_tag_modifier ON applied_tag_modifier.to_tag = image_tag.tag "
+                           "GROUP BY applied_tag_modifier.modifier;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            DBID id;
+
+            if (statementObj.GetObjectIDFromColumn(id, 0))
+                ModifierUseCounts[id] = statementObj.GetColumnAsInt64(1);
+        }
+    }
+
+    TagUseCountsLoaded = true;
+}
+
+void Database::_ChangeTagUseCount(LockT& guard, const AppliedTag& tag, int64_t change)
+{
+    // Nothing to update until the counts are loaded with the dictionary
+    if (!TagUseCountsLoaded)
+        return;
+
+    if (const auto mainTag = tag.GetTag(); mainTag)
+    {
+        const auto uses = TagUseCounts[mainTag->GetID()] += change;
+
+        if (TagNamesValid)
+            TagCompletions.SetUses(mainTag->GetName(), uses);
+    }
+
+    for (const auto& modifier : tag.GetModifiers())
+    {
+        const auto uses = ModifierUseCounts[modifier->GetID()] += change;
+
+        if (TagNamesValid)
+            TagCompletions.SetUses(modifier->GetName(), uses);
+    }
+}
+
+void Database::BuildTagDictionary(LockT& guard)
+{
+    TagNames.Clear();
+    TagCompletions.Clear();
+
+    // Aliases refer to the tags and modifiers by id
+    std::unordered_map<DBID, std::shared_ptr<Tag>> tags;
+    std::unordered_map<DBID, std::shared_ptr<TagModifier>> modifiers;
+
+    // Suggestions are ranked by how many images use the tags and modifiers. Counting goes
+    // through all the applied tags so it is only done once, after that the counts are updated
+    // as tags are added to and removed from images
+    if (!TagUseCountsLoaded)
+        _LoadTagUseCounts(guard);
+
+    const auto usesOf = [](const std::unordered_map<DBID, int64_t>& counts, DBID id) -> int64_t {
+        const auto found = counts.find(id);
+        return found != counts.end() ? found->second : 0;
+    };
+
+    {
+        const char str[] = "SELECT * FROM tags WHERE deleted IS NOT 1 ORDER BY id;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            auto tag = _LoadTagFromRow(guard, statementObj);
+            const auto key = StringToLower(tag->GetName());
+
+            TagNames.AddTag(key, tag, false);
+            TagCompletions.Add(tag->GetName(), key, usesOf(TagUseCounts, tag->GetID()));
+            tags[tag->GetID()] = tag;
+        }
+    }
+
+    {
+        const char str[] = "SELECT name, meant_tag FROM tag_aliases ORDER BY rowid;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            DBID id;
+
+            if (!statementObj.GetObjectIDFromColumn(id, 1))
+                continue;
+
+            // Aliases of deleted tags aren't found
+            const auto tag = tags.find(id);
+
+            if (tag == tags.end())
+                continue;
+
+            const auto alias = statementObj.GetColumnAsString(0);
+            const auto key = StringToLower(alias);
+
+            TagNames.AddTag(key, tag->second, true);
+            TagCompletions.Add(alias, key, usesOf(TagUseCounts, id));
+        }
+    }
+
+    {
+        const char str[] = "SELECT * FROM tag_modifiers WHERE deleted IS NOT 1 ORDER BY id;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            auto modifier = _LoadTagModifierFromRow(guard, statementObj);
+            const auto key = StringToLower(modifier->GetName());
+
+            TagNames.AddModifier(key, modifier, false);
+            TagCompletions.Add(modifier->GetName(), key, usesOf(ModifierUseCounts, modifier->GetID()));
+            modifiers[modifier->GetID()] = modifier;
+        }
+    }
+
+    {
+        const char str[] = "SELECT name, meant_modifier FROM tag_modifier_aliases ORDER BY rowid;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            DBID id;
+
+            if (!statementObj.GetObjectIDFromColumn(id, 1))
+                continue;
+
+            const auto modifier = modifiers.find(id);
+
+            if (modifier == modifiers.end())
+                continue;
+
+            const auto alias = statementObj.GetColumnAsString(0);
+            const auto key = StringToLower(alias);
+
+            TagNames.AddModifier(key, modifier->second, true);
+            TagCompletions.Add(alias, key, usesOf(ModifierUseCounts, id));
+        }
+    }
+
+    {
+        const char str[] = "SELECT * FROM common_composite_tags ORDER BY id;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            const auto text = statementObj.GetColumnAsString(1);
+            const auto pattern = StringToLower(text);
+
+            TagNames.AddBreakRule(pattern, _LoadTagBreakRuleFromRow(guard, statementObj));
+
+            // Break rules are suggested when the pattern without the wildcard matches
+            auto key = pattern;
+            key.erase(std::remove(key.begin(), key.end(), '*'), key.end());
+
+            TagCompletions.Add(text, key, 0);
+        }
+    }
+
+    {
+        const char str[] = "SELECT alias, expanded FROM tag_super_aliases ORDER BY rowid;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            const auto alias = statementObj.GetColumnAsString(0);
+            const auto key = StringToLower(alias);
+
+            TagNames.AddSuperAlias(key, statementObj.GetColumnAsString(1));
+            TagCompletions.Add(alias, key, 0);
+        }
+    }
+
+    TagNamesValid = true;
+
+    LOG_INFO("Database: tag dictionary has " + std::to_string(TagNames.GetEntryCount()) + " entries and " +
+        std::to_string(TagCompletions.GetCount()) + " suggestions");
 }
 
 void Database::UpdateTag(Tag& tag)
@@ -2650,12 +3265,14 @@ void Database::UpdateTag(Tag& tag)
     const char str[] = "UPDATE tags SET name = ?, category = ?, description = ?, "
                        "is_private = ?, deleted = NULL WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(
         tag.GetName(), static_cast<int64_t>(tag.GetCategory()), tag.GetDescription(), tag.GetIsPrivate(), tag.GetID());
 
     statementObj.StepAll(statementInUse);
+    _OnTagNamesChanged(guard);
 }
 
 bool Database::InsertTagAlias(Tag& tag, const std::string& alias)
@@ -2668,7 +3285,8 @@ bool Database::InsertTagAlias(Tag& tag, const std::string& alias)
     {
         const char str[] = "SELECT * FROM tag_aliases WHERE name = ?;";
 
-        PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
         auto statementInUse = statementObj.Setup(alias);
 
@@ -2680,11 +3298,14 @@ bool Database::InsertTagAlias(Tag& tag, const std::string& alias)
 
     const char str[] = "INSERT INTO tag_aliases (name, meant_tag) VALUES (?, ?);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(alias, tag.GetID());
 
     statementObj.StepAll(statementInUse);
+
+    _OnTagNamesChanged(guard);
     return true;
 }
 
@@ -2694,11 +3315,14 @@ void Database::DeleteTagAlias(const std::string& alias)
 
     const char str[] = "DELETE FROM tag_aliases WHERE name = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(alias);
 
     statementObj.StepAll(statementInUse);
+
+    _OnTagNamesChanged(guard);
 }
 
 void Database::DeleteTagAlias(const Tag& tag, const std::string& alias)
@@ -2707,11 +3331,14 @@ void Database::DeleteTagAlias(const Tag& tag, const std::string& alias)
 
     const char str[] = "DELETE FROM tag_aliases WHERE name = ? AND meant_tag = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(alias, tag.GetID());
 
     statementObj.StepAll(statementInUse);
+
+    _OnTagNamesChanged(guard);
 }
 
 std::vector<std::string> Database::SelectTagAliases(const Tag& tag)
@@ -2722,7 +3349,8 @@ std::vector<std::string> Database::SelectTagAliases(const Tag& tag)
 
     const char str[] = "SELECT name FROM tag_aliases WHERE meant_tag = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(tag.GetID());
 
@@ -2741,7 +3369,8 @@ bool Database::InsertTagImply(Tag& tag, const Tag& implied)
     {
         const char str[] = "SELECT 1 FROM tag_implies WHERE primary_tag = ? AND to_apply = ?;";
 
-        PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
         auto statementInUse = statementObj.Setup(tag.GetID(), implied.GetID());
 
@@ -2753,7 +3382,8 @@ bool Database::InsertTagImply(Tag& tag, const Tag& implied)
 
     const char str[] = "INSERT INTO tag_implies (primary_tag, to_apply) VALUES (?, ?);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(tag.GetID(), implied.GetID());
 
@@ -2767,7 +3397,8 @@ void Database::DeleteTagImply(Tag& tag, const Tag& implied)
 
     const char str[] = "DELETE FROM tag_implies WHERE primary_tag = ? AND to_apply = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(tag.GetID(), implied.GetID());
 
@@ -2803,7 +3434,8 @@ std::vector<DBID> Database::SelectTagImplies(LockT& guard, const Tag& tag)
 
     const char str[] = "SELECT to_apply FROM tag_implies WHERE primary_tag = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(tag.GetID());
 
@@ -2827,7 +3459,8 @@ std::shared_ptr<AppliedTag> Database::SelectAppliedTagByID(LockT& guard, DBID id
 {
     const char str[] = "SELECT * FROM applied_tag WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -2853,7 +3486,8 @@ DBID Database::SelectExistingAppliedTagID(LockT& guard, const AppliedTag& tag)
 {
     const char str[] = "SELECT id FROM applied_tag WHERE tag = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(tag.GetTag()->GetID());
 
@@ -2885,7 +3519,8 @@ std::vector<std::shared_ptr<TagModifier>> Database::SelectAppliedTagModifiers(
 
     const char str[] = "SELECT modifier FROM applied_tag_modifier WHERE to_tag = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(appliedtag.GetID());
 
@@ -2907,7 +3542,8 @@ std::tuple<std::string, std::shared_ptr<AppliedTag>> Database::SelectAppliedTagC
 {
     const char str[] = "SELECT * FROM applied_tag_combine WHERE tag_left = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(appliedtag.GetID());
 
@@ -2934,7 +3570,8 @@ bool Database::InsertAppliedTag(LockT& guard, AppliedTag& tag)
     {
         const char str[] = "INSERT INTO applied_tag (tag) VALUES (?);";
 
-        PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
         auto statementInUse = statementObj.Setup(tag.GetTag()->GetID());
 
@@ -2986,7 +3623,8 @@ bool Database::InsertAppliedTag(LockT& guard, AppliedTag& tag)
             const char str[] = "INSERT INTO applied_tag_combine (tag_left, tag_right, "
                                "combined_with) VALUES (?, ?, ?);";
 
-            PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+            auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+            auto& statementObj = *cachedStatement;
 
             auto statementInUse = statementObj.Setup(id, otherid, combinestr);
 
@@ -3011,7 +3649,8 @@ bool Database::InsertAppliedTag(LockT& guard, AppliedTag& tag)
         const char str[] = "INSERT INTO applied_tag_modifier (to_tag, modifier) "
                            "VALUES (?, ?);";
 
-        PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
         auto statementInUse = statementObj.Setup(id, modifier->GetID());
 
@@ -3037,7 +3676,8 @@ void Database::DeleteAppliedTagIfNotUsed(LockT& guard, AppliedTag& tag)
     // Not used, delete //
     const char str[] = "DELETE FROM applied_tag WHERE id = ?1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(tag.GetID());
 
@@ -3052,7 +3692,8 @@ bool Database::SelectIsAppliedTagUsed(LockT& guard, DBID id)
     {
         const char str[] = "SELECT 1 FROM image_tag WHERE tag = ? LIMIT 1;";
 
-        PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
         auto statementInUse = statementObj.Setup(id);
 
@@ -3067,7 +3708,8 @@ bool Database::SelectIsAppliedTagUsed(LockT& guard, DBID id)
     {
         const char str[] = "SELECT 1 FROM collection_tag WHERE tag = ? LIMIT 1;";
 
-        PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
         auto statementInUse = statementObj.Setup(id);
 
@@ -3083,7 +3725,8 @@ bool Database::SelectIsAppliedTagUsed(LockT& guard, DBID id)
         const char str[] = "SELECT 1 FROM applied_tag_combine WHERE tag_left = ?1 OR "
                            "tag_right = ?1 LIMIT 1;";
 
-        PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
         auto statementInUse = statementObj.Setup(id);
 
@@ -3101,7 +3744,8 @@ bool Database::CheckDoesAppliedTagModifiersMatch(LockT& guard, DBID id, const Ap
 {
     const char str[] = "SELECT modifier FROM applied_tag_modifier WHERE to_tag = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -3179,7 +3823,8 @@ bool Database::CheckDoesAppliedTagCombinesMatch(LockT& guard, DBID id, const App
 
     const char str[] = "SELECT * FROM applied_tag_combine WHERE tag_left = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -3222,7 +3867,8 @@ DBID Database::SelectAppliedTagIDByOffset(LockT& guard, int64_t offset)
 {
     const char str[] = "SELECT id FROM applied_tag ORDER BY id ASC LIMIT 1 OFFSET ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(offset);
 
@@ -3256,6 +3902,9 @@ void Database::CombineAppliedTagDuplicate(LockT& guard, DBID first, DBID second)
 
     RunSQLAsPrepared(guard, "DELETE FROM image_tag WHERE tag = ?;", second);
 
+    if (ImageTagIndexLoaded)
+        ImageTagIndex.MergeTags(first, second);
+
     // combine left side
     RunSQLAsPrepared(guard,
         "UPDATE applied_tag_combine SET tag_left = ?1 "
@@ -3278,7 +3927,8 @@ void Database::CombineAppliedTagDuplicate(LockT& guard, DBID first, DBID second)
     // And the delete it //
     const char str[] = "DELETE FROM applied_tag WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(second);
 
@@ -3292,7 +3942,8 @@ std::shared_ptr<TagModifier> Database::SelectTagModifierByID(LockT& guard, DBID
 {
     const char str[] = "SELECT * FROM tag_modifiers WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -3308,7 +3959,8 @@ std::shared_ptr<TagModifier> Database::SelectTagModifierByName(LockT& guard, con
 {
     const char str[] = "SELECT * FROM tag_modifiers WHERE name = ? AND deleted IS NOT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(name);
 
@@ -3326,7 +3978,8 @@ std::shared_ptr<TagModifier> Database::SelectTagModifierByAlias(LockT& guard, co
                        "LEFT JOIN tag_modifiers ON tag_modifiers.id = tag_modifier_aliases.meant_modifier "
                        "WHERE tag_modifier_aliases.name = ? AND tag_modifiers.deleted IS NOT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(alias);
 
@@ -3340,12 +3993,9 @@ std::shared_ptr<TagModifier> Database::SelectTagModifierByAlias(LockT& guard, co
 
 std::shared_ptr<TagModifier> Database::SelectTagModifierByNameOrAlias(LockT& guard, const std::string& name)
 {
-    auto tag = SelectTagModifierByName(guard, name);
-
-    if (tag)
-        return tag;
+    const auto entry = _FindInTagDictionary(guard, name);
 
-    return SelectTagModifierByAlias(guard, name);
+    return entry ? entry->Modifier : nullptr;
 }
 
 void Database::UpdateTagModifier(const TagModifier& modifier)
@@ -3358,12 +4008,15 @@ void Database::UpdateTagModifier(const TagModifier& modifier)
     const char str[] = "UPDATE tag_modifiers SET name = ?, description = ?, "
                        "is_private = ? WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse =
         statementObj.Setup(modifier.GetName(), modifier.GetDescription(), modifier.GetIsPrivate(), modifier.GetID());
 
     statementObj.StepAll(statementInUse);
+
+    _OnTagNamesChanged(guard);
 }
 
 //
@@ -3373,7 +4026,8 @@ std::shared_ptr<TagBreakRule> Database::SelectTagBreakRuleByExactPattern(LockT&
 {
     const char str[] = "SELECT * FROM common_composite_tags WHERE tag_string = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(pattern);
 
@@ -3389,24 +4043,10 @@ std::shared_ptr<TagBreakRule> Database::SelectTagBreakRuleByStr(const std::strin
 {
     GUARD_LOCK();
 
-    auto exact = SelectTagBreakRuleByExactPattern(guard, searchstr);
-
-    if (exact)
-        return exact;
-
-    const char str[] = "SELECT * FROM common_composite_tags WHERE "
-                       "REPLACE(tag_string, '*', '') = ?;";
-
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
-
-    auto statementInUse = statementObj.Setup(searchstr);
-
-    if (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
-    {
-        return _LoadTagBreakRuleFromRow(guard, statementObj);
-    }
+    // The dictionary has the rules both by their exact pattern and without the wildcard
+    const auto entry = _FindInTagDictionary(guard, searchstr);
 
-    return nullptr;
+    return entry ? entry->BreakRule : nullptr;
 }
 
 std::vector<std::shared_ptr<TagModifier>> Database::SelectModifiersForBreakRule(LockT& guard, const TagBreakRule& rule)
@@ -3415,7 +4055,8 @@ std::vector<std::shared_ptr<TagModifier>> Database::SelectModifiersForBreakRule(
 
     const char str[] = "SELECT modifier FROM composite_tag_modifiers WHERE composite = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(rule.GetID());
 
@@ -3469,7 +4110,8 @@ std::shared_ptr<NetGallery> Database::SelectNetGalleryByID(LockT& guard, DBID id
 {
     const char str[] = "SELECT * FROM net_gallery WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -3482,12 +4124,13 @@ std::shared_ptr<NetGallery> Database::SelectNetGalleryByID(LockT& guard, DBID id
 }
 
 // ------------------------------------ //
-void Database::SelectIncorrectlyDeletedNetGalleries(LockT& guard, std::vector<DBID>& result)
+void Database::SelectIncorrectlyDeletedNetGalleries(DatabaseReadLock& reader, std::vector<DBID>& result)
 {
     const char str[] = "SELECT id FROM net_gallery WHERE deleted = TRUE AND NOT EXISTS "
                        "(SELECT id FROM action_history WHERE json_data LIKE '%' || net_gallery.id || '%');";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = reader.GetStatement(str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -3508,7 +4151,8 @@ bool Database::InsertNetGallery(LockT& guard, std::shared_ptr<NetGallery> galler
     const char str[] = "INSERT INTO net_gallery (gallery_url, target_path, gallery_name, "
                        "currently_scanned, is_downloaded, tags_string) VALUES (?, ?, ?, ?, ?, ?);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse =
         statementObj.Setup(gallery->GetGalleryURL(), gallery->GetTargetPath(), gallery->GetTargetGalleryName(),
@@ -3536,7 +4180,8 @@ void Database::UpdateNetGallery(NetGallery& gallery)
                        "gallery_name = ?, currently_scanned = ?, is_downloaded = ?, tags_string = ? "
                        "WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse =
         statementObj.Setup(gallery.GetGalleryURL(), gallery.GetTargetPath(), gallery.GetTargetGalleryName(),
@@ -3600,7 +4245,8 @@ std::shared_ptr<NetFile> Database::SelectNetFileByID(LockT& guard, DBID id)
 {
     const char str[] = "SELECT * FROM net_files WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -3620,7 +4266,8 @@ void Database::InsertNetFile(LockT& guard, NetFile& netfile, NetGallery& gallery
     const char str[] = "INSERT INTO net_files (file_url, page_referrer, preferred_name, "
                        "tags_string, belongs_to_gallery) VALUES (?, ?, ?, ?, ?);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(netfile.GetRawURL(), netfile.GetPageReferrer(), netfile.GetPreferredName(),
         netfile.GetTagsString(), gallery.GetID());
@@ -3636,7 +4283,8 @@ void Database::UpdateNetFile(NetFile& netfile)
     const char str[] = "UPDATE net_files SET file_url = ?, referrer = ?, preferred_name = ?, "
                        "tags_string = ?, belongs_to_gallery = ? WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(netfile.GetRawURL(), netfile.GetPageReferrer(), netfile.GetPreferredName(),
         netfile.GetTagsString(), netfile.GetID());
@@ -3650,7 +4298,8 @@ void Database::DeleteNetFile(NetFile& netfile)
 
     const char str[] = "DELETE FROM net_files WHERE id = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(netfile.GetID());
 
@@ -3660,86 +4309,14 @@ void Database::DeleteNetFile(NetFile& netfile)
 //
 // Wilcard searches for tag suggestions
 //
-//! \brief Returns text of all break rules that contain str
-void Database::SelectTagBreakRulesByStrWildcard(std::vector<std::string>& breakrules, const std::string& pattern)
-{
-    GUARD_LOCK();
-
-    const char str[] = "SELECT tag_string FROM common_composite_tags WHERE "
-                       "REPLACE(tag_string, '*', '') LIKE ?;";
-
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
-
-    auto statementInUse = statementObj.Setup("%" + pattern + "%");
-
-    while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
-    {
-        breakrules.push_back(statementObj.GetColumnAsString(0));
-    }
-}
-
-void Database::SelectTagNamesWildcard(std::vector<std::string>& result, const std::string& pattern)
+void Database::SelectTagSuggestions(std::vector<std::string>& result, const std::string& pattern, size_t max)
 {
     GUARD_LOCK();
 
-    const char str[] = "SELECT name FROM tags WHERE name LIKE ? AND deleted IS NOT 1;";
+    if (!TagNamesValid)
+        BuildTagDictionary(guard);
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
-
-    auto statementInUse = statementObj.Setup("%" + pattern + "%");
-
-    while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
-    {
-        result.push_back(statementObj.GetColumnAsString(0));
-    }
-}
-
-void Database::SelectTagAliasesWildcard(std::vector<std::string>& result, const std::string& pattern)
-{
-    GUARD_LOCK();
-
-    const char str[] = "SELECT name FROM tag_aliases WHERE name LIKE ?;";
-
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
-
-    auto statementInUse = statementObj.Setup("%" + pattern + "%");
-
-    while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
-    {
-        result.push_back(statementObj.GetColumnAsString(0));
-    }
-}
-
-void Database::SelectTagModifierNamesWildcard(std::vector<std::string>& result, const std::string& pattern)
-{
-    GUARD_LOCK();
-
-    const char str[] = "SELECT name FROM tag_modifiers WHERE name LIKE ? AND deleted IS NOT 1;";
-
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
-
-    auto statementInUse = statementObj.Setup("%" + pattern + "%");
-
-    while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
-    {
-        result.push_back(statementObj.GetColumnAsString(0));
-    }
-}
-
-void Database::SelectTagSuperAliasWildcard(std::vector<std::string>& result, const std::string& pattern)
-{
-    GUARD_LOCK();
-
-    const char str[] = "SELECT alias FROM tag_super_aliases WHERE alias LIKE ?;";
-
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
-
-    auto statementInUse = statementObj.Setup("%" + pattern + "%");
-
-    while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
-    {
-        result.push_back(statementObj.GetColumnAsString(0));
-    }
+    TagCompletions.Find(result, StringToLower(pattern), max);
 }
 
 // ------------------------------------ //
@@ -3803,7 +4380,8 @@ std::shared_ptr<DatabaseAction> Database::SelectDatabaseActionByID(LockT& guard,
 {
     const char str[] = "SELECT * FROM action_history WHERE id = ?1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup(id);
 
@@ -3819,7 +4397,8 @@ std::shared_ptr<DatabaseAction> Database::SelectOldestDatabaseAction(LockT& guar
 {
     const char str[] = "SELECT * FROM action_history ORDER BY id ASC LIMIT 1;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -3883,7 +4462,8 @@ bool Database::UpdateDatabaseAction(LockT& guard, DatabaseAction& action)
     const char str[] = "UPDATE action_history SET performed = ?1, json_data = ?2, description "
                        "= ?3 WHERE id = ?4;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse =
         statementObj.Setup(action.IsPerformed(), action.SerializeData(), action.GenerateDescription(), action.GetID());
@@ -3952,7 +4532,8 @@ void Database::InsertIgnorePairs(const std::vector<std::tuple<DBID, DBID>>& pair
 
     const char str[] = "INSERT INTO ignored_duplicates (primary_image, other_image) VALUES (?1, ?2);";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     for (const auto& pair : pairs)
     {
@@ -3968,7 +4549,8 @@ void Database::DeleteIgnorePairs(const std::vector<std::tuple<DBID, DBID>>& pair
 
     const char str[] = "DELETE FROM ignored_duplicates WHERE primary_image = ?1 AND other_image = ?2;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     for (const auto& pair : pairs)
     {
@@ -3992,7 +4574,8 @@ void Database::CombineAllPossibleAppliedTags(LockT& guard)
     {
         const char str[] = "SELECT COUNT(*) FROM applied_tag;";
 
-        PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
 
         auto statementInUse = statementObj.Setup();
 
@@ -4009,7 +4592,8 @@ void Database::CombineAllPossibleAppliedTags(LockT& guard)
     // For super speed check against only other tags that have the same primary tag
     const char str[] = "SELECT id FROM applied_tag WHERE tag = ?;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     for (int64_t i = 0; i < count; ++i)
     {
@@ -4077,7 +4661,8 @@ int64_t Database::CountAppliedTags()
 
     const char str[] = "SELECT COUNT(*) FROM applied_tag;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -4095,7 +4680,8 @@ void Database::GenerateMissingDatabaseActionDescriptions(LockT& guard)
 
     const char str[] = "SELECT * FROM action_history WHERE description IS NULL OR description IS '';";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -4132,6 +4718,9 @@ void Database::RedoAction(ImageDeleteAction& action)
     {
         RunSQLAsPrepared(guard, "UPDATE pictures SET deleted = 1 WHERE id = ?1;", image);
 
+        if (ImageTagIndexLoaded)
+            ImageTagIndex.RemoveImage(image);
+
         auto obj = LoadedImages.GetIfLoaded(image);
         if (obj)
             obj->_UpdateDeletedStatus(true);
@@ -4149,6 +4738,9 @@ void Database::UndoAction(ImageDeleteAction& action)
     {
         RunSQLAsPrepared(guard, "UPDATE pictures SET deleted = NULL WHERE id = ?1;", image);
 
+        if (ImageTagIndexLoaded)
+            ImageTagIndex.AddImage(image);
+
         auto obj = LoadedImages.GetIfLoaded(image);
         if (obj)
             obj->_UpdateDeletedStatus(false);
@@ -4200,6 +4792,9 @@ void Database::RedoAction(ImageMergeAction& action)
     {
         RunSQLAsPrepared(guard, "UPDATE pictures SET deleted = 1 WHERE id = ?1;", image);
 
+        if (ImageTagIndexLoaded)
+            ImageTagIndex.RemoveImage(image);
+
         auto obj = LoadedImages.GetIfLoaded(image);
         if (obj)
         {
@@ -4311,6 +4906,9 @@ void Database::UndoAction(ImageMergeAction& action)
     {
         RunSQLAsPrepared(guard, "UPDATE pictures SET deleted = NULL WHERE id = ?1;", image);
 
+        if (ImageTagIndexLoaded)
+            ImageTagIndex.AddImage(image);
+
         auto obj = LoadedImages.GetIfLoaded(image);
         if (obj)
         {
@@ -4393,8 +4991,8 @@ void Database::UndoAction(ImageMergeAction& action)
         auto uncategorized = SelectCollectionByID(guard, DATABASE_UNCATEGORIZED_COLLECTION_ID);
 
         if (uncategorized)
-            InsertImageToCollection(
-                guard, *uncategorized, *target, SelectCollectionLargestShowOrder(guard, *uncategorized) + 1);
+            InsertImageToCollection(guard, *uncategorized, *target,
+                SelectCollectionLargestShowOrder(guard, *uncategorized) + DATABASE_SHOW_ORDER_GAP);
     }
 
     _SetActionStatus(guard, action, false);
@@ -4483,8 +5081,8 @@ void Database::RedoAction(ImageDeleteFromCollectionAction& action)
             {
                 for (auto image : imagesToAddToUncategorized)
                 {
-                    InsertImageToCollection(
-                        guard, *uncategorized, image, SelectCollectionLargestShowOrder(guard, *uncategorized) + 1);
+                    InsertImageToCollection(guard, *uncategorized, image,
+                        SelectCollectionLargestShowOrder(guard, *uncategorized) + DATABASE_SHOW_ORDER_GAP);
                 }
             }
         }
@@ -4533,11 +5131,12 @@ void Database::UndoAction(ImageDeleteFromCollectionAction& action)
             }
         }
 
-        // Add them to the target collection
-        for (const auto& imageOrder : action.GetImagesToDelete())
+        // Add them to the target collection. Inserting can renumber the collection, which
+        // updates the rest of the show orders in this action so they are read again each time
+        for (size_t i = 0; i < action.GetImagesToDelete().size(); ++i)
         {
-            const auto image = std::get<0>(imageOrder);
-            const auto order = std::get<1>(imageOrder);
+            const auto image = std::get<0>(action.GetImagesToDelete()[i]);
+            const auto order = std::get<1>(action.GetImagesToDelete()[i]);
 
             InsertImageToCollection(guard, targetID, image, order);
         }
@@ -4562,46 +5161,101 @@ void Database::RedoAction(CollectionReorderAction& action)
     if (!target /*|| target->IsDeleted()*/)
         throw InvalidState("cannot redo action: invalid target collection");
 
-    const auto existing = SelectImageIDsAndShowOrderInCollection(*target);
+    std::vector<ImageShowOrder> changes;
 
-    const auto& newOrder = action.GetNewOrder();
+    // The moves are calculated when first performed. After that they are applied directly
+    const bool calculateMoves = !action.GetNewOrder().empty();
+    std::vector<ShowOrderMove> moves;
 
-    int64_t currentShowOrder = 1;
+    if (calculateMoves)
+    {
+        auto existing = SelectImageIDsAndShowOrderInCollection(guard, targetID);
 
-    const char updateSql[] = "UPDATE collection_image SET show_order = ?3 WHERE "
-                             "collection = ?1 AND image = ?2;";
+        std::unordered_map<DBID, int64_t> currentOrders;
 
-    PreparedStatement updateStatement(SQLiteDb, updateSql, sizeof(updateSql));
+        for (const auto& [image, order] : existing)
+            currentOrders[image] = order;
 
-    {
-        DoDBSavePoint transaction(*this, guard, "collection_reorder_redo");
-        transaction.AllowCommit(false);
+        // All the images in the wanted order with their current show orders
+        std::vector<ImageShowOrder> wantedOrder;
+        wantedOrder.reserve(existing.size());
 
-        for (const auto& image : newOrder)
+        for (const auto image : action.GetNewOrder())
         {
-            updateStatement.StepAll(updateStatement.Setup(targetID, image, currentShowOrder++));
+            const auto found = currentOrders.find(image);
+
+            if (found == currentOrders.end())
+                continue;
+
+            wantedOrder.emplace_back(image, found->second);
+            currentOrders.erase(found);
         }
 
         // Add the existing ones to the back that weren't mentioned in neworder
         for (const auto& idOrder : existing)
         {
-            const auto id = std::get<0>(idOrder);
+            if (currentOrders.find(std::get<0>(idOrder)) != currentOrders.end())
+                wantedOrder.push_back(idOrder);
+        }
+
+        if (!CalculateShowOrderChanges(wantedOrder, changes))
+        {
+            // Renumbering first makes space in the gaps so that only the moved images are
+            // stored. It also keeps the show orders in the other actions on this collection valid
+            UpdateCollectionShowOrdersEvenly(guard, targetID);
+            existing = SelectImageIDsAndShowOrderInCollection(guard, targetID);
 
-            if (std::find(newOrder.begin(), newOrder.end(), id) == newOrder.end())
+            for (const auto& [image, order] : existing)
+                currentOrders[image] = order;
+
+            for (auto& [image, order] : wantedOrder)
+                order = currentOrders[image];
+
+            changes.clear();
+
+            // With too many images moved to one gap this still has to number the new order
+            if (!CalculateShowOrderChanges(wantedOrder, changes))
             {
-                updateStatement.StepAll(updateStatement.Setup(targetID, id, currentShowOrder++));
+                changes.clear();
+                CalculateEvenShowOrders(wantedOrder, changes);
             }
         }
 
-        _SetActionStatus(guard, action, true);
+        // Current orders can have only the images not in the new order left, so this is filled again
+        for (const auto& [image, order] : existing)
+            currentOrders[image] = order;
 
-        // Save the detected information needed for undo
-        action.SetOldOrder(existing);
-        action.Save();
+        moves.reserve(changes.size());
 
-        transaction.AllowCommit(true);
+        for (const auto& [image, order] : changes)
+            moves.push_back(ShowOrderMove{image, currentOrders[image], order});
     }
-
+    else
+    {
+        changes.reserve(action.GetMoves().size());
+
+        for (const auto& move : action.GetMoves())
+            changes.emplace_back(move.Image, move.NewOrder);
+    }
+
+    {
+        DoDBSavePoint transaction(*this, guard, "collection_reorder_redo");
+        transaction.AllowCommit(false);
+
+        _UpdateCollectionShowOrders(guard, targetID, changes);
+
+        _SetActionStatus(guard, action, true);
+
+        // Save the detected information needed for undo
+        if (calculateMoves)
+        {
+            action.SetMoves(std::move(moves), SelectCollectionLargestShowOrder(guard, *target));
+            action.Save();
+        }
+
+        transaction.AllowCommit(true);
+    }
+
     GUARD_LOCK_OTHER_NAME(target, targetLock);
     target->NotifyAll(targetLock);
 }
@@ -4616,45 +5270,54 @@ void Database::UndoAction(CollectionReorderAction& action)
     if (!target /*|| target->IsDeleted()*/)
         throw InvalidState("cannot undo action: invalid target collection");
 
-    const auto existing = SelectImageIDsAndShowOrderInCollection(*target);
+    const auto& moves = action.GetMoves();
 
-    const auto& oldOrder = action.GetOldOrder();
+    std::vector<ImageShowOrder> changes;
+    changes.reserve(moves.size());
 
-    const char updateSql[] = "UPDATE collection_image SET show_order = ?3 WHERE "
-                             "collection = ?1 AND image = ?2;";
+    int64_t maxOldOrder = -1;
 
-    PreparedStatement updateStatement(SQLiteDb, updateSql, sizeof(updateSql));
+    for (const auto& move : moves)
+    {
+        changes.emplace_back(move.Image, move.OldOrder);
+        maxOldOrder = std::max(maxOldOrder, move.OldOrder);
+    }
 
-    int64_t maxShowOrder = -1;
+    // Images added after doing the action come after LastShowOrder. If the action renumbered
+    // the collection those can be before the restored show orders, so they are moved to the end
+    const auto lastShowOrder = action.GetLastShowOrder();
 
+    if (maxOldOrder > lastShowOrder)
     {
-        DoDBSavePoint transaction(*this, guard, "collection_reorder_undo");
-        transaction.AllowCommit(false);
+        const char str[] = "SELECT image FROM collection_image WHERE collection = ?1 AND show_order > ?2 AND "
+                           "show_order <= ?3 ORDER BY show_order ASC, image ASC;";
 
-        // Restore the old order
-        for (const auto& idOrder : oldOrder)
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup(targetID, lastShowOrder, maxOldOrder);
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
         {
-            const auto id = std::get<0>(idOrder);
-            const auto order = std::get<1>(idOrder);
+            DBID image;
 
-            updateStatement.StepAll(updateStatement.Setup(targetID, id, order));
+            if (!statementObj.GetObjectIDFromColumn(image, 0))
+                continue;
 
-            if (order > maxShowOrder)
-                maxShowOrder = order;
+            if (std::find_if(moves.begin(), moves.end(),
+                    [image](const ShowOrderMove& move) { return move.Image == image; }) != moves.end())
+                continue;
+
+            maxOldOrder += DATABASE_SHOW_ORDER_GAP;
+            changes.emplace_back(image, maxOldOrder);
         }
+    }
 
-        // If there were images added after doing the action we need to make sure they also
-        // have correct show order
-        for (const auto& idOrder : existing)
-        {
-            const auto id = std::get<0>(idOrder);
+    {
+        DoDBSavePoint transaction(*this, guard, "collection_reorder_undo");
+        transaction.AllowCommit(false);
 
-            if (std::find_if(oldOrder.begin(), oldOrder.end(),
-                    [&](const auto& tuple) { return std::get<0>(tuple) == id; }) == oldOrder.end())
-            {
-                updateStatement.StepAll(updateStatement.Setup(targetID, id, ++maxShowOrder));
-            }
-        }
+        _UpdateCollectionShowOrders(guard, targetID, changes);
 
         _SetActionStatus(guard, action, false);
         transaction.AllowCommit(true);
@@ -4720,6 +5383,8 @@ void Database::RedoAction(CollectionDeleteAction& action)
 
     RunSQLAsPrepared(guard, "UPDATE collections SET deleted = 1 WHERE id = ?1;", id);
 
+    _UpdateCollectionCompletion(guard, id, true);
+
     auto obj = LoadedCollections.GetIfLoaded(id);
     if (obj)
         obj->_UpdateDeletedStatus(true);
@@ -4736,6 +5401,8 @@ void Database::UndoAction(CollectionDeleteAction& action)
 
     RunSQLAsPrepared(guard, "UPDATE collections SET deleted = NULL WHERE id = ?1;", id);
 
+    _UpdateCollectionCompletion(guard, id, false);
+
     auto obj = LoadedCollections.GetIfLoaded(id);
     if (obj)
         obj->_UpdateDeletedStatus(false);
@@ -5041,6 +5708,102 @@ std::shared_ptr<Image> Database::_LoadImageFromRow(LockT& guard, PreparedStateme
     return loaded;
 }
 
+std::vector<std::shared_ptr<Image>> Database::_SelectImagesByIDs(LockT& guard, const std::vector<DBID>& ids)
+{
+    std::vector<std::shared_ptr<Image>> result;
+
+    if (ids.empty())
+        return result;
+
+    std::unordered_map<DBID, std::shared_ptr<Image>> loaded;
+    loaded.reserve(ids.size());
+
+    for (size_t start = 0; start < ids.size(); start += DATABASE_MAX_IDS_PER_QUERY)
+    {
+        const auto count = std::min<size_t>(ids.size() - start, DATABASE_MAX_IDS_PER_QUERY);
+
+        // The number of parameters is rounded up to a power of two (by repeating the last id)
+        // so that only a few different statements end up in the statement cache
+        size_t parameters = 8;
+
+        while (parameters < count)
+            parameters *= 2;
+
+        std::string str = "SELECT * FROM pictures WHERE deleted IS NOT 1 AND id IN (?";
+
+        for (size_t i = 1; i < parameters; ++i)
+            str += ",?";
+
+        str += ");";
+
+        auto cachedStatement = _GetStatement(guard, str.c_str(), str.size());
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup();
+
+        for (size_t i = 0; i < parameters; ++i)
+            statementObj.Bind(ids[start + std::min(i, count - 1)]);
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            auto image = _LoadImageFromRow(guard, statementObj);
+
+            if (image)
+                loaded[image->GetID()] = image;
+        }
+    }
+
+    result.reserve(loaded.size());
+
+    for (DBID id : ids)
+    {
+        const auto found = loaded.find(id);
+
+        if (found != loaded.end())
+            result.push_back(found->second);
+    }
+
+    return result;
+}
+
+size_t Database::_SelectImagesInCollectionPage(LockT& guard, DBID collection, int64_t& lastShowOrder,
+    DBID& lastImage, int64_t limit, std::vector<std::shared_ptr<Image>>& result)
+{
+    // Images with the same show order are ordered by id so that the position of the last loaded
+    // image is exact
+    const char str[] = "SELECT pictures.*, collection_image.show_order, collection_image.image FROM collection_image "
+                       "INNER JOIN pictures ON pictures.id = collection_image.image "
+                       "WHERE collection_image.collection = ?1 AND "
+                       "collection_image.show_order >= ?2 AND (collection_image.show_order > ?2 OR "
+                       "collection_image.image > ?3) AND pictures.deleted IS NOT 1 "
+                       "ORDER BY collection_image.show_order ASC, collection_image.image ASC LIMIT ?4;";
+
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
+
+    auto statementInUse = statementObj.Setup(collection, lastShowOrder, lastImage, limit);
+
+    const auto showOrderColumn = statementObj.GetColumnCount() - 2;
+    const auto imageColumn = statementObj.GetColumnCount() - 1;
+    size_t rows = 0;
+
+    while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+    {
+        ++rows;
+
+        // Moved past rows that fail to load as well so that they aren't read again
+        lastShowOrder = statementObj.GetColumnAsInt64(showOrderColumn);
+        lastImage = statementObj.GetColumnAsInt64(imageColumn);
+
+        auto image = _LoadImageFromRow(guard, statementObj);
+
+        if (image)
+            result.push_back(image);
+    }
+
+    return rows;
+}
+
 std::shared_ptr<Folder> Database::_LoadFolderFromRow(LockT& guard, PreparedStatement& statement)
 {
     CheckRowID(statement, 0, "id");
@@ -5091,6 +5854,45 @@ std::shared_ptr<DatabaseAction> Database::_LoadDatabaseActionFromRow(LockT& guar
     return loaded;
 }
 
+void Database::_UpdateConvertCollectionReorderActions(LockT& guard)
+{
+    DoDBTransaction transaction(*this, guard);
+
+    std::vector<std::shared_ptr<DatabaseAction>> actions;
+
+    {
+        const char str[] = "SELECT * FROM action_history WHERE type = ?1;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup(static_cast<int>(DATABASE_ACTION_TYPE::CollectionReorder));
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            auto action = _LoadDatabaseActionFromRow(guard, statementObj);
+
+            if (action)
+            {
+                actions.push_back(action);
+            }
+            else
+            {
+                LOG_WARNING("Database: can't convert collection reorder action that failed to load");
+            }
+        }
+    }
+
+    // Loading converted the old format, this stores the moves
+    for (const auto& action : actions)
+        UpdateDatabaseAction(guard, *action);
+
+    LOG_INFO("Database: converted " + std::to_string(actions.size()) + " collection reorder actions");
+
+    actions.clear();
+    PurgeInactiveCache();
+}
+
 // ------------------------------------ //
 // Helper operations
 void Database::_SetActionStatus(LockT& guard, DatabaseAction& action, bool performed)
@@ -5115,6 +5917,9 @@ void Database::_PurgeImages(LockT& guard, const std::vector<DBID>& images)
                 LoadedImages.Remove(image);
 
                 RunSQLAsPrepared(guard, "DELETE FROM pictures WHERE id = ?1;", image);
+
+                if (ImageTagIndexLoaded)
+                    ImageTagIndex.PurgeImage(image);
             }
             else
             {
@@ -5190,8 +5995,8 @@ void Database::_PurgeCollection(LockT& guard, DBID collection)
 
         if (image)
         {
-            InsertImageToCollectionAG(
-                *uncategorized, *image, SelectCollectionLargestShowOrder(guard, *uncategorized) + 1);
+            InsertImageToCollectionAG(*uncategorized, *image,
+                SelectCollectionLargestShowOrder(guard, *uncategorized) + DATABASE_SHOW_ORDER_GAP);
         }
         else
         {
@@ -5233,6 +6038,189 @@ void Database::_PurgeFolder(LockT& guard, DBID folder)
     LoadedFolders.Remove(folder);
 }
 
+// ------------------------------------ //
+const TagDictionary::Entry* Database::_FindInTagDictionary(LockT& guard, const std::string& text)
+{
+    if (!TagNamesValid)
+        BuildTagDictionary(guard);
+
+    return TagNames.Find(StringToLower(text));
+}
+
+void Database::_OnTagNamesChanged(LockT& guard)
+{
+    // Rebuilt on the next lookup so that the change is seen right away
+    TagNamesValid = false;
+
+    DualView::Get().QueueDBThreadFunction(
+        []() { DualView::Get().GetEvents().FireEvent(CHANGED_EVENT::TAGS_CHANGED); });
+}
+
+void Database::_UpdateCollectionCompletion(LockT& guard, DBID collection, bool remove)
+{
+    if (!CollectionCompletionsValid)
+        return;
+
+    const char str[] = "SELECT name, deleted, "
+                       "(SELECT COUNT(*) FROM collection_image WHERE collection = collections.id) "
+                       "FROM collections WHERE id = ?1;";
+
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
+
+    auto statementInUse = statementObj.Setup(collection);
+
+    if (statementObj.Step(statementInUse) != PreparedStatement::STEP_RESULT::ROW)
+        return;
+
+    const auto name = statementObj.GetColumnAsString(0);
+
+    if (remove)
+    {
+        CollectionCompletions.Remove(name);
+    }
+    else if (!statementObj.GetColumnAsOptionalBool(1))
+    {
+        CollectionCompletions.Add(name, StringToLower(name), statementObj.GetColumnAsInt64(2));
+    }
+}
+
+// ------------------------------------ //
+int64_t Database::_MakeSpaceBeforeShowOrder(LockT& guard, DBID collection, int64_t showorder)
+{
+    std::optional<int64_t> previous;
+
+    {
+        const char str[] = "SELECT show_order FROM collection_image WHERE collection = ?1 AND "
+                           "show_order < ?2 ORDER BY show_order DESC LIMIT 1;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup(collection, showorder);
+
+        if (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+            previous = statementObj.GetColumnAsInt64(0);
+    }
+
+    const auto result = ShowOrderBetween(previous, showorder);
+
+    if (!result)
+    {
+        // The gap has run out. The image that had showorder is found again after renumbering
+        const auto image = SelectImageIDInCollectionByShowOrder(guard, collection, showorder);
+
+        LOG_INFO("Database: renumbering show orders of collection " + std::to_string(collection) +
+            " as there is no space to insert an image");
+        UpdateCollectionShowOrdersEvenly(guard, collection);
+
+        return _MakeSpaceBeforeShowOrder(
+            guard, collection, SelectImageShowOrderInCollection(guard, collection, image));
+    }
+
+    if (previous && showorder - *previous <= DATABASE_SHOW_ORDER_RENUMBER_GAP)
+        _QueueShowOrderRenumber(guard, collection);
+
+    return *result;
+}
+
+void Database::_UpdateCollectionShowOrders(
+    LockT& guard, DBID collection, const std::vector<ImageShowOrder>& changes)
+{
+    if (changes.empty())
+        return;
+
+    DoDBSavePoint transaction(*this, guard, "update_show_orders");
+    transaction.AllowCommit(false);
+
+    for (const auto& [image, order] : changes)
+        UpdateCollectionImageShowOrder(guard, collection, image, order);
+
+    transaction.AllowCommit(true);
+}
+
+void Database::_QueueShowOrderRenumber(LockT& guard, DBID collection)
+{
+    if (!PendingShowOrderRenumbers.insert(collection).second)
+        return;
+
+    DualView::Get().QueueDBThreadFunction(
+        [this, collection]()
+        {
+            GUARD_LOCK();
+
+            // A gap running out before this is ran renumbers the collection already
+            if (PendingShowOrderRenumbers.find(collection) == PendingShowOrderRenumbers.end())
+                return;
+
+            UpdateCollectionShowOrdersEvenly(guard, collection);
+        });
+}
+
+void Database::_TranslateRenumberedShowOrdersInActions(
+    LockT& guard, DBID collection, const std::vector<ImageShowOrder>& before)
+{
+    std::vector<std::shared_ptr<DatabaseAction>> actions;
+
+    {
+        const char str[] = "SELECT * FROM action_history WHERE (type = ?1 OR type = ?2) AND json_data LIKE ?3;";
+
+        auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+        auto& statementObj = *cachedStatement;
+
+        auto statementInUse = statementObj.Setup(static_cast<int>(DATABASE_ACTION_TYPE::ImageRemovedFromCollection),
+            static_cast<int>(DATABASE_ACTION_TYPE::CollectionReorder), "%" + std::to_string(collection) + "%");
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+        {
+            auto action = _LoadDatabaseActionFromRow(guard, statementObj);
+
+            if (action)
+                actions.push_back(action);
+        }
+    }
+
+    // The LIKE also matches other ids that contain this one so the target is checked here
+    for (const auto& action : actions)
+    {
+        if (const auto removal = std::dynamic_pointer_cast<ImageDeleteFromCollectionAction>(action))
+        {
+            if (removal->GetDeletedFromCollection() != collection)
+                continue;
+
+            auto images = removal->GetImagesToDelete();
+
+            for (auto& [image, order] : images)
+                order = TranslateRenumberedShowOrder(before, order);
+
+            removal->SetImagesToDelete(std::move(images));
+        }
+        else if (const auto reorder = std::dynamic_pointer_cast<CollectionReorderAction>(action))
+        {
+            // The moves are only calculated when first performed. This includes the action that
+            // is being performed when RedoAction needs to renumber first
+            if (reorder->GetTargetCollection() != collection || reorder->GetMoves().empty())
+                continue;
+
+            auto moves = reorder->GetMoves();
+
+            for (auto& move : moves)
+            {
+                move.OldOrder = TranslateRenumberedShowOrder(before, move.OldOrder);
+                move.NewOrder = TranslateRenumberedShowOrder(before, move.NewOrder);
+            }
+
+            reorder->SetMoves(std::move(moves), TranslateRenumberedShowOrder(before, reorder->GetLastShowOrder()));
+        }
+        else
+        {
+            continue;
+        }
+
+        UpdateDatabaseAction(guard, *action);
+    }
+}
+
 // ------------------------------------ //
 void Database::ThrowCurrentSqlError(LockT& guard)
 {
@@ -5403,6 +6391,25 @@ bool Database::_UpdateDatabase(LockT& guard, const int oldversion)
             _SetCurrentDatabaseVersion(guard, 26);
             return true;
         }
+        case 26:
+        {
+            _RunSQL(guard, LoadResourceCopy("/com/boostslair/dualviewpp/resources/sql/migration_26_27.sql"));
+            _SetCurrentDatabaseVersion(guard, 27);
+            return true;
+        }
+        case 27:
+        {
+            _RunSQL(guard, LoadResourceCopy("/com/boostslair/dualviewpp/resources/sql/migration_27_28.sql"));
+            _SetCurrentDatabaseVersion(guard, 28);
+            return true;
+        }
+        case 28:
+        {
+            // Collection reorder actions are stored as moves instead of the full orders
+            _UpdateConvertCollectionReorderActions(guard);
+            _SetCurrentDatabaseVersion(guard, 29);
+            return true;
+        }
         default:
         {
             LOG_ERROR("Unknown database version to update from: " + Convert::ToString(oldversion));
@@ -5466,6 +6473,14 @@ bool Database::_UpdateDatabaseSignatures(LockT& guard, const int oldversion)
 
     switch (oldversion)
     {
+        case 1:
+        {
+            _RunSQL(guard, PictureSignatureDb,
+                LoadResourceCopy("/com/boostslair/dualviewpp/resources/sql/migration_signatures_1_2.sql"));
+            _RebuildSignatureWords(guard);
+            _SetCurrentDatabaseVersionSignatures(guard, 2);
+            return true;
+        }
         default:
         {
             LOG_ERROR("Unknown database version to update from: " + Convert::ToString(oldversion));
@@ -5490,7 +6505,8 @@ void Database::_UpdateApplyDownloadTagStrings(LockT& guard)
                        "INNER JOIN pictures ON net_files.file_url = pictures.from_file WHERE "
                        "net_files.tags_string IS NOT NULL AND LENGTH(net_files.tags_string) > 0;";
 
-    PreparedStatement statementObj(SQLiteDb, str, sizeof(str));
+    auto cachedStatement = _GetStatement(guard, str, sizeof(str));
+    auto& statementObj = *cachedStatement;
 
     auto statementInUse = statementObj.Setup();
 
@@ -5762,3 +6778,111 @@ DoDBSavePoint::~DoDBSavePoint()
         DB.RollbackSavePoint(Locked, SavePoint, Auxiliary);
     }
 }
+
+// ------------------------------------ //
+// ReadConnection
+ReadConnection::ReadConnection(const std::string& file, const std::string& signatureFile)
+{
+    const auto open = [this](const std::string& path, sqlite3*& db)
+    {
+        const auto result =
+            sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_URI | SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr);
+
+        if (result == SQLITE_OK && db)
+            return;
+
+        const std::string errormessage(db ? sqlite3_errmsg(db) : "out of memory");
+
+        // The destructor isn't ran when the constructor throws
+        sqlite3_close(SQLiteDb);
+        sqlite3_close(PictureSignatureDb);
+        SQLiteDb = nullptr;
+        PictureSignatureDb = nullptr;
+
+        LOG_ERROR("Sqlite failed to open read connection to '" + path + "' errorcode: " +
+            Convert::ToString(result) + " message: " + errormessage);
+        throw Leviathan::InvalidState("failed to open sqlite read connection");
+    };
+
+    open(file, SQLiteDb);
+    open(signatureFile, PictureSignatureDb);
+
+    Statements.SetDatabase(SQLiteDb);
+    SignatureStatements.SetDatabase(PictureSignatureDb);
+}
+
+ReadConnection::~ReadConnection()
+{
+    Statements.Clear();
+    SignatureStatements.Clear();
+
+    sqlite3_close(SQLiteDb);
+    sqlite3_close(PictureSignatureDb);
+}
+
+void ReadConnection::BeginRead()
+{
+    for (sqlite3* db : {SQLiteDb, PictureSignatureDb})
+    {
+        const auto result = sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+
+        if (result != SQLITE_OK)
+            ThrowErrorFromDB(db, result, "starting read transaction");
+    }
+}
+
+void ReadConnection::EndRead()
+{
+    for (sqlite3* db : {SQLiteDb, PictureSignatureDb})
+    {
+        // Nothing was written so this can't lose anything
+        if (sqlite3_get_autocommit(db) == 0 && sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            LOG_ERROR("Database: ending read transaction failed: " + std::string(sqlite3_errmsg(db)));
+        }
+    }
+}
+
+// ------------------------------------ //
+// DatabaseReadLock
+DatabaseReadLock::DatabaseReadLock(Database& database, RecursiveLock& guard) : Owner(&database) {}
+
+DatabaseReadLock::DatabaseReadLock(Database& database, std::unique_ptr<ReadConnection>&& connection) :
+    Owner(&database), Connection(std::move(connection))
+{
+}
+
+DatabaseReadLock::DatabaseReadLock(Database& database, std::unique_ptr<RecursiveLock>&& lock) :
+    Owner(&database), OwnedLock(std::move(lock))
+{
+}
+
+DatabaseReadLock::DatabaseReadLock(DatabaseReadLock&& other) :
+    Owner(other.Owner), Connection(std::move(other.Connection)), OwnedLock(std::move(other.OwnedLock))
+{
+}
+
+DatabaseReadLock::~DatabaseReadLock()
+{
+    if (Connection)
+    {
+        Connection->EndRead();
+        Owner->_ReturnReadConnection(std::move(Connection));
+    }
+}
+
+PreparedStatementCache::Handle DatabaseReadLock::GetStatement(const char* str, size_t length)
+{
+    if (Connection)
+        return Connection->Statements.Get(str, length);
+
+    return Owner->Statements.Get(str, length);
+}
+
+PreparedStatementCache::Handle DatabaseReadLock::GetSignatureStatement(const char* str, size_t length)
+{
+    if (Connection)
+        return Connection->SignatureStatements.Get(str, length);
+
+    return Owner->SignatureStatements.Get(str, length);
+}
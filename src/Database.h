@@ -1,15 +1,24 @@
 #pragma once
 
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "Common/ThreadSafe.h"
 
 #include "Common.h"
+#include "CompletionIndex.h"
 #include "PreparedStatement.h"
+#include "ShowOrder.h"
 #include "SingleLoad.h"
 #include "SQLHelpers.h"
+#include "TagDictionary.h"
+#include "TagSearchIndex.h"
 
 // Forward declare sqlite //
 struct sqlite3;
@@ -35,6 +44,7 @@ class NetGalleryDeleteAction;
 class CollectionDeleteAction;
 class FolderDeleteAction;
 class ImagePath;
+class SignatureIndex;
 
 class Tag;
 class AppliedTag;
@@ -44,12 +54,102 @@ class TagBreakRule;
 enum class DATABASE_ACTION_TYPE : int;
 
 // The version number of the database
-constexpr auto DATABASE_CURRENT_VERSION = 26;
-constexpr auto DATABASE_CURRENT_SIGNATURES_VERSION = 1;
+constexpr auto DATABASE_CURRENT_VERSION = 29;
+constexpr auto DATABASE_CURRENT_SIGNATURES_VERSION = 2;
 
 constexpr auto IMAGE_SIGNATURE_WORD_COUNT = 100;
 constexpr auto IMAGE_SIGNATURE_WORD_LENGTH = 10;
 
+//! Largest number of ids bound to a single "IN (...)" query when loading multiple images
+constexpr auto DATABASE_MAX_IDS_PER_QUERY = 256;
+
+class Database;
+
+//! \brief Read-only connections to the database files, pooled by Database
+class ReadConnection
+{
+public:
+    //! \exception Leviathan::InvalidState if opening fails
+    ReadConnection(const std::string& file, const std::string& signatureFile);
+    ~ReadConnection();
+
+    ReadConnection(const ReadConnection& other) = delete;
+    ReadConnection& operator=(const ReadConnection& other) = delete;
+
+    //! \brief Starts read transactions so that all reads see the same snapshot
+    void BeginRead();
+
+    //! \brief Ends the read transactions
+    void EndRead();
+
+    sqlite3* SQLiteDb = nullptr;
+    sqlite3* PictureSignatureDb = nullptr;
+
+    PreparedStatementCache Statements;
+    PreparedStatementCache SignatureStatements;
+};
+
+//! \brief Read access to the database, used instead of the database lock by methods that only
+//! run SELECT queries
+//!
+//! When Database has read connections this holds one of them so reads don't wait for the
+//! database lock and writes don't wait for reads. Everything read through one of these sees the
+//! same snapshot of the database, taken on the first read, and doesn't see writes committed
+//! after that. Without read connections (for example in-memory databases) this holds the
+//! database lock and reads through the main connection.
+//! \note Don't acquire a second one on the same thread while holding one, that can deadlock
+//! when all connections are in use. Use the constructor taking a lock to read while the database
+//! is already locked
+class DatabaseReadLock
+{
+    friend Database;
+
+public:
+    //! \brief Reads through the main connection while guard holds the database lock
+    //!
+    //! This also sees the uncommitted changes of the current transaction
+    DatabaseReadLock(Database& database, RecursiveLock& guard);
+
+    DatabaseReadLock(DatabaseReadLock&& other);
+    ~DatabaseReadLock();
+
+    DatabaseReadLock(const DatabaseReadLock& other) = delete;
+    DatabaseReadLock& operator=(const DatabaseReadLock& other) = delete;
+
+    //! \brief Returns a compiled statement for str on the main database
+    PreparedStatementCache::Handle GetStatement(const char* str, size_t length);
+
+    //! \brief Variant of GetStatement for the picture signature db
+    PreparedStatementCache::Handle GetSignatureStatement(const char* str, size_t length);
+
+    //! \returns True if this holds a read connection, false if the main connection is used
+    bool IsPooled() const
+    {
+        return Connection != nullptr;
+    }
+
+private:
+    DatabaseReadLock(Database& database, std::unique_ptr<ReadConnection>&& connection);
+    DatabaseReadLock(Database& database, std::unique_ptr<RecursiveLock>&& lock);
+
+private:
+    Database* Owner;
+
+    std::unique_ptr<ReadConnection> Connection;
+
+    //! Set when there are no read connections
+    std::unique_ptr<RecursiveLock> OwnedLock;
+};
+
+//! \brief Variant of CREATE_NON_LOCKING_WRAPPER for methods taking a DatabaseReadLock
+#define CREATE_READ_LOCKING_WRAPPER(x)                               \
+    template<typename... TBindTypes>                                 \
+    auto x##AG(TBindTypes&&... valuestobind)                         \
+    {                                                                \
+        auto reader = AcquireReadLock();                             \
+        return x(reader, std::forward<TBindTypes>(valuestobind)...); \
+    }
+
 //! \brief All database manipulation happens through this class
 //!
 //! There should be only one database object at a time. It is contained in DualView
@@ -79,6 +179,8 @@ class Database : public Leviathan::ThreadSafeRecursive
     friend CollectionDeleteAction;
     friend FolderDeleteAction;
 
+    friend DatabaseReadLock;
+
 public:
     //! \brief Normal database creation, uses the specified file
     Database(std::string dbfile);
@@ -96,6 +198,22 @@ public:
     //! \note Must be called on the thread that
     void Init();
 
+    //! \brief Opens read-only connections for DatabaseReadLock to use
+    //!
+    //! Must be called after Init. Before this reads use the main connection
+    //! \exception Leviathan::InvalidState if the database is in-memory or opening fails
+    void OpenReadConnections(int count);
+
+    //! \brief Returns read access to the database, waiting for a free read connection if they
+    //! are all in use
+    DatabaseReadLock AcquireReadLock();
+
+    //! \returns The number of read connections, 0 if reads use the main connection
+    int GetReadConnectionCount() const
+    {
+        return ReadConnectionCount;
+    }
+
     //! \brief Selects the database version
     //! \returns True if succeeded, false if no version exists.
     bool SelectDatabaseVersion(LockT& guard, sqlite3* db, int& result);
@@ -148,6 +266,27 @@ public:
     std::vector<std::shared_ptr<Image>> SelectImageByTag(LockT& guard, DBID tagid);
     CREATE_NON_LOCKING_WRAPPER(SelectImageByTag);
 
+    //! \brief Retrieves the ids of images matching a tag search expression
+    //!
+    //! Uses an in-memory index of the image tags so the number of tags in the search doesn't
+    //! affect the number of queries ran
+    //! \param query Parsed search where each Term has its applied tag id set
+    //! \returns Sorted ids of the non-deleted images that match
+    std::vector<DBID> SelectImageIDsByTagSearch(LockT& guard, const TagSearchNode& query);
+    CREATE_NON_LOCKING_WRAPPER(SelectImageIDsByTagSearch);
+
+    //! \brief Retrieves images matching a tag search expression
+    //! \see SelectImageIDsByTagSearch
+    std::vector<std::shared_ptr<Image>> SelectImagesByTagSearch(LockT& guard, const TagSearchNode& query);
+    CREATE_NON_LOCKING_WRAPPER(SelectImagesByTagSearch);
+
+    //! \brief Loads the image tag search index from the database
+    //!
+    //! This is done on startup so that the first search doesn't need to wait for it. After
+    //! this the index is updated when tags are added to or removed from images
+    void BuildImageTagIndex(LockT& guard);
+    CREATE_NON_LOCKING_WRAPPER(BuildImageTagIndex);
+
     //! \brief Retrieves an Image's id based on the hash
     DBID SelectImageIDByHash(LockT& guard, const std::string& hash);
     CREATE_NON_LOCKING_WRAPPER(SelectImageIDByHash);
@@ -157,25 +296,34 @@ public:
     CREATE_NON_LOCKING_WRAPPER(SelectImageNameByID);
 
     //! \brief Counts the number of images in the database
-    size_t SelectImageCount(LockT& guard);
+    size_t SelectImageCount(DatabaseReadLock& reader);
+    CREATE_READ_LOCKING_WRAPPER(SelectImageCount);
 
-    void SelectImagePaths(LockT& guard, std::vector<ImagePath>& results, int64_t offset, int64_t max = 10000);
+    void SelectImagePaths(
+        DatabaseReadLock& reader, std::vector<ImagePath>& results, int64_t offset, int64_t max = 10000);
 
     //! \brief Retrieves signature (or empty string) for image id
     std::string SelectImageSignatureByID(LockT& guard, DBID image);
     CREATE_NON_LOCKING_WRAPPER(SelectImageSignatureByID);
 
+    //! \brief Stores signatures and their words for duplicate detection for multiple images at once
+    //!
+    //! Everything is written in one transaction with statements that are reused for all the
+    //! images, and the words of a full signature are inserted with a single multi-row insert
+    void InsertImageSignatures(LockT& guard, const std::vector<std::tuple<DBID, std::string>>& signatures);
+    CREATE_NON_LOCKING_WRAPPER(InsertImageSignatures);
+
     //! \brief Retrieves image ids that don't have a signature
-    std::vector<DBID> SelectImageIDsWithoutSignature(LockT& guard);
-    CREATE_NON_LOCKING_WRAPPER(SelectImageIDsWithoutSignature);
+    std::vector<DBID> SelectImageIDsWithoutSignature(DatabaseReadLock& reader);
+    CREATE_READ_LOCKING_WRAPPER(SelectImageIDsWithoutSignature);
 
     //! \brief Finds images that are incorrectly orphaned in the DB. Note this is currently different from the other
     //! orphan checks by finding images not in any folder.
-    void SelectOrphanedImages(LockT& guard, std::vector<DBID>& result);
+    void SelectOrphanedImages(DatabaseReadLock& reader, std::vector<DBID>& result);
 
     //! \brief Finds incorrectly deleted images that are orphaned due to not being part of an action (i.e. an action
     //! has been incorrectly purged from the DB without removing an image)
-    void SelectIncorrectlyDeletedImages(LockT& guard, std::vector<DBID>& result);
+    void SelectIncorrectlyDeletedImages(DatabaseReadLock& reader, std::vector<DBID>& result);
 
     //! \brief Loads a TagCollection for the specified image.
     //! \returns Null if the image is not in the database
@@ -190,7 +338,10 @@ public:
     //! \brief Removes a tag from an image
     void DeleteImageTag(LockT& guard, std::weak_ptr<Image> image, AppliedTag& tag);
 
-    //! \brief Queries the signature words table to find potentially duplicate images
+    //! \brief Finds potentially duplicate images based on their signatures
+    //!
+    //! The signatures are loaded into a SignatureIndex through a read connection, the actual
+    //! search is done without holding any database resources
     //! \param sensitivity How many parts need to match before returning a result. Strength of
     //! 20 can be used instead of refining the results further to get a faster method for
     //! finding duplicates, but less accurate
@@ -199,6 +350,9 @@ public:
     //! then the strength
     std::map<DBID, std::vector<std::tuple<DBID, int>>> SelectPotentialImageDuplicates(int sensitivity = 15);
 
+    //! \brief Loads all image signatures and ignored duplicate pairs into index
+    void SelectSignatureIndexData(DatabaseReadLock& reader, SignatureIndex& index);
+
     //
     // Collection functions
     //
@@ -237,14 +391,23 @@ public:
 
     std::string SelectCollectionNameByID(DBID id);
 
+    //! \brief Finds collection names containing pattern for auto completion
+    //!
+    //! Uses an in-memory trigram index, collections with more images are suggested first
     std::vector<std::string> SelectCollectionNamesByWildcard(const std::string& pattern, int64_t max = 50);
 
+    //! \brief Loads the index used by SelectCollectionNamesByWildcard
+    //!
+    //! If this isn't called the index is built on the first search
+    void BuildCollectionCompletions(LockT& guard);
+    CREATE_NON_LOCKING_WRAPPER(BuildCollectionCompletions);
+
     //! \brief Retrieves a Collection based on the id
     std::shared_ptr<Collection> SelectCollectionByID(LockT& guard, DBID id);
     CREATE_NON_LOCKING_WRAPPER(SelectCollectionByID);
 
     //! \brief Finds collections that are incorrectly orphaned in the DB
-    void SelectIncorrectlyDeletedCollections(LockT& guard, std::vector<DBID>& result);
+    void SelectIncorrectlyDeletedCollections(DatabaseReadLock& reader, std::vector<DBID>& result);
 
     //! \brief Returns the largest value used for an image in the collection
     //! If the collection is empty returns 0
@@ -276,8 +439,8 @@ public:
     //! \brief Adds image to collection
     //! \returns True if succeeded. False if no rows where changed
     //! \param showorder The order number of the image in the collection. If the same one is
-    //! already in use the order in which the two images that have the same show_order is
-    //! random
+    //! already in use the image is placed right before the image using it. Appended images should
+    //! leave a DATABASE_SHOW_ORDER_GAP sized gap after the last image
     bool InsertImageToCollection(LockT& guard, DBID collection, Image& image, int64_t showorder);
     CREATE_NON_LOCKING_WRAPPER(InsertImageToCollection);
 
@@ -319,6 +482,8 @@ public:
     int64_t SelectImageShowOrderInCollection(LockT& guard, const Collection& collection, const Image& image);
     CREATE_NON_LOCKING_WRAPPER(SelectImageShowOrderInCollection);
 
+    int64_t SelectImageShowOrderInCollection(LockT& guard, DBID collection, DBID image);
+
     //! \brief Returns the image with the show order
     //! \note If for some reason there are multiples with the same show_order one of them
     //! is returned
@@ -366,8 +531,18 @@ public:
     //! \brief Returns all images in a collection
     std::vector<std::shared_ptr<Image>> SelectImagesInCollection(const Collection& collection, int32_t limit = -1);
 
+    //! \brief Loads the images in a collection in pages of pageSize images
+    //!
+    //! The database is unlocked between the pages so the first images can be shown while the
+    //! rest are still loading
+    //! \param callback Called with each page in show order, return false to stop loading
+    void SelectImagesInCollectionPaged(const Collection& collection, int32_t pageSize,
+        const std::function<bool(std::vector<std::shared_ptr<Image>>&)>& callback);
+
     std::vector<std::tuple<DBID, int64_t>> SelectImageIDsAndShowOrderInCollection(const Collection& collection);
 
+    std::vector<std::tuple<DBID, int64_t>> SelectImageIDsAndShowOrderInCollection(LockT& guard, DBID collection);
+
     //! \brief Returns all collections and the show order an image has
     std::vector<std::tuple<DBID, int64_t>> SelectCollectionIDsImageIsIn(LockT& guard, const Image& image);
 
@@ -383,7 +558,17 @@ public:
     //! This does no checks to ensure that this doesn't cause duplicate show orders
     bool UpdateCollectionImageShowOrder(LockT& guard, DBID collection, DBID image, int64_t showorder);
 
+    //! \brief Gives the images in a collection evenly spaced show orders without changing their
+    //! order
+    //!
+    //! Inserts and moves use the gaps between the show orders so this is only needed when a gap
+    //! runs out
+    //! \returns The number of changed rows
+    int UpdateCollectionShowOrdersEvenly(LockT& guard, DBID collection);
+
     //! \brief Updates the order of collection images in an action
+    //!
+    //! Only the images that move relative to the others get new show orders
     std::shared_ptr<DatabaseAction> UpdateCollectionImagesOrder(
         Collection& collection, const std::vector<std::shared_ptr<Image>>& neworder);
 
@@ -399,7 +584,7 @@ public:
     CREATE_NON_LOCKING_WRAPPER(SelectFolderByID);
 
     //! \brief Finds folders that are incorrectly orphaned in the DB
-    void SelectIncorrectlyDeletedFolders(LockT& guard, std::vector<DBID>& result);
+    void SelectIncorrectlyDeletedFolders(DatabaseReadLock& reader, std::vector<DBID>& result);
 
     //! \brief Creates a new folder, must have a parent folder
     //! \returns The created folder or null if the name conflicts
@@ -522,11 +707,22 @@ public:
     CREATE_NON_LOCKING_WRAPPER(SelectTagByAlias);
 
     //! \brief Selects a tag matching the name or has an alias for the name
+    //! \note This uses the tag dictionary so this doesn't run a query
     std::shared_ptr<Tag> SelectTagByNameOrAlias(const std::string& name);
 
     //! \brief Returns the text of a super alias
+    //! \note This uses the tag dictionary so this doesn't run a query
     std::string SelectTagSuperAlias(const std::string& name);
 
+    //! \brief Loads the dictionary used to look up tags, modifiers, break rules and super
+    //! aliases by their text and the index for suggesting them
+    //!
+    //! If this isn't called the dictionary is built on the first lookup. After changing any of
+    //! the names the dictionary is rebuilt on the next lookup. The use counts that rank the
+    //! suggestions are only loaded by the first build and kept up to date after that
+    void BuildTagDictionary(LockT& guard);
+    CREATE_NON_LOCKING_WRAPPER(BuildTagDictionary);
+
     //! \brief Updates Tag's properties
     void UpdateTag(Tag& tag);
 
@@ -653,7 +849,7 @@ public:
     CREATE_NON_LOCKING_WRAPPER(SelectNetGalleryByID);
 
     //! \brief Finds NetGallery items that are incorrectly orphaned in the DB
-    void SelectIncorrectlyDeletedNetGalleries(LockT& guard, std::vector<DBID>& result);
+    void SelectIncorrectlyDeletedNetGalleries(DatabaseReadLock& reader, std::vector<DBID>& result);
 
     //! \brief Adds a new NetGallery to the database
     //! \returns True if added, false if it is already added
@@ -691,16 +887,13 @@ public:
     //
     // Wilcard searches for tag suggestions
     //
-    //! \brief Returns text of all break rules that contain str
-    void SelectTagBreakRulesByStrWildcard(std::vector<std::string>& breakrules, const std::string& pattern);
-
-    void SelectTagNamesWildcard(std::vector<std::string>& result, const std::string& pattern);
-
-    void SelectTagAliasesWildcard(std::vector<std::string>& result, const std::string& pattern);
-
-    void SelectTagModifierNamesWildcard(std::vector<std::string>& result, const std::string& pattern);
-
-    void SelectTagSuperAliasWildcard(std::vector<std::string>& result, const std::string& pattern);
+    //! \brief Finds tag names, tag aliases, modifiers, break rules and super aliases that
+    //! contain pattern
+    //!
+    //! Uses the in-memory trigram index built with the tag dictionary. More used tags and
+    //! modifiers are suggested first
+    //! \param max The maximum number of texts added to result
+    void SelectTagSuggestions(std::vector<std::string>& result, const std::string& pattern, size_t max);
 
     //
     // Complex operations
@@ -756,6 +949,25 @@ public:
     //! action purging and undo mechanism breaks
     void SetMaxActionHistory(uint32_t maxactions);
 
+    //
+    // Statement caching
+    //
+
+    //! \brief Sets how many unused compiled statements are kept for each connection
+    //! \param size 0 disables caching
+    void SetStatementCacheSize(LockT& guard, size_t size);
+    CREATE_NON_LOCKING_WRAPPER(SetStatementCacheSize);
+
+    //! \brief Returns the statement cache of the main database, for reading the counters
+    PreparedStatementCache& GetStatementCache(LockT& guard)
+    {
+        return Statements;
+    }
+
+    //! \brief Prints hit counts of the statement caches to the log
+    void PrintStatementCacheStats(LockT& guard);
+    CREATE_NON_LOCKING_WRAPPER(PrintStatementCacheStats);
+
     //
     // Ignore pairs
     //
@@ -865,7 +1077,8 @@ protected:
     template<typename... TBindTypes>
     void RunSQLAsPrepared(LockT& guard, const std::string& str, TBindTypes&&... valuestobind)
     {
-        PreparedStatement statementobj(SQLiteDb, str);
+        auto cachedStatement = _GetStatement(guard, str.c_str(), str.size());
+        auto& statementobj = *cachedStatement;
 
         auto statementinuse = statementobj.Setup(std::forward<TBindTypes>(valuestobind)...);
 
@@ -876,13 +1089,29 @@ protected:
     template<typename... TBindTypes>
     void RunOnSignatureDB(LockT& guard, const std::string& str, TBindTypes&&... valuestobind)
     {
-        PreparedStatement statementobj(PictureSignatureDb, str);
+        auto cachedStatement = _GetSignatureStatement(guard, str.c_str(), str.size());
+        auto& statementobj = *cachedStatement;
 
         auto statementinuse = statementobj.Setup(std::forward<TBindTypes>(valuestobind)...);
 
         statementobj.StepAll(statementinuse);
     }
 
+    //! \brief Returns a compiled statement for str on the main database from the statement
+    //! cache
+    //!
+    //! Use this instead of creating a PreparedStatement for SQL that doesn't change
+    PreparedStatementCache::Handle _GetStatement(LockT& guard, const char* str, size_t length)
+    {
+        return Statements.Get(str, length);
+    }
+
+    //! \brief Variant of _GetStatement for the picture signature db
+    PreparedStatementCache::Handle _GetSignatureStatement(LockT& guard, const char* str, size_t length)
+    {
+        return SignatureStatements.Get(str, length);
+    }
+
     //! \brief Runs a raw sql query.
     //! \note Don't use unless absolutely necessary prefer to use Database::RunSqlAsPrepared
     void _RunSQL(LockT& guard, const std::string& sql);
@@ -921,6 +1150,18 @@ private:
     //! \brief Loads an Image object from the current row
     std::shared_ptr<Image> _LoadImageFromRow(LockT& guard, PreparedStatement& statement);
 
+    //! \brief Loads non-deleted images by id with a few IN queries instead of one query per image
+    //! \returns The images in the same order as ids, missing and deleted ones are skipped
+    std::vector<std::shared_ptr<Image>> _SelectImagesByIDs(LockT& guard, const std::vector<DBID>& ids);
+
+    //! \brief Loads a page of the images in a collection that come after the position in
+    //! lastShowOrder and lastImage and updates those to the last loaded image
+    //! \param limit Maximum number of rows to read, -1 for no limit
+    //! \returns The number of rows read. Rows that fail to load are skipped so this can be more
+    //! than the number of images added to result
+    size_t _SelectImagesInCollectionPage(LockT& guard, DBID collection, int64_t& lastShowOrder, DBID& lastImage,
+        int64_t limit, std::vector<std::shared_ptr<Image>>& result);
+
     //! \brief Loads a Folder object from the current row
     std::shared_ptr<Folder> _LoadFolderFromRow(LockT& guard, PreparedStatement& statement);
 
@@ -934,19 +1175,64 @@ private:
 
     void InsertTagCollection(LockT& guard, Collection& image, DBID appliedtagid);
 
-    //! \brief Inserts the image signature to the auxiliary DB
-    void _InsertImageSignatureParts(LockT& guard, DBID image, const std::string& signature);
+    //! \brief Recreates all of the signature words from the stored signatures
+    void _RebuildSignatureWords(LockT& guard);
 
     //
     // Helper operations
     //
     void _SetActionStatus(LockT& guard, DatabaseAction& action, bool performed);
 
+    //! \brief Called by DatabaseReadLock when it is done with connection
+    void _ReturnReadConnection(std::unique_ptr<ReadConnection>&& connection);
+
     void _PurgeImages(LockT& guard, const std::vector<DBID>& images);
     void _PurgeNetGalleries(LockT& guard, DBID gallery);
     void _PurgeCollection(LockT& guard, DBID collection);
     void _PurgeFolder(LockT& guard, DBID folder);
 
+    //! \brief Looks up text in the tag dictionary, building it first if needed
+    //! \returns Null if the text isn't a known tag, modifier, break rule or super alias
+    const TagDictionary::Entry* _FindInTagDictionary(LockT& guard, const std::string& text);
+
+    //! \brief Counts how many images use each tag and modifier, called by BuildTagDictionary the
+    //! first time it runs
+    void _LoadTagUseCounts(LockT& guard);
+
+    //! \brief Updates the use counts of the tag and the modifiers of an applied tag after it is
+    //! added to or removed from an image
+    //!
+    //! The suggestions of the tag and modifier names are updated right away, aliases get the new
+    //! counts when the dictionary is rebuilt next time
+    void _ChangeTagUseCount(LockT& guard, const AppliedTag& tag, int64_t change);
+
+    //! \brief Called after tag, modifier or break rule names change
+    //!
+    //! Invalidates the tag dictionary and fires CHANGED_EVENT::TAGS_CHANGED
+    void _OnTagNamesChanged(LockT& guard);
+
+    //! \brief Updates the collection completion index after a collection is renamed, deleted
+    //! or restored
+    //! \param remove If true the current name of the collection is removed, otherwise added
+    void _UpdateCollectionCompletion(LockT& guard, DBID collection, bool remove);
+
+    //! \brief Finds a free show order right before the image that has showorder
+    //! \note Renumbers the collection if the gap before the image has run out
+    int64_t _MakeSpaceBeforeShowOrder(LockT& guard, DBID collection, int64_t showorder);
+
+    //! \brief Sets new show orders for images in a collection
+    void _UpdateCollectionShowOrders(LockT& guard, DBID collection, const std::vector<ImageShowOrder>& changes);
+
+    //! \brief Renumbers a collection on the database thread. Used when the gaps in a collection
+    //! are getting small to avoid renumbering in the middle of an insert
+    void _QueueShowOrderRenumber(LockT& guard, DBID collection);
+
+    //! \brief Moves the show_orders stored in undo information along when a collection is
+    //! renumbered
+    //! \param before The images of the collection with their show_orders before renumbering
+    void _TranslateRenumberedShowOrdersInActions(
+        LockT& guard, DBID collection, const std::vector<ImageShowOrder>& before);
+
     //
     // Utility stuff
     //
@@ -984,12 +1270,21 @@ private:
     //! the result that is being iterated
     void _UpdateApplyDownloadTagStrings(LockT& guard);
 
+    //! \brief Converts collection reorder actions from the full old and new orders to moves
+    void _UpdateConvertCollectionReorderActions(LockT& guard);
+
 protected:
     sqlite3* SQLiteDb = nullptr;
 
     //! This has the image signature table
     sqlite3* PictureSignatureDb = nullptr;
 
+    //! Compiled statements for SQLiteDb
+    PreparedStatementCache Statements;
+
+    //! Compiled statements for PictureSignatureDb
+    PreparedStatementCache SignatureStatements;
+
     //! Used for backups before potentially dangerous operations
     std::string DatabaseFile;
 
@@ -1013,6 +1308,46 @@ protected:
 
     //! Makes sure each DatabaseAction is only loaded once
     SingleLoad<DatabaseAction, int64_t> LoadedDatabaseActions;
+
+    //! Collections that have a renumber queued by _QueueShowOrderRenumber
+    std::unordered_set<DBID> PendingShowOrderRenumbers;
+
+    //! Prepared paths of the database files for opening read connections, empty for in-memory
+    //! databases
+    std::string SQLiteFile;
+    std::string PictureSignatureFile;
+
+    //! Read connections not currently used by a DatabaseReadLock
+    std::vector<std::unique_ptr<ReadConnection>> IdleReadConnections;
+    int ReadConnectionCount = 0;
+
+    std::mutex ReadConnectionMutex;
+    std::condition_variable ReadConnectionNotify;
+
+    //! Applied tags of all images for searching, only updated after BuildImageTagIndex is called
+    TagSearchIndex ImageTagIndex;
+    bool ImageTagIndexLoaded = false;
+
+    //! Tag, modifier, break rule and super alias texts for parsing tags without queries. This and
+    //! the other in-memory indexes are only used while locked
+    TagDictionary TagNames;
+
+    //! Texts suggested by SelectTagSuggestions
+    CompletionIndex TagCompletions;
+
+    //! False when TagNames and TagCompletions need to be rebuilt before the next lookup
+    bool TagNamesValid = false;
+
+    //! How many images use each tag and modifier for ranking TagCompletions. These are kept when
+    //! the names change as counting them goes through all the applied tags. Updated by
+    //! _ChangeTagUseCount
+    std::unordered_map<DBID, int64_t> TagUseCounts;
+    std::unordered_map<DBID, int64_t> ModifierUseCounts;
+    bool TagUseCountsLoaded = false;
+
+    //! Collection names for SelectCollectionNamesByWildcard
+    CompletionIndex CollectionCompletions;
+    bool CollectionCompletionsValid = false;
 };
 
 //! \brief Helper class that automatically commits a transaction when it destructs
@@ -2,6 +2,7 @@
 #include "DownloadManager.h"
 
 #include <boost/filesystem.hpp>
+#include <cryptopp/sha.h>
 
 #include "Common.h"
 #include "DualView.h"
@@ -14,11 +15,51 @@
 #include "Settings.h"
 #include "TimeHelpers.h"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace DV;
 
 // ------------------------------------ //
-DownloadManager::DownloadManager()
+// Run again exception for DownloadJob
+class RetryDownload : std::exception
+{
+};
+
+//! The download thread waits at most this long for activity before checking ThreadQuit
+constexpr auto DOWNLOAD_THREAD_MAX_WAIT_MS = 1000;
+
+//! \brief Limits how many jobs _StartQueuedDownloads pops while looking for a host that isn't
+//! at the limit
+constexpr auto DOWNLOAD_MAX_SKIPPED_JOBS = 32;
+
+struct DownloadManager::ActiveTransfer
+{
+    std::shared_ptr<TaskListWithPriority<std::shared_ptr<DownloadJob>>::TaskItem> Task;
+
+    CurlWrapper Curl;
+    char Error[CURL_ERROR_SIZE] = {};
+
+    std::string Host;
+
+    //! Number of failed attempts
+    int Attempt = 0;
+
+    //! True when the easy handle isn't in the multi handle and waits for RetryAt
+    bool WaitingForRetry = false;
+    std::chrono::steady_clock::time_point RetryAt;
+};
+
+// ------------------------------------ //
+DownloadManager::DownloadManager(int parallelDownloads, int downloadsPerHost) :
+    ParallelDownloads(std::max(parallelDownloads, 1)), DownloadsPerHost(std::max(downloadsPerHost, 1))
 {
+    // Limits the connections in case curl would want to open new ones for a host while old
+    // connections are closing
+    curl_multi_setopt(Multi.Get(), CURLMOPT_MAX_TOTAL_CONNECTIONS, static_cast<long>(ParallelDownloads));
+    curl_multi_setopt(Multi.Get(), CURLMOPT_MAXCONNECTS, static_cast<long>(ParallelDownloads * 2));
+    curl_multi_setopt(Multi.Get(), CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
     DownloadThread = std::thread(&DownloadManager::RunDLThread, this);
 }
 
@@ -27,8 +68,6 @@ DownloadManager::~DownloadManager()
     // Makes sure the thread is marked as closing
     StopDownloads();
 
-    // Notify it just in case it's waiting
-    NotifyThread.notify_all();
     DownloadThread.join();
 
     GUARD_LOCK_OTHER(WorkQueue);
@@ -46,39 +85,239 @@ DownloadManager::~DownloadManager()
 void DownloadManager::StopDownloads()
 {
     ThreadQuit = true;
-    NotifyThread.notify_all();
+    curl_multi_wakeup(Multi.Get());
 }
 
 // ------------------------------------ //
 void DownloadManager::RunDLThread()
 {
-    GUARD_LOCK_OTHER(WorkQueue);
-
     while (!ThreadQuit)
     {
-        // Wait for work //
-        if (WorkQueue.Empty(guard))
-            NotifyThread.wait(guard);
+        _StartQueuedDownloads();
+
+        int running = 0;
+        curl_multi_perform(Multi.Get(), &running);
+
+        _HandleFinishedTransfers();
+
+        if (ThreadQuit)
+            break;
+
+        // Finished transfers may have made room for new ones
+        _StartQueuedDownloads();
+
+        int timeout = DOWNLOAD_THREAD_MAX_WAIT_MS;
+
+        const auto untilRetry = _RestartRetries();
+
+        if (untilRetry >= 0)
+            timeout = std::min(timeout, untilRetry);
+
+        // curl lowers the timeout if it has something to do earlier. QueueDownload and
+        // StopDownloads interrupt this
+        curl_multi_poll(Multi.Get(), nullptr, 0, timeout, nullptr);
+    }
+
+    // Unfinished transfers are put back to the queue so that they are reported as not done
+    if (!Transfers.empty())
+    {
+        LOG_WARNING("DownloadManager: stopping " + std::to_string(Transfers.size()) + " unfinished download(s)");
+
+        GUARD_LOCK_OTHER(WorkQueue);
+
+        for (auto& transfer : Transfers)
+        {
+            if (!transfer->WaitingForRetry)
+                curl_multi_remove_handle(Multi.Get(), transfer->Curl.Get());
+
+            transfer->Task->Task->Retry();
+            WorkQueue.Push(guard, transfer->Task);
+        }
 
+        Transfers.clear();
+        HostTransferCounts.clear();
+        ActiveDownloadCount = 0;
+    }
+
+    LOG_INFO("Download Thread Quit");
+}
+
+void DownloadManager::_StartQueuedDownloads()
+{
+    if (static_cast<int>(Transfers.size()) >= ParallelDownloads)
+        return;
+
+    std::vector<std::shared_ptr<TaskListWithPriority<std::shared_ptr<DownloadJob>>::TaskItem>> skipped;
+
+    GUARD_LOCK_OTHER(WorkQueue);
+
+    while (static_cast<int>(Transfers.size()) < ParallelDownloads && skipped.size() < DOWNLOAD_MAX_SKIPPED_JOBS)
+    {
         auto task = WorkQueue.Pop(guard);
 
         if (!task)
-            continue;
-
-        // Handle the download objects
+            break;
 
         // Unlock while working on an item
         guard.unlock();
 
-        task->Task->DoDownload(*this);
-        // Needed? the tasks are now const
-        // task->Task.reset();
-        task->OnDone();
+        if (!task->Task->UsesNetwork())
+        {
+            // These just read local files so they are not worth running in parallel
+            task->Task->DoDownload(*this);
+            task->OnDone();
+        }
+        else
+        {
+            auto host = Leviathan::StringOperations::BaseHostName(task->Task->GetURL().GetURL());
+
+            if (HostTransferCounts[host] >= DownloadsPerHost)
+            {
+                skipped.push_back(std::move(task));
+            }
+            else
+            {
+                _StartTransfer(std::move(task), host);
+            }
+        }
 
         guard.lock();
     }
 
-    LOG_INFO("Download Thread Quit");
+    // The skipped jobs keep their priority and are tried again when a transfer finishes
+    for (const auto& task : skipped)
+        WorkQueue.Push(guard, task);
+}
+
+void DownloadManager::_StartTransfer(
+    std::shared_ptr<TaskListWithPriority<std::shared_ptr<DownloadJob>>::TaskItem> task, const std::string& host)
+{
+    auto transfer = std::make_unique<ActiveTransfer>();
+    transfer->Task = std::move(task);
+    transfer->Host = host;
+
+    CURL* curl = transfer->Curl.Get();
+
+    if (!transfer->Task->Task->SetupTransfer(curl, transfer->Error))
+    {
+        transfer->Task->OnDone();
+        return;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_SHARE, Share.Get());
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer.get());
+
+    // Waiting for a HTTP/2 connection to be usable for multiplexing is better than opening more
+    // connections
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+
+    ++HostTransferCounts[host];
+
+    curl_multi_add_handle(Multi.Get(), curl);
+
+    Transfers.push_back(std::move(transfer));
+    ActiveDownloadCount = Transfers.size();
+}
+
+int DownloadManager::_RestartRetries()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    int untilNext = -1;
+
+    for (auto& transfer : Transfers)
+    {
+        if (!transfer->WaitingForRetry)
+            continue;
+
+        if (transfer->RetryAt <= now)
+        {
+            transfer->WaitingForRetry = false;
+            transfer->Error[0] = '\0';
+
+            // Adding an easy handle again restarts its transfer
+            curl_multi_add_handle(Multi.Get(), transfer->Curl.Get());
+
+            // Makes sure the poll doesn't wait before curl starts the transfer
+            untilNext = 0;
+            continue;
+        }
+
+        const auto wait = static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(transfer->RetryAt - now).count() + 1);
+
+        if (untilNext < 0 || wait < untilNext)
+            untilNext = wait;
+    }
+
+    return untilNext;
+}
+
+void DownloadManager::_HandleFinishedTransfers()
+{
+    int remaining = 0;
+
+    while (CURLMsg* message = curl_multi_info_read(Multi.Get(), &remaining))
+    {
+        if (message->msg != CURLMSG_DONE)
+            continue;
+
+        CURL* curl = message->easy_handle;
+        const auto result = message->data.result;
+
+        char* privateData = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, &privateData);
+        auto* transfer = reinterpret_cast<ActiveTransfer*>(privateData);
+
+        // message is invalid after this
+        curl_multi_remove_handle(Multi.Get(), curl);
+
+        auto& job = *transfer->Task->Task;
+
+        std::chrono::milliseconds retryDelay(0);
+
+        if (job.OnTransferFinished(curl, result, transfer->Error, transfer->Attempt, retryDelay) ==
+            DOWNLOAD_STEP_RESULT::Finished)
+        {
+            _RemoveTransfer(transfer);
+            continue;
+        }
+
+        if (++transfer->Attempt >= PAGE_SCAN_RETRIES)
+        {
+            job.OnOutOfRetries();
+            _RemoveTransfer(transfer);
+            continue;
+        }
+
+        // The transfer keeps its place so that other jobs to the host don't start while waiting
+        transfer->WaitingForRetry = true;
+        transfer->RetryAt = std::chrono::steady_clock::now() + retryDelay;
+    }
+}
+
+void DownloadManager::_RemoveTransfer(ActiveTransfer* transfer)
+{
+    const auto found = std::find_if(Transfers.begin(), Transfers.end(),
+        [transfer](const std::unique_ptr<ActiveTransfer>& item) { return item.get() == transfer; });
+
+    if (found == Transfers.end())
+    {
+        LOG_ERROR("DownloadManager: finished transfer is not in the list of transfers");
+        return;
+    }
+
+    // Keeps the transfer alive until the task is marked done
+    auto removed = std::move(*found);
+    Transfers.erase(found);
+    ActiveDownloadCount = Transfers.size();
+
+    const auto hostCount = HostTransferCounts.find(removed->Host);
+
+    if (hostCount != HostTransferCounts.end() && --hostCount->second <= 0)
+        HostTransferCounts.erase(hostCount);
+
+    removed->Task->OnDone();
 }
 
 // ------------------------------------ //
@@ -92,7 +331,7 @@ std::shared_ptr<BaseTaskItem> DownloadManager::QueueDownload(
 
     auto task = WorkQueue.Push(guard, job, priority);
 
-    NotifyThread.notify_all();
+    curl_multi_wakeup(Multi.Get());
     return task;
 }
 
@@ -142,12 +381,6 @@ std::string DownloadManager::GetCachePathForURL(const std::string& url)
         .string();
 }
 
-// ------------------------------------ //
-// Run again exception for DownloadJob
-class RetryDownload : std::exception
-{
-};
-
 // ------------------------------------ //
 // DownloadJob
 DownloadJob::DownloadJob(const ProcessableURL& url) : URL(url)
@@ -208,11 +441,47 @@ size_t DV::CurlWriteCallback(char* ptr, size_t size, size_t nmemb, void* userdat
 {
     auto* obj = reinterpret_cast<DownloadJob*>(userdata);
 
-    obj->DownloadBytes.append(ptr, size * nmemb);
+    // Returning a different size makes curl fail the transfer
+    if (!obj->OnDataReceived(ptr, size * nmemb))
+        return 0;
+
     return size * nmemb;
 }
 
+bool DownloadJob::OnDataReceived(const char* data, size_t length)
+{
+    DownloadBytes.append(data, length);
+    return true;
+}
+
 void DownloadJob::DoDownload(DownloadManager& manager)
+{
+    // Holds curl errors //
+    char curlError[CURL_ERROR_SIZE] = {};
+
+    CurlWrapper curlWrapper;
+    CURL* curl = curlWrapper.Get();
+
+    if (!SetupTransfer(curl, curlError))
+        return;
+
+    curl_easy_setopt(curl, CURLOPT_SHARE, manager.GetCurlShare());
+
+    for (int i = 0; i < PAGE_SCAN_RETRIES; ++i)
+    {
+        std::chrono::milliseconds retryDelay(0);
+
+        if (OnTransferFinished(curl, curl_easy_perform(curl), curlError, i, retryDelay) ==
+            DOWNLOAD_STEP_RESULT::Finished)
+            return;
+
+        std::this_thread::sleep_for(retryDelay);
+    }
+
+    OnOutOfRetries();
+}
+
+bool DownloadJob::SetupTransfer(CURL* curl, char* errorBuffer)
 {
     if (URL.HasCanonicalURL())
     {
@@ -223,12 +492,6 @@ void DownloadJob::DoDownload(DownloadManager& manager)
         LOG_INFO("DownloadJob running: " + URL.GetURL());
     }
 
-    // Holds curl errors //
-    char curlError[CURL_ERROR_SIZE];
-
-    CurlWrapper curlWrapper;
-    CURL* curl = curlWrapper.Get();
-
     bool debug = DualView::Get().GetSettings().GetCurlDebug();
 
     if (debug)
@@ -274,8 +537,17 @@ void DownloadJob::DoDownload(DownloadManager& manager)
         if (!escaped)
         {
             LOG_ERROR("Escaping url failed: " + path);
-            HandleError();
-            return;
+
+            try
+            {
+                HandleError();
+            }
+            catch (const RetryDownload&)
+            {
+                LOG_INFO("Ignoring retry request as the url can't be escaped");
+            }
+
+            return false;
         }
 
         // Except we don't want to escape '/'s
@@ -288,8 +560,10 @@ void DownloadJob::DoDownload(DownloadManager& manager)
         curl_free(escaped);
     }
 
-    LOG_INFO("DownloadJob: Escaped download url is: " + finalURL);
-    curl_easy_setopt(curl, CURLOPT_URL, finalURL.c_str());
+    TransferURL = finalURL;
+
+    LOG_INFO("DownloadJob: Escaped download url is: " + TransferURL);
+    curl_easy_setopt(curl, CURLOPT_URL, TransferURL.c_str());
 
     if (URL.HasReferrer())
     {
@@ -305,7 +579,7 @@ void DownloadJob::DoDownload(DownloadManager& manager)
     curl_easy_setopt(curl, CURLOPT_USERAGENT, DOWNLOADER_USER_AGENT);
 
     // Capture error messages
-    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, curlError);
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, errorBuffer);
 
     // Follow redirects
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
@@ -335,74 +609,87 @@ void DownloadJob::DoDownload(DownloadManager& manager)
     curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, &CurlProgressCallback);
     curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0);
 
-    // Do download
-    // TODO: replace the retries and sleeps here to place new download entries into the
-    // dl queue
-    for (int i = 0; i < PAGE_SCAN_RETRIES; ++i)
+    return true;
+}
+
+DOWNLOAD_STEP_RESULT DownloadJob::OnTransferFinished(
+    CURL* curl, CURLcode result, char* errorBuffer, int attempt, std::chrono::milliseconds& retryDelay)
+{
+    retryDelay = std::chrono::milliseconds(350 * static_cast<int>(std::pow(2, attempt + 1)));
+
+    if (result != CURLE_OK)
     {
-        const auto result = curl_easy_perform(curl);
+        // Handle error //
+        errorBuffer[CURL_ERROR_SIZE - 1] = '\0';
+
+        std::string error = errorBuffer;
 
-        if (result == CURLE_OK)
+        LOG_ERROR("Curl failed with error(" + Convert::ToString(result) + "): " + error);
+
+        try
         {
-            // Download finished successfully
+            HandleError();
+        }
+        catch (const RetryDownload&)
+        {
+            Retry();
+            return DOWNLOAD_STEP_RESULT::Retry;
+        }
 
-            // Check HTTP result code
-            long httpCode = 0;
+        return DOWNLOAD_STEP_RESULT::Finished;
+    }
 
-            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+    // Download finished successfully
 
-            if (httpCode != 200)
-            {
-                LOG_ERROR("received HTTP error code: " + Convert::ToString(httpCode) + " from url " + finalURL);
-                LOG_WRITE("Response data: " + DownloadBytes);
-
-                if (httpCode == 429)
-                {
-                    int sleepTime = 2 + (i * 5);
-
-                    LOG_WARNING("Got slow down status code (429). Waiting " + std::to_string(sleepTime) +
-                        " seconds before retry");
-                    std::this_thread::sleep_for(std::chrono::seconds(sleepTime));
-                }
-
-dlRetryLabel:
-                LOG_INFO("Retrying url download: " + finalURL);
-                Retry();
-                std::this_thread::sleep_for(std::chrono::milliseconds(350 * static_cast<int>(std::pow(2, i + 1))));
-                continue;
-            }
+    // Check HTTP result code
+    long httpCode = 0;
 
-            // Get content type
-            char* contentPtr = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
 
-            if (CURLE_OK == curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &contentPtr) && contentPtr)
-            {
-                DownloadedContentType = std::string(contentPtr);
-            }
+    if (httpCode != 200)
+    {
+        LOG_ERROR("received HTTP error code: " + Convert::ToString(httpCode) + " from url " + TransferURL);
+        LOG_WRITE("Response data: " + DownloadBytes);
 
-            try
-            {
-                HandleContent();
-            }
-            catch (const RetryDownload&)
-            {
-                goto dlRetryLabel;
-            }
+        if (httpCode == 429)
+        {
+            const auto slowDown = std::chrono::seconds(2 + (attempt * 5));
 
-            return;
+            LOG_WARNING("Got slow down status code (429). Waiting " + std::to_string(slowDown.count()) +
+                " seconds before retry");
+            retryDelay += slowDown;
         }
 
-        // Handle error //
-        curlError[CURL_ERROR_SIZE - 1] = '\0';
+        LOG_INFO("Retrying url download: " + TransferURL);
+        Retry();
+        return DOWNLOAD_STEP_RESULT::Retry;
+    }
 
-        std::string error = curlError;
+    // Get content type
+    char* contentPtr = nullptr;
 
-        LOG_ERROR("Curl failed with error(" + Convert::ToString(result) + "): " + error);
-        HandleError();
-        return;
+    if (CURLE_OK == curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &contentPtr) && contentPtr)
+    {
+        DownloadedContentType = std::string(contentPtr);
     }
 
-    LOG_ERROR("URL download ran out of retries: " + finalURL);
+    try
+    {
+        HandleContent();
+    }
+    catch (const RetryDownload&)
+    {
+        LOG_INFO("Retrying url download: " + TransferURL);
+        Retry();
+        return DOWNLOAD_STEP_RESULT::Retry;
+    }
+
+    return DOWNLOAD_STEP_RESULT::Finished;
+}
+
+void DownloadJob::OnOutOfRetries()
+{
+    LOG_ERROR("URL download ran out of retries: " + TransferURL);
     try
     {
         HandleError();
@@ -490,9 +777,94 @@ ImageFileDLJob::ImageFileDLJob(const ProcessableURL& url, bool replaceLocal /*=
 {
 }
 
+ImageFileDLJob::~ImageFileDLJob()
+{
+    _DiscardTemporaryFile();
+}
+
+void ImageFileDLJob::Retry()
+{
+    DownloadJob::Retry();
+    _DiscardTemporaryFile();
+}
+
+bool ImageFileDLJob::OnDataReceived(const char* data, size_t length)
+{
+    if (!TemporaryFile.is_open() && !_OpenTemporaryFile())
+        return false;
+
+    TemporaryFile.write(data, length);
+
+    if (!TemporaryFile.good())
+    {
+        LOG_ERROR("ImageFileDLJob: writing to temporary file failed: " + TemporaryPath);
+        return false;
+    }
+
+    Hasher->Update(reinterpret_cast<const unsigned char*>(data), length);
+    ReceivedLength += length;
+
+    if (!ProbeFinished)
+    {
+        HeaderBytes.append(data, length);
+
+        const auto result = ProbeImageHeader(HeaderBytes.data(), HeaderBytes.size(), ImageInfo);
+
+        if (result != IMAGE_PROBE_RESULT::NeedMoreData || HeaderBytes.size() >= IMAGE_PROBE_MAX_READ_SIZE)
+        {
+            ProbeFinished = true;
+            ProbeSucceeded = result == IMAGE_PROBE_RESULT::Success;
+
+            HeaderBytes.clear();
+            HeaderBytes.shrink_to_fit();
+        }
+    }
+
+    // Only a bit of the end needs to be kept, this trims only once in a while to not move the
+    // data on each call
+    TailBytes.append(data, length);
+
+    if (TailBytes.size() > IMAGE_END_MARKER_SEARCH_SIZE * 4)
+        TailBytes.erase(0, TailBytes.size() - IMAGE_END_MARKER_SEARCH_SIZE);
+
+    return true;
+}
+
 void ImageFileDLJob::HandleContent()
 {
-    LOG_WRITE("TODO: check the file integrity as an image before succeeding");
+    // Empty responses don't call OnDataReceived
+    if (!TemporaryFile.is_open() && !_OpenTemporaryFile())
+    {
+        HandleError();
+        return;
+    }
+
+    TemporaryFile.close();
+
+    if (TemporaryFile.fail())
+    {
+        LOG_ERROR("ImageFileDLJob: failed to close temporary file: " + TemporaryPath);
+        HandleError();
+        return;
+    }
+
+    unsigned char digest[CryptoPP::SHA256::DIGESTSIZE];
+    Hasher->Final(digest);
+    FileHash = DualView::EncodeBase64HashDigest(digest, sizeof(digest));
+
+    // The whole file was shorter than what the probe wanted
+    if (!ProbeFinished)
+    {
+        ProbeSucceeded = ProbeImageHeader(HeaderBytes.data(), HeaderBytes.size(), ImageInfo) ==
+            IMAGE_PROBE_RESULT::Success;
+        ProbeFinished = true;
+    }
+
+    RecognizedImage =
+        ProbeSucceeded && HasImageEndMarker(TailBytes.data(), TailBytes.size(), ReceivedLength, ImageInfo);
+
+    if (!RecognizedImage)
+        LOG_INFO("ImageFileDLJob: downloaded data is not a complete image of a known format");
 
     // Generate filename //
     if (ReplaceLocal)
@@ -510,13 +882,81 @@ void ImageFileDLJob::HandleContent()
             false);
     }
 
-    LOG_INFO("Writing downloaded image to file: " + LocalFile);
+    LOG_INFO("Moving downloaded image to file: " + LocalFile);
+
+    try
+    {
+        // Both are in the staging folder so this doesn't copy the data
+        boost::filesystem::rename(TemporaryPath, LocalFile);
+    }
+    catch (const boost::filesystem::filesystem_error& e)
+    {
+        LOG_ERROR("ImageFileDLJob: failed to move the downloaded file: " + std::string(e.what()));
+        LocalFile.clear();
+        HandleError();
+        return;
+    }
 
-    Leviathan::FileSystem::WriteToFile(DownloadBytes, LocalFile);
+    TemporaryPath.clear();
 
     OnFinished(true);
 }
 
+void ImageFileDLJob::HandleError()
+{
+    _DiscardTemporaryFile();
+    DownloadJob::HandleError();
+}
+
+bool ImageFileDLJob::_OpenTemporaryFile()
+{
+    _DiscardTemporaryFile();
+
+    TemporaryPath = (boost::filesystem::path(DualView::Get().GetSettings().GetStagingFolder()) /
+        boost::filesystem::unique_path("dl-%%%%-%%%%-%%%%-%%%%.part"))
+                        .string();
+
+    TemporaryFile.open(TemporaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!TemporaryFile.is_open())
+    {
+        LOG_ERROR("ImageFileDLJob: failed to open temporary file: " + TemporaryPath);
+        TemporaryPath.clear();
+        return false;
+    }
+
+    Hasher = std::make_unique<CryptoPP::SHA256>();
+    return true;
+}
+
+void ImageFileDLJob::_DiscardTemporaryFile()
+{
+    if (TemporaryFile.is_open())
+        TemporaryFile.close();
+
+    // Clears failbit left by an earlier failed open or write so that the stream can be reused
+    TemporaryFile.clear();
+
+    if (!TemporaryPath.empty())
+    {
+        boost::system::error_code error;
+        boost::filesystem::remove(TemporaryPath, error);
+        TemporaryPath.clear();
+    }
+
+    Hasher.reset();
+    FileHash.clear();
+
+    HeaderBytes.clear();
+    ProbeFinished = false;
+    ProbeSucceeded = false;
+    TailBytes.clear();
+    ReceivedLength = 0;
+
+    ImageInfo = ImageHeaderInfo();
+    RecognizedImage = false;
+}
+
 // ------------------------------------ //
 // LocallyCachedDLJob
 LocallyCachedDLJob::LocallyCachedDLJob(const std::string& file) : DownloadJob(ProcessableURL(file, true))
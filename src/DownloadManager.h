@@ -1,17 +1,28 @@
 #pragma once
 
 #include <atomic>
-#include <condition_variable>
+#include <chrono>
+#include <fstream>
 #include <functional>
 #include <list>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include "Common.h"
+#include "CurlWrapper.h"
+#include "ImageProbe.h"
 #include "ProcessableURL.h"
 #include "ScanResult.h"
 #include "TaskListWithPriority.h"
 
+namespace CryptoPP
+{
+class SHA256;
+} // namespace CryptoPP
+
 namespace DV
 {
 constexpr auto PAGE_SCAN_RETRIES = 6;
@@ -20,6 +31,14 @@ constexpr auto DOWNLOADER_USER_AGENT = "Mozilla/5.0 (X11; Linux x86_64; rv:109.0
 
 class DownloadManager;
 
+//! \brief What should be done with a DownloadJob after a transfer attempt
+enum class DOWNLOAD_STEP_RESULT
+{
+    Finished,
+    //! The transfer should be ran again after a delay
+    Retry
+};
+
 size_t CurlWriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
 
 //! \brief A job for the downloader to do
@@ -32,8 +51,32 @@ public:
     virtual ~DownloadJob() = default;
 
     //! \brief Called on the download thread to process this download
+    //!
+    //! DownloadManager only calls this for jobs that don't use the network, the default
+    //! implementation runs the whole download as a blocking transfer
     virtual void DoDownload(DownloadManager& manager);
 
+    //! \returns False if this job replaces DoDownload with something that doesn't download
+    //! anything, in which case DownloadManager doesn't count it as a transfer
+    [[nodiscard]] virtual bool UsesNetwork() const
+    {
+        return true;
+    }
+
+    //! \brief Sets the options on an easy handle for downloading this job
+    //! \param errorBuffer Buffer of size CURL_ERROR_SIZE for curl errors
+    //! \returns False if the url can't be used. HandleError has been called in that case
+    bool SetupTransfer(CURL* curl, char* errorBuffer);
+
+    //! \brief Handles the result of a transfer of an easy handle set up with SetupTransfer
+    //! \param attempt How many times the transfer has been retried already
+    //! \param retryDelay Set to how long to wait before retrying when this returns Retry
+    DOWNLOAD_STEP_RESULT OnTransferFinished(
+        CURL* curl, CURLcode result, char* errorBuffer, int attempt, std::chrono::milliseconds& retryDelay);
+
+    //! \brief Fails this job after it has been retried PAGE_SCAN_RETRIES times
+    void OnOutOfRetries();
+
     //! \brief Called from curl when the download has progressed
     //! \returns True if download should be canceled
     //! \todo Actually implement timeout
@@ -50,7 +93,7 @@ public:
     }
 
     //! Resets the state to allow retrying this download
-    void Retry()
+    virtual void Retry()
     {
         DownloadBytes.clear();
         HasFinished = false;
@@ -80,6 +123,10 @@ public:
     }
 
 protected:
+    //! \brief Called from curl with each piece of the received data
+    //! \returns False if the download should be stopped because the data can't be stored
+    virtual bool OnDataReceived(const char* data, size_t length);
+
     virtual void HandleContent() = 0;
 
     virtual void HandleError()
@@ -99,6 +146,9 @@ protected:
     //! Contains the content type after fetching has the content type if the server sent the type to us
     std::string DownloadedContentType;
 
+    //! The escaped url given to curl
+    std::string TransferURL;
+
     bool HasFinished = false;
     bool HasSucceeded = true;
 
@@ -143,32 +193,94 @@ public:
 
     void DoDownload(DownloadManager& manager) override;
 
+    [[nodiscard]] bool UsesNetwork() const override
+    {
+        return false;
+    }
+
 private:
     std::string FilePath;
 };
 
 //! \brief Downloads a file to a local file in the staging folder
+//!
+//! The data is written to a temporary file as it arrives instead of keeping it in memory. The
+//! file hash and the image header information are calculated while downloading so that the
+//! finished file doesn't need to be read again
 class ImageFileDLJob : public DownloadJob
 {
 public:
     //! \param replaceLocal If true the local filename is not made unique before downloading.
     //! if false numbers are added to the end of the name if it exists already
     explicit ImageFileDLJob(const ProcessableURL& url, bool replaceLocal = false);
+    ~ImageFileDLJob() override;
+
+    void Retry() override;
 
     [[nodiscard]] auto GetLocalFile() const
     {
         return LocalFile;
     }
 
+    //! \returns The hash of LocalFile, same as DualView::CalculateBase64EncodedFileHash would
+    //! calculate. Empty until the download has succeeded
+    [[nodiscard]] const std::string& GetFileHash() const
+    {
+        return FileHash;
+    }
+
+    //! \returns True if ProbeImageHeader recognized the file and it wasn't cut off
+    [[nodiscard]] bool IsRecognizedImage() const
+    {
+        return RecognizedImage;
+    }
+
+    //! \returns The format and dimensions of the downloaded image if IsRecognizedImage is true
+    [[nodiscard]] const ImageHeaderInfo& GetImageInfo() const
+    {
+        return ImageInfo;
+    }
+
 protected:
-    //! Writes the received data to a file
+    bool OnDataReceived(const char* data, size_t length) override;
+
+    //! Moves the temporary file to the staging folder
     void HandleContent() override;
 
+    void HandleError() override;
+
+    bool _OpenTemporaryFile();
+
+    //! \brief Closes and deletes the temporary file (if open) and resets the state calculated
+    //! from the received data
+    void _DiscardTemporaryFile();
+
 protected:
-    //! Once download has started (or finished) this contains the local file path
+    //! Once download has finished this contains the local file path
     std::string LocalFile;
 
     bool ReplaceLocal;
+
+    //! The file in the staging folder that the data is written to while downloading
+    std::string TemporaryPath;
+    std::ofstream TemporaryFile;
+
+    std::unique_ptr<CryptoPP::SHA256> Hasher;
+    std::string FileHash;
+
+    //! Start of the data for ProbeImageHeader, cleared once the probe has finished
+    std::string HeaderBytes;
+    bool ProbeFinished = false;
+    bool ProbeSucceeded = false;
+
+    //! The last bytes of the data for HasImageEndMarker
+    std::string TailBytes;
+
+    //! Length of all of the received data
+    uint64_t ReceivedLength = 0;
+
+    ImageHeaderInfo ImageInfo;
+    bool RecognizedImage = false;
 };
 
 //! \brief A fake download that loads a local file
@@ -180,6 +292,11 @@ public:
 
     void DoDownload(DownloadManager& manager) override;
 
+    [[nodiscard]] bool UsesNetwork() const override
+    {
+        return false;
+    }
+
 protected:
     void HandleContent() override;
 };
@@ -196,19 +313,51 @@ protected:
 
 //! \brief Handles scanning pages for content and downloading found content
 //!
-//! Uses plugins to handle contents of webpages once downloaded
+//! Uses plugins to handle contents of webpages once downloaded. The download thread runs
+//! multiple transfers at once with a curl multi handle so that connections to the same host are
+//! reused (and HTTP/2 connections are multiplexed). Jobs are started in the WorkQueue priority
+//! order, jobs whose host already has the maximum number of transfers are skipped until one of
+//! them finishes.
 class DownloadManager
 {
+    struct ActiveTransfer;
+
 public:
-    DownloadManager();
+    //! \param parallelDownloads Maximum number of transfers running at once
+    //! \param downloadsPerHost Maximum number of transfers to a single host at once
+    DownloadManager(int parallelDownloads = DUALVIEW_SETTINGS_DEFAULT_PARALLEL_DOWNLOADS,
+        int downloadsPerHost = DUALVIEW_SETTINGS_DEFAULT_DOWNLOADS_PER_HOST);
     ~DownloadManager();
 
-    //! \brief Makes the download thread quit after it has processed the current download
+    //! \brief Makes the download thread quit. Transfers that are in progress are put back into
+    //! the queue
     void StopDownloads();
 
     //! \brief Adds an item to the work queue
     std::shared_ptr<BaseTaskItem> QueueDownload(std::shared_ptr<DownloadJob> job, int64_t priority = -1);
 
+    //! \returns The number of transfers that are running or waiting to be retried
+    [[nodiscard]] size_t CountActiveDownloads() const
+    {
+        return ActiveDownloadCount;
+    }
+
+    [[nodiscard]] auto GetParallelDownloads() const
+    {
+        return ParallelDownloads;
+    }
+
+    [[nodiscard]] auto GetDownloadsPerHost() const
+    {
+        return DownloadsPerHost;
+    }
+
+    //! \brief The share handle used by all transfers to share DNS and TLS session caches
+    [[nodiscard]] CURLSH* GetCurlShare()
+    {
+        return Share.Get();
+    }
+
     //! \brief Extracts a filename from an url
     [[nodiscard]] static std::string ExtractFileName(const std::string& url);
 
@@ -229,14 +378,46 @@ protected:
     //! Main function for DownloadThread
     void RunDLThread();
 
+    //! \brief Starts transfers for queued jobs until the limits are reached
+    //!
+    //! Also runs the jobs that don't use the network
+    void _StartQueuedDownloads();
+
+    void _StartTransfer(std::shared_ptr<TaskListWithPriority<std::shared_ptr<DownloadJob>>::TaskItem> task,
+        const std::string& host);
+
+    //! \brief Restarts the transfers whose retry delay has passed
+    //! \returns The time in milliseconds until the next retry should start, or -1
+    int _RestartRetries();
+
+    //! \brief Processes the transfers curl has finished
+    void _HandleFinishedTransfers();
+
+    //! \brief Removes a transfer and marks its task as done
+    void _RemoveTransfer(ActiveTransfer* transfer);
+
 protected:
+    const int ParallelDownloads;
+    const int DownloadsPerHost;
+
+    //! Shared by all the easy handles so this needs to be destroyed last
+    CurlShareWrapper Share;
+
+    CurlMultiWrapper Multi;
+
     std::thread DownloadThread;
 
     std::atomic<bool> ThreadQuit{false};
 
-    std::condition_variable NotifyThread;
-
     TaskListWithPriority<std::shared_ptr<DownloadJob>> WorkQueue;
+
+    //! Running transfers, only used by the download thread
+    std::vector<std::unique_ptr<ActiveTransfer>> Transfers;
+
+    //! Number of transfers in Transfers for each host
+    std::unordered_map<std::string, int> HostTransferCounts;
+
+    std::atomic<size_t> ActiveDownloadCount{0};
 };
 
 } // namespace DV
@@ -2,7 +2,9 @@
 #include "DualView.h"
 
 #include <chrono>
+#include <fstream>
 #include <iostream>
+#include <unordered_set>
 
 #include <boost/filesystem.hpp>
 #include <cryptopp/sha.h>
@@ -408,8 +410,7 @@ void DualView::_OnInstanceLoaded()
     // Gtk::AccelMap::add_entry("<CollectionList-Item>/Right/Help", GDK_KEY_H,
     //    Gdk::CONTROL_MASK);
 
-    // Start worker threads //
-    _StartWorkerThreads();
+    // Worker threads are started by the load thread once the settings are loaded
 
     LOG_INFO("Basic initialization completed");
 
@@ -432,6 +433,9 @@ bool DualView::_DoInitThreadAction()
 
     _Settings->VerifyFoldersExist();
 
+    // Start worker threads //
+    _StartWorkerThreads();
+
     // Load curl //
     _CurlWrapper = std::make_unique<CurlWrapper>();
 
@@ -464,11 +468,27 @@ bool DualView::_DoInitThreadAction()
         _PluginManager->PrintPluginStats();
     }
 
-    // Start downloader threads and load more curl instances
-    _DownloadManager = std::make_unique<DownloadManager>();
+    // Start downloader thread, this also initializes curl
+    _DownloadManager = std::make_unique<DownloadManager>(
+        _Settings->GetParallelDownloads(), _Settings->GetDownloadsPerHost());
 
     // Load ImageMagick library //
-    _CacheManager = std::make_unique<CacheManager>();
+    _CacheManager = std::make_unique<CacheManager>(
+        static_cast<size_t>(std::max(_Settings->GetImageCacheMegabytes(), 1)) * 1024 * 1024,
+        _Settings->GetFullImageLoadThreads(), _Settings->GetThumbnailGenerationThreads());
+
+    if (_Settings->GetUseThumbnailPack())
+    {
+        try
+        {
+            _CacheManager->EnableThumbnailPack(GetThumbnailPackFolder());
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR("Opening thumbnail pack failed, using separate thumbnail files instead: " +
+                std::string(e.what()));
+        }
+    }
 
     // Load database //
     // Database object
@@ -493,7 +513,27 @@ bool DualView::_DoInitThreadAction()
         return true;
     }
 
-    DatabaseThread = std::thread(&DualView::_RunDatabaseThread, this);
+    if (_Settings->GetDatabaseReadConnections() > 0)
+    {
+        try
+        {
+            _Database->OpenReadConnections(_Settings->GetDatabaseReadConnections());
+        }
+        catch (const Leviathan::InvalidState& e)
+        {
+            LOG_ERROR("Opening database read connections failed:");
+            e.PrintToLog();
+        }
+    }
+
+    Executor.StartDatabaseThread();
+
+    // Image searches use this index, so it is loaded before the user gets to searching
+    QueueDBThreadFunction([this]() { _Database->BuildImageTagIndexAG(); });
+
+    // Same for the dictionary that tag parsing and suggestions use
+    QueueDBThreadFunction([this]() { _Database->BuildTagDictionaryAG(); });
+    QueueDBThreadFunction([this]() { _Database->BuildCollectionCompletionsAG(); });
 
     // Succeeded //
     return false;
@@ -696,61 +736,62 @@ void DualView::QueueImageHashCalculate(std::shared_ptr<Image> img)
 
     HashImageQueue.push_back(img);
 
-    HashCalculationThreadNotify.notify_all();
+    if (RunningHashTasks >= HashTaskLimit)
+        return;
+
+    ++RunningHashTasks;
+    QueueWorkerFunction(std::bind(&DualView::_RunHashCalculateTask, this));
 }
 
-void DualView::_RunHashCalculateThread()
+void DualView::_RunHashCalculateTask()
 {
     std::unique_lock<std::mutex> lock(HashImageQueueMutex);
 
-    while (!QuitWorkerThreads)
+    while (!HashImageQueue.empty() && !QuitWorkerThreads)
     {
-        if (HashImageQueue.empty())
-            HashCalculationThreadNotify.wait(lock);
+        auto img = HashImageQueue.front().lock();
 
-        while (!HashImageQueue.empty())
-        {
-            auto img = HashImageQueue.front().lock();
-
-            HashImageQueue.pop_front();
+        HashImageQueue.pop_front();
 
-            if (!img)
-            {
-                // Image has been deallocated already //
-                continue;
-            }
+        if (!img)
+        {
+            // Image has been deallocated already //
+            continue;
+        }
 
-            lock.unlock();
+        lock.unlock();
 
-            img->_DoHashCalculation();
+        img->_DoHashCalculation();
 
-            lock.lock();
+        lock.lock();
 
-            // Replace with an existing image if the hash exists //
-            try
-            {
-                auto existing = _Database->SelectImageByHashAG(img->GetHash());
+        // Replace with an existing image if the hash exists //
+        try
+        {
+            auto existing = _Database->SelectImageByHashAG(img->GetHash());
 
-                if (existing)
-                {
-                    LOG_INFO("Calculated hash for a duplicate image");
-                    img->BecomeDuplicateOf(*existing);
-                    continue;
-                }
-            }
-            catch (const InvalidSQL&)
+            if (existing)
             {
-                // Database probably isn't initialized
-            }
-            catch (const Leviathan::InvalidState& e)
-            {
-                LOG_ERROR("Image hash calculation failed, exception:");
-                e.PrintToLog();
+                LOG_INFO("Calculated hash for a duplicate image");
+                img->BecomeDuplicateOf(*existing);
+                continue;
             }
-
-            img->_OnFinishHash();
         }
+        catch (const InvalidSQL&)
+        {
+            // Database probably isn't initialized
+        }
+        catch (const Leviathan::InvalidState& e)
+        {
+            LOG_ERROR("Image hash calculation failed, exception:");
+            e.PrintToLog();
+        }
+
+        img->_OnFinishHash();
     }
+
+    // This is decreased while still locked so that an image queued right now gets a new task
+    --RunningHashTasks;
 }
 
 // ------------------------------------ //
@@ -759,11 +800,7 @@ void DualView::QueueDBThreadFunction(std::function<void()> func, int64_t priorit
     if (priority == -1)
         priority = TimeHelpers::GetCurrentUnixTimestamp();
 
-    GUARD_LOCK_OTHER(DatabaseFuncQueue);
-
-    DatabaseFuncQueue.Push(guard, std::make_unique<std::function<void()>>(func), priority);
-
-    DatabaseThreadNotify.notify_all();
+    Executor.Queue(EXECUTOR_LANE::Database, std::move(func), priority);
 }
 
 void DualView::QueueWorkerFunction(std::function<void()> func, int64_t priority /*= -1*/)
@@ -771,11 +808,7 @@ void DualView::QueueWorkerFunction(std::function<void()> func, int64_t priority
     if (priority == -1)
         priority = TimeHelpers::GetCurrentUnixTimestamp();
 
-    GUARD_LOCK_OTHER(WorkerFuncQueue);
-
-    WorkerFuncQueue.Push(guard, std::make_unique<std::function<void()>>(func), priority);
-
-    WorkerThreadNotify.notify_one();
+    Executor.Queue(EXECUTOR_LANE::Worker, std::move(func), priority);
 }
 
 void DualView::QueueConditional(std::function<bool()> func)
@@ -787,48 +820,6 @@ void DualView::QueueConditional(std::function<bool()> func)
     ConditionalWorkerThreadNotify.notify_one();
 }
 
-void DualView::_RunDatabaseThread()
-{
-    GUARD_LOCK_OTHER(DatabaseFuncQueue);
-
-    while (!QuitWorkerThreads)
-    {
-        if (DatabaseFuncQueue.Empty(guard))
-            DatabaseThreadNotify.wait(guard);
-
-        while (auto task = DatabaseFuncQueue.Pop(guard))
-        {
-            guard.unlock();
-
-            task->Task->operator()();
-            task->OnDone();
-
-            guard.lock();
-        }
-    }
-}
-
-void DualView::_RunWorkerThread()
-{
-    GUARD_LOCK_OTHER(WorkerFuncQueue);
-
-    while (!QuitWorkerThreads)
-    {
-        if (WorkerFuncQueue.Empty(guard))
-            WorkerThreadNotify.wait(guard);
-
-        while (auto task = WorkerFuncQueue.Pop(guard))
-        {
-            guard.unlock();
-
-            task->Task->operator()();
-            task->OnDone();
-
-            guard.lock();
-        }
-    }
-}
-
 void DualView::_RunConditionalThread()
 {
     std::unique_lock<std::mutex> lock(ConditionalFuncQueueMutex);
@@ -868,9 +859,8 @@ void DualView::_RunConditionalThread()
 // ------------------------------------ //
 void DualView::InvokeFunction(std::function<void()> func)
 {
-    std::unique_lock<std::mutex> lock(InvokeQueueMutex);
-
-    InvokeQueue.push_back(func);
+    // All invokes have the same priority to run them in the order they were queued
+    Executor.Queue(EXECUTOR_LANE::Main, std::move(func), 0);
 
     // Notify main thread
     InvokeDispatcher.emit();
@@ -894,36 +884,36 @@ void DualView::_ProcessInvokeQueue()
     if (!LoadCompletelyFinished)
         return;
 
-    std::unique_lock<std::mutex> lock(InvokeQueueMutex);
-
     // To not completely lock up the main thread, there's a max  number of invokes to process
     // at once
-    int processedInvokes = 0;
-
-    while (!InvokeQueue.empty())
-    {
-        const auto func = InvokeQueue.front();
+    Executor.RunMainLane(MAX_INVOKES_PER_CALL);
+}
 
-        InvokeQueue.pop_front();
+// ------------------------------------ //
+void DualView::_StartWorkerThreads()
+{
+    QuitWorkerThreads = false;
 
-        lock.unlock();
+    // Hashing is disk and CPU bound so multiple files are processed at once
+    int hashThreads = _Settings ? _Settings->GetHashCalculationThreads() : 0;
 
-        func();
+    if (hashThreads < 1)
+        hashThreads = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, 4);
 
-        lock.lock();
+    {
+        std::lock_guard<std::mutex> lock(HashImageQueueMutex);
+        HashTaskLimit = hashThreads;
 
-        if (++processedInvokes >= MAX_INVOKES_PER_CALL)
-            break;
+        // Images queued before the workers were started
+        while (RunningHashTasks < HashTaskLimit && RunningHashTasks < static_cast<int>(HashImageQueue.size()))
+        {
+            ++RunningHashTasks;
+            QueueWorkerFunction(std::bind(&DualView::_RunHashCalculateTask, this));
+        }
     }
-}
 
-// ------------------------------------ //
-void DualView::_StartWorkerThreads()
-{
-    QuitWorkerThreads = false;
+    Executor.StartWorkers(_Settings ? _Settings->GetWorkerThreads() : 0);
 
-    HashCalculationThread = std::thread(std::bind(&DualView::_RunHashCalculateThread, this));
-    Worker1Thread = std::thread(std::bind(&DualView::_RunWorkerThread, this));
     ConditionalWorker1 = std::thread(std::bind(&DualView::_RunConditionalThread, this));
 }
 
@@ -932,23 +922,13 @@ void DualView::_WaitForWorkerThreads()
     // Make sure this is set //
     QuitWorkerThreads = true;
 
-    HashCalculationThreadNotify.notify_all();
-    DatabaseThreadNotify.notify_all();
-    WorkerThreadNotify.notify_all();
     ConditionalWorkerThreadNotify.notify_all();
 
-    if (HashCalculationThread.joinable())
-        HashCalculationThread.join();
-
-    if (DatabaseThread.joinable())
-        DatabaseThread.join();
+    Executor.Stop();
 
     if (DateInitThread.joinable())
         DateInitThread.join();
 
-    if (Worker1Thread.joinable())
-        Worker1Thread.join();
-
     if (ConditionalWorker1.joinable())
         ConditionalWorker1.join();
 }
@@ -1762,6 +1742,11 @@ std::string DualView::GetThumbnailFolder() const
         .c_str();
 }
 
+std::string DualView::GetThumbnailPackFolder() const
+{
+    return (boost::filesystem::path(GetThumbnailFolder()) / boost::filesystem::path("pack/")).string();
+}
+
 // ------------------------------------ //
 // Database saving functions
 bool DualView::AddToCollection(std::vector<std::shared_ptr<Image>> resources, bool move, std::string collectionname,
@@ -1908,7 +1893,8 @@ bool DualView::AddToCollection(std::vector<std::shared_ptr<Image>> resources, bo
             LEVIATHAN_ASSERT(actualresource, "actualresource not set in DualView import image");
 
             // Associate with collection //
-            addtocollection->AddImage(actualresource, ++order, guard);
+            order += DATABASE_SHOW_ORDER_GAP;
+            addtocollection->AddImage(actualresource, order, guard);
 
             currentitem++;
 
@@ -2618,7 +2604,7 @@ thingwasvalidlabel:
         }
 
         // Also we want to get longer tags that start with the same thing //
-        RetrieveTagsMatching(result, str);
+        RetrieveTagsMatching(result, str, maxcount);
     }
     else
     {
@@ -2632,7 +2618,7 @@ thingwasvalidlabel:
             SUGG_DEBUG("Finding suggestions: " + currentpart);
 
             std::vector<std::string> tmpholder;
-            RetrieveTagsMatching(tmpholder, currentpart);
+            RetrieveTagsMatching(tmpholder, currentpart, maxcount);
 
             result.reserve(result.size() + tmpholder.size());
 
@@ -2677,10 +2663,16 @@ thingwasvalidlabel:
         }
     }
 
-    // Sort the most relevant results first //
-    DV::SortSuggestions(result.begin(), result.end(), str);
+    // The results are already ranked by use count, this only moves the exact and prefix matches
+    // first //
+    DV::GroupSuggestions(result.begin(), result.end(), str);
 
-    result.erase(std::unique(result.begin(), result.end()), result.end());
+    // The first of the duplicates is the better ranked one
+    std::unordered_set<std::string> seen;
+
+    result.erase(std::remove_if(result.begin(), result.end(),
+                     [&seen](const std::string& suggestion) { return !seen.insert(suggestion).second; }),
+        result.end());
 
     if (result.size() > maxcount)
         result.resize(maxcount);
@@ -2693,17 +2685,9 @@ thingwasvalidlabel:
 }
 
 // ------------------------------------ //
-void DualView::RetrieveTagsMatching(std::vector<std::string>& result, const std::string& str) const
+void DualView::RetrieveTagsMatching(std::vector<std::string>& result, const std::string& str, size_t max) const
 {
-    _Database->SelectTagNamesWildcard(result, str);
-
-    _Database->SelectTagAliasesWildcard(result, str);
-
-    _Database->SelectTagModifierNamesWildcard(result, str);
-
-    _Database->SelectTagBreakRulesByStrWildcard(result, str);
-
-    _Database->SelectTagSuperAliasWildcard(result, str);
+    _Database->SelectTagSuggestions(result, str, max);
 }
 
 // ------------------------------------ //
@@ -2891,6 +2875,15 @@ std::string DualView::MakePathUniqueAndShort(const std::string& path, bool allow
     return MakePathUniqueAndShort(finaltarget.string(), allowCuttingFolder);
 }
 
+std::string DualView::EncodeBase64HashDigest(const unsigned char* digest, size_t length)
+{
+    // Encode it //
+    std::string hash = base64_encode(digest, static_cast<unsigned int>(length));
+
+    // Make it path safe //
+    return Leviathan::StringOperations::ReplaceSingleCharacter<std::string>(hash, '/', '_');
+}
+
 std::string DualView::CalculateBase64EncodedHash(const std::string& str)
 {
     // Calculate sha256 hash //
@@ -2900,9 +2893,38 @@ std::string DualView::CalculateBase64EncodedHash(const std::string& str)
 
     static_assert(sizeof(digest) == CryptoPP::SHA256::DIGESTSIZE, "sizeof funkyness");
 
-    // Encode it //
-    std::string hash = base64_encode(digest, sizeof(digest));
+    return EncodeBase64HashDigest(digest, sizeof(digest));
+}
 
-    // Make it path safe //
-    return Leviathan::StringOperations::ReplaceSingleCharacter<std::string>(hash, '/', '_');
+std::string DualView::CalculateBase64EncodedFileHash(
+    const std::string& file, size_t chunksize /*= DUALVIEW_HASH_READ_CHUNK_SIZE*/)
+{
+    if (chunksize < 1)
+        throw Leviathan::InvalidArgument("chunksize must be at least 1");
+
+    std::ifstream reader(file, std::ios::in | std::ios::binary);
+
+    if (!reader.good())
+        throw Leviathan::InvalidArgument("Failed to open file for hashing: " + file);
+
+    CryptoPP::SHA256 hasher;
+    std::vector<char> buffer(chunksize);
+
+    while (reader.good())
+    {
+        reader.read(buffer.data(), buffer.size());
+
+        const auto read = reader.gcount();
+
+        if (read > 0)
+            hasher.Update(reinterpret_cast<const unsigned char*>(buffer.data()), static_cast<size_t>(read));
+    }
+
+    if (reader.bad())
+        throw Leviathan::InvalidArgument("Failed to read file for hashing: " + file);
+
+    unsigned char digest[CryptoPP::SHA256::DIGESTSIZE];
+    hasher.Final(digest);
+
+    return EncodeBase64HashDigest(digest, sizeof(digest));
 }
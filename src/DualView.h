@@ -1,7 +1,7 @@
 #pragma once
 #include <gtkmm.h>
 
-#include "TaskListWithPriority.h"
+#include "WorkExecutor.h"
 #include "windows/BaseWindow.h"
 
 #include "Common.h"
@@ -56,6 +56,9 @@ class MaintenanceTools;
 
 struct ResolvePathInfinityBlocker;
 
+//! Size of the pieces files are read in when calculating their hash
+constexpr size_t DUALVIEW_HASH_READ_CHUNK_SIZE = 1024 * 1024;
+
 //! \brief Main class that contains all the windows and systems
 class DualView {
 public:
@@ -208,6 +211,18 @@ public:
     //! Also any characters not valid in paths will be replaced
     static std::string CalculateBase64EncodedHash(const std::string& str);
 
+    //! \brief Calculates the same hash as CalculateBase64EncodedHash but for the contents of a file
+    //!
+    //! The file is read in chunksize pieces so memory use doesn't depend on the file size
+    //! \exception Leviathan::InvalidArgument if the file can't be read
+    static std::string CalculateBase64EncodedFileHash(
+        const std::string& file, size_t chunksize = DUALVIEW_HASH_READ_CHUNK_SIZE);
+
+    //! \brief Encodes a sha256 digest like CalculateBase64EncodedHash does
+    //!
+    //! For when the hash is calculated in pieces somewhere else
+    static std::string EncodeBase64HashDigest(const unsigned char* digest, size_t length);
+
     //! \brief Moves an image to the folder determined from the collection's name
     //! \return True if succeeded, false if it failed for some reason
     //! \param move If true the file will be moved. If false the file will be copied instead
@@ -293,7 +308,8 @@ public:
 
     //! \brief Retrieves tag names, modifiers, aliases, super aliases, and common modifiers
     //! containing str
-    void RetrieveTagsMatching(std::vector<std::string>& result, const std::string& str) const;
+    //! \param max The maximum number of retrieved texts, the most used ones are picked
+    void RetrieveTagsMatching(std::vector<std::string>& result, const std::string& str, size_t max) const;
 
 
 
@@ -330,6 +346,9 @@ public:
     //! \brief Returns the thumbnail folder
     std::string GetThumbnailFolder() const;
 
+    //! \brief Returns the folder ThumbnailPack segments are stored in
+    std::string GetThumbnailPackFolder() const;
+
     //! \brief Returns the CacheManager. use to load images
     //! \todo Assert if _CacheManager is null
     inline CacheManager& GetCacheManager() const
@@ -351,6 +370,12 @@ public:
         return *_Settings;
     }
 
+    //! \brief Returns the executor running the worker, database and main thread functions
+    inline WorkExecutor& GetExecutor()
+    {
+        return Executor;
+    }
+
     //! \brief Returns the logger object
     inline Leviathan::Logger* GetLogger() const
     {
@@ -420,19 +445,13 @@ protected:
     //! other windows open.
     void _AddOpenWindow(std::shared_ptr<BaseWindow> window, Gtk::Window& gtk);
 
-    //! \brief Processes InvokeQueue
+    //! \brief Runs the functions queued with InvokeFunction
     void _ProcessInvokeQueue();
 
-    //! \brief Processes hash calculation queue
+    //! \brief Processes hash calculation queue, ran as a worker task
     //! \todo Make this return images that are duplicates of currently loaded images,
     //! that are loaded but aren't in the database
-    void _RunHashCalculateThread();
-
-    //! \brief Processes DatabaseFuncQueue
-    void _RunDatabaseThread();
-
-    //! \brief Processer worker queue
-    void _RunWorkerThread();
+    void _RunHashCalculateTask();
 
     //! \brief Conditional worker thread
     void _RunConditionalThread();
@@ -532,10 +551,6 @@ private:
     //! Emitted on when a worker thread wants to run something on the main thread
     Glib::Dispatcher InvokeDispatcher;
 
-    //! Queued functions to run on the main thread
-    std::list<std::function<void()>> InvokeQueue;
-    std::mutex InvokeQueueMutex;
-
     //! Mutex for accessing QueuedCmds
     std::mutex QueuedCmdsMutex;
 
@@ -600,26 +615,17 @@ private:
     //! A wrapper for the global curl instance
     std::unique_ptr<CurlWrapper> _CurlWrapper;
 
-    //! Hash loading thread
-    std::thread HashCalculationThread;
-    std::condition_variable HashCalculationThreadNotify;
+    //! Runs the worker, database and main thread (invoke) functions
+    WorkExecutor Executor;
 
+    //! Images waiting for hash calculation. Hashing runs as worker tasks but only up to
+    //! HashTaskLimit of them at once as it is mostly disk bound
     std::list<std::weak_ptr<Image>> HashImageQueue;
     std::mutex HashImageQueueMutex;
 
-
-    //! Database background thread
-    std::thread DatabaseThread;
-    std::condition_variable DatabaseThreadNotify;
-
-    TaskListWithPriority<std::unique_ptr<std::function<void()>>> DatabaseFuncQueue;
-
-    //! Worker threads
-    std::thread Worker1Thread;
-
-    std::condition_variable WorkerThreadNotify;
-
-    TaskListWithPriority<std::unique_ptr<std::function<void()>>> WorkerFuncQueue;
+    //! HashImageQueueMutex must be locked when accessing these
+    int HashTaskLimit = 0;
+    int RunningHashTasks = 0;
 
     //! Conditional worker
     std::thread ConditionalWorker1;
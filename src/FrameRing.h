@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace DV
+{
+//! \brief Fixed size ring of converted animation frames ahead of the shown frame
+//!
+//! The ring covers the frames from the playhead (the shown frame) onwards, wrapping around to
+//! the first frame. Moving the playhead releases the frames that were passed so that their
+//! slots can be used for the frames further ahead.
+//! \note This is not thread safe, AnimationFrameBuffer uses this while locked
+template<class FrameT>
+class FrameRing
+{
+    struct Slot
+    {
+        FrameT Data;
+        bool Ready = false;
+    };
+
+public:
+    //! \param capacity The number of frames kept, clamped between 1 and frameCount
+    FrameRing(size_t frameCount, size_t capacity) :
+        FrameCount(std::max<size_t>(frameCount, 1)), Slots(std::clamp<size_t>(capacity, 1, FrameCount))
+    {
+    }
+
+    //! \brief Finds the first frame from the playhead onwards that isn't converted
+    //! \returns False if all the frames in the ring are converted
+    bool GetNextToConvert(size_t& frame) const
+    {
+        for (size_t i = 0; i < Slots.size(); ++i)
+        {
+            if (!_GetSlot(i).Ready)
+            {
+                frame = (Playhead + i) % FrameCount;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    //! \brief Stores a converted frame, ignored if the frame is no longer in the ring
+    void Store(size_t frame, FrameT data)
+    {
+        const auto distance = _Distance(frame);
+
+        if (distance >= Slots.size())
+            return;
+
+        auto& slot = _GetSlot(distance);
+        slot.Data = std::move(data);
+        slot.Ready = true;
+    }
+
+    //! \brief Moves the playhead to frame
+    //! \returns The converted frame or an empty FrameT if it isn't converted yet
+    FrameT Take(size_t frame)
+    {
+        frame %= FrameCount;
+
+        const auto distance = _Distance(frame);
+
+        if (distance >= Slots.size())
+        {
+            // Jumped past all of the converted frames
+            for (auto& slot : Slots)
+                slot = Slot();
+
+            Start = 0;
+            Playhead = frame;
+            return FrameT();
+        }
+
+        // When all the frames fit, the released slots would get the same frames again
+        if (Slots.size() < FrameCount)
+        {
+            for (size_t i = 0; i < distance; ++i)
+                _GetSlot(i) = Slot();
+        }
+
+        Start = (Start + distance) % Slots.size();
+        Playhead = frame;
+
+        const auto& slot = _GetSlot(0);
+
+        return slot.Ready ? slot.Data : FrameT();
+    }
+
+    size_t GetBufferedCount() const
+    {
+        return std::count_if(Slots.begin(), Slots.end(), [](const Slot& slot) { return slot.Ready; });
+    }
+
+    size_t GetCapacity() const
+    {
+        return Slots.size();
+    }
+
+    size_t GetPlayhead() const
+    {
+        return Playhead;
+    }
+
+private:
+    size_t _Distance(size_t frame) const
+    {
+        return (frame % FrameCount + FrameCount - Playhead) % FrameCount;
+    }
+
+    Slot& _GetSlot(size_t distance)
+    {
+        return Slots[(Start + distance) % Slots.size()];
+    }
+
+    const Slot& _GetSlot(size_t distance) const
+    {
+        return Slots[(Start + distance) % Slots.size()];
+    }
+
+private:
+    const size_t FrameCount;
+
+    //! The slot of the playhead is at Start, the following frames are after it
+    std::vector<Slot> Slots;
+    size_t Start = 0;
+
+    size_t Playhead = 0;
+};
+
+} // namespace DV
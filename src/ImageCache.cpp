@@ -0,0 +1,179 @@
+// ------------------------------------ //
+#include "ImageCache.h"
+
+#include "CacheManager.h"
+
+using namespace DV;
+// ------------------------------------ //
+ImageCache::ImageCache(size_t memoryBudget, size_t maxCount) : MemoryBudget(memoryBudget), MaxCount(maxCount)
+{
+}
+
+// ------------------------------------ //
+std::shared_ptr<LoadedImage> ImageCache::Get(const std::string& path)
+{
+    const auto found = PathIndex.find(path);
+
+    if (found == PathIndex.end())
+        return nullptr;
+
+    const auto iter = found->second;
+
+    // Failed images are dropped so that they can be attempted to be loaded again
+    if (!iter->Image->PathMatches(path))
+    {
+        _Erase(iter);
+        return nullptr;
+    }
+
+    Entries.splice(Entries.begin(), Entries, iter);
+    return iter->Image;
+}
+
+void ImageCache::Insert(const std::shared_ptr<LoadedImage>& image, const std::string& path, size_t bytes /*= 0*/)
+{
+    const auto existing = PathIndex.find(path);
+
+    if (existing != PathIndex.end())
+        _Erase(existing->second);
+
+    Entries.push_front(Entry{image, path, bytes});
+
+    PathIndex[path] = Entries.begin();
+    ImageIndex[image.get()] = Entries.begin();
+    TotalBytes += bytes;
+
+    _Evict();
+}
+
+bool ImageCache::UpdateSize(const LoadedImage& image, size_t bytes)
+{
+    const auto found = ImageIndex.find(&image);
+
+    if (found == ImageIndex.end())
+        return false;
+
+    TotalBytes = TotalBytes - found->second->Bytes + bytes;
+    found->second->Bytes = bytes;
+
+    _Evict();
+    return true;
+}
+
+bool ImageCache::RemoveIfUnused(const std::shared_ptr<LoadedImage>& image, long extraReferences)
+{
+    const auto found = ImageIndex.find(image.get());
+
+    if (found == ImageIndex.end())
+        return image.use_count() <= extraReferences;
+
+    // The cache entry is one reference
+    if (image.use_count() > extraReferences + 1)
+        return false;
+
+    _Erase(found->second);
+    return true;
+}
+
+void ImageCache::OnMoved(const std::string& oldpath, const std::string& newpath)
+{
+    const auto found = PathIndex.find(oldpath);
+
+    if (found == PathIndex.end())
+        return;
+
+    const auto iter = found->second;
+    PathIndex.erase(found);
+
+    // Moving on top of another cached image replaces that
+    const auto existing = PathIndex.find(newpath);
+
+    if (existing != PathIndex.end())
+        _Erase(existing->second);
+
+    iter->Path = newpath;
+    iter->Image->OnMoved(newpath);
+    PathIndex[newpath] = iter;
+}
+
+size_t ImageCache::RemoveExpired(std::chrono::high_resolution_clock::time_point now,
+    std::chrono::milliseconds maxAge, std::chrono::milliseconds forceAge)
+{
+    size_t removed = 0;
+    bool forceOne = forceAge.count() > 0;
+
+    for (auto iter = Entries.begin(); iter != Entries.end();)
+    {
+        const auto age = now - iter->Image->GetLastUsed();
+        const auto current = iter++;
+
+        if (current->Image.use_count() == 1 && age > maxAge)
+        {
+            _Erase(current);
+            ++removed;
+        }
+        else if (forceOne && age > forceAge)
+        {
+            _Erase(current);
+            ++removed;
+
+            // Only one per call
+            forceOne = false;
+        }
+    }
+
+    return removed;
+}
+
+void ImageCache::SetMemoryBudget(size_t bytes)
+{
+    MemoryBudget = bytes;
+    _Evict();
+}
+
+void ImageCache::Clear()
+{
+    Entries.clear();
+    PathIndex.clear();
+    ImageIndex.clear();
+    TotalBytes = 0;
+}
+
+// ------------------------------------ //
+void ImageCache::_Evict()
+{
+    if (!_IsOverLimits())
+        return;
+
+    // Images that are in use elsewhere are skipped as unloading them wouldn't release any memory
+    // and they would just be loaded again if requested. The most recently added image is always
+    // kept
+    auto iter = Entries.end();
+
+    while (_IsOverLimits() && iter != Entries.begin())
+    {
+        --iter;
+
+        if (iter == Entries.begin())
+            break;
+
+        if (iter->Image.use_count() > 1)
+            continue;
+
+        const auto current = iter++;
+        _Erase(current);
+    }
+}
+
+void ImageCache::_Erase(EntryList::iterator iter)
+{
+    const auto pathFound = PathIndex.find(iter->Path);
+
+    if (pathFound != PathIndex.end() && pathFound->second == iter)
+        PathIndex.erase(pathFound);
+
+    ImageIndex.erase(iter->Image.get());
+    TotalBytes -= iter->Bytes;
+
+    Entries.erase(iter);
+}
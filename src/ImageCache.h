@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace DV
+{
+class LoadedImage;
+
+//! \brief Least recently used cache of full size images, indexed by path
+//!
+//! Tracks the decoded size of each image and evicts the least recently used images that aren't
+//! in use elsewhere when over the memory budget or the maximum count. Eviction is done whenever
+//! something is added or an image size becomes known.
+//! \note This is not thread safe, CacheManager locks ImageCacheLock when using this
+class ImageCache
+{
+    struct Entry
+    {
+        std::shared_ptr<LoadedImage> Image;
+
+        //! Path this is indexed by, this is kept separately as LoadedImage replaces its path with
+        //! the error message on failure
+        std::string Path;
+
+        size_t Bytes = 0;
+    };
+
+    using EntryList = std::list<Entry>;
+
+public:
+    //! \param memoryBudget Maximum total size of cached decoded images in bytes
+    //! \param maxCount Maximum number of cached images, regardless of their size
+    ImageCache(size_t memoryBudget, size_t maxCount);
+
+    //! \brief Returns the image for path and marks it as most recently used
+    //! \returns Null if not cached or the cached image failed to load (in which case it is
+    //! removed)
+    std::shared_ptr<LoadedImage> Get(const std::string& path);
+
+    //! \brief Adds a new image to the cache as the most recently used image
+    //!
+    //! A previous image with the same path is replaced
+    void Insert(const std::shared_ptr<LoadedImage>& image, const std::string& path, size_t bytes = 0);
+
+    //! \brief Updates the size of an image once it is known
+    //! \returns False if image isn't in this cache
+    bool UpdateSize(const LoadedImage& image, size_t bytes);
+
+    //! \brief Removes image from this cache if only this cache and the caller reference it
+    //! \param extraReferences The number of references the caller holds
+    //! \returns True if the image isn't needed by anyone and was removed (or wasn't cached)
+    bool RemoveIfUnused(const std::shared_ptr<LoadedImage>& image, long extraReferences);
+
+    //! \brief Updates the path of a cached image and tells the image that it has moved
+    void OnMoved(const std::string& oldpath, const std::string& newpath);
+
+    //! \brief Removes images that haven't been used in maxAge and aren't in use anywhere else
+    //! \param forceAge If not zero one image older than this is removed even if it is in use
+    //! \returns The number of removed images
+    size_t RemoveExpired(std::chrono::high_resolution_clock::time_point now,
+        std::chrono::milliseconds maxAge, std::chrono::milliseconds forceAge);
+
+    //! \brief Changes the memory budget and evicts immediately if needed
+    void SetMemoryBudget(size_t bytes);
+
+    void Clear();
+
+    size_t GetCount() const
+    {
+        return Entries.size();
+    }
+
+    size_t GetTotalBytes() const
+    {
+        return TotalBytes;
+    }
+
+    size_t GetMemoryBudget() const
+    {
+        return MemoryBudget;
+    }
+
+private:
+    //! \brief Evicts least recently used images until under the limits
+    void _Evict();
+
+    void _Erase(EntryList::iterator iter);
+
+    bool _IsOverLimits() const
+    {
+        return TotalBytes > MemoryBudget || Entries.size() > MaxCount;
+    }
+
+private:
+    //! Most recently used image is at the front
+    EntryList Entries;
+
+    std::unordered_map<std::string, EntryList::iterator> PathIndex;
+    std::unordered_map<const LoadedImage*, EntryList::iterator> ImageIndex;
+
+    size_t TotalBytes = 0;
+    size_t MemoryBudget;
+    size_t MaxCount;
+};
+
+} // namespace DV
@@ -0,0 +1,432 @@
+// ------------------------------------ //
+#include "ImageProbe.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+using namespace DV;
+// ------------------------------------ //
+namespace
+{
+inline uint32_t ReadByte(const char* data, size_t offset)
+{
+    return static_cast<uint8_t>(data[offset]);
+}
+
+inline uint32_t ReadBigEndian16(const char* data, size_t offset)
+{
+    return (ReadByte(data, offset) << 8) | ReadByte(data, offset + 1);
+}
+
+inline uint32_t ReadBigEndian32(const char* data, size_t offset)
+{
+    return (ReadBigEndian16(data, offset) << 16) | ReadBigEndian16(data, offset + 2);
+}
+
+inline uint32_t ReadLittleEndian16(const char* data, size_t offset)
+{
+    return ReadByte(data, offset) | (ReadByte(data, offset + 1) << 8);
+}
+
+inline uint32_t ReadLittleEndian24(const char* data, size_t offset)
+{
+    return ReadLittleEndian16(data, offset) | (ReadByte(data, offset + 2) << 16);
+}
+
+inline uint32_t ReadLittleEndian32(const char* data, size_t offset)
+{
+    return ReadLittleEndian16(data, offset) | (ReadLittleEndian16(data, offset + 2) << 16);
+}
+
+inline bool StartsWith(const char* data, size_t length, const char* prefix, size_t prefixLength, size_t offset = 0)
+{
+    return length >= offset + prefixLength && std::memcmp(data + offset, prefix, prefixLength) == 0;
+}
+
+IMAGE_PROBE_RESULT ProbeJPEG(const char* data, size_t length, ImageHeaderInfo& info)
+{
+    size_t offset = 2;
+
+    while (true)
+    {
+        // Markers can be padded with any number of 0xFF bytes
+        while (offset + 1 < length && ReadByte(data, offset) == 0xFF && ReadByte(data, offset + 1) == 0xFF)
+            ++offset;
+
+        if (offset + 4 > length)
+            return IMAGE_PROBE_RESULT::NeedMoreData;
+
+        if (ReadByte(data, offset) != 0xFF)
+            return IMAGE_PROBE_RESULT::Unknown;
+
+        const auto marker = ReadByte(data, offset + 1);
+
+        // Markers without a length
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+        {
+            offset += 2;
+            continue;
+        }
+
+        // Image data starts before the frame header was found
+        if (marker == 0xDA || marker == 0xD9)
+            return IMAGE_PROBE_RESULT::Unknown;
+
+        const auto segmentLength = ReadBigEndian16(data, offset + 2);
+
+        if (segmentLength < 2)
+            return IMAGE_PROBE_RESULT::Unknown;
+
+        // Start of frame markers, C4, C8 and CC are other tables
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+        {
+            if (offset + 9 > length)
+                return IMAGE_PROBE_RESULT::NeedMoreData;
+
+            info.Format = "JPEG";
+            info.Height = static_cast<int>(ReadBigEndian16(data, offset + 5));
+            info.Width = static_cast<int>(ReadBigEndian16(data, offset + 7));
+            info.FrameCount = 1;
+
+            // A height of 0 means that the height is defined later in the file
+            if (info.Width < 1 || info.Height < 1)
+                return IMAGE_PROBE_RESULT::Unknown;
+
+            return IMAGE_PROBE_RESULT::Success;
+        }
+
+        offset += 2 + segmentLength;
+    }
+}
+
+IMAGE_PROBE_RESULT ProbePNG(const char* data, size_t length, ImageHeaderInfo& info)
+{
+    // Signature + IHDR chunk header + width and height
+    if (length < 24)
+        return IMAGE_PROBE_RESULT::NeedMoreData;
+
+    if (!StartsWith(data, length, "IHDR", 4, 12))
+        return IMAGE_PROBE_RESULT::Unknown;
+
+    info.Format = "PNG";
+    info.Width = static_cast<int>(ReadBigEndian32(data, 16));
+    info.Height = static_cast<int>(ReadBigEndian32(data, 20));
+    info.FrameCount = 1;
+
+    if (info.Width < 1 || info.Height < 1)
+        return IMAGE_PROBE_RESULT::Unknown;
+
+    // Animated PNGs have an acTL chunk before the image data
+    size_t offset = 8;
+
+    while (offset + 8 <= length)
+    {
+        const auto chunkLength = ReadBigEndian32(data, offset);
+
+        if (StartsWith(data, length, "acTL", 4, offset + 4))
+        {
+            if (offset + 12 > length)
+                return IMAGE_PROBE_RESULT::NeedMoreData;
+
+            info.FrameCount = static_cast<int>(ReadBigEndian32(data, offset + 8));
+            break;
+        }
+
+        if (StartsWith(data, length, "IDAT", 4, offset + 4))
+            break;
+
+        // Chunk header and CRC
+        offset += 12 + static_cast<size_t>(chunkLength);
+    }
+
+    if (offset + 8 > length)
+        return IMAGE_PROBE_RESULT::NeedMoreData;
+
+    return IMAGE_PROBE_RESULT::Success;
+}
+
+//! \brief Skips GIF data sub-blocks
+//! \returns False if the data ended
+bool SkipGIFSubBlocks(const char* data, size_t length, size_t& offset)
+{
+    while (offset < length)
+    {
+        const auto blockSize = ReadByte(data, offset);
+        ++offset;
+
+        if (blockSize == 0)
+            return true;
+
+        offset += blockSize;
+    }
+
+    return false;
+}
+
+IMAGE_PROBE_RESULT ProbeGIF(const char* data, size_t length, ImageHeaderInfo& info)
+{
+    if (length < 13)
+        return IMAGE_PROBE_RESULT::NeedMoreData;
+
+    info.Format = "GIF";
+    info.Width = static_cast<int>(ReadLittleEndian16(data, 6));
+    info.Height = static_cast<int>(ReadLittleEndian16(data, 8));
+    info.FrameCount = 0;
+
+    if (info.Width < 1 || info.Height < 1)
+        return IMAGE_PROBE_RESULT::Unknown;
+
+    const auto flags = ReadByte(data, 10);
+
+    size_t offset = 13;
+
+    // Global colour table
+    if (flags & 0x80)
+        offset += 3 * (static_cast<size_t>(1) << ((flags & 0x07) + 1));
+
+    int frames = 0;
+
+    while (offset < length)
+    {
+        const auto blockType = ReadByte(data, offset);
+
+        if (blockType == 0x3B)
+        {
+            info.FrameCount = frames;
+            break;
+        }
+
+        if (blockType == 0x21)
+        {
+            // Extension
+            offset += 2;
+
+            if (!SkipGIFSubBlocks(data, length, offset))
+                break;
+        }
+        else if (blockType == 0x2C)
+        {
+            // Image descriptor
+            if (offset + 10 > length)
+                break;
+
+            const auto imageFlags = ReadByte(data, offset + 9);
+            offset += 10;
+
+            if (imageFlags & 0x80)
+                offset += 3 * (static_cast<size_t>(1) << ((imageFlags & 0x07) + 1));
+
+            // LZW minimum code size
+            ++offset;
+
+            if (!SkipGIFSubBlocks(data, length, offset))
+                break;
+
+            ++frames;
+        }
+        else
+        {
+            // Broken file, Magick will probably still manage to show the frames before this
+            break;
+        }
+    }
+
+    return IMAGE_PROBE_RESULT::Success;
+}
+
+IMAGE_PROBE_RESULT ProbeWebP(const char* data, size_t length, ImageHeaderInfo& info)
+{
+    if (length < 30)
+        return IMAGE_PROBE_RESULT::NeedMoreData;
+
+    info.Format = "WEBP";
+    info.FrameCount = 1;
+    info.FileSize = static_cast<uint64_t>(ReadLittleEndian32(data, 4)) + 8;
+
+    if (StartsWith(data, length, "VP8 ", 4, 12))
+    {
+        // Lossy, check the frame start code
+        if (ReadByte(data, 23) != 0x9D || ReadByte(data, 24) != 0x01 || ReadByte(data, 25) != 0x2A)
+            return IMAGE_PROBE_RESULT::Unknown;
+
+        info.Width = static_cast<int>(ReadLittleEndian16(data, 26) & 0x3FFF);
+        info.Height = static_cast<int>(ReadLittleEndian16(data, 28) & 0x3FFF);
+    }
+    else if (StartsWith(data, length, "VP8L", 4, 12))
+    {
+        // Lossless
+        if (ReadByte(data, 20) != 0x2F)
+            return IMAGE_PROBE_RESULT::Unknown;
+
+        const auto bits = ReadLittleEndian32(data, 21);
+        info.Width = static_cast<int>((bits & 0x3FFF) + 1);
+        info.Height = static_cast<int>(((bits >> 14) & 0x3FFF) + 1);
+    }
+    else if (StartsWith(data, length, "VP8X", 4, 12))
+    {
+        // Extended
+        const auto flags = ReadByte(data, 20);
+        info.Width = static_cast<int>(ReadLittleEndian24(data, 24) + 1);
+        info.Height = static_cast<int>(ReadLittleEndian24(data, 27) + 1);
+
+        if (flags & 0x02)
+        {
+            // Animated, count the frame chunks
+            info.FrameCount = 0;
+
+            const size_t riffEnd = static_cast<size_t>(ReadLittleEndian32(data, 4)) + 8;
+            size_t offset = 12;
+            int frames = 0;
+
+            while (offset + 8 <= length && offset < riffEnd)
+            {
+                if (StartsWith(data, length, "ANMF", 4, offset))
+                    ++frames;
+
+                const auto chunkLength = static_cast<size_t>(ReadLittleEndian32(data, offset + 4));
+
+                // Chunks are padded to even size
+                offset += 8 + chunkLength + (chunkLength & 1);
+            }
+
+            if (offset >= riffEnd)
+                info.FrameCount = frames;
+        }
+    }
+    else
+    {
+        return IMAGE_PROBE_RESULT::Unknown;
+    }
+
+    if (info.Width < 1 || info.Height < 1)
+        return IMAGE_PROBE_RESULT::Unknown;
+
+    return IMAGE_PROBE_RESULT::Success;
+}
+
+IMAGE_PROBE_RESULT ProbeBMP(const char* data, size_t length, ImageHeaderInfo& info)
+{
+    if (length < 26)
+        return IMAGE_PROBE_RESULT::NeedMoreData;
+
+    const auto headerSize = ReadLittleEndian32(data, 14);
+
+    if (headerSize == 12)
+    {
+        // OS/2 BITMAPCOREHEADER
+        info.Width = static_cast<int>(ReadLittleEndian16(data, 18));
+        info.Height = static_cast<int>(ReadLittleEndian16(data, 20));
+    }
+    else if (headerSize >= 40)
+    {
+        info.Width = static_cast<int32_t>(ReadLittleEndian32(data, 18));
+
+        // Negative height is used for top-down images
+        const auto height = static_cast<int32_t>(ReadLittleEndian32(data, 22));
+        info.Height = height < 0 ? -height : height;
+    }
+    else
+    {
+        return IMAGE_PROBE_RESULT::Unknown;
+    }
+
+    info.Format = "BMP";
+    info.FrameCount = 1;
+
+    // Some writers leave this as 0 in which case the file can't be checked
+    info.FileSize = ReadLittleEndian32(data, 2);
+
+    if (info.Width < 1 || info.Height < 1)
+        return IMAGE_PROBE_RESULT::Unknown;
+
+    return IMAGE_PROBE_RESULT::Success;
+}
+
+} // namespace
+
+// ------------------------------------ //
+IMAGE_PROBE_RESULT DV::ProbeImageHeader(const char* data, size_t length, ImageHeaderInfo& info)
+{
+    if (length < 12)
+        return IMAGE_PROBE_RESULT::NeedMoreData;
+
+    if (StartsWith(data, length, "\xFF\xD8\xFF", 3))
+        return ProbeJPEG(data, length, info);
+
+    if (StartsWith(data, length, "\x89PNG\r\n\x1A\n", 8))
+        return ProbePNG(data, length, info);
+
+    if (StartsWith(data, length, "GIF87a", 6) || StartsWith(data, length, "GIF89a", 6))
+        return ProbeGIF(data, length, info);
+
+    if (StartsWith(data, length, "RIFF", 4) && StartsWith(data, length, "WEBP", 4, 8))
+        return ProbeWebP(data, length, info);
+
+    if (StartsWith(data, length, "BM", 2))
+        return ProbeBMP(data, length, info);
+
+    return IMAGE_PROBE_RESULT::Unknown;
+}
+
+bool DV::ProbeImageFile(const std::string& file, ImageHeaderInfo& info)
+{
+    std::ifstream reader(file, std::ios::binary);
+
+    if (!reader.good())
+        return false;
+
+    std::vector<char> buffer;
+    size_t readSize = IMAGE_PROBE_INITIAL_READ_SIZE;
+
+    while (true)
+    {
+        const auto previousSize = buffer.size();
+        buffer.resize(readSize);
+
+        reader.read(buffer.data() + previousSize, readSize - previousSize);
+        buffer.resize(previousSize + static_cast<size_t>(reader.gcount()));
+
+        const auto result = ProbeImageHeader(buffer.data(), buffer.size(), info);
+
+        if (result == IMAGE_PROBE_RESULT::Success)
+            return true;
+
+        if (result == IMAGE_PROBE_RESULT::Unknown || !reader.good() || readSize >= IMAGE_PROBE_MAX_READ_SIZE)
+            return false;
+
+        readSize *= 4;
+    }
+}
+
+bool DV::HasImageEndMarker(const char* data, size_t length, uint64_t totalLength, const ImageHeaderInfo& info)
+{
+    const auto& format = info.Format;
+
+    if (format == "JPEG")
+    {
+        // Some programs add extra bytes after the end marker
+        constexpr size_t maxTrailing = 1024;
+
+        for (size_t i = length; i >= 2 && length - i < maxTrailing; --i)
+        {
+            if (ReadByte(data, i - 2) == 0xFF && ReadByte(data, i - 1) == 0xD9)
+                return true;
+        }
+
+        return false;
+    }
+
+    if (format == "PNG")
+        return length >= 12 && std::memcmp(data + length - 8, "IEND", 4) == 0;
+
+    if (format == "GIF")
+        return length > 0 && ReadByte(data, length - 1) == 0x3B;
+
+    // These have no end marker but the header tells how long the file should be
+    if (format == "WEBP" || format == "BMP")
+        return info.FileSize != 0 && totalLength >= info.FileSize;
+
+    return false;
+}
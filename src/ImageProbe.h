@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace DV
+{
+//! Number of bytes first read from a file when probing
+constexpr size_t IMAGE_PROBE_INITIAL_READ_SIZE = 4096;
+
+//! Probing gives up and lets the caller decode the whole image if the dimensions aren't found in
+//! this many bytes (JPEG files can have large metadata segments before the frame header)
+constexpr size_t IMAGE_PROBE_MAX_READ_SIZE = 1024 * 1024;
+
+//! HasImageEndMarker doesn't look further than this from the end of the data
+constexpr size_t IMAGE_END_MARKER_SEARCH_SIZE = 1026;
+
+enum class IMAGE_PROBE_RESULT
+{
+    //! Format and dimensions were found
+    Success,
+    //! The format isn't supported or the header is broken
+    Unknown,
+    //! The dimensions weren't found in the data given
+    NeedMoreData
+};
+
+//! \brief Basic information about an image read from the file header
+struct ImageHeaderInfo
+{
+    //! Same as the Magick format name, for example "JPEG"
+    std::string Format;
+
+    int Width = 0;
+    int Height = 0;
+
+    //! 0 if the frame count isn't known as the data ended before all frames were seen
+    int FrameCount = 0;
+
+    //! Size of the whole file from the header of formats that don't have an end marker (WebP and
+    //! BMP). 0 if the header doesn't tell it
+    uint64_t FileSize = 0;
+};
+
+//! \brief Reads the format and dimensions of JPEG, PNG, GIF, WebP and BMP images from their
+//! header without decoding the image
+//!
+//! GIF and animated WebP frames are counted until the data ends
+IMAGE_PROBE_RESULT ProbeImageHeader(const char* data, size_t length, ImageHeaderInfo& info);
+
+//! \brief Probes an image file by reading only the start of the file
+//! \returns False if the file can't be read or probed. The image should then be opened with
+//! Magick to find out if it is an image in some other format
+bool ProbeImageFile(const std::string& file, ImageHeaderInfo& info);
+
+//! \brief Checks that image data isn't cut off without decoding it
+//!
+//! JPEG, PNG and GIF are checked for their end marker and WebP and BMP against the file size in
+//! their header. Used to detect incomplete downloads.
+//! \param data The end of the data, only the last IMAGE_END_MARKER_SEARCH_SIZE bytes are needed
+//! \param totalLength Length of all of the data, which is more than length if data is just the end
+//! \param info The result of probing the start of the data
+//! \returns False if the data is cut off or the format can't be checked, in which case the image
+//! should be decoded to find out if it is complete
+bool HasImageEndMarker(const char* data, size_t length, uint64_t totalLength, const ImageHeaderInfo& info);
+
+} // namespace DV
@@ -68,6 +68,75 @@ void PreparedStatement::SetBindWithType(int index, const bool& value)
     CheckBindSuccess(sqlite3_bind_int(Statement, index, value ? 1 : 0), index);
 }
 
+// ------------------------------------ //
+// PreparedStatementCache
+void PreparedStatementCache::SetDatabase(sqlite3* db)
+{
+    Clear();
+    DB = db;
+}
+
+PreparedStatementCache::Handle PreparedStatementCache::Get(const char* str, size_t length)
+{
+    std::string sql(str, length > 0 && str[length - 1] == '\0' ? length - 1 : length);
+
+    const auto found = UnusedBySQL.find(sql);
+
+    if(found != UnusedBySQL.end()) {
+
+        ++Hits;
+
+        auto statement = std::move(found->second->second);
+        Unused.erase(found->second);
+        UnusedBySQL.erase(found);
+
+        return Handle(*this, std::move(sql), std::move(statement));
+    }
+
+    ++Misses;
+
+    auto statement = std::make_unique<PreparedStatement>(DB, str, length);
+    return Handle(*this, std::move(sql), std::move(statement));
+}
+
+void PreparedStatementCache::Clear()
+{
+    UnusedBySQL.clear();
+    Unused.clear();
+}
+
+void PreparedStatementCache::SetMaxSize(size_t maxSize)
+{
+    MaxSize = maxSize;
+    _EvictOverLimit();
+}
+
+void PreparedStatementCache::_Return(
+    std::string&& sql, std::unique_ptr<PreparedStatement>&& statement)
+{
+    // An unfinished statement would keep its read transaction open
+    statement->Reset();
+
+    // If the same SQL was used recursively there already is an unused copy
+    if(MaxSize == 0 || UnusedBySQL.find(sql) != UnusedBySQL.end())
+        return;
+
+    Unused.emplace_front(std::move(sql), std::move(statement));
+    UnusedBySQL[Unused.front().first] = Unused.begin();
+
+    _EvictOverLimit();
+}
+
+void PreparedStatementCache::_EvictOverLimit()
+{
+    while(Unused.size() > MaxSize) {
+
+        UnusedBySQL.erase(Unused.back().first);
+        Unused.pop_back();
+        ++Evictions;
+    }
+}
+
 // ------------------------------------ //
 void PreparedStatement::StepAndPrettyPrint(const SetupStatementForUse& isprepared)
 {
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <cstring>
+#include <list>
+#include <memory>
 #include <sqlite3.h>
 #include <thread>
+#include <unordered_map>
 
 #include "Common.h"
 #include "SQLHelpers.h"
@@ -219,6 +222,15 @@ public:
         return str ? std::string(reinterpret_cast<const char*>(str)) : std::string();
     }
 
+    //! \brief Variant of GetColumnAsString that keeps embedded null bytes
+    auto GetColumnAsBinaryString(int column)
+    {
+        AssertIfColumnOutOfRange(column);
+        const auto* data = sqlite3_column_blob(Statement, column);
+        const auto length = sqlite3_column_bytes(Statement, column);
+        return data ? std::string(static_cast<const char*>(data), length) : std::string();
+    }
+
     //! \brief Sets id to be the value from column
     //! \returns True if column is valid and not null
     bool GetObjectIDFromColumn(DBID& id, int column = 0)
@@ -300,6 +312,141 @@ void PreparedStatement::SetBindWithType(int index, const std::nullptr_t& value);
 template<>
 void PreparedStatement::SetBindWithType(int index, const bool& value);
 
+//! Default number of unused statements kept per database connection
+constexpr size_t DEFAULT_STATEMENT_CACHE_SIZE = 128;
+
+//! \brief Keeps compiled statements of a database connection around so that running the same
+//! SQL again doesn't need to compile it again
+//!
+//! Statements are checked out of the cache while in use so the same SQL can be used
+//! recursively, in which case the second user gets a new statement. When there are more than
+//! the maximum number of unused statements the least recently used ones are finalized.
+//! \note The database needs to be locked while using this
+class PreparedStatementCache
+{
+public:
+    //! \brief A statement checked out from the cache, returns it to the cache when destroyed
+    class Handle
+    {
+    public:
+        Handle(PreparedStatementCache& cache, std::string sql, std::unique_ptr<PreparedStatement>&& statement) :
+            Cache(cache), SQL(std::move(sql)), Statement(std::move(statement))
+        {
+        }
+
+        Handle(Handle&& other) :
+            Cache(other.Cache), SQL(std::move(other.SQL)), Statement(std::move(other.Statement))
+        {
+        }
+
+        Handle(const Handle& other) = delete;
+        Handle& operator=(const Handle& other) = delete;
+
+        ~Handle()
+        {
+            if (Statement)
+                Cache._Return(std::move(SQL), std::move(Statement));
+        }
+
+        PreparedStatement& operator*()
+        {
+            return *Statement;
+        }
+
+        PreparedStatement* operator->()
+        {
+            return Statement.get();
+        }
+
+    private:
+        PreparedStatementCache& Cache;
+        std::string SQL;
+        std::unique_ptr<PreparedStatement> Statement;
+    };
+
+public:
+    explicit PreparedStatementCache(size_t maxSize = DEFAULT_STATEMENT_CACHE_SIZE) : MaxSize(maxSize) {}
+
+    ~PreparedStatementCache()
+    {
+        Clear();
+    }
+
+    PreparedStatementCache(const PreparedStatementCache& other) = delete;
+    PreparedStatementCache& operator=(const PreparedStatementCache& other) = delete;
+
+    //! \brief Sets the connection statements are compiled for. Clears the cache
+    void SetDatabase(sqlite3* db);
+
+    //! \brief Returns a statement for str, compiling it if there isn't an unused one
+    //! \param length Size of str, may include the null terminator like with PreparedStatement
+    Handle Get(const char* str, size_t length);
+
+    Handle Get(const std::string& str)
+    {
+        return Get(str.c_str(), str.size());
+    }
+
+    //! \brief Finalizes all unused statements
+    //! \note Must be called before closing the connection
+    void Clear();
+
+    //! \brief Sets the maximum number of unused statements. 0 disables caching
+    void SetMaxSize(size_t maxSize);
+
+    size_t GetMaxSize() const
+    {
+        return MaxSize;
+    }
+
+    //! \returns The number of unused statements in the cache
+    size_t GetSize() const
+    {
+        return Unused.size();
+    }
+
+    size_t GetHits() const
+    {
+        return Hits;
+    }
+
+    size_t GetMisses() const
+    {
+        return Misses;
+    }
+
+    size_t GetEvictions() const
+    {
+        return Evictions;
+    }
+
+    void ResetCounters()
+    {
+        Hits = 0;
+        Misses = 0;
+        Evictions = 0;
+    }
+
+private:
+    void _Return(std::string&& sql, std::unique_ptr<PreparedStatement>&& statement);
+
+    void _EvictOverLimit();
+
+private:
+    using UnusedList = std::list<std::pair<std::string, std::unique_ptr<PreparedStatement>>>;
+
+    sqlite3* DB = nullptr;
+    size_t MaxSize;
+
+    //! Most recently used first
+    UnusedList Unused;
+    std::unordered_map<std::string, UnusedList::iterator> UnusedBySQL;
+
+    size_t Hits = 0;
+    size_t Misses = 0;
+    size_t Evictions = 0;
+};
+
 #if defined(_DEBUG) && !defined(NDEBUG)
 inline void CheckRowID(PreparedStatement& statement, int index, const char* name)
 {
@@ -144,6 +144,59 @@ void Settings::Save()
         data.AddObject(plugins);
     }
 
+    // Performance settings //
+    {
+        auto performance = std::make_shared<ObjectFileObjectProper>(
+            "Performance", "", std::vector<std::unique_ptr<std::string>>());
+
+        auto threadsList = std::make_unique<ObjectFileListProper>("threads");
+
+        threadsList->AddVariable(std::make_shared<NamedVariableList>(
+            "SignatureCalculation", new IntBlock(SignatureCalculationThreads)));
+
+        threadsList->AddVariable(
+            std::make_shared<NamedVariableList>("Worker", new IntBlock(WorkerThreads)));
+
+        threadsList->AddVariable(std::make_shared<NamedVariableList>(
+            "HashCalculation", new IntBlock(HashCalculationThreads)));
+
+        threadsList->AddVariable(std::make_shared<NamedVariableList>(
+            "FullImageLoad", new IntBlock(FullImageLoadThreads)));
+
+        threadsList->AddVariable(std::make_shared<NamedVariableList>(
+            "ThumbnailGeneration", new IntBlock(ThumbnailGenerationThreads)));
+
+        threadsList->AddVariable(std::make_shared<NamedVariableList>(
+            "DatabaseReadConnections", new IntBlock(DatabaseReadConnections)));
+
+        performance->AddVariableList(std::move(threadsList));
+
+        auto cacheList = std::make_unique<ObjectFileListProper>("cache");
+
+        cacheList->AddVariable(std::make_shared<NamedVariableList>(
+            "ImageCacheMegabytes", new IntBlock(ImageCacheMegabytes)));
+
+        cacheList->AddVariable(std::make_shared<NamedVariableList>(
+            "AnimationBufferMegabytes", new IntBlock(AnimationBufferMegabytes)));
+
+        cacheList->AddVariable(std::make_shared<NamedVariableList>(
+            "UseThumbnailPack", new BoolBlock(UseThumbnailPack)));
+
+        performance->AddVariableList(std::move(cacheList));
+
+        auto downloadsList = std::make_unique<ObjectFileListProper>("downloads");
+
+        downloadsList->AddVariable(std::make_shared<NamedVariableList>(
+            "ParallelDownloads", new IntBlock(ParallelDownloads)));
+
+        downloadsList->AddVariable(std::make_shared<NamedVariableList>(
+            "DownloadsPerHost", new IntBlock(DownloadsPerHost)));
+
+        performance->AddVariableList(std::move(downloadsList));
+
+        data.AddObject(performance);
+    }
+
     if(!ObjectFileProcessor::WriteObjectFile(
            data, SettingsFile, DualView::Get().GetLogger())) {
         LOG_ERROR("Saving settings failed");
@@ -183,6 +236,7 @@ void Settings::_Load()
     std::shared_ptr<Leviathan::ObjectFileObject> images = nullptr;
     std::shared_ptr<Leviathan::ObjectFileObject> downloads = nullptr;
     std::shared_ptr<Leviathan::ObjectFileObject> plugins = nullptr;
+    std::shared_ptr<Leviathan::ObjectFileObject> performance = nullptr;
 
     for(size_t i = 0; i < file->GetTotalObjectCount(); ++i) {
 
@@ -203,6 +257,10 @@ void Settings::_Load()
         } else if(obj->GetName() == "Plugins") {
 
             plugins = obj;
+
+        } else if(obj->GetName() == "Performance") {
+
+            performance = obj;
         }
     }
 
@@ -339,6 +397,77 @@ void Settings::_Load()
 
         LOG_WARNING("Settings file missing Plugin settings");
     }
+
+    // Performance settings //
+    // Older settings files don't have these so the defaults are used without a warning
+    if(performance) {
+
+        auto threads = performance->GetListWithName("threads");
+
+        if(threads) {
+
+            Leviathan::ObjectFileProcessor::LoadValueFromNamedVars(threads->GetVariables(),
+                "SignatureCalculation", SignatureCalculationThreads,
+                SignatureCalculationThreads, log, "Settings: Load:");
+
+            Leviathan::ObjectFileProcessor::LoadValueFromNamedVars(threads->GetVariables(),
+                "Worker", WorkerThreads, WorkerThreads, log, "Settings: Load:");
+
+            Leviathan::ObjectFileProcessor::LoadValueFromNamedVars(threads->GetVariables(),
+                "HashCalculation", HashCalculationThreads, HashCalculationThreads, log,
+                "Settings: Load:");
+
+            Leviathan::ObjectFileProcessor::LoadValueFromNamedVars(threads->GetVariables(),
+                "FullImageLoad", FullImageLoadThreads, FullImageLoadThreads, log,
+                "Settings: Load:");
+
+            Leviathan::ObjectFileProcessor::LoadValueFromNamedVars(threads->GetVariables(),
+                "ThumbnailGeneration", ThumbnailGenerationThreads, ThumbnailGenerationThreads,
+                log, "Settings: Load:");
+
+            Leviathan::ObjectFileProcessor::LoadValueFromNamedVars(threads->GetVariables(),
+                "DatabaseReadConnections", DatabaseReadConnections, DatabaseReadConnections,
+                log, "Settings: Load:");
+
+        } else {
+
+            LOG_WARNING("Settings Performance missing threads list");
+        }
+
+        auto cache = performance->GetListWithName("cache");
+
+        if(cache) {
+
+            Leviathan::ObjectFileProcessor::LoadValueFromNamedVars(cache->GetVariables(),
+                "ImageCacheMegabytes", ImageCacheMegabytes, ImageCacheMegabytes, log,
+                "Settings: Load:");
+
+            Leviathan::ObjectFileProcessor::LoadValueFromNamedVars(cache->GetVariables(),
+                "AnimationBufferMegabytes", AnimationBufferMegabytes, AnimationBufferMegabytes, log,
+                "Settings: Load:");
+
+            Leviathan::ObjectFileProcessor::LoadValueFromNamedVars(cache->GetVariables(),
+                "UseThumbnailPack", UseThumbnailPack, UseThumbnailPack, log,
+                "Settings: Load:");
+
+        } else {
+
+            LOG_WARNING("Settings Performance missing cache list");
+        }
+
+        auto downloads = performance->GetListWithName("downloads");
+
+        if(downloads) {
+
+            Leviathan::ObjectFileProcessor::LoadValueFromNamedVars(downloads->GetVariables(),
+                "ParallelDownloads", ParallelDownloads, ParallelDownloads, log,
+                "Settings: Load:");
+
+            Leviathan::ObjectFileProcessor::LoadValueFromNamedVars(downloads->GetVariables(),
+                "DownloadsPerHost", DownloadsPerHost, DownloadsPerHost, log,
+                "Settings: Load:");
+        }
+    }
 }
 
 bool Settings::IsVersionCompatible(int loadversion)
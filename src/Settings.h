@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Common.h"
+
 #include "ObjectFiles/ObjectFile.h"
 
 #include <boost/filesystem.hpp>
@@ -118,6 +120,84 @@ public:
         return DuplicateSensitivity;
     }
 
+    //! \returns The number of threads to use for image signature calculation, 0 means the core
+    //! count
+    auto GetSignatureCalculationThreads() const
+    {
+        return SignatureCalculationThreads;
+    }
+
+    //! \returns The number of threads running general background tasks, 0 means the core count
+    auto GetWorkerThreads() const
+    {
+        return WorkerThreads;
+    }
+
+    //! \returns The number of files to hash at once, 0 means automatic
+    auto GetHashCalculationThreads() const
+    {
+        return HashCalculationThreads;
+    }
+
+    //! \returns The number of threads loading full size images, 0 means automatic
+    auto GetFullImageLoadThreads() const
+    {
+        return FullImageLoadThreads;
+    }
+
+    //! \returns The number of threads generating thumbnails, 0 means automatic
+    auto GetThumbnailGenerationThreads() const
+    {
+        return ThumbnailGenerationThreads;
+    }
+
+    //! \returns The number of read-only database connections, 0 means reads use the main
+    //! connection
+    auto GetDatabaseReadConnections() const
+    {
+        return DatabaseReadConnections;
+    }
+
+    //! \returns The maximum number of downloads running at the same time
+    auto GetParallelDownloads() const
+    {
+        return ParallelDownloads;
+    }
+
+    //! \returns The maximum number of downloads from a single host at the same time
+    auto GetDownloadsPerHost() const
+    {
+        return DownloadsPerHost;
+    }
+
+    //! \returns The memory budget for full size images kept in memory
+    auto GetImageCacheMegabytes() const
+    {
+        return ImageCacheMegabytes;
+    }
+
+    //! \returns The memory budget for animation frames converted ahead of time
+    auto GetAnimationBufferMegabytes() const
+    {
+        return AnimationBufferMegabytes;
+    }
+
+    //! \returns True if thumbnails are stored in pack files instead of a file per thumbnail
+    auto GetUseThumbnailPack() const
+    {
+        return UseThumbnailPack;
+    }
+
+    void SetUseThumbnailPack(bool use, bool save = true)
+    {
+        IsDirty = true;
+
+        UseThumbnailPack = use;
+
+        if(save)
+            Save();
+    }
+
 
 
     //! \brief Returns true if loadversion is compatible with SETTINGS_VERSION
@@ -182,6 +262,40 @@ protected:
     //! The sensitivy in the libpuzzle duplicate search
     int DuplicateSensitivity = 20;
 
+    // Performance settings //
+    //! Number of threads calculating image signatures, 0 uses the number of cores
+    int SignatureCalculationThreads = 0;
+
+    //! Number of threads in the shared worker pool, 0 uses the number of cores
+    int WorkerThreads = 0;
+
+    //! Number of worker tasks calculating file hashes at once, 0 uses the number of cores up to 4
+    int HashCalculationThreads = 0;
+
+    //! Number of threads decoding full size images, 0 uses half of the cores up to 4
+    int FullImageLoadThreads = 0;
+
+    //! Number of threads generating new thumbnails, 0 uses the number of cores
+    int ThumbnailGenerationThreads = 0;
+
+    //! Number of read-only database connections for running queries in parallel
+    int DatabaseReadConnections = DUALVIEW_SETTINGS_DEFAULT_DATABASE_READ_CONNECTIONS;
+
+    //! Number of transfers DownloadManager runs at once
+    int ParallelDownloads = DUALVIEW_SETTINGS_DEFAULT_PARALLEL_DOWNLOADS;
+
+    //! Limit for transfers to one host to not get rate limited
+    int DownloadsPerHost = DUALVIEW_SETTINGS_DEFAULT_DOWNLOADS_PER_HOST;
+
+    //! Maximum memory use of cached full size images
+    int ImageCacheMegabytes = DUALVIEW_SETTINGS_DEFAULT_IMAGE_CACHE_MEGABYTES;
+
+    //! Maximum memory use of the converted frames of the shown animation
+    int AnimationBufferMegabytes = DUALVIEW_SETTINGS_DEFAULT_ANIMATION_BUFFER_MEGABYTES;
+
+    //! Store thumbnails in ThumbnailPack segments
+    bool UseThumbnailPack = false;
+
     //! Settings storage object
     //! \todo This will be used to preserve comments in the file, currently does nothing
 };
@@ -0,0 +1,291 @@
+// ------------------------------------ //
+#include "ShowOrder.h"
+
+#include <algorithm>
+
+using namespace DV;
+// ------------------------------------ //
+namespace
+{
+//! \brief Finds the longest strictly increasing subsequence of the show_orders
+//! \returns Flags for which entries are part of the subsequence
+std::vector<bool> FindInOrderImages(const std::vector<ImageShowOrder>& order)
+{
+    // Index of the entry ending the best subsequence of each length and the previous entry of
+    // each entry in its subsequence
+    std::vector<size_t> tails;
+    std::vector<size_t> previous(order.size(), order.size());
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        const auto value = std::get<1>(order[i]);
+
+        const auto position = std::lower_bound(tails.begin(), tails.end(), value,
+            [&](size_t entry, int64_t compared) { return std::get<1>(order[entry]) < compared; });
+
+        if (position != tails.begin())
+            previous[i] = *(position - 1);
+
+        if (position == tails.end())
+        {
+            tails.push_back(i);
+        }
+        else
+        {
+            *position = i;
+        }
+    }
+
+    std::vector<bool> result(order.size(), false);
+
+    if (tails.empty())
+        return result;
+
+    for (auto current = tails.back(); current < order.size(); current = previous[current])
+        result[current] = true;
+
+    return result;
+}
+
+//! Version byte at the start of encoded moves
+constexpr uint8_t SHOW_ORDER_MOVES_FORMAT = 1;
+
+void WriteVarInt(std::string& output, int64_t value)
+{
+    // Zigzag encoding keeps small negative differences small
+    auto encoded = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+
+    while (encoded >= 0x80)
+    {
+        output.push_back(static_cast<char>((encoded & 0x7f) | 0x80));
+        encoded >>= 7;
+    }
+
+    output.push_back(static_cast<char>(encoded));
+}
+
+bool ReadVarInt(const std::string& input, size_t& position, int64_t& value)
+{
+    uint64_t encoded = 0;
+
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (position >= input.size())
+            return false;
+
+        const auto byte = static_cast<uint8_t>(input[position++]);
+        encoded |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+        if ((byte & 0x80) == 0)
+        {
+            value = static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+            return true;
+        }
+    }
+
+    return false;
+}
+} // namespace
+
+// ------------------------------------ //
+std::optional<int64_t> DV::ShowOrderBetween(std::optional<int64_t> previous, std::optional<int64_t> next)
+{
+    if (!next)
+        return previous ? *previous + DATABASE_SHOW_ORDER_GAP : DATABASE_SHOW_ORDER_GAP;
+
+    if (!previous)
+    {
+        previous = *next - DATABASE_SHOW_ORDER_GAP;
+
+        // Show orders are kept positive as -1 is used to indicate images not in a collection
+        if (*next >= 0 && *previous < 0)
+            previous = 0;
+    }
+
+    if (*next - *previous < 2)
+        return std::nullopt;
+
+    return *previous + (*next - *previous) / 2;
+}
+
+bool DV::CalculateShowOrderChanges(const std::vector<ImageShowOrder>& order, std::vector<ImageShowOrder>& changes)
+{
+    const auto inOrder = FindInOrderImages(order);
+
+    std::optional<int64_t> lastOrder;
+
+    size_t index = 0;
+
+    while (index < order.size())
+    {
+        if (inOrder[index])
+        {
+            lastOrder = std::get<1>(order[index]);
+            ++index;
+            continue;
+        }
+
+        // Find the run of images that need to be placed before the next image that stays
+        auto end = index;
+
+        while (end < order.size() && !inOrder[end])
+            ++end;
+
+        const auto count = static_cast<int64_t>(end - index);
+
+        int64_t lower;
+        int64_t step;
+
+        if (end < order.size())
+        {
+            const auto upper = std::get<1>(order[end]);
+
+            if (lastOrder)
+            {
+                lower = *lastOrder;
+            }
+            else
+            {
+                lower = upper - DATABASE_SHOW_ORDER_GAP * (count + 1);
+
+                if (upper >= 0 && lower < 0)
+                    lower = 0;
+            }
+
+            step = (upper - lower) / (count + 1);
+
+            if (step < 1)
+                return false;
+        }
+        else
+        {
+            lower = lastOrder ? *lastOrder : 0;
+            step = DATABASE_SHOW_ORDER_GAP;
+        }
+
+        for (int64_t i = 0; i < count; ++i)
+        {
+            const auto& [image, current] = order[index + i];
+            const auto newOrder = lower + step * (i + 1);
+
+            if (newOrder != current)
+                changes.emplace_back(image, newOrder);
+
+            lastOrder = newOrder;
+        }
+
+        index = end;
+    }
+
+    return true;
+}
+
+void DV::CalculateEvenShowOrders(const std::vector<ImageShowOrder>& order, std::vector<ImageShowOrder>& changes)
+{
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        const auto newOrder = DATABASE_SHOW_ORDER_GAP * static_cast<int64_t>(i + 1);
+
+        if (std::get<1>(order[i]) != newOrder)
+            changes.emplace_back(std::get<0>(order[i]), newOrder);
+    }
+}
+
+int64_t DV::TranslateRenumberedShowOrder(const std::vector<ImageShowOrder>& before, int64_t showorder)
+{
+    if (before.empty())
+        return showorder;
+
+    // CalculateEvenShowOrders numbering of an image in before
+    const auto renumbered = [&](std::vector<ImageShowOrder>::const_iterator image)
+    { return DATABASE_SHOW_ORDER_GAP * static_cast<int64_t>(image - before.begin() + 1); };
+
+    const auto next = std::lower_bound(before.begin(), before.end(), showorder,
+        [](const ImageShowOrder& image, int64_t value) { return std::get<1>(image) < value; });
+
+    // After the last image the distance to it is kept
+    if (next == before.end())
+        return renumbered(next - 1) + (showorder - std::get<1>(before.back()));
+
+    if (std::get<1>(*next) == showorder)
+        return renumbered(next);
+
+    // Before the first image the gap starts from 0 as show_orders are kept positive
+    int64_t previous = 0;
+    int64_t previousRenumbered = 0;
+
+    if (next != before.begin())
+    {
+        previous = std::get<1>(*(next - 1));
+        previousRenumbered = renumbered(next - 1);
+    }
+    else if (showorder < 0)
+    {
+        return renumbered(next) - (std::get<1>(*next) - showorder);
+    }
+
+    const auto nextRenumbered = renumbered(next);
+
+    const auto scaled = previousRenumbered +
+        (showorder - previous) * (nextRenumbered - previousRenumbered) / (std::get<1>(*next) - previous);
+
+    // Shrinking a large gap can round the value onto the images around it
+    return std::clamp(scaled, previousRenumbered + 1, nextRenumbered - 1);
+}
+
+// ------------------------------------ //
+std::string DV::EncodeShowOrderMoves(const std::vector<ShowOrderMove>& moves)
+{
+    std::string result;
+    result.reserve(1 + moves.size() * 4);
+
+    result.push_back(static_cast<char>(SHOW_ORDER_MOVES_FORMAT));
+    WriteVarInt(result, static_cast<int64_t>(moves.size()));
+
+    ShowOrderMove previous{0, 0, 0};
+
+    for (const auto& move : moves)
+    {
+        WriteVarInt(result, move.Image - previous.Image);
+        WriteVarInt(result, move.OldOrder - previous.OldOrder);
+        WriteVarInt(result, move.NewOrder - previous.NewOrder);
+
+        previous = move;
+    }
+
+    return result;
+}
+
+bool DV::DecodeShowOrderMoves(const std::string& data, std::vector<ShowOrderMove>& moves)
+{
+    if (data.empty() || static_cast<uint8_t>(data[0]) != SHOW_ORDER_MOVES_FORMAT)
+        return false;
+
+    size_t position = 1;
+    int64_t count;
+
+    // Each move takes at least 3 bytes
+    if (!ReadVarInt(data, position, count) || count < 0 ||
+        static_cast<uint64_t>(count) > (data.size() - position) / 3)
+        return false;
+
+    moves.reserve(moves.size() + count);
+
+    ShowOrderMove previous{0, 0, 0};
+
+    for (int64_t i = 0; i < count; ++i)
+    {
+        int64_t image;
+        int64_t oldOrder;
+        int64_t newOrder;
+
+        if (!ReadVarInt(data, position, image) || !ReadVarInt(data, position, oldOrder) ||
+            !ReadVarInt(data, position, newOrder))
+            return false;
+
+        previous = ShowOrderMove{previous.Image + image, previous.OldOrder + oldOrder, previous.NewOrder + newOrder};
+        moves.push_back(previous);
+    }
+
+    return position == data.size();
+}
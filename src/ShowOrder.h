@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Common.h"
+
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace DV
+{
+//! Distance between the show_orders of consecutive images in an evenly numbered collection.
+//! Images inserted or moved between two images get a show_order from the gap between them so
+//! that the other images don't need to be updated.
+constexpr int64_t DATABASE_SHOW_ORDER_GAP = 1024;
+
+//! When an image is placed in a gap this small the collection is renumbered in the background
+//! before the gap runs out
+constexpr int64_t DATABASE_SHOW_ORDER_RENUMBER_GAP = 16;
+
+//! \brief Image id and show_order pair
+using ImageShowOrder = std::tuple<DBID, int64_t>;
+
+//! \brief An image whose show_order is changed by a collection reorder
+struct ShowOrderMove
+{
+    DBID Image;
+    int64_t OldOrder;
+    int64_t NewOrder;
+
+    bool operator==(const ShowOrderMove& other) const
+    {
+        return Image == other.Image && OldOrder == other.OldOrder && NewOrder == other.NewOrder;
+    }
+};
+
+//! \brief Picks a show_order between two show_orders
+//! \param previous The show_order before the wanted one, or nullopt to place before next
+//! \param next The show_order after the wanted one, or nullopt to place after previous
+//! \returns The middle value or nullopt if there are no free values in between
+std::optional<int64_t> ShowOrderBetween(std::optional<int64_t> previous, std::optional<int64_t> next);
+
+//! \brief Calculates the show_order changes to put images in a new order
+//!
+//! The largest set of images that already are in the right relative order keep their
+//! show_orders. The other images are placed in the gaps between them.
+//! \param order All the images of a collection in the wanted order with their current
+//! show_orders
+//! \param changes Receives the images that need a new show_order
+//! \returns False if the gaps are too small, the collection needs to be renumbered then
+bool CalculateShowOrderChanges(const std::vector<ImageShowOrder>& order, std::vector<ImageShowOrder>& changes);
+
+//! \brief Calculates the show_order changes to evenly number a collection
+//! \param order All the images of a collection in the wanted order with their current
+//! show_orders
+//! \param changes Receives the images whose show_order isn't already the evenly spaced one
+void CalculateEvenShowOrders(const std::vector<ImageShowOrder>& order, std::vector<ImageShowOrder>& changes);
+
+//! \brief Maps a show_order from before a collection was evenly renumbered to the new numbering
+//!
+//! Used to update show_orders that were stored elsewhere, like undo information, so that they
+//! keep their place relative to the images. A show_order of an image maps to the new one of
+//! that image. Other values are scaled into the new gap between the images around them.
+//! \param before The images of the collection sorted by their show_orders before renumbering
+int64_t TranslateRenumberedShowOrder(const std::vector<ImageShowOrder>& before, int64_t showorder);
+
+//! \brief Encodes moves to a compact binary string for storing in the action history
+//!
+//! Each value is stored as a variable length difference to the same value of the previous
+//! move. Images moved together have close ids and evenly spaced show_orders so each move takes
+//! only a few bytes.
+std::string EncodeShowOrderMoves(const std::vector<ShowOrderMove>& moves);
+
+//! \brief Decodes moves encoded with EncodeShowOrderMoves
+//! \returns False if data isn't valid
+bool DecodeShowOrderMoves(const std::string& data, std::vector<ShowOrderMove>& moves);
+
+} // namespace DV
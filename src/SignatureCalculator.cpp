@@ -24,9 +24,10 @@ using namespace DV;
 // ------------------------------------ //
 struct SignatureCalculator::Private
 {
-    Private()
+    Private(int workers)
     {
         puzzle_init_context(&Context);
+        SetWorkerCount(workers);
     }
 
     ~Private()
@@ -34,14 +35,23 @@ struct SignatureCalculator::Private
         puzzle_free_context(&Context);
     }
 
+    void SetWorkerCount(int workers)
+    {
+        if (workers < 1)
+            workers = static_cast<int>(std::thread::hardware_concurrency());
+
+        WorkerCount = static_cast<size_t>(std::max(1, workers));
+    }
+
     //! This is the tail of the queue and contains images that haven't been loaded from the
     //! database yet
     std::vector<DBID> QueueEnd;
 
     std::vector<std::shared_ptr<Image>> Queue;
 
-    //! Used to throttle if it looks like the database can't keep up
-    std::atomic<int> QueuedDatabaseWrites{0};
+    //! Number of save batches queued to the database thread that haven't finished yet. Used to
+    //! throttle if it looks like the database can't keep up
+    std::shared_ptr<std::atomic<int>> QueuedDatabaseWrites = std::make_shared<std::atomic<int>>(0);
 
     //! The total number of items added
     std::atomic<int> TotalItemsAdded{0};
@@ -49,29 +59,36 @@ struct SignatureCalculator::Private
     //! The total number of items processed
     std::atomic<int> TotalItemsProcessed{0};
 
-    bool Done = false;
+    //! Number of workers currently calculating a signature
+    std::atomic<int> ActiveWorkers{0};
+
+    std::atomic<bool> Done = false;
 
     //! Used to only read one batch of images at a time
     std::atomic<bool> DBReadInProgress = false;
 
-    //! Used to have one save operation going on at once
-    std::shared_ptr<std::atomic<bool>> DBWriteInProgress = std::make_shared<std::atomic<bool>>(false);
-
     std::atomic<bool> RunThread = false;
 
+    //! Context used by CalculateImageSignature, the workers have their own contexts
     PuzzleContext Context;
     std::mutex ContextMutex;
 
     std::mutex DataMutex;
     std::condition_variable WorkerNotify;
 
-    std::thread WorkerThread;
+    //! Calculated images waiting to be saved. Shared between all the workers
+    std::vector<std::shared_ptr<Image>> SaveQueue;
+    std::mutex SaveQueueMutex;
+
+    size_t WorkerCount = 1;
+    std::vector<std::thread> WorkerThreads;
 
     std::function<void(int processed, int total, bool done)> Callback;
 };
 
 // ------------------------------------ //
-SignatureCalculator::SignatureCalculator() : pimpl(std::make_unique<Private>())
+SignatureCalculator::SignatureCalculator(int workers /*= 0*/) :
+    pimpl(std::make_unique<Private>(workers))
 {
 }
 
@@ -122,10 +139,18 @@ void SignatureCalculator::Resume()
     {
         pimpl->RunThread = true;
 
-        if (pimpl->WorkerThread.joinable())
-            pimpl->WorkerThread.join();
+        for (auto& thread : pimpl->WorkerThreads)
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+
+        pimpl->WorkerThreads.clear();
+
+        LOG_INFO("SignatureCalculator: starting " + std::to_string(pimpl->WorkerCount) + " worker(s)");
 
-        pimpl->WorkerThread = std::thread(&SignatureCalculator::_RunCalculationThread, this);
+        for (size_t i = 0; i < pimpl->WorkerCount; ++i)
+            pimpl->WorkerThreads.emplace_back(&SignatureCalculator::_RunCalculationThread, this);
     }
 }
 
@@ -140,8 +165,13 @@ void SignatureCalculator::Pause(bool wait /*= false*/)
 
     if (wait)
     {
-        if (pimpl->WorkerThread.joinable())
-            pimpl->WorkerThread.join();
+        for (auto& thread : pimpl->WorkerThreads)
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+
+        pimpl->WorkerThreads.clear();
     }
 }
 
@@ -150,6 +180,16 @@ bool SignatureCalculator::IsDone() const
     return pimpl->Done;
 }
 
+void SignatureCalculator::SetWorkerCount(int workers)
+{
+    pimpl->SetWorkerCount(workers);
+}
+
+size_t SignatureCalculator::GetWorkerCount() const
+{
+    return pimpl->WorkerCount;
+}
+
 // ------------------------------------ //
 void SignatureCalculator::SetStatusListener(std::function<void(int processed, int total, bool done)> callback)
 {
@@ -184,24 +224,35 @@ void SignatureCalculator::_SaveQueueHelper(std::vector<std::shared_ptr<Image>>&
 
     if (runinbackground)
     {
-        // Only one at a time
-        while (*pimpl->DBWriteInProgress)
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        // Wait if the database thread has too much of our work already. When stopping the
+        // limit is ignored to not delay the exit
+        auto& queuedWrites = *pimpl->QueuedDatabaseWrites;
+
+        int current = queuedWrites.load();
+
+        while (true)
+        {
+            if (current < SIGNATURE_CALCULATOR_MAX_QUEUED_WRITES || !pimpl->RunThread)
+            {
+                if (queuedWrites.compare_exchange_weak(current, current + 1))
+                    break;
 
-        // No race condition here as only one thread queues these
-        *pimpl->DBWriteInProgress = true;
+                continue;
+            }
 
-        auto isalive = GetAliveMarker();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            current = queuedWrites.load();
+        }
 
         DualView::Get().QueueDBThreadFunction(
-            [status{pimpl->DBWriteInProgress}, savequeue]()
+            [status{pimpl->QueuedDatabaseWrites}, savequeue]()
             {
                 if (savequeue.empty())
                     LOG_ERROR("SignatureCalculator: save queue became empty in transit");
 
                 _QueueToDB(savequeue);
 
-                *status = false;
+                --(*status);
             });
     }
     else
@@ -212,86 +263,124 @@ void SignatureCalculator::_SaveQueueHelper(std::vector<std::shared_ptr<Image>>&
     savequeue.clear();
 }
 
-void SignatureCalculator::_RunCalculationThread()
+void SignatureCalculator::_OnImageCalculated(const std::shared_ptr<Image>& image)
 {
-    LOG_INFO("SignatureCalculator: running worker thread");
+    if (!image->IsInDatabase())
+        return;
 
-    std::vector<std::shared_ptr<Image>> saveQueue;
+    if (SIGNATURE_CALCULATOR_GROUP_IMAGE_SAVE < 2)
+    {
+        image->Save();
+        return;
+    }
 
-    if (SIGNATURE_CALCULATOR_GROUP_IMAGE_SAVE > 1)
-        saveQueue.reserve(SIGNATURE_CALCULATOR_GROUP_IMAGE_SAVE);
+    std::vector<std::shared_ptr<Image>> toSave;
 
-    std::unique_lock<std::mutex> lock(pimpl->DataMutex);
+    {
+        std::lock_guard<std::mutex> lock(pimpl->SaveQueueMutex);
 
-    bool didSomethingOld = false;
+        pimpl->SaveQueue.push_back(image);
+
+        if (pimpl->SaveQueue.size() <= SIGNATURE_CALCULATOR_GROUP_IMAGE_SAVE)
+            return;
+
+        toSave.swap(pimpl->SaveQueue);
+    }
+
+    // The actual save is done without holding the lock so that the other workers can keep
+    // adding to the queue
+    _SaveQueueHelper(toSave, true);
+}
+
+void SignatureCalculator::_FlushSaveQueue(bool runinbackground)
+{
+    std::vector<std::shared_ptr<Image>> toSave;
 
-    while (pimpl->RunThread)
     {
-        bool somethingToDo = false;
+        std::lock_guard<std::mutex> lock(pimpl->SaveQueueMutex);
+        toSave.swap(pimpl->SaveQueue);
+    }
 
-        // Queue DB read if too few items are loaded (and there are items to load)
-        if (pimpl->Queue.size() <= SIGNATURE_CALCULATOR_READ_MORE_THRESSHOLD && !pimpl->QueueEnd.empty() &&
-            !pimpl->DBReadInProgress)
-        {
-            pimpl->DBReadInProgress = true;
+    _SaveQueueHelper(toSave, runinbackground);
+}
+
+void SignatureCalculator::_QueueDatabaseReadIfNeeded()
+{
+    // Queue DB read if too few items are loaded (and there are items to load). The threshold
+    // is raised by the worker count so that all the workers have something to do
+    if (pimpl->Queue.size() > SIGNATURE_CALCULATOR_READ_MORE_THRESSHOLD + pimpl->WorkerCount ||
+        pimpl->QueueEnd.empty() || pimpl->DBReadInProgress)
+    {
+        return;
+    }
+
+    pimpl->DBReadInProgress = true;
+
+    std::vector<DBID> itemsToRead;
+    itemsToRead.reserve(SIGNATURE_CALCULATOR_READ_BATCH);
 
-            somethingToDo = true;
-            didSomethingOld = true;
+    while (!pimpl->QueueEnd.empty() && itemsToRead.size() < SIGNATURE_CALCULATOR_READ_BATCH)
+    {
+        itemsToRead.push_back(pimpl->QueueEnd.back());
+        pimpl->QueueEnd.pop_back();
+    }
+
+    auto isalive = GetAliveMarker();
 
-            std::vector<DBID> itemsToRead;
-            itemsToRead.reserve(SIGNATURE_CALCULATOR_READ_BATCH);
+    DualView::Get().QueueDBThreadFunction(
+        [=]()
+        {
+            std::vector<std::shared_ptr<Image>> images;
+            images.reserve(itemsToRead.size());
 
-            while (!pimpl->QueueEnd.empty() && itemsToRead.size() < SIGNATURE_CALCULATOR_READ_BATCH)
+            for (auto item : itemsToRead)
             {
-                itemsToRead.push_back(pimpl->QueueEnd.back());
-                pimpl->QueueEnd.pop_back();
-            }
+                auto image = DualView::Get().GetDatabase().SelectImageByIDAG(item);
 
-            auto isalive = GetAliveMarker();
+                if (image)
+                    images.push_back(image);
+            }
 
-            DualView::Get().QueueDBThreadFunction(
-                [=]()
+            DualView::Get().InvokeFunction(
+                [this, isalive, images]()
                 {
-                    std::vector<std::shared_ptr<Image>> images;
-                    images.reserve(itemsToRead.size());
+                    INVOKE_CHECK_ALIVE_MARKER(isalive);
 
-                    for (auto item : itemsToRead)
-                    {
-                        auto image = DualView::Get().GetDatabase().SelectImageByIDAG(item);
+                    AddImages(images);
+                    pimpl->DBReadInProgress = false;
+                });
+        });
+}
 
-                        if (image)
-                            images.push_back(image);
-                    }
+void SignatureCalculator::_RunCalculationThread()
+{
+    LOG_INFO("SignatureCalculator: running worker thread");
 
-                    DualView::Get().InvokeFunction(
-                        [this, isalive, images]()
-                        {
-                            INVOKE_CHECK_ALIVE_MARKER(isalive);
+    // Each worker has its own context so that the workers don't need to wait for each other
+    PuzzleContext context;
+    puzzle_init_context(&context);
 
-                            AddImages(images);
-                            pimpl->DBReadInProgress = false;
-                        });
-                });
-        }
+    std::unique_lock<std::mutex> lock(pimpl->DataMutex);
+
+    while (pimpl->RunThread)
+    {
+        _QueueDatabaseReadIfNeeded();
 
         // Process items
         if (!pimpl->Queue.empty())
         {
-            somethingToDo = true;
-            didSomethingOld = true;
-
             auto image = pimpl->Queue.back();
             pimpl->Queue.pop_back();
 
+            ++pimpl->ActiveWorkers;
+
             // Unlock while processing an item
             lock.unlock();
 
             if (image)
             {
                 // Calculate new signature
-                bool success = CalculateImageSignature(*image);
-
-                if (!success)
+                if (!_CalculateImageSignature(*image, context, nullptr))
                 {
                     LOG_ERROR("SignatureCalculator: failed to calculate for image: " + image->GetName() +
                         ", path: " + image->GetResourcePath());
@@ -299,79 +388,64 @@ void SignatureCalculator::_RunCalculationThread()
                 else
                 {
                     // Save the updated signature
-                    if (image->IsInDatabase())
-                    {
-                        if (SIGNATURE_CALCULATOR_GROUP_IMAGE_SAVE < 2)
-                        {
-                            image->Save();
-                        }
-                        else
-                        {
-                            saveQueue.push_back(image);
-
-                            if (saveQueue.size() > SIGNATURE_CALCULATOR_GROUP_IMAGE_SAVE)
-                                _SaveQueueHelper(saveQueue, true);
-                        }
-                    }
-
-                    // A lot of spam
-                    // LOG_INFO("SignatureCalculator: calculated for image: " +
-                    // image->GetName());
+                    _OnImageCalculated(image);
                 }
             }
 
             ++pimpl->TotalItemsProcessed;
             _ReportStatus();
+
             lock.lock();
+            --pimpl->ActiveWorkers;
+            continue;
         }
 
-        if (!somethingToDo)
-        {
-            // Nothing to do
-            // Save queue if it has something
-            if (!saveQueue.empty())
-            {
-                lock.unlock();
-                _SaveQueueHelper(saveQueue, true);
-                lock.lock();
-            }
+        // Nothing to do
+        // Save queue if it has something
+        lock.unlock();
+        _FlushSaveQueue(true);
+        lock.lock();
 
-            if (pimpl->DBReadInProgress)
-            {
-                // Shouldn't mark done while waiting for more data
-                pimpl->WorkerNotify.wait_for(lock, std::chrono::seconds(1));
-                didSomethingOld = true;
-            }
-            else
-            {
-                // If also didn't do anything last time this is now done. And isn't waiting for
-                // a database read then this is done
-                if (!didSomethingOld && !pimpl->Done)
-                {
-                    // Some extra checking to not report us being done too soon
-                    if (!pimpl->DBReadInProgress && pimpl->TotalItemsProcessed > 0)
-                    {
-                        pimpl->Done = true;
-                        LOG_INFO("SignatureCalculator: has finished with all work");
-                        _ReportStatus();
-                    }
-                }
+        // More work may have been added while saving
+        if (!pimpl->Queue.empty())
+            continue;
 
-                didSomethingOld = false;
+        if (pimpl->DBReadInProgress)
+        {
+            // Shouldn't mark done while waiting for more data
+            pimpl->WorkerNotify.wait_for(lock, std::chrono::seconds(1));
+            continue;
+        }
 
-                // Sleep while waiting for something to happen
-                pimpl->WorkerNotify.wait_for(lock, std::chrono::seconds(3));
-            }
+        // Done once no worker is processing anything and there's nothing left to load
+        if (!pimpl->Done && pimpl->ActiveWorkers == 0 && pimpl->QueueEnd.empty() &&
+            pimpl->TotalItemsProcessed > 0)
+        {
+            pimpl->Done = true;
+            LOG_INFO("SignatureCalculator: has finished with all work");
+            _ReportStatus();
         }
+
+        // Sleep while waiting for something to happen
+        pimpl->WorkerNotify.wait_for(lock, std::chrono::seconds(3));
     }
 
-    _SaveQueueHelper(saveQueue, false);
+    lock.unlock();
+
+    _FlushSaveQueue(false);
+
+    puzzle_free_context(&context);
 
     LOG_INFO("SignatureCalculator: running worker thread exiting");
 }
 
 // ------------------------------------ //
 bool SignatureCalculator::CalculateImageSignature(Image& image)
+{
+    return _CalculateImageSignature(image, pimpl->Context, &pimpl->ContextMutex);
+}
+
+bool SignatureCalculator::_CalculateImageSignature(Image& image, PuzzleContext& context, std::mutex* contextlock)
 {
     const auto file = image.GetResourcePath();
 
@@ -419,14 +493,17 @@ bool SignatureCalculator::CalculateImageSignature(Image& image)
     createdImage.front().write(0, 0, width, height, "RGB", Magick::CharPixel, dataHolder.data());
 
     // Lock for the puzzle context
-    std::lock_guard<std::mutex> lock(pimpl->ContextMutex);
+    std::unique_lock<std::mutex> lock;
+
+    if (contextlock)
+        lock = std::unique_lock<std::mutex>(*contextlock);
 
     PuzzleCvec cvec;
-    puzzle_init_cvec(&pimpl->Context, &cvec);
+    puzzle_init_cvec(&context, &cvec);
 
     bool success = true;
 
-    if (puzzle_fill_cvec_from_memory(&pimpl->Context, &cvec, dataHolder.data(), width, height) == 0)
+    if (puzzle_fill_cvec_from_memory(&context, &cvec, dataHolder.data(), width, height) == 0)
     {
         success = true;
         image.SetSignature(std::string(reinterpret_cast<char*>(cvec.vec), cvec.sizeof_vec));
@@ -436,6 +513,6 @@ bool SignatureCalculator::CalculateImageSignature(Image& image)
         success = false;
     }
 
-    puzzle_free_cvec(&pimpl->Context, &cvec);
+    puzzle_free_cvec(&context, &cvec);
     return success;
 }
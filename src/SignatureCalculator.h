@@ -5,8 +5,11 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
+struct PuzzleContext_;
+
 namespace DV {
 
 class Image;
@@ -15,13 +18,20 @@ constexpr auto SIGNATURE_CALCULATOR_READ_MORE_THRESSHOLD = 5;
 constexpr auto SIGNATURE_CALCULATOR_READ_BATCH = 50;
 constexpr auto SIGNATURE_CALCULATOR_GROUP_IMAGE_SAVE = 100;
 
+//! Maximum number of save batches that can be waiting on the database thread before the workers
+//! wait for them to finish
+constexpr auto SIGNATURE_CALCULATOR_MAX_QUEUED_WRITES = 2;
+
 //! \brief Manages calculating signatures for a bunch of images
+//!
+//! The calculation is done by a pool of worker threads that each have their own puzzle context
 //! \note This processes items in LIFO order, first image is only processed once finished
 class SignatureCalculator : public IsAlive {
     struct Private;
 
 public:
-    SignatureCalculator();
+    //! \param workers The number of worker threads to use, 0 or less uses the core count
+    explicit SignatureCalculator(int workers = 0);
     ~SignatureCalculator();
 
     void AddImages(const std::vector<DBID>& images);
@@ -32,6 +42,12 @@ public:
 
     bool IsDone() const;
 
+    //! \brief Sets the number of workers, only takes effect on next Resume if currently running
+    //! \param workers The number of worker threads to use, 0 or less uses the core count
+    void SetWorkerCount(int workers);
+
+    size_t GetWorkerCount() const;
+
 
     //! \brief A callback for getting status updates.
     //! \note This can be called from a background thread
@@ -39,12 +55,27 @@ public:
 
     //! \brief Calculates the signatures for the given image
     //! \returns False on error
-    //! \note This shares the static puzzle context and uses a lock to protect access to it
+    //! \note This shares a puzzle context and uses a lock to protect access to it, the worker
+    //! threads don't use this
     bool CalculateImageSignature(Image& image);
 
 private:
     void _RunCalculationThread();
 
+    //! \brief Variant of CalculateImageSignature that uses the given context
+    //! \param contextlock If not null locked while the context is in use
+    bool _CalculateImageSignature(Image& image, PuzzleContext_& context, std::mutex* contextlock);
+
+    //! \brief Queues a read of the next batch of images from QueueEnd if needed
+    //! \note DataMutex must be locked when calling this
+    void _QueueDatabaseReadIfNeeded();
+
+    //! \brief Adds a calculated image to the shared save queue and saves the queue if it is full
+    void _OnImageCalculated(const std::shared_ptr<Image>& image);
+
+    //! \brief Saves everything in the shared save queue
+    void _FlushSaveQueue(bool runinbackground);
+
     void _ReportStatus() const;
 
     void _SaveQueueHelper(
@@ -0,0 +1,319 @@
+// ------------------------------------ //
+#include "SignatureIndex.h"
+
+#include "Database.h"
+#include "Exceptions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <thread>
+
+using namespace DV;
+// ------------------------------------ //
+constexpr auto WORD_BITS = IMAGE_SIGNATURE_WORD_LENGTH * SIGNATURE_INDEX_BITS_PER_VALUE;
+constexpr uint64_t WORD_MASK = (1ULL << WORD_BITS) - 1;
+constexpr uint64_t POSTING_INDEX_MASK = 0xFFFFFFFFULL;
+
+//! Images are handed out to the scan threads in chunks of this size
+constexpr size_t SCAN_CHUNK_SIZE = 256;
+
+static_assert(WORD_BITS <= 32, "signature word doesn't fit in the upper half of a posting");
+static_assert(IMAGE_SIGNATURE_WORD_COUNT < 256, "word counts are stored in uint8_t");
+static_assert((IMAGE_SIGNATURE_WORD_COUNT - 1 + IMAGE_SIGNATURE_WORD_LENGTH) * SIGNATURE_INDEX_BITS_PER_VALUE <=
+        SIGNATURE_INDEX_PACKED_ELEMENTS * 64,
+    "not enough space for packed signature values");
+
+//! \brief Converts a libpuzzle value (-2 to 2) to a 3 bit unsigned value
+inline uint64_t PackValue(char value)
+{
+    return static_cast<uint64_t>(std::clamp<int>(static_cast<signed char>(value), -2, 2) + 2);
+}
+
+inline uint32_t ExtractWord(const uint64_t* packed, size_t position)
+{
+    const size_t bit = position * SIGNATURE_INDEX_BITS_PER_VALUE;
+    const size_t element = bit / 64;
+    const size_t shift = bit % 64;
+
+    uint64_t value = packed[element] >> shift;
+
+    if (shift + WORD_BITS > 64)
+        value |= packed[element + 1] << (64 - shift);
+
+    return static_cast<uint32_t>(value & WORD_MASK);
+}
+
+// ------------------------------------ //
+void SignatureIndex::Reserve(size_t count)
+{
+    ImageIDs.reserve(count);
+    WordCounts.reserve(count);
+    PackedSignatures.reserve(count * SIGNATURE_INDEX_PACKED_ELEMENTS);
+}
+
+void SignatureIndex::Clear()
+{
+    ImageIDs.clear();
+    WordCounts.clear();
+    PackedSignatures.clear();
+    Postings.clear();
+    PositionOffsets.clear();
+    IgnoredPairs.clear();
+    PostingsBuilt = false;
+}
+
+// ------------------------------------ //
+size_t SignatureIndex::CountWords(size_t signatureLength)
+{
+    // Same condition as in Database::InsertImageSignatures
+    if (signatureLength <= IMAGE_SIGNATURE_WORD_LENGTH)
+        return 0;
+
+    return std::min<size_t>(IMAGE_SIGNATURE_WORD_COUNT, signatureLength - IMAGE_SIGNATURE_WORD_LENGTH + 1);
+}
+
+int64_t SignatureIndex::CreateWordKey(const std::string& signature, size_t position)
+{
+    uint64_t word = 0;
+
+    for (size_t i = 0; i < IMAGE_SIGNATURE_WORD_LENGTH; ++i)
+        word |= PackValue(signature[position + i]) << (i * SIGNATURE_INDEX_BITS_PER_VALUE);
+
+    return static_cast<int64_t>((static_cast<uint64_t>(position) << 32) | word);
+}
+
+bool SignatureIndex::AddSignature(DBID image, const std::string& signature)
+{
+    const auto words = CountWords(signature.size());
+
+    if (words < 1)
+        return false;
+
+    PostingsBuilt = false;
+
+    ImageIDs.push_back(image);
+    WordCounts.push_back(static_cast<uint8_t>(words));
+
+    const auto start = PackedSignatures.size();
+    PackedSignatures.resize(start + SIGNATURE_INDEX_PACKED_ELEMENTS, 0);
+    uint64_t* packed = PackedSignatures.data() + start;
+
+    const auto valueCount = words + IMAGE_SIGNATURE_WORD_LENGTH - 1;
+
+    for (size_t i = 0; i < valueCount; ++i)
+    {
+        const size_t bit = i * SIGNATURE_INDEX_BITS_PER_VALUE;
+        const uint64_t value = PackValue(signature[i]);
+
+        packed[bit / 64] |= value << (bit % 64);
+
+        // Value split between two elements
+        if (bit % 64 + SIGNATURE_INDEX_BITS_PER_VALUE > 64)
+            packed[bit / 64 + 1] |= value >> (64 - bit % 64);
+    }
+
+    return true;
+}
+
+void SignatureIndex::AddIgnoredPair(DBID primary, DBID other)
+{
+    IgnoredPairs.insert(std::make_tuple(primary, other));
+}
+
+uint32_t SignatureIndex::GetWord(size_t index, size_t position) const
+{
+    if (index >= ImageIDs.size() || position >= WordCounts[index])
+        throw Leviathan::InvalidArgument("signature index or word position out of range");
+
+    return ExtractWord(PackedSignatures.data() + index * SIGNATURE_INDEX_PACKED_ELEMENTS, position);
+}
+
+// ------------------------------------ //
+void SignatureIndex::BuildPostings()
+{
+    if (ImageIDs.size() > POSTING_INDEX_MASK)
+        throw Leviathan::InvalidState("too many images for SignatureIndex");
+
+    // Make sure the images are in id order, this way the lower index is always the lower id
+    if (!std::is_sorted(ImageIDs.begin(), ImageIDs.end()))
+    {
+        std::vector<size_t> order(ImageIDs.size());
+        std::iota(order.begin(), order.end(), 0);
+
+        std::sort(order.begin(), order.end(), [this](size_t left, size_t right) {
+            return ImageIDs[left] < ImageIDs[right];
+        });
+
+        std::vector<DBID> sortedIDs;
+        std::vector<uint8_t> sortedCounts;
+        std::vector<uint64_t> sortedPacked;
+
+        sortedIDs.reserve(order.size());
+        sortedCounts.reserve(order.size());
+        sortedPacked.reserve(PackedSignatures.size());
+
+        for (const auto index : order)
+        {
+            sortedIDs.push_back(ImageIDs[index]);
+            sortedCounts.push_back(WordCounts[index]);
+
+            const auto start = PackedSignatures.begin() + index * SIGNATURE_INDEX_PACKED_ELEMENTS;
+            sortedPacked.insert(sortedPacked.end(), start, start + SIGNATURE_INDEX_PACKED_ELEMENTS);
+        }
+
+        ImageIDs = std::move(sortedIDs);
+        WordCounts = std::move(sortedCounts);
+        PackedSignatures = std::move(sortedPacked);
+    }
+
+    // Count the size of each word position
+    PositionOffsets.assign(IMAGE_SIGNATURE_WORD_COUNT + 1, 0);
+
+    for (const auto count : WordCounts)
+    {
+        for (size_t position = 0; position < count; ++position)
+            ++PositionOffsets[position + 1];
+    }
+
+    std::partial_sum(PositionOffsets.begin(), PositionOffsets.end(), PositionOffsets.begin());
+
+    Postings.resize(PositionOffsets.back());
+
+    std::vector<size_t> writePositions(PositionOffsets.begin(), PositionOffsets.end() - 1);
+
+    for (size_t index = 0; index < ImageIDs.size(); ++index)
+    {
+        const uint64_t* packed = PackedSignatures.data() + index * SIGNATURE_INDEX_PACKED_ELEMENTS;
+
+        for (size_t position = 0; position < WordCounts[index]; ++position)
+        {
+            Postings[writePositions[position]++] =
+                (static_cast<uint64_t>(ExtractWord(packed, position)) << 32) | static_cast<uint64_t>(index);
+        }
+    }
+
+    for (size_t position = 0; position + 1 < PositionOffsets.size(); ++position)
+    {
+        std::sort(Postings.begin() + PositionOffsets[position], Postings.begin() + PositionOffsets[position + 1]);
+    }
+
+    PostingsBuilt = true;
+}
+
+// ------------------------------------ //
+std::map<DBID, std::vector<std::tuple<DBID, int>>> SignatureIndex::FindPotentialDuplicates(
+    int sensitivity, unsigned threads /*= 0*/) const
+{
+    if (!PostingsBuilt)
+        throw Leviathan::InvalidState("SignatureIndex: BuildPostings must be called before searching");
+
+    std::map<DBID, std::vector<std::tuple<DBID, int>>> result;
+
+    if (ImageIDs.size() < 2)
+        return result;
+
+    if (threads < 1)
+        threads = std::max(1U, std::thread::hardware_concurrency());
+
+    threads = static_cast<unsigned>(
+        std::min<size_t>(threads, (ImageIDs.size() + SCAN_CHUNK_SIZE - 1) / SCAN_CHUNK_SIZE));
+
+    std::vector<std::vector<std::tuple<uint32_t, uint32_t, int>>> threadResults(threads);
+    std::atomic<size_t> nextChunk{0};
+
+    const auto worker = [&](size_t threadIndex) {
+        std::vector<uint8_t> counts(ImageIDs.size(), 0);
+        std::vector<uint32_t> touched;
+
+        while (true)
+        {
+            const auto start = nextChunk.fetch_add(SCAN_CHUNK_SIZE);
+
+            if (start >= ImageIDs.size())
+                break;
+
+            _ScanRange(start, std::min(start + SCAN_CHUNK_SIZE, ImageIDs.size()), sensitivity, counts, touched,
+                threadResults[threadIndex]);
+        }
+    };
+
+    if (threads == 1)
+    {
+        worker(0);
+    }
+    else
+    {
+        std::vector<std::thread> scanThreads;
+        scanThreads.reserve(threads);
+
+        for (unsigned i = 0; i < threads; ++i)
+            scanThreads.emplace_back(worker, i);
+
+        for (auto& thread : scanThreads)
+            thread.join();
+    }
+
+    for (auto& matches : threadResults)
+    {
+        for (const auto& [original, duplicate, strength] : matches)
+        {
+            result[ImageIDs[original]].emplace_back(ImageIDs[duplicate], strength);
+        }
+    }
+
+    // The chunks are processed in a random order, so sort for consistent results
+    for (auto& [original, duplicates] : result)
+    {
+        std::sort(duplicates.begin(), duplicates.end());
+    }
+
+    return result;
+}
+
+void SignatureIndex::_ScanRange(size_t start, size_t end, int sensitivity, std::vector<uint8_t>& counts,
+    std::vector<uint32_t>& touched, std::vector<std::tuple<uint32_t, uint32_t, int>>& result) const
+{
+    for (size_t index = start; index < end; ++index)
+    {
+        const uint64_t* packed = PackedSignatures.data() + index * SIGNATURE_INDEX_PACKED_ELEMENTS;
+
+        for (size_t position = 0; position < WordCounts[index]; ++position)
+        {
+            const uint64_t word = ExtractWord(packed, position);
+
+            const auto positionEnd = Postings.begin() + PositionOffsets[position + 1];
+
+            // Only images with higher index are looked at, so each pair is only found once
+            auto iter =
+                std::lower_bound(Postings.begin() + PositionOffsets[position], positionEnd, (word << 32) | (index + 1));
+
+            for (; iter != positionEnd && (*iter >> 32) == word; ++iter)
+            {
+                const auto other = static_cast<uint32_t>(*iter & POSTING_INDEX_MASK);
+
+                if (counts[other]++ == 0)
+                    touched.push_back(other);
+            }
+        }
+
+        for (const auto other : touched)
+        {
+            const int strength = counts[other];
+            counts[other] = 0;
+
+            if (strength < sensitivity)
+                continue;
+
+            if (!IgnoredPairs.empty() &&
+                IgnoredPairs.find(std::make_tuple(ImageIDs[index], ImageIDs[other])) != IgnoredPairs.end())
+            {
+                continue;
+            }
+
+            result.emplace_back(static_cast<uint32_t>(index), other, strength);
+        }
+
+        touched.clear();
+    }
+}
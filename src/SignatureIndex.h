@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Common.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+namespace DV
+{
+//! Number of bits used to store a single libpuzzle signature value (values are in range -2 to 2)
+constexpr auto SIGNATURE_INDEX_BITS_PER_VALUE = 3;
+
+//! Number of uint64_t elements used to store the packed values of one signature. This needs to fit
+//! IMAGE_SIGNATURE_WORD_COUNT + IMAGE_SIGNATURE_WORD_LENGTH - 1 values
+constexpr auto SIGNATURE_INDEX_PACKED_ELEMENTS = 6;
+
+//! \brief Bit-packed in-memory index of image signatures for quickly finding potential duplicates
+//!
+//! This replaces the self-join on picture_signature_words that used to be ran while holding the database lock. The
+//! matching logic is the same: each image has up to IMAGE_SIGNATURE_WORD_COUNT words that are made from
+//! IMAGE_SIGNATURE_WORD_LENGTH consecutive signature values. Two images get one point of strength for each position
+//! where they have the same word.
+//!
+//! Usage: add all signatures and ignored pairs, then call BuildPostings and after that FindPotentialDuplicates. Only
+//! the first step needs the database to be locked.
+//! \note Signatures of a single image should only be added once
+class SignatureIndex
+{
+public:
+    //! \brief Hashes a pair of image ids for the ignored pairs set
+    struct PairHash
+    {
+        size_t operator()(const std::tuple<DBID, DBID>& pair) const noexcept
+        {
+            const auto first = static_cast<uint64_t>(std::get<0>(pair));
+            const auto second = static_cast<uint64_t>(std::get<1>(pair));
+            return std::hash<uint64_t>()(first * 0x9E3779B97F4A7C15ULL ^ second);
+        }
+    };
+
+    using IgnoredPairSet = std::unordered_set<std::tuple<DBID, DBID>, PairHash>;
+
+public:
+    //! \brief Reserves space for count images
+    void Reserve(size_t count);
+
+    //! \brief Removes all data from this index
+    void Clear();
+
+    //! \brief Adds an image signature to the index
+    //! \param signature The raw libpuzzle signature. Values outside the valid libpuzzle range are clamped
+    //! \returns False if the signature is too short to have any words in it, in which case it is not added
+    bool AddSignature(DBID image, const std::string& signature);
+
+    //! \brief Marks a pair of images as not duplicates of each other
+    //! \param primary The image with the lower id
+    void AddIgnoredPair(DBID primary, DBID other);
+
+    //! \brief Builds the inverted word -> image lists. Must be called after all signatures are added
+    void BuildPostings();
+
+    //! \brief Finds images that share at least sensitivity words
+    //! \param threads The number of threads to use, 0 uses all cores
+    //! \returns The same format as Database::SelectPotentialImageDuplicates. Lower ids are reported as the original
+    //! image and the vector contains the duplicate ids and the strength of the match
+    std::map<DBID, std::vector<std::tuple<DBID, int>>> FindPotentialDuplicates(
+        int sensitivity, unsigned threads = 0) const;
+
+    size_t GetImageCount() const
+    {
+        return ImageIDs.size();
+    }
+
+    //! \brief Returns the packed word of image at index at word position
+    //! \exception Leviathan::InvalidArgument if index or position is out of range
+    uint32_t GetWord(size_t index, size_t position) const;
+
+    //! \returns The number of words in a signature of the given length
+    static size_t CountWords(size_t signatureLength);
+
+    //! \brief Creates the integer key stored in picture_signature_words for a word of a raw signature
+    //!
+    //! The word position is in the upper 32 bits and the lower bits have the word packed the same way as GetWord
+    //! returns it
+    //! \note position must be less than CountWords(signature.size())
+    static int64_t CreateWordKey(const std::string& signature, size_t position);
+
+private:
+    //! \brief Finds the candidates for images in range [start, end) and puts the found matches in result
+    void _ScanRange(size_t start, size_t end, int sensitivity, std::vector<uint8_t>& counts,
+        std::vector<uint32_t>& touched, std::vector<std::tuple<uint32_t, uint32_t, int>>& result) const;
+
+private:
+    //! Ids of the images in the index, after BuildPostings this is in ascending order
+    std::vector<DBID> ImageIDs;
+
+    //! Number of words each image has
+    std::vector<uint8_t> WordCounts;
+
+    //! The signature values. SIGNATURE_INDEX_PACKED_ELEMENTS elements per image
+    std::vector<uint64_t> PackedSignatures;
+
+    //! Inverted lists for each word position. Each item is (word << 32) | image index and each position range is
+    //! sorted so that all images with the same word are next to each other in ascending index order
+    std::vector<uint64_t> Postings;
+
+    //! Start of each word position in Postings, the last item is the end of the last position
+    std::vector<size_t> PositionOffsets;
+
+    IgnoredPairSet IgnoredPairs;
+
+    bool PostingsBuilt = false;
+};
+
+} // namespace DV
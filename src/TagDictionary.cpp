@@ -0,0 +1,81 @@
+// ------------------------------------ //
+#include "TagDictionary.h"
+
+#include <algorithm>
+
+using namespace DV;
+// ------------------------------------ //
+void TagDictionary::Clear()
+{
+    Entries.clear();
+}
+
+// ------------------------------------ //
+void TagDictionary::AddTag(const std::string& text, const std::shared_ptr<Tag>& tag, bool alias)
+{
+    auto& entry = Entries[text];
+
+    // The first added one wins like the first row of a query would
+    if (entry.MatchedTag && (alias || !entry.TagIsAlias))
+        return;
+
+    entry.MatchedTag = tag;
+    entry.TagIsAlias = alias;
+}
+
+void TagDictionary::AddModifier(const std::string& text, const std::shared_ptr<TagModifier>& modifier, bool alias)
+{
+    auto& entry = Entries[text];
+
+    if (entry.Modifier && (alias || !entry.ModifierIsAlias))
+        return;
+
+    entry.Modifier = modifier;
+    entry.ModifierIsAlias = alias;
+}
+
+void TagDictionary::AddBreakRule(const std::string& pattern, const std::shared_ptr<TagBreakRule>& rule)
+{
+    {
+        auto& entry = Entries[pattern];
+
+        if (!entry.BreakRule || entry.BreakRuleIsWildcard)
+        {
+            entry.BreakRule = rule;
+            entry.BreakRuleIsWildcard = false;
+        }
+    }
+
+    auto withoutWildcard = pattern;
+    withoutWildcard.erase(std::remove(withoutWildcard.begin(), withoutWildcard.end(), '*'), withoutWildcard.end());
+
+    if (withoutWildcard == pattern)
+        return;
+
+    auto& entry = Entries[withoutWildcard];
+
+    if (!entry.BreakRule)
+    {
+        entry.BreakRule = rule;
+        entry.BreakRuleIsWildcard = true;
+    }
+}
+
+void TagDictionary::AddSuperAlias(const std::string& alias, const std::string& expanded)
+{
+    auto& entry = Entries[alias];
+
+    if (entry.SuperAlias.empty())
+        entry.SuperAlias = expanded;
+}
+
+// ------------------------------------ //
+const TagDictionary::Entry* TagDictionary::Find(const std::string& text) const
+{
+    const auto found = Entries.find(text);
+
+    if (found == Entries.end())
+        return nullptr;
+
+    return &found->second;
+}
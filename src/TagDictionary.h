@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Common.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace DV
+{
+class Tag;
+class TagModifier;
+class TagBreakRule;
+
+//! \brief In-memory dictionary of all the words that tag parsing looks up
+//!
+//! Holds the tag names and aliases, modifier names and aliases, break rule patterns and super
+//! aliases keyed by their lowercase text. A single hash lookup tells everything a word can be
+//! so that parsing a tag string doesn't need to run queries for every word combination.
+class TagDictionary
+{
+public:
+    //! \brief Everything a single word matches
+    struct Entry
+    {
+        std::shared_ptr<Tag> MatchedTag;
+        std::shared_ptr<TagModifier> Modifier;
+        std::shared_ptr<TagBreakRule> BreakRule;
+
+        //! The text this expands to if this is a super alias
+        std::string SuperAlias;
+
+        //! Names are preferred over aliases with the same text
+        bool TagIsAlias = false;
+        bool ModifierIsAlias = false;
+
+        //! Exact patterns are preferred over patterns with the wildcard removed
+        bool BreakRuleIsWildcard = false;
+    };
+
+    void Clear();
+
+    //! \brief Adds a tag name or alias
+    //! \note All the texts given to this class need to be lowercase
+    void AddTag(const std::string& text, const std::shared_ptr<Tag>& tag, bool alias);
+
+    void AddModifier(const std::string& text, const std::shared_ptr<TagModifier>& modifier, bool alias);
+
+    //! \brief Adds a break rule for both its exact pattern and the pattern with '*' removed
+    void AddBreakRule(const std::string& pattern, const std::shared_ptr<TagBreakRule>& rule);
+
+    void AddSuperAlias(const std::string& alias, const std::string& expanded);
+
+    //! \returns The entry for text or null if text isn't known
+    const Entry* Find(const std::string& text) const;
+
+    size_t GetEntryCount() const
+    {
+        return Entries.size();
+    }
+
+private:
+    std::unordered_map<std::string, Entry> Entries;
+};
+
+} // namespace DV
@@ -0,0 +1,449 @@
+// ------------------------------------ //
+#include "TagSearchIndex.h"
+
+#include "Exceptions.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+using namespace DV;
+// ------------------------------------ //
+namespace
+{
+enum class TOKEN
+{
+    Word,
+    And,
+    Or,
+    Not,
+    Open,
+    Close,
+    End
+};
+
+//! \brief Splits a search expression into tokens
+class TagSearchTokenizer
+{
+public:
+    explicit TagSearchTokenizer(const std::string& expression) : Expression(expression) {}
+
+    TOKEN Next(std::string& word)
+    {
+        while (Position < Expression.size() && std::isspace(static_cast<unsigned char>(Expression[Position])))
+            ++Position;
+
+        if (Position >= Expression.size())
+            return TOKEN::End;
+
+        const char current = Expression[Position];
+
+        switch (current)
+        {
+            case '(': ++Position; return TOKEN::Open;
+            case ')': ++Position; return TOKEN::Close;
+            case ',':
+            case '&': ++Position; return TOKEN::And;
+            case '|': ++Position; return TOKEN::Or;
+            case '-': ++Position; return TOKEN::Not;
+            default: break;
+        }
+
+        const auto start = Position;
+
+        while (Position < Expression.size() && !std::isspace(static_cast<unsigned char>(Expression[Position])) &&
+            std::string("(),&|").find(Expression[Position]) == std::string::npos)
+        {
+            ++Position;
+        }
+
+        word = Expression.substr(start, Position - start);
+
+        if (word == "AND")
+            return TOKEN::And;
+
+        if (word == "OR")
+            return TOKEN::Or;
+
+        if (word == "NOT")
+            return TOKEN::Not;
+
+        return TOKEN::Word;
+    }
+
+private:
+    const std::string& Expression;
+    size_t Position = 0;
+};
+
+//! \brief Recursive descent parser for tag search expressions
+class TagSearchParser
+{
+public:
+    explicit TagSearchParser(const std::string& expression) : Tokenizer(expression)
+    {
+        _Advance();
+    }
+
+    std::unique_ptr<TagSearchNode> Parse()
+    {
+        auto result = _ParseOr();
+
+        if (Current != TOKEN::End)
+            throw Leviathan::InvalidArgument("Unexpected ')' in tag search");
+
+        return result;
+    }
+
+private:
+    std::unique_ptr<TagSearchNode> _ParseOr()
+    {
+        auto first = _ParseAnd();
+
+        if (Current != TOKEN::Or)
+            return first;
+
+        auto node = std::make_unique<TagSearchNode>(TagSearchNode::TYPE::Or);
+        node->Children.push_back(std::move(first));
+
+        while (Current == TOKEN::Or)
+        {
+            _Advance();
+            node->Children.push_back(_ParseAnd());
+        }
+
+        return node;
+    }
+
+    std::unique_ptr<TagSearchNode> _ParseAnd()
+    {
+        auto first = _ParseUnary();
+
+        if (Current != TOKEN::And)
+            return first;
+
+        auto node = std::make_unique<TagSearchNode>(TagSearchNode::TYPE::And);
+        node->Children.push_back(std::move(first));
+
+        while (Current == TOKEN::And)
+        {
+            _Advance();
+            node->Children.push_back(_ParseUnary());
+        }
+
+        return node;
+    }
+
+    std::unique_ptr<TagSearchNode> _ParseUnary()
+    {
+        switch (Current)
+        {
+            case TOKEN::Not:
+            {
+                _Advance();
+
+                auto node = std::make_unique<TagSearchNode>(TagSearchNode::TYPE::Not);
+                node->Children.push_back(_ParseUnary());
+                return node;
+            }
+            case TOKEN::Open:
+            {
+                _Advance();
+
+                auto node = _ParseOr();
+
+                if (Current != TOKEN::Close)
+                    throw Leviathan::InvalidArgument("Missing ')' in tag search");
+
+                _Advance();
+                return node;
+            }
+            case TOKEN::Word:
+            {
+                auto node = std::make_unique<TagSearchNode>(TagSearchNode::TYPE::Term);
+                node->Text = CurrentWord;
+                _Advance();
+
+                // Words next to each other are parts of the same tag
+                while (Current == TOKEN::Word)
+                {
+                    node->Text += " " + CurrentWord;
+                    _Advance();
+                }
+
+                return node;
+            }
+            default: throw Leviathan::InvalidArgument("Expected a tag in tag search");
+        }
+    }
+
+    void _Advance()
+    {
+        Current = Tokenizer.Next(CurrentWord);
+    }
+
+private:
+    TagSearchTokenizer Tokenizer;
+
+    TOKEN Current;
+    std::string CurrentWord;
+};
+
+std::vector<DBID> Intersect(const std::vector<DBID>& left, const std::vector<DBID>& right)
+{
+    std::vector<DBID> result;
+    result.reserve(std::min(left.size(), right.size()));
+
+    std::set_intersection(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(result));
+    return result;
+}
+
+std::vector<DBID> Subtract(const std::vector<DBID>& left, const std::vector<DBID>& right)
+{
+    std::vector<DBID> result;
+    result.reserve(left.size());
+
+    std::set_difference(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(result));
+    return result;
+}
+
+std::vector<DBID> Unite(const std::vector<DBID>& left, const std::vector<DBID>& right)
+{
+    std::vector<DBID> result;
+    result.reserve(left.size() + right.size());
+
+    std::set_union(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(result));
+    return result;
+}
+
+//! \brief Inserts value to a sorted vector if it isn't there already
+void InsertSorted(std::vector<DBID>& list, DBID value)
+{
+    const auto iter = std::lower_bound(list.begin(), list.end(), value);
+
+    if (iter == list.end() || *iter != value)
+        list.insert(iter, value);
+}
+
+bool EraseSorted(std::vector<DBID>& list, DBID value)
+{
+    const auto iter = std::lower_bound(list.begin(), list.end(), value);
+
+    if (iter == list.end() || *iter != value)
+        return false;
+
+    list.erase(iter);
+    return true;
+}
+
+const std::vector<DBID> EMPTY_POSTING;
+
+} // namespace
+
+// ------------------------------------ //
+// TagSearchNode
+void TagSearchNode::ForEachTerm(const std::function<void(TagSearchNode&)>& callback)
+{
+    if (Type == TYPE::Term)
+        callback(*this);
+
+    for (auto& child : Children)
+        child->ForEachTerm(callback);
+}
+
+std::string TagSearchNode::ToString() const
+{
+    switch (Type)
+    {
+        case TYPE::Term: return Text;
+        case TYPE::Not: return "NOT " + Children.front()->ToString();
+        case TYPE::And:
+        case TYPE::Or:
+        {
+            std::string result = "(";
+
+            for (size_t i = 0; i < Children.size(); ++i)
+            {
+                if (i > 0)
+                    result += Type == TYPE::And ? " AND " : " OR ";
+
+                result += Children[i]->ToString();
+            }
+
+            return result + ")";
+        }
+    }
+
+    return "";
+}
+
+std::unique_ptr<TagSearchNode> DV::ParseTagSearch(const std::string& expression)
+{
+    return TagSearchParser(expression).Parse();
+}
+
+// ------------------------------------ //
+// TagSearchIndex
+void TagSearchIndex::Clear()
+{
+    Postings.clear();
+    AllImages.clear();
+}
+
+void TagSearchIndex::Build(std::vector<DBID> images, const std::vector<std::tuple<DBID, DBID>>& imageTags)
+{
+    Clear();
+
+    AllImages = std::move(images);
+    std::sort(AllImages.begin(), AllImages.end());
+    AllImages.erase(std::unique(AllImages.begin(), AllImages.end()), AllImages.end());
+
+    for (const auto& [image, tag] : imageTags)
+        Postings[tag].push_back(image);
+
+    for (auto& [tag, tagImages] : Postings)
+    {
+        std::sort(tagImages.begin(), tagImages.end());
+        tagImages.erase(std::unique(tagImages.begin(), tagImages.end()), tagImages.end());
+        tagImages.shrink_to_fit();
+    }
+}
+
+void TagSearchIndex::AddImage(DBID image)
+{
+    InsertSorted(AllImages, image);
+}
+
+void TagSearchIndex::RemoveImage(DBID image)
+{
+    EraseSorted(AllImages, image);
+}
+
+void TagSearchIndex::PurgeImage(DBID image)
+{
+    RemoveImage(image);
+
+    for (auto iter = Postings.begin(); iter != Postings.end();)
+    {
+        if (EraseSorted(iter->second, image) && iter->second.empty())
+        {
+            iter = Postings.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+void TagSearchIndex::AddTag(DBID image, DBID tag)
+{
+    InsertSorted(Postings[tag], image);
+}
+
+void TagSearchIndex::RemoveTag(DBID image, DBID tag)
+{
+    const auto found = Postings.find(tag);
+
+    if (found == Postings.end())
+        return;
+
+    if (EraseSorted(found->second, image) && found->second.empty())
+        Postings.erase(found);
+}
+
+void TagSearchIndex::MergeTags(DBID target, DBID source)
+{
+    if (target == source)
+        return;
+
+    const auto found = Postings.find(source);
+
+    if (found == Postings.end())
+        return;
+
+    auto& targetList = Postings[target];
+    targetList = Unite(targetList, found->second);
+
+    // The reference to target stays valid as unordered_map doesn't move its values
+    Postings.erase(source);
+}
+
+const std::vector<DBID>& TagSearchIndex::GetImagesWithTag(DBID tag) const
+{
+    const auto found = Postings.find(tag);
+
+    if (found == Postings.end())
+        return EMPTY_POSTING;
+
+    return found->second;
+}
+
+// ------------------------------------ //
+std::vector<DBID> TagSearchIndex::Search(const TagSearchNode& query) const
+{
+    // Tag lists also contain deleted images
+    return Intersect(_Evaluate(query), AllImages);
+}
+
+std::vector<DBID> TagSearchIndex::_Evaluate(const TagSearchNode& node) const
+{
+    switch (node.Type)
+    {
+        case TagSearchNode::TYPE::Term: return GetImagesWithTag(node.TagID);
+        case TagSearchNode::TYPE::Not: return Subtract(AllImages, _Evaluate(*node.Children.front()));
+        case TagSearchNode::TYPE::Or:
+        {
+            std::vector<DBID> result;
+
+            for (const auto& child : node.Children)
+                result = Unite(result, _Evaluate(*child));
+
+            return result;
+        }
+        case TagSearchNode::TYPE::And:
+        {
+            // Negated parts are subtracted from the result of the other parts instead of first
+            // finding all images without them
+            std::vector<std::vector<DBID>> included;
+            std::vector<DBID> excluded;
+
+            for (const auto& child : node.Children)
+            {
+                if (child->Type == TagSearchNode::TYPE::Not)
+                {
+                    excluded = Unite(excluded, _Evaluate(*child->Children.front()));
+                }
+                else
+                {
+                    included.push_back(_Evaluate(*child));
+                }
+            }
+
+            std::vector<DBID> result;
+
+            if (included.empty())
+            {
+                result = AllImages;
+            }
+            else
+            {
+                // Smallest lists first to make the intermediate results small
+                std::sort(included.begin(), included.end(),
+                    [](const auto& left, const auto& right) { return left.size() < right.size(); });
+
+                result = std::move(included.front());
+
+                for (size_t i = 1; i < included.size() && !result.empty(); ++i)
+                    result = Intersect(result, included[i]);
+            }
+
+            if (!excluded.empty())
+                result = Subtract(result, excluded);
+
+            return result;
+        }
+    }
+
+    return {};
+}
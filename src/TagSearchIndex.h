@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Common.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace DV
+{
+//! \brief Node in a parsed tag search expression
+struct TagSearchNode
+{
+    enum class TYPE
+    {
+        Term,
+        And,
+        Or,
+        Not
+    };
+
+    explicit TagSearchNode(TYPE type) : Type(type) {}
+
+    TYPE Type;
+
+    //! The tag text of a Term
+    std::string Text;
+
+    //! The applied tag id of a Term, -1 if no applied tag matches Text
+    DBID TagID = -1;
+
+    std::vector<std::unique_ptr<TagSearchNode>> Children;
+
+    //! \brief Calls callback for every Term node in this tree
+    void ForEachTerm(const std::function<void(TagSearchNode&)>& callback);
+
+    //! \brief Returns the expression as text with parentheses around every operator
+    std::string ToString() const;
+};
+
+//! \brief Parses a tag search expression
+//!
+//! Terms are tag texts, like "red car", combined with AND, OR and NOT (also written as ',', '|'
+//! and '-' before a term) and grouped with parentheses. AND binds tighter than OR and two terms
+//! next to each other without an operator in between are a single tag text.
+//! \exception Leviathan::InvalidArgument if the expression is invalid
+std::unique_ptr<TagSearchNode> ParseTagSearch(const std::string& expression);
+
+//! \brief In-memory index of which images have which applied tags, used for searching images by
+//! multiple tags without running a query per tag
+//!
+//! Each applied tag has a sorted list of image ids. All non-deleted image ids are also stored as
+//! NOT needs something to subtract from.
+//! \note This is not thread safe, Database uses this while locked
+class TagSearchIndex
+{
+public:
+    void Clear();
+
+    //! \brief Replaces all data in the index
+    //! \param images The non-deleted images
+    //! \param imageTags Pairs of image and applied tag ids
+    void Build(std::vector<DBID> images, const std::vector<std::tuple<DBID, DBID>>& imageTags);
+
+    void AddImage(DBID image);
+
+    //! \brief Removes an image from the image list (but not from the tag lists)
+    //!
+    //! Used when images are marked as deleted as they can be restored with their tags
+    void RemoveImage(DBID image);
+
+    //! \brief Removes an image from the image list and all tag lists
+    void PurgeImage(DBID image);
+
+    void AddTag(DBID image, DBID tag);
+    void RemoveTag(DBID image, DBID tag);
+
+    //! \brief Moves all images of source tag to target tag
+    void MergeTags(DBID target, DBID source);
+
+    //! \returns The sorted list of images that have tag
+    const std::vector<DBID>& GetImagesWithTag(DBID tag) const;
+
+    //! \brief Finds the images that match a parsed search expression
+    //! \returns Sorted image ids
+    //! \note Term nodes must have their TagID set
+    std::vector<DBID> Search(const TagSearchNode& query) const;
+
+    size_t GetTagCount() const
+    {
+        return Postings.size();
+    }
+
+    size_t GetImageCount() const
+    {
+        return AllImages.size();
+    }
+
+private:
+    std::vector<DBID> _Evaluate(const TagSearchNode& node) const;
+
+private:
+    std::unordered_map<DBID, std::vector<DBID>> Postings;
+
+    //! Sorted ids of all images that aren't deleted
+    std::vector<DBID> AllImages;
+};
+
+} // namespace DV
@@ -4,17 +4,54 @@
 
 #include "Common/ThreadSafe.h"
 
-#include <deque>
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 namespace DV {
 
 using PriorityValueT = int64_t;
 
+class BaseTaskItem;
+
+//! \brief Tasks whose priority has changed while queued
+//!
+//! This has its own lock so that priorities can be changed without locking the task list (which
+//! the caller might already have locked)
+class TaskPriorityChanges {
+public:
+    void Add(std::weak_ptr<BaseTaskItem> task)
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Changed.push_back(std::move(task));
+        HasChanges = true;
+    }
+
+    std::vector<std::weak_ptr<BaseTaskItem>> TakeAll()
+    {
+        std::vector<std::weak_ptr<BaseTaskItem>> result;
+
+        std::lock_guard<std::mutex> lock(Mutex);
+        result.swap(Changed);
+        HasChanges = false;
+        return result;
+    }
+
+    //! Allows checking for changes without locking
+    std::atomic<bool> HasChanges{false};
+
+private:
+    std::mutex Mutex;
+    std::vector<std::weak_ptr<BaseTaskItem>> Changed;
+};
+
 //! \brief Base class for TaskItem that can be used when the actual task is unnecessary to know
 //! \todo Add a cancel interface here?
-class BaseTaskItem {
+class BaseTaskItem : public std::enable_shared_from_this<BaseTaskItem> {
+    template<class T>
+    friend class TaskListWithPriority;
+
 protected:
     explicit BaseTaskItem(PriorityValueT priority) noexcept : Priority(priority) {}
 
@@ -25,9 +62,16 @@ public:
         SetPriority(TimeHelpers::GetCurrentUnixTimestamp());
     }
 
+    //! \brief Changes the priority. If this is queued the task list is reordered before it
+    //! next pops a task
     void SetPriority(PriorityValueT newPriority)
     {
-        Priority = newPriority;
+        Priority.store(newPriority, std::memory_order_release);
+
+        std::lock_guard<std::mutex> lock(QueueMutex);
+
+        if(const auto changes = Queue.lock())
+            changes->Add(weak_from_this());
     }
 
     [[nodiscard]] auto GetPriority() const
@@ -43,11 +87,22 @@ public:
 private:
     std::atomic<bool> Done{false};
     std::atomic<PriorityValueT> Priority;
+
+    //! Locks Queue, the task list lock is always locked before this if both are needed
+    std::mutex QueueMutex;
+
+    //! Where priority changes are reported while this is in a task list
+    std::weak_ptr<TaskPriorityChanges> Queue;
+
+    //! Position in the heap of the task list, only used with the task list locked
+    size_t HeapIndex = 0;
 };
 
 //! \brief Keeps a list of tasks that can be executed, and priority changed while running
 //!
-//! For performance this only performs partial sorts when getting the task to execute
+//! The tasks are kept in a binary heap that also tracks where each task is so that priority
+//! changes move the task without searching for it. Tasks with the same priority are executed in
+//! the order they were added.
 template<class T>
 class TaskListWithPriority : public ThreadSafe {
 public:
@@ -63,16 +118,27 @@ public:
     };
 
 public:
+    TaskListWithPriority() : Changes(std::make_shared<TaskPriorityChanges>()) {}
+
     //! \brief Adds a new task to be ran
     std::shared_ptr<TaskItem> Push(
         Lock& guard, T item, PriorityValueT priority = TimeHelpers::GetCurrentUnixTimestamp())
     {
         const auto task = std::make_shared<TaskItem>(item, priority);
 
-        Queue.emplace_back(task);
+        _Insert(task);
         return task;
     }
 
+    //! \brief Adds an already created task, used to move tasks between lists while keeping
+    //! references to the task (and its priority) valid
+    //!
+    //! The task is ordered after the existing tasks with the same priority
+    void Push(Lock& guard, const std::shared_ptr<TaskItem>& task)
+    {
+        _Insert(task);
+    }
+
     void Clear()
     {
         GUARD_LOCK();
@@ -81,98 +147,161 @@ public:
 
     void Clear(Lock& guard)
     {
-        Queue.clear();
-        SinceLastFullSort = 0;
+        for(const auto& entry : Heap)
+            _Detach(*entry.Task);
+
+        Heap.clear();
+        Changes->TakeAll();
     }
 
     bool Empty(Lock& guard) const
     {
-        return Queue.empty();
+        return Heap.empty();
+    }
+
+    size_t GetSize(Lock& guard) const
+    {
+        return Heap.size();
     }
 
     //! \brief Gets the next task to run and removes it from the queue
     std::shared_ptr<TaskItem> Pop(Lock& guard)
     {
-        if(Queue.empty())
+        _ApplyPriorityChanges();
+
+        if(Heap.empty())
             return nullptr;
 
-        ++SinceLastFullSort;
-        ++SinceFrontProcess;
+        auto result = std::move(Heap.front().Task);
+        _Detach(*result);
 
-        // A bit of a hack to make thumbnail and gallery loading nicer looking at the front
-        if(SinceFrontProcess >= FrontProcessInterval) {
+        if(Heap.size() > 1) {
 
-            auto result = Queue.front();
-            Queue.pop_front();
+            Heap.front() = std::move(Heap.back());
+            Heap.pop_back();
+            Heap.front().Task->HeapIndex = 0;
+            _SiftDown(0);
 
-            SinceFrontProcess = 0;
-            return result;
+        } else {
+            Heap.pop_back();
         }
 
-        const bool fullLook = SinceLastFullSort >= FullSortInterval;
-        SinceLastFullSort = 0;
+        return result;
+    }
 
-        // Find kind of the highest priority as well as do some bubble sorting
+private:
+    struct HeapEntry {
+        //! Copy of the task priority. The heap is ordered by this as the task priority can
+        //! change at any time
+        PriorityValueT Priority;
 
-        int timeLooking = 20;
+        //! Insertion order for keeping same priority tasks in order
+        uint64_t Sequence;
 
-        auto bestTask = Queue.rbegin();
+        std::shared_ptr<TaskItem> Task;
+    };
 
-        for(auto iter = bestTask; iter != Queue.rend();) {
-            // Can't do anything really with the last item
-            const auto next = std::next(iter);
-            if(next == Queue.rend())
-                break;
+    //! \returns True if left should be ran before right
+    static bool _IsBefore(const HeapEntry& left, const HeapEntry& right)
+    {
+        if(left.Priority != right.Priority)
+            return left.Priority > right.Priority;
+
+        return left.Sequence < right.Sequence;
+    }
+
+    void _Insert(const std::shared_ptr<TaskItem>& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(task->QueueMutex);
+            task->Queue = Changes;
+        }
+
+        // The priority is read after registering for changes so that no change is missed
+        task->HeapIndex = Heap.size();
+        Heap.push_back(HeapEntry{task->GetPriority(), NextSequence++, task});
 
-            const auto currentPriority = (*iter)->GetPriority();
-            const auto nextPriority = (*next)->GetPriority();
-            const auto bestPriority = (*bestTask)->GetPriority();
+        _SiftUp(Heap.size() - 1);
+    }
+
+    static void _Detach(BaseTaskItem& task)
+    {
+        std::lock_guard<std::mutex> lock(task.QueueMutex);
+        task.Queue.reset();
+    }
 
-            if(currentPriority < nextPriority) {
+    void _ApplyPriorityChanges()
+    {
+        if(!Changes->HasChanges)
+            return;
 
-                std::swap(*iter, *next);
+        for(const auto& weakTask : Changes->TakeAll()) {
 
-                if(nextPriority >= bestPriority) {
-                    bestTask = iter;
-                }
-            } else {
-                if(currentPriority >= bestPriority) {
-                    bestTask = iter;
-                }
-            }
+            const auto task = weakTask.lock();
 
-            if(currentPriority != nextPriority)
-                --timeLooking;
+            // Skip tasks that have already been popped
+            if(!task || task->HeapIndex >= Heap.size() ||
+                Heap[task->HeapIndex].Task.get() != task.get())
+                continue;
 
-            if(timeLooking < 0 && !fullLook) {
-                break;
-            }
+            const auto index = task->HeapIndex;
+            Heap[index].Priority = task->GetPriority();
 
-            ++iter;
+            _SiftDown(_SiftUp(index));
         }
+    }
 
-        if(bestTask != Queue.rend()) {
-            const auto result = *bestTask;
-            Queue.erase(std::next(bestTask).base());
-            return result;
+    //! \returns The new index of the moved entry
+    size_t _SiftUp(size_t index)
+    {
+        while(index > 0) {
+
+            const auto parent = (index - 1) / 2;
+
+            if(!_IsBefore(Heap[index], Heap[parent]))
+                break;
+
+            _Swap(index, parent);
+            index = parent;
         }
 
-        // Fallback for just returning the last item
-        if(!Queue.empty()) {
-            const auto result = Queue.back();
-            Queue.pop_back();
-            return result;
+        return index;
+    }
+
+    void _SiftDown(size_t index)
+    {
+        while(true) {
+
+            const auto left = index * 2 + 1;
+            const auto right = left + 1;
+
+            auto best = index;
+
+            if(left < Heap.size() && _IsBefore(Heap[left], Heap[best]))
+                best = left;
+
+            if(right < Heap.size() && _IsBefore(Heap[right], Heap[best]))
+                best = right;
+
+            if(best == index)
+                return;
+
+            _Swap(index, best);
+            index = best;
         }
+    }
 
-        return nullptr;
+    void _Swap(size_t first, size_t second)
+    {
+        std::swap(Heap[first], Heap[second]);
+        Heap[first].Task->HeapIndex = first;
+        Heap[second].Task->HeapIndex = second;
     }
 
 private:
-    const int FullSortInterval = 20;
-    const int FrontProcessInterval = 5;
+    std::vector<HeapEntry> Heap;
+    uint64_t NextSequence = 0;
 
-    std::deque<std::shared_ptr<TaskItem>> Queue;
-    int SinceLastFullSort = 0;
-    int SinceFrontProcess = 0;
+    std::shared_ptr<TaskPriorityChanges> Changes;
 };
 } // namespace DV
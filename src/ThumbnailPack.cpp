@@ -0,0 +1,409 @@
+// ------------------------------------ //
+#include "ThumbnailPack.h"
+
+#include "Common.h"
+#include "Exceptions.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace DV;
+// ------------------------------------ //
+constexpr uint32_t RECORD_MAGIC = 0x50545644; // "DVTP"
+constexpr uint64_t TOMBSTONE_LENGTH = UINT64_MAX;
+
+constexpr auto SEGMENT_PREFIX = "segment_";
+constexpr auto SEGMENT_EXTENSION = ".pack";
+
+//! \brief Header before each record in a segment
+struct RecordHeader
+{
+    uint32_t Magic;
+    uint32_t NameLength;
+
+    //! TOMBSTONE_LENGTH for removed thumbnails
+    uint64_t DataLength;
+};
+
+static_assert(sizeof(RecordHeader) == 16, "RecordHeader has unexpected padding");
+
+static boost::filesystem::path MakeSegmentPath(const std::string& folder, uint32_t number)
+{
+    auto name = std::to_string(number);
+    name.insert(0, 6 - std::min<size_t>(6, name.size()), '0');
+
+    return boost::filesystem::path(folder) / (SEGMENT_PREFIX + name + SEGMENT_EXTENSION);
+}
+
+// ------------------------------------ //
+ThumbnailPack::ThumbnailPack(const std::string& folder, uint64_t segmentSize /*= THUMBNAIL_PACK_DEFAULT_SEGMENT_SIZE*/) :
+    Folder(folder), SegmentSize(segmentSize)
+{
+    namespace bf = boost::filesystem;
+
+    boost::system::error_code error;
+    bf::create_directories(Folder, error);
+
+    if (!bf::is_directory(Folder))
+        throw Leviathan::InvalidArgument("Thumbnail pack folder can't be created: " + Folder);
+
+    for (bf::directory_iterator iter(Folder); iter != bf::directory_iterator(); ++iter)
+    {
+        const auto filename = iter->path().filename().string();
+
+        if (!bf::is_regular_file(iter->status()) || iter->path().extension() != SEGMENT_EXTENSION ||
+            filename.find(SEGMENT_PREFIX) != 0)
+        {
+            continue;
+        }
+
+        const auto numberPart = filename.substr(std::strlen(SEGMENT_PREFIX),
+            filename.size() - std::strlen(SEGMENT_PREFIX) - std::strlen(SEGMENT_EXTENSION));
+
+        uint32_t number;
+
+        try
+        {
+            number = static_cast<uint32_t>(std::stoul(numberPart));
+        }
+        catch (const std::exception&)
+        {
+            LOG_WARNING("ThumbnailPack: ignoring file with invalid segment number: " + filename);
+            continue;
+        }
+
+        auto& segment = Segments[number];
+        segment.Number = number;
+        segment.Path = iter->path();
+        segment.Size = bf::file_size(iter->path());
+    }
+
+    // Later segments override the earlier ones
+    for (auto iter = Segments.begin(); iter != Segments.end(); ++iter)
+    {
+        _ScanSegment(iter->second, std::next(iter) == Segments.end());
+        TotalBytes += iter->second.Size;
+    }
+
+    if (Segments.empty())
+    {
+        _StartNewSegment();
+    }
+    else
+    {
+        ActiveWriter.open(Segments.rbegin()->second.Path.string(), std::ios::binary | std::ios::app);
+
+        if (!ActiveWriter.good())
+            throw Leviathan::InvalidArgument("Can't open thumbnail pack segment for writing");
+    }
+}
+
+ThumbnailPack::~ThumbnailPack()
+{
+    _CloseActiveWriter();
+}
+
+// ------------------------------------ //
+bool ThumbnailPack::Contains(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Index.find(name) != Index.end();
+}
+
+bool ThumbnailPack::Read(const std::string& name, std::string& data) const
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+
+    const auto found = Index.find(name);
+
+    if (found == Index.end())
+        return false;
+
+    const auto& location = found->second;
+
+    const char* segmentData = _MapSegment(Segments.at(location.Segment));
+
+    data.assign(segmentData + location.Offset, location.Length);
+    return true;
+}
+
+void ThumbnailPack::Add(const std::string& name, const void* data, size_t length)
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+
+    const auto existing = Index.find(name);
+
+    if (existing != Index.end())
+        LiveBytes -= _RecordSize(name, existing->second.Length);
+
+    Index[name] = _Append(name, data, length, false);
+    LiveBytes += _RecordSize(name, length);
+}
+
+bool ThumbnailPack::Remove(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+
+    const auto found = Index.find(name);
+
+    if (found == Index.end())
+        return false;
+
+    LiveBytes -= _RecordSize(name, found->second.Length);
+    Index.erase(found);
+
+    _Append(name, nullptr, 0, true);
+    return true;
+}
+
+void ThumbnailPack::Clear()
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+
+    _CloseActiveWriter();
+
+    for (auto& [number, segment] : Segments)
+    {
+        segment.Region.reset();
+        segment.Mapping.reset();
+
+        boost::system::error_code error;
+        boost::filesystem::remove(segment.Path, error);
+
+        if (error)
+            LOG_ERROR("ThumbnailPack: failed to delete segment: " + segment.Path.string());
+    }
+
+    Segments.clear();
+    Index.clear();
+    TotalBytes = 0;
+    LiveBytes = 0;
+
+    boost::system::error_code error;
+    boost::filesystem::create_directories(Folder, error);
+
+    _StartNewSegment();
+}
+
+void ThumbnailPack::Compact()
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+
+    // Everything is written to new segments so that no old record can come back when the
+    // segments are scanned next time
+    const auto oldSegments = Segments.size();
+
+    _StartNewSegment();
+
+    for (auto& [name, location] : Index)
+    {
+        const char* segmentData = _MapSegment(Segments.at(location.Segment));
+
+        // Copied as the mapping is invalidated if the segment being read from is remapped
+        const std::string data(segmentData + location.Offset, location.Length);
+
+        location = _Append(name, data.data(), data.size(), false);
+    }
+
+    // Remove the old segments in order, if this is interrupted the remaining segments are newer
+    // than the deleted ones so no removed thumbnails reappear
+    for (size_t i = 0; i < oldSegments; ++i)
+    {
+        auto& segment = Segments.begin()->second;
+
+        segment.Region.reset();
+        segment.Mapping.reset();
+
+        TotalBytes -= segment.Size;
+
+        boost::system::error_code error;
+        boost::filesystem::remove(segment.Path, error);
+
+        if (error)
+            LOG_ERROR("ThumbnailPack: failed to delete compacted segment: " + segment.Path.string());
+
+        Segments.erase(Segments.begin());
+    }
+}
+
+bool ThumbnailPack::ShouldCompact() const
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+    return TotalBytes > 0 && LiveBytes * 2 < TotalBytes;
+}
+
+// ------------------------------------ //
+size_t ThumbnailPack::GetCount() const
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Index.size();
+}
+
+uint64_t ThumbnailPack::GetTotalBytes() const
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+    return TotalBytes;
+}
+
+uint64_t ThumbnailPack::GetLiveBytes() const
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+    return LiveBytes;
+}
+
+size_t ThumbnailPack::GetSegmentCount() const
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Segments.size();
+}
+
+// ------------------------------------ //
+void ThumbnailPack::_ScanSegment(Segment& segment, bool truncateBrokenTail)
+{
+    if (segment.Size < 1)
+        return;
+
+    const char* data = _MapSegment(segment);
+
+    uint64_t offset = 0;
+
+    while (offset < segment.Size)
+    {
+        RecordHeader header;
+
+        if (segment.Size - offset < sizeof(header))
+            break;
+
+        std::memcpy(&header, data + offset, sizeof(header));
+
+        const auto dataLength = header.DataLength == TOMBSTONE_LENGTH ? 0 : header.DataLength;
+
+        if (header.Magic != RECORD_MAGIC ||
+            segment.Size - offset - sizeof(header) < static_cast<uint64_t>(header.NameLength) ||
+            segment.Size - offset - sizeof(header) - header.NameLength < dataLength)
+        {
+            break;
+        }
+
+        std::string name(data + offset + sizeof(header), header.NameLength);
+
+        const auto existing = Index.find(name);
+
+        if (existing != Index.end())
+        {
+            LiveBytes -= _RecordSize(name, existing->second.Length);
+            Index.erase(existing);
+        }
+
+        if (header.DataLength != TOMBSTONE_LENGTH)
+        {
+            LiveBytes += _RecordSize(name, dataLength);
+            Index[std::move(name)] = Location{segment.Number, offset + sizeof(header) + header.NameLength, dataLength};
+        }
+
+        offset += sizeof(header) + header.NameLength + dataLength;
+    }
+
+    if (offset == segment.Size)
+        return;
+
+    LOG_WARNING("ThumbnailPack: segment has a broken record at " + std::to_string(offset) +
+        ", file: " + segment.Path.string());
+
+    // A partially written record at the end of the last segment is cut off so that new records
+    // can be appended after the valid ones
+    if (truncateBrokenTail)
+    {
+        segment.Region.reset();
+        segment.Mapping.reset();
+
+        boost::filesystem::resize_file(segment.Path, offset);
+        segment.Size = offset;
+    }
+}
+
+ThumbnailPack::Location ThumbnailPack::_Append(
+    const std::string& name, const void* data, uint64_t length, bool tombstone)
+{
+    auto* active = &Segments.rbegin()->second;
+
+    if (active->Size > 0 && active->Size + _RecordSize(name, length) > SegmentSize)
+    {
+        _StartNewSegment();
+        active = &Segments.rbegin()->second;
+    }
+
+    RecordHeader header{RECORD_MAGIC, static_cast<uint32_t>(name.size()), tombstone ? TOMBSTONE_LENGTH : length};
+
+    ActiveWriter.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ActiveWriter.write(name.data(), name.size());
+
+    if (length > 0)
+        ActiveWriter.write(static_cast<const char*>(data), length);
+
+    // Flushed so that the memory mapping sees the data
+    ActiveWriter.flush();
+
+    if (!ActiveWriter.good())
+        throw Leviathan::InvalidState("Writing to thumbnail pack segment failed: " + active->Path.string());
+
+    const Location location{active->Number, active->Size + sizeof(header) + name.size(), length};
+
+    const auto written = _RecordSize(name, length);
+    active->Size += written;
+    TotalBytes += written;
+
+    return location;
+}
+
+void ThumbnailPack::_StartNewSegment()
+{
+    _CloseActiveWriter();
+
+    const uint32_t number = Segments.empty() ? 1 : Segments.rbegin()->first + 1;
+
+    auto& segment = Segments[number];
+    segment.Number = number;
+    segment.Path = MakeSegmentPath(Folder, number);
+    segment.Size = 0;
+
+    ActiveWriter.open(segment.Path.string(), std::ios::binary | std::ios::trunc);
+
+    if (!ActiveWriter.good())
+        throw Leviathan::InvalidArgument("Can't create thumbnail pack segment: " + segment.Path.string());
+}
+
+const char* ThumbnailPack::_MapSegment(Segment& segment) const
+{
+    namespace bi = boost::interprocess;
+
+    // Appended data is only visible after remapping
+    if (!segment.Region || segment.Region->get_size() < segment.Size)
+    {
+        segment.Region.reset();
+
+        if (!segment.Mapping)
+            segment.Mapping = std::make_unique<bi::file_mapping>(segment.Path.string().c_str(), bi::read_only);
+
+        segment.Region = std::make_unique<bi::mapped_region>(*segment.Mapping, bi::read_only, 0, segment.Size);
+    }
+
+    return static_cast<const char*>(segment.Region->get_address());
+}
+
+void ThumbnailPack::_CloseActiveWriter()
+{
+    if (ActiveWriter.is_open())
+        ActiveWriter.close();
+
+    ActiveWriter.clear();
+}
+
+uint64_t ThumbnailPack::_RecordSize(const std::string& name, uint64_t length)
+{
+    return sizeof(RecordHeader) + name.size() + length;
+}
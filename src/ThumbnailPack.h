@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <boost/filesystem/path.hpp>
+
+namespace boost::interprocess
+{
+class file_mapping;
+class mapped_region;
+} // namespace boost::interprocess
+
+namespace DV
+{
+//! A new segment file is started once the current one grows past this
+constexpr uint64_t THUMBNAIL_PACK_DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+
+//! \brief Stores thumbnails in a few large append-only segment files instead of one file per image
+//!
+//! Each record in a segment is a small header, the name (hash + extension) and the file data.
+//! Removing a thumbnail appends a record without data. The index from name to data location is
+//! kept in memory and rebuilt by scanning the segments when opened, later records override
+//! earlier ones. Segments are read through memory mappings. Compact rewrites the live data to
+//! new segments to get rid of removed and replaced thumbnails.
+//! \note This is thread safe, all operations lock an internal mutex
+class ThumbnailPack
+{
+    struct Segment
+    {
+        uint32_t Number;
+        boost::filesystem::path Path;
+        uint64_t Size = 0;
+
+        std::unique_ptr<boost::interprocess::file_mapping> Mapping;
+        std::unique_ptr<boost::interprocess::mapped_region> Region;
+    };
+
+    struct Location
+    {
+        uint32_t Segment;
+
+        //! Offset of the data (after the header and name) in the segment
+        uint64_t Offset;
+        uint64_t Length;
+    };
+
+public:
+    //! \brief Opens the pack in folder or creates an empty one
+    //! \exception Leviathan::InvalidArgument if the folder or a segment can't be opened
+    explicit ThumbnailPack(const std::string& folder, uint64_t segmentSize = THUMBNAIL_PACK_DEFAULT_SEGMENT_SIZE);
+    ~ThumbnailPack();
+
+    ThumbnailPack(const ThumbnailPack&) = delete;
+    ThumbnailPack& operator=(const ThumbnailPack&) = delete;
+
+    bool Contains(const std::string& name) const;
+
+    //! \brief Copies the data of a thumbnail to data
+    //! \returns False if there is no thumbnail with name
+    bool Read(const std::string& name, std::string& data) const;
+
+    //! \brief Adds a thumbnail, replacing an existing one with the same name
+    //! \exception Leviathan::InvalidState if writing fails
+    void Add(const std::string& name, const void* data, size_t length);
+
+    //! \returns False if there was no thumbnail with name
+    bool Remove(const std::string& name);
+
+    //! \brief Deletes all segment files
+    void Clear();
+
+    //! \brief Moves all live thumbnails to new segments and deletes the old segments
+    //! \note Reads are blocked while this runs
+    void Compact();
+
+    //! \returns True if at least half of the segment data is removed or replaced thumbnails
+    bool ShouldCompact() const;
+
+    size_t GetCount() const;
+
+    //! \returns The size of all segment files
+    uint64_t GetTotalBytes() const;
+
+    //! \returns The size of the records that are still in use
+    uint64_t GetLiveBytes() const;
+
+    size_t GetSegmentCount() const;
+
+    const std::string& GetFolder() const
+    {
+        return Folder;
+    }
+
+private:
+    //! \brief Reads all records of a segment into the index
+    void _ScanSegment(Segment& segment, bool truncateBrokenTail);
+
+    //! \brief Appends a record to the active segment
+    //! \returns The location of the written data
+    Location _Append(const std::string& name, const void* data, uint64_t length, bool tombstone);
+
+    //! \brief Closes the current active segment and creates a new empty one
+    void _StartNewSegment();
+
+    //! \brief Makes sure that the whole segment is mapped
+    //! \returns A pointer to the start of the segment data
+    const char* _MapSegment(Segment& segment) const;
+
+    void _CloseActiveWriter();
+
+    static uint64_t _RecordSize(const std::string& name, uint64_t length);
+
+private:
+    const std::string Folder;
+    const uint64_t SegmentSize;
+
+    mutable std::mutex Mutex;
+
+    //! Segments by their number, the last one is the one written to
+    mutable std::map<uint32_t, Segment> Segments;
+
+    std::unordered_map<std::string, Location> Index;
+
+    std::ofstream ActiveWriter;
+
+    uint64_t TotalBytes = 0;
+    uint64_t LiveBytes = 0;
+};
+
+} // namespace DV
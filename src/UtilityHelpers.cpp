@@ -84,6 +84,19 @@ bool DV::CompareSuggestionStrings(
     return left < right;
 }
 
+int DV::GetSuggestionMatchGroup(const std::string& str, const std::string& text)
+{
+    const auto lower = StringToLower(text);
+
+    if(lower == str)
+        return 0;
+
+    if(Leviathan::StringOperations::StringStartsWith(lower, str))
+        return 1;
+
+    return 2;
+}
+
 bool DV::CompareSuggestionTags(const std::string& str, const std::shared_ptr<Tag>& left,
     const std::shared_ptr<Tag>& right)
 {
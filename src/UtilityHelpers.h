@@ -38,6 +38,24 @@ void SortSuggestions(IterType begin, IterType end, const std::string& str)
             std::placeholders::_2));
 }
 
+//! \brief Returns 0 if text is str, 1 if text starts with str and 2 otherwise
+//! \param str Needs to be lowercase
+int GetSuggestionMatchGroup(const std::string& str, const std::string& text);
+
+//! \brief Sorts the exact matches of str first and then the ones starting with it
+//!
+//! Unlike SortSuggestions this keeps the order of the suggestions within those groups. Used for
+//! suggestions that are already ranked by how much they are used
+template<class IterType>
+void GroupSuggestions(IterType begin, IterType end, const std::string& str)
+{
+    const auto lower = StringToLower(str);
+
+    std::stable_sort(begin, end, [&lower](const std::string& left, const std::string& right) {
+        return GetSuggestionMatchGroup(lower, left) < GetSuggestionMatchGroup(lower, right);
+    });
+}
+
 template<class IterType>
 void SortTagSuggestions(IterType begin, IterType end, const std::string& str)
 {
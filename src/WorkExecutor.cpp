@@ -0,0 +1,334 @@
+// ------------------------------------ //
+#include "WorkExecutor.h"
+
+#include "Exceptions.h"
+
+#include <algorithm>
+
+using namespace DV;
+// ------------------------------------ //
+namespace
+{
+//! Set on the worker threads so that tasks queued from them go to their own queue
+thread_local const WorkExecutor* CurrentExecutor = nullptr;
+thread_local WorkExecutor::TaskList* CurrentWorkerQueue = nullptr;
+
+int64_t ToMicroseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+void UpdateMax(std::atomic<int64_t>& max, int64_t value)
+{
+    auto current = max.load();
+
+    while (value > current && !max.compare_exchange_weak(current, value))
+    {
+    }
+}
+} // namespace
+
+// ------------------------------------ //
+WorkExecutor::WorkExecutor() {}
+
+WorkExecutor::~WorkExecutor()
+{
+    Stop();
+}
+
+// ------------------------------------ //
+void WorkExecutor::StartWorkers(int threads)
+{
+    if (!Workers.empty())
+        throw Leviathan::InvalidState("WorkExecutor workers are already running");
+
+    if (threads < 1)
+        threads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+    Quit = false;
+
+    // All the queues need to exist before any worker can try stealing from them
+    for (int i = 0; i < threads; ++i)
+        WorkerQueues.push_back(std::make_unique<TaskList>());
+
+    for (int i = 0; i < threads; ++i)
+        Workers.emplace_back(&WorkExecutor::_RunWorker, this, static_cast<size_t>(i));
+}
+
+void WorkExecutor::StartDatabaseThread()
+{
+    if (DatabaseThread.joinable())
+        throw Leviathan::InvalidState("WorkExecutor database thread is already running");
+
+    Quit = false;
+
+    DatabaseThread = std::thread(&WorkExecutor::_RunDatabaseThread, this);
+}
+
+void WorkExecutor::Stop()
+{
+    Quit = true;
+
+    {
+        std::lock_guard<std::mutex> lock(WorkerSleepMutex);
+        WorkerNotify.notify_all();
+    }
+
+    {
+        GUARD_LOCK_OTHER(DatabaseQueue);
+        DatabaseNotify.notify_all();
+    }
+
+    for (auto& thread : Workers)
+        thread.join();
+
+    Workers.clear();
+
+    if (DatabaseThread.joinable())
+        DatabaseThread.join();
+
+    // Tasks queued from the workers are moved to the shared queue so that they aren't lost
+    GUARD_LOCK_OTHER(SharedWorkerQueue);
+
+    for (const auto& queue : WorkerQueues)
+    {
+        GUARD_LOCK_OTHER_NAME(*queue, queueGuard);
+
+        while (const auto task = queue->Pop(queueGuard))
+            SharedWorkerQueue.Push(guard, task);
+    }
+
+    WorkerQueues.clear();
+}
+
+// ------------------------------------ //
+std::shared_ptr<BaseTaskItem> WorkExecutor::Queue(
+    EXECUTOR_LANE lane, std::function<void()> func, PriorityValueT priority)
+{
+    auto task = std::make_unique<ExecutorTask>();
+    task->Function = std::move(func);
+    task->QueuedAt = std::chrono::steady_clock::now();
+
+    std::shared_ptr<BaseTaskItem> result;
+
+    switch (lane)
+    {
+        case EXECUTOR_LANE::Worker:
+        {
+            auto& list = CurrentExecutor == this && CurrentWorkerQueue ? *CurrentWorkerQueue : SharedWorkerQueue;
+
+            {
+                GUARD_LOCK_OTHER(list);
+                result = list.Push(guard, std::move(task), priority);
+            }
+
+            // The count is increased after the push so a woken up worker always finds the task
+            ++_GetCounters(lane).Queued;
+
+            std::lock_guard<std::mutex> lock(WorkerSleepMutex);
+            WorkerNotify.notify_one();
+            break;
+        }
+        case EXECUTOR_LANE::Database:
+        {
+            GUARD_LOCK_OTHER(DatabaseQueue);
+            result = DatabaseQueue.Push(guard, std::move(task), priority);
+            ++_GetCounters(lane).Queued;
+
+            DatabaseNotify.notify_all();
+            break;
+        }
+        case EXECUTOR_LANE::Main:
+        {
+            GUARD_LOCK_OTHER(MainQueue);
+            result = MainQueue.Push(guard, std::move(task), priority);
+            ++_GetCounters(lane).Queued;
+            break;
+        }
+        case EXECUTOR_LANE::Count: throw Leviathan::InvalidArgument("invalid executor lane");
+    }
+
+    return result;
+}
+
+int WorkExecutor::RunMainLane(int maxTasks)
+{
+    int ran = 0;
+
+    while (ran < maxTasks)
+    {
+        const auto task = _PopTask(MainQueue, EXECUTOR_LANE::Main);
+
+        if (!task)
+            break;
+
+        _RunTask(EXECUTOR_LANE::Main, *task);
+        ++ran;
+    }
+
+    return ran;
+}
+
+bool WorkExecutor::IsOnWorkerThread() const
+{
+    return CurrentExecutor == this;
+}
+
+// ------------------------------------ //
+std::vector<ExecutorLaneStats> WorkExecutor::GetStats() const
+{
+    std::vector<ExecutorLaneStats> result;
+
+    for (size_t i = 0; i < Counters.size(); ++i)
+    {
+        const auto& counters = Counters[i];
+
+        ExecutorLaneStats stats;
+        stats.Lane = static_cast<EXECUTOR_LANE>(i);
+        stats.QueueDepth = std::max<int64_t>(counters.Queued, 0);
+        stats.Running = counters.Running;
+        stats.Completed = counters.Completed;
+        stats.Steals = counters.Steals;
+
+        if (stats.Completed > 0)
+        {
+            stats.AverageWaitMS = counters.TotalWaitMicroseconds / 1000.0 / stats.Completed;
+            stats.AverageRunMS = counters.TotalRunMicroseconds / 1000.0 / stats.Completed;
+        }
+
+        stats.MaxWaitMS = counters.MaxWaitMicroseconds / 1000.0;
+
+        result.push_back(stats);
+    }
+
+    return result;
+}
+
+void WorkExecutor::ResetStats()
+{
+    for (auto& counters : Counters)
+    {
+        counters.Completed = 0;
+        counters.Steals = 0;
+        counters.TotalWaitMicroseconds = 0;
+        counters.MaxWaitMicroseconds = 0;
+        counters.TotalRunMicroseconds = 0;
+    }
+}
+
+const char* WorkExecutor::GetLaneName(EXECUTOR_LANE lane)
+{
+    switch (lane)
+    {
+        case EXECUTOR_LANE::Worker: return "Worker";
+        case EXECUTOR_LANE::Database: return "Database";
+        case EXECUTOR_LANE::Main: return "Main";
+        case EXECUTOR_LANE::Count: break;
+    }
+
+    return "Unknown";
+}
+
+// ------------------------------------ //
+std::shared_ptr<WorkExecutor::TaskList::TaskItem> WorkExecutor::_PopTask(TaskList& list, EXECUTOR_LANE lane)
+{
+    GUARD_LOCK_OTHER(list);
+
+    auto task = list.Pop(guard);
+
+    if (task)
+        --_GetCounters(lane).Queued;
+
+    return task;
+}
+
+std::shared_ptr<WorkExecutor::TaskList::TaskItem> WorkExecutor::_TakeWorkerTask(size_t workerIndex)
+{
+    if (auto task = _PopTask(*WorkerQueues[workerIndex], EXECUTOR_LANE::Worker))
+        return task;
+
+    if (auto task = _PopTask(SharedWorkerQueue, EXECUTOR_LANE::Worker))
+        return task;
+
+    // Start from the next worker so that all of the workers don't steal from the same one
+    for (size_t i = 1; i < WorkerQueues.size(); ++i)
+    {
+        const auto victim = (workerIndex + i) % WorkerQueues.size();
+
+        if (auto task = _PopTask(*WorkerQueues[victim], EXECUTOR_LANE::Worker))
+        {
+            ++_GetCounters(EXECUTOR_LANE::Worker).Steals;
+            return task;
+        }
+    }
+
+    return nullptr;
+}
+
+void WorkExecutor::_RunTask(EXECUTOR_LANE lane, TaskList::TaskItem& task)
+{
+    auto& counters = _GetCounters(lane);
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto wait = ToMicroseconds(start - task.Task->QueuedAt);
+
+    ++counters.Running;
+
+    task.Task->Function();
+    task.OnDone();
+
+    --counters.Running;
+
+    counters.TotalRunMicroseconds += ToMicroseconds(std::chrono::steady_clock::now() - start);
+    counters.TotalWaitMicroseconds += wait;
+    UpdateMax(counters.MaxWaitMicroseconds, wait);
+
+    ++counters.Completed;
+}
+
+void WorkExecutor::_RunWorker(size_t workerIndex)
+{
+    CurrentExecutor = this;
+    CurrentWorkerQueue = WorkerQueues[workerIndex].get();
+
+    auto& queued = _GetCounters(EXECUTOR_LANE::Worker).Queued;
+
+    while (!Quit)
+    {
+        if (const auto task = _TakeWorkerTask(workerIndex))
+        {
+            _RunTask(EXECUTOR_LANE::Worker, *task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(WorkerSleepMutex);
+        WorkerNotify.wait(lock, [&]() { return Quit || queued > 0; });
+    }
+
+    CurrentExecutor = nullptr;
+    CurrentWorkerQueue = nullptr;
+}
+
+void WorkExecutor::_RunDatabaseThread()
+{
+    GUARD_LOCK_OTHER(DatabaseQueue);
+
+    while (!Quit)
+    {
+        const auto task = DatabaseQueue.Pop(guard);
+
+        if (!task)
+        {
+            DatabaseNotify.wait(guard);
+            continue;
+        }
+
+        --_GetCounters(EXECUTOR_LANE::Database).Queued;
+
+        guard.unlock();
+
+        _RunTask(EXECUTOR_LANE::Database, *task);
+
+        guard.lock();
+    }
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "TaskListWithPriority.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DV
+{
+//! Priority for tasks that something is waiting on right now. The default priority is the time
+//! of queueing so these run before all the other queued tasks
+constexpr PriorityValueT EXECUTOR_PRIORITY_IMMEDIATE = std::numeric_limits<PriorityValueT>::max();
+
+//! \brief The separate queues of WorkExecutor
+enum class EXECUTOR_LANE : int
+{
+    //! General background work, ran by all of the worker threads
+    Worker = 0,
+
+    //! Database writes, ran one at a time by a single thread
+    Database,
+
+    //! Functions that need to run on the main thread, ran by WorkExecutor::RunMainLane
+    Main,
+
+    Count
+};
+
+//! \brief Statistics of a single lane at the time they were retrieved
+struct ExecutorLaneStats
+{
+    EXECUTOR_LANE Lane;
+
+    //! Tasks waiting to be ran
+    int64_t QueueDepth = 0;
+
+    //! Tasks being ran right now
+    int64_t Running = 0;
+
+    uint64_t Completed = 0;
+
+    //! Time between queueing tasks and them starting to run
+    double AverageWaitMS = 0;
+    double MaxWaitMS = 0;
+
+    double AverageRunMS = 0;
+
+    //! Tasks that an idle worker took from another worker's queue
+    uint64_t Steals = 0;
+};
+
+//! \brief A queued function in WorkExecutor
+struct ExecutorTask
+{
+    std::function<void()> Function;
+
+    std::chrono::steady_clock::time_point QueuedAt;
+};
+
+//! \brief Runs queued functions on a pool of worker threads, the database thread and the main
+//! thread
+//!
+//! Tasks queued from a worker thread go to that worker's own queue, other tasks go to a shared
+//! queue. Workers run tasks from their own queue first, then from the shared queue and when both
+//! are empty they steal tasks from the other workers' queues. Each queue is ordered by the task
+//! priorities.
+//! \note Tasks can be queued before the threads are started, they are ran once the threads start
+class WorkExecutor
+{
+public:
+    using TaskList = TaskListWithPriority<std::unique_ptr<ExecutorTask>>;
+
+    WorkExecutor();
+    ~WorkExecutor();
+
+    WorkExecutor(const WorkExecutor& other) = delete;
+    WorkExecutor& operator=(const WorkExecutor& other) = delete;
+
+    //! \brief Starts the worker threads
+    //! \param threads The number of threads, 0 uses the number of cores
+    //! \exception Leviathan::InvalidState if the workers are already running
+    void StartWorkers(int threads);
+
+    //! \brief Starts the thread running the Database lane
+    //! \exception Leviathan::InvalidState if the thread is already running
+    void StartDatabaseThread();
+
+    //! \brief Stops all the threads after they finish their current tasks
+    //!
+    //! Tasks that haven't been started are kept so the threads can be started again
+    void Stop();
+
+    //! \brief Queues a function to run on a lane
+    //! \returns The queued task, this can be used to change the priority
+    std::shared_ptr<BaseTaskItem> Queue(EXECUTOR_LANE lane, std::function<void()> func,
+        PriorityValueT priority = TimeHelpers::GetCurrentUnixTimestamp());
+
+    //! \brief Runs tasks from the Main lane on the calling thread
+    //! \param maxTasks The maximum number of tasks to run so that the main thread isn't blocked
+    //! for too long
+    //! \returns The number of ran tasks
+    int RunMainLane(int maxTasks);
+
+    //! \returns True if called on one of the worker threads of this executor
+    bool IsOnWorkerThread() const;
+
+    int GetWorkerCount() const
+    {
+        return static_cast<int>(Workers.size());
+    }
+
+    std::vector<ExecutorLaneStats> GetStats() const;
+
+    //! \brief Resets the completed task counts and the timing values
+    void ResetStats();
+
+    static const char* GetLaneName(EXECUTOR_LANE lane);
+
+private:
+    //! \brief Counters for ExecutorLaneStats. These are updated without locking
+    struct LaneCounters
+    {
+        std::atomic<int64_t> Queued{0};
+        std::atomic<int64_t> Running{0};
+        std::atomic<uint64_t> Completed{0};
+        std::atomic<uint64_t> Steals{0};
+
+        std::atomic<int64_t> TotalWaitMicroseconds{0};
+        std::atomic<int64_t> MaxWaitMicroseconds{0};
+        std::atomic<int64_t> TotalRunMicroseconds{0};
+    };
+
+    LaneCounters& _GetCounters(EXECUTOR_LANE lane)
+    {
+        return Counters[static_cast<size_t>(lane)];
+    }
+
+    //! \brief Pops a task and updates the queued count
+    std::shared_ptr<TaskList::TaskItem> _PopTask(TaskList& list, EXECUTOR_LANE lane);
+
+    //! \brief Finds the next task for a worker, stealing from other workers if needed
+    std::shared_ptr<TaskList::TaskItem> _TakeWorkerTask(size_t workerIndex);
+
+    void _RunTask(EXECUTOR_LANE lane, TaskList::TaskItem& task);
+
+    void _RunWorker(size_t workerIndex);
+    void _RunDatabaseThread();
+
+private:
+    std::atomic<bool> Quit{false};
+
+    std::array<LaneCounters, static_cast<size_t>(EXECUTOR_LANE::Count)> Counters;
+
+    //! Worker lane tasks that weren't queued from a worker thread
+    TaskList SharedWorkerQueue;
+
+    //! Each worker thread has its own queue at the same index as the thread
+    std::vector<std::unique_ptr<TaskList>> WorkerQueues;
+    std::vector<std::thread> Workers;
+
+    //! Idle workers wait on this. The mutex is locked when notifying so that wake ups aren't lost
+    std::mutex WorkerSleepMutex;
+    std::condition_variable WorkerNotify;
+
+    TaskList DatabaseQueue;
+    std::condition_variable DatabaseNotify;
+    std::thread DatabaseThread;
+
+    TaskList MainQueue;
+};
+
+} // namespace DV
@@ -12,13 +12,19 @@
 
 using namespace DV;
 
+//! Time to wait after the text changes before retrieving suggestions
+constexpr auto COMPLETION_UPDATE_DELAY_MS = 150;
+
 // ------------------------------------ //
 EasyEntryCompletion::EasyEntryCompletion(size_t suggestionstoshow /*= 50*/, size_t mincharsbeforecomplete /*= 3*/) :
     SuggestionsToShow(suggestionstoshow), CompleteAfterCharacters(mincharsbeforecomplete)
 {
 }
 
-EasyEntryCompletion::~EasyEntryCompletion() = default;
+EasyEntryCompletion::~EasyEntryCompletion()
+{
+    UpdateTimer.disconnect();
+}
 
 // ------------------------------------ //
 void EasyEntryCompletion::Init(Gtk::Entry* entry, std::function<bool(const Glib::ustring& str)> onselected,
@@ -82,29 +88,48 @@ bool EasyEntryCompletion::_OnMatchSelected(const Gtk::TreeModel::iterator& iter)
 // ------------------------------------ //
 void EasyEntryCompletion::_OnTextUpdated()
 {
+    UpdateTimer.disconnect();
+
+    // Results of already queued requests are no longer wanted
+    ++(*LatestRequest);
+
     // No completion if less than 3 characters
     if (EntryWithSuggestions->get_text_length() < CompleteAfterCharacters)
         return;
 
+    UpdateTimer = Glib::signal_timeout().connect(
+        sigc::mem_fun(*this, &EasyEntryCompletion::_OnUpdateTimer), COMPLETION_UPDATE_DELAY_MS);
+}
+
+bool EasyEntryCompletion::_OnUpdateTimer()
+{
     auto isalive = GetAliveMarker();
     auto text = EntryWithSuggestions->get_text();
 
+    const auto request = ++(*LatestRequest);
+
     DualView::Get().QueueDBThreadFunction(
-        [this, isalive, text, suggest{GetSuggestions}, count{SuggestionsToShow}]()
+        [this, isalive, text, request, latest{LatestRequest}, suggest{GetSuggestions}, count{SuggestionsToShow}]()
         {
+            // The text has changed again while this was queued
+            if (*latest != request)
+                return;
+
             // Spams way too much
             // LOG_INFO("Getting suggestions for text: " + text);
             const std::string str = DV::StringToLower(text);
 
+            // The suggestions are already ranked, sorting them here would lose the use count order
             auto result = suggest(str, count);
 
-            DV::SortSuggestions(result.begin(), result.end(), str);
-
             DualView::Get().InvokeFunction(
-                [this, isalive, data{std::move(result)}]()
+                [this, isalive, request, latest, data{std::move(result)}]()
                 {
                     INVOKE_CHECK_ALIVE_MARKER(isalive);
 
+                    if (*latest != request)
+                        return;
+
                     CompletionRows->clear();
 
                     // Fill the autocomplete
@@ -115,6 +140,9 @@ void EasyEntryCompletion::_OnTextUpdated()
                     }
                 });
         });
+
+    // Only ran once per text change
+    return false;
 }
 
 // ------------------------------------ //
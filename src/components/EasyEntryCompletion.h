@@ -2,6 +2,8 @@
 
 #include "IsAlive.h"
 
+#include <atomic>
+#include <memory>
 #include <string>
 
 #include <gtkmm.h>
@@ -37,9 +39,14 @@ protected:
     //! \brief Called when an autocomplete entry is selected. Calls the OnSelected callback
     bool _OnMatchSelected(const Gtk::TreeModel::iterator& iter);
 
-    //! \brief Updates the suggestions
+    //! \brief Starts the timer for updating the suggestions
+    //!
+    //! Typing quickly only updates the suggestions once the user pauses
     void _OnTextUpdated();
 
+    //! \brief Retrieves new suggestions for the current text
+    bool _OnUpdateTimer();
+
     //! \brief For completing any part
     bool DoesCompletionMatch(
         const Glib::ustring& key, const Gtk::TreeModel::const_iterator& iter);
@@ -55,6 +62,12 @@ protected:
 
     Gtk::Entry* EntryWithSuggestions = nullptr;
 
+    sigc::connection UpdateTimer;
+
+    //! Incremented for each suggestion request. Requests that have been replaced by a newer one
+    //! are skipped. Shared with the queued requests as this object may be destroyed before they run
+    std::shared_ptr<std::atomic<uint64_t>> LatestRequest = std::make_shared<std::atomic<uint64_t>>(0);
+
     // Suggestion data
     Glib::RefPtr<Gtk::EntryCompletion> Completion;
     CompletionColumns CompletionColumnTypes;
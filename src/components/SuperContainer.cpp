@@ -4,6 +4,8 @@
 #include "Common.h"
 #include "DualView.h"
 
+#include <algorithm>
+
 using namespace DV;
 // ------------------------------------ //
 
@@ -38,6 +40,11 @@ void SuperContainer::_CommonCtor()
     signal_button_press_event().connect(
         sigc::mem_fun(*this, &SuperContainer::_OnMouseButtonPressed));
 
+    get_vadjustment()->signal_value_changed().connect(
+        sigc::mem_fun(*this, &SuperContainer::_OnScrollChanged));
+    get_vadjustment()->signal_changed().connect(
+        sigc::mem_fun(*this, &SuperContainer::_OnScrollChanged));
+
     // Both scrollbars need to be able to appear, otherwise the width cannot be reduced
     // so that wrapping occurs
     set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
@@ -58,9 +65,41 @@ void SuperContainer::Clear(bool deselect /*= false*/)
 
     // This will delete all the widgets //
     Positions.clear();
+    BoundElements.clear();
+    WidgetPool.clear();
+
+    if(Virtualized)
+        Container.set_size_request(-1, -1);
+
     _PositionIndicator();
     LayoutDirty = false;
 }
+
+void SuperContainer::SetVirtualized(bool virtualized)
+{
+    if(Virtualized == virtualized)
+        return;
+
+    if(!IsEmpty())
+        throw Leviathan::InvalidState(
+            "SuperContainer must be empty when changing virtualization");
+
+    Clear();
+    Virtualized = virtualized;
+}
+
+size_t SuperContainer::CountCreatedWidgets() const
+{
+    size_t count = WidgetPool.size();
+
+    for(const auto& position : Positions) {
+
+        if(position.WidgetToPosition && position.WidgetToPosition->Widget)
+            ++count;
+    }
+
+    return count;
+}
 // ------------------------------------ //
 void SuperContainer::UpdatePositioning()
 {
@@ -69,14 +108,20 @@ void SuperContainer::UpdatePositioning()
 
     LayoutDirty = false;
     WidestRow = Margin;
+    TallestItem = 0;
 
     if(Positions.empty()) {
+
+        if(Virtualized)
+            Container.set_size_request(-1, -1);
+
         _PositionIndicator();
         return;
     }
 
     int32_t CurrentRow = Margin;
     int32_t CurrentY = Positions.front().Y;
+    int32_t bottom = 0;
 
     for(auto& position : Positions) {
 
@@ -92,6 +137,12 @@ void SuperContainer::UpdatePositioning()
 
         CurrentRow += position.Width + Padding;
 
+        if(position.WidgetToPosition) {
+
+            TallestItem = std::max(TallestItem, position.Height);
+            bottom = std::max(bottom, position.Y + position.Height);
+        }
+
         _ApplyWidgetPosition(position);
     }
 
@@ -102,6 +153,13 @@ void SuperContainer::UpdatePositioning()
     // Add margin
     WidestRow += Margin;
 
+    if(Virtualized) {
+
+        // Most items don't have widgets so the container can't calculate its own height
+        Container.set_size_request(-1, bottom + Margin);
+        _UpdateVirtualWidgets();
+    }
+
     _PositionIndicator();
 }
 
@@ -183,7 +241,7 @@ size_t SuperContainer::CountSelectedItems() const
         if(!position.WidgetToPosition)
             break;
 
-        if(position.WidgetToPosition->Widget->IsSelected())
+        if(position.WidgetToPosition->IsSelected())
             ++count;
     }
 
@@ -198,7 +256,7 @@ void SuperContainer::DeselectAllItems()
         if(!position.WidgetToPosition)
             break;
 
-        position.WidgetToPosition->Widget->Deselect();
+        position.WidgetToPosition->Deselect();
     }
 }
 
@@ -210,7 +268,7 @@ void SuperContainer::SelectAllItems()
         if(!position.WidgetToPosition)
             break;
 
-        position.WidgetToPosition->Widget->Select();
+        position.WidgetToPosition->Select();
     }
 }
 
@@ -222,10 +280,12 @@ void SuperContainer::DeselectAllExcept(const ListItem* item)
         if(!position.WidgetToPosition)
             break;
 
-        if(position.WidgetToPosition->Widget.get() == item)
+        const auto& widget = position.WidgetToPosition->Widget;
+
+        if(widget && widget.get() == item)
             continue;
 
-        position.WidgetToPosition->Widget->Deselect();
+        position.WidgetToPosition->Deselect();
     }
 }
 
@@ -237,9 +297,9 @@ void SuperContainer::DeselectFirstItem()
         if(!position.WidgetToPosition)
             break;
 
-        if(position.WidgetToPosition->Widget->IsSelected()) {
+        if(position.WidgetToPosition->IsSelected()) {
 
-            position.WidgetToPosition->Widget->Deselect();
+            position.WidgetToPosition->Deselect();
             return;
         }
     }
@@ -259,7 +319,7 @@ void SuperContainer::SelectFirstItems(int count)
         if(!position.WidgetToPosition)
             break;
 
-        position.WidgetToPosition->Widget->Select();
+        position.WidgetToPosition->Select();
         ++selected;
     }
 }
@@ -278,12 +338,19 @@ void SuperContainer::SelectNextItem()
 
         if(select == true) {
 
-            position.WidgetToPosition->Widget->Select();
-            DeselectAllExcept(position.WidgetToPosition->Widget.get());
+            position.WidgetToPosition->Select();
+
+            for(auto& other : Positions) {
+
+                if(other.WidgetToPosition &&
+                    other.WidgetToPosition != position.WidgetToPosition)
+                    other.WidgetToPosition->Deselect();
+            }
+
             break;
         }
 
-        if(position.WidgetToPosition->Widget->IsSelected()) {
+        if(position.WidgetToPosition->IsSelected()) {
 
             select = true;
         }
@@ -310,12 +377,19 @@ void SuperContainer::SelectPreviousItem()
 
         if(select == true) {
 
-            position.WidgetToPosition->Widget->Select();
-            DeselectAllExcept(position.WidgetToPosition->Widget.get());
+            position.WidgetToPosition->Select();
+
+            for(auto& other : Positions) {
+
+                if(other.WidgetToPosition &&
+                    other.WidgetToPosition != position.WidgetToPosition)
+                    other.WidgetToPosition->Deselect();
+            }
+
             break;
         }
 
-        if(position.WidgetToPosition->Widget->IsSelected()) {
+        if(position.WidgetToPosition->IsSelected()) {
 
             select = true;
         }
@@ -344,7 +418,7 @@ void SuperContainer::ShiftSelectTo(const ListItem* item)
 
         if(position.WidgetToPosition->Widget.get() == item) {
             itemsPosition = i;
-        } else if(selectStart == 0 && position.WidgetToPosition->Widget->IsSelected()) {
+        } else if(selectStart == 0 && position.WidgetToPosition->IsSelected()) {
             selectStart = i;
         }
     }
@@ -362,7 +436,7 @@ void SuperContainer::ShiftSelectTo(const ListItem* item)
         if(!position.WidgetToPosition)
             continue;
 
-        position.WidgetToPosition->Widget->Select();
+        position.WidgetToPosition->Select();
     }
 
     // TODO: post-select callback
@@ -544,6 +618,44 @@ SuperContainer::GridPosition& SuperContainer::_AddNewGridPosition(
 // ------------------------------------ //
 void SuperContainer::_SetWidgetSize(Element& widget)
 {
+    if(Virtualized) {
+
+        const std::type_index type = typeid(*widget.CreatedFrom);
+        const auto found = VirtualItemSizes.find(type);
+
+        if(found != VirtualItemSizes.end()) {
+
+            std::tie(widget.Width, widget.Height) = found->second;
+
+            if(widget.Widget)
+                widget.Widget->set_size_request(widget.Width, widget.Height);
+
+            return;
+        }
+
+        // Measure a widget of this type. It is then kept for reuse
+        Element measured(widget.CreatedFrom, widget.Selectable);
+        measured.Widget->SetItemSize(SelectedItemSize);
+        Container.add(*measured.Widget);
+
+        int width_min, width_natural;
+        int height_min, height_natural;
+
+        measured.Widget->get_preferred_width(width_min, width_natural);
+        measured.Widget->get_preferred_height_for_width(
+            width_natural, height_min, height_natural);
+
+        measured.Widget->set_size_request(width_natural, height_natural);
+        measured.Widget->hide();
+
+        WidgetPool.push_back(PooledWidget{measured.Widget, widget.Selectable});
+
+        VirtualItemSizes[type] = std::make_tuple(width_natural, height_natural);
+        widget.Width = width_natural;
+        widget.Height = height_natural;
+        return;
+    }
+
     int width_min, width_natural;
     int height_min, height_natural;
 
@@ -571,6 +683,34 @@ void SuperContainer::SetItemSize(LIST_ITEM_SIZE newsize)
     if(Positions.empty())
         return;
 
+    if(Virtualized) {
+
+        // Widgets are recreated with the new size as they become visible //
+        for(auto& position : Positions) {
+
+            if(position.WidgetToPosition && position.WidgetToPosition->Widget)
+                _UnbindVirtualWidget(*position.WidgetToPosition);
+        }
+
+        BoundElements.clear();
+        WidgetPool.clear();
+        VirtualItemSizes.clear();
+
+        for(auto& position : Positions) {
+
+            if(!position.WidgetToPosition)
+                continue;
+
+            _SetWidgetSize(*position.WidgetToPosition);
+            position.Width = position.WidgetToPosition->Width;
+            position.Height = position.WidgetToPosition->Height;
+        }
+
+        Reflow(0);
+        UpdatePositioning();
+        return;
+    }
+
     // Resize all elements //
     for(const auto& position : Positions) {
 
@@ -628,7 +768,7 @@ void SuperContainer::_RemoveElementsNotMarkedKeep()
             LayoutDirty = true;
 
             // Remove this widget //
-            Container.remove(*current.WidgetToPosition->Widget);
+            _ReleaseElementWidget(*current.WidgetToPosition);
             current.WidgetToPosition.reset();
 
             // On the next iteration the next widget will be moved to this position
@@ -655,7 +795,7 @@ void SuperContainer::_RemoveWidget(size_t index)
 
     size_t reflowStart = Positions.size();
 
-    Container.remove(*Positions[index].WidgetToPosition->Widget);
+    _ReleaseElementWidget(*Positions[index].WidgetToPosition);
     Positions[index].WidgetToPosition.reset();
 
     // Move forward all the widgets //
@@ -690,14 +830,15 @@ void SuperContainer::_SetWidget(
         } else {
 
             // Remove the current one
-            Container.remove(*Positions[index].WidgetToPosition->Widget);
+            _ReleaseElementWidget(*Positions[index].WidgetToPosition);
         }
     }
 
     // Initialize a size for the widget
     _SetWidgetSize(*widget);
 
-    _SetWidgetAdvancedSelection(*widget->Widget, selectable);
+    if(widget->Widget)
+        _SetWidgetAdvancedSelection(*widget->Widget, selectable);
 
     // Set it //
     if(Positions[index].SetNewWidget(widget)) {
@@ -705,6 +846,11 @@ void SuperContainer::_SetWidget(
         // Do a reflow //
         Reflow(index);
 
+    } else if(Virtualized) {
+
+        // The widget is created when UpdatePositioning finds that this is visible
+        LayoutDirty = true;
+
     } else {
 
         // Apply positioning now //
@@ -758,12 +904,13 @@ void SuperContainer::_AddWidgetToEnd(std::shared_ptr<ResourceWithPreview> item,
     const std::shared_ptr<ItemSelectable>& selectable)
 {
     // Create the widget //
-    auto element = std::make_shared<Element>(item, selectable);
+    auto element = _CreateElement(item, selectable);
 
     // Initialize a size for the widget
     _SetWidgetSize(*element);
 
-    _SetWidgetAdvancedSelection(*element->Widget, selectable.operator bool());
+    if(element->Widget)
+        _SetWidgetAdvancedSelection(*element->Widget, selectable.operator bool());
 
     // Find the first empty spot //
     for(size_t i = 0; i < Positions.size(); ++i) {
@@ -785,13 +932,158 @@ void SuperContainer::_AddWidgetToEnd(std::shared_ptr<ResourceWithPreview> item,
 
     pos.WidgetToPosition = element;
 
-    if(!LayoutDirty) {
+    if(Virtualized) {
+
+        LayoutDirty = true;
+
+    } else if(!LayoutDirty) {
 
         _ApplyWidgetPosition(pos);
         UpdateRowWidths();
         _PositionIndicator();
     }
 }
+std::shared_ptr<SuperContainer::Element> SuperContainer::_CreateElement(
+    std::shared_ptr<ResourceWithPreview> item,
+    const std::shared_ptr<ItemSelectable>& selectable)
+{
+    return std::make_shared<Element>(item, selectable, !Virtualized);
+}
+
+void SuperContainer::_ReleaseElementWidget(Element& element)
+{
+    if(!element.Widget)
+        return;
+
+    if(Virtualized) {
+
+        _UnbindVirtualWidget(element);
+
+    } else {
+
+        Container.remove(*element.Widget);
+    }
+}
+
+void SuperContainer::_ReplaceVirtualElement(size_t index,
+    std::shared_ptr<ResourceWithPreview> item,
+    const std::shared_ptr<ItemSelectable>& selectable)
+{
+    auto element = Positions[index].WidgetToPosition;
+
+    element->CreatedFrom = item;
+    element->Selectable = selectable;
+    element->Selected = false;
+    element->Active = true;
+    element->Keep = true;
+
+    // The new resource can be of a different type
+    _SetWidgetSize(*element);
+
+    if(Positions[index].SetNewWidget(element))
+        Reflow(index);
+
+    LayoutDirty = true;
+}
+// ------------------------------------ //
+void SuperContainer::_UpdateVirtualWidgets()
+{
+    if(!Virtualized)
+        return;
+
+    ++VisibleGeneration;
+
+    const auto adjustment = get_vadjustment();
+    const auto top = adjustment->get_value() - SUPERCONTAINER_VIRTUAL_PREFETCH;
+    const auto bottom = adjustment->get_value() + adjustment->get_page_size() +
+                        SUPERCONTAINER_VIRTUAL_PREFETCH;
+
+    // Positions are in row order so the first row that can be visible can be found with a
+    // binary search
+    const auto first = std::partition_point(Positions.begin(), Positions.end(),
+        [&](const GridPosition& position) { return position.Y + TallestItem < top; });
+
+    auto last = first;
+
+    for(; last != Positions.end() && last->WidgetToPosition && last->Y <= bottom; ++last)
+        last->WidgetToPosition->VisibleGeneration = VisibleGeneration;
+
+    // Release widgets that are no longer visible first so that they can be reused //
+    for(const auto& element : BoundElements) {
+
+        if(element->Widget && element->VisibleGeneration != VisibleGeneration)
+            _UnbindVirtualWidget(*element);
+    }
+
+    BoundElements.clear();
+
+    for(auto iter = first; iter != last; ++iter) {
+
+        if(!iter->WidgetToPosition->Widget)
+            _BindVirtualWidget(*iter->WidgetToPosition);
+
+        _ApplyWidgetPosition(*iter);
+        BoundElements.push_back(iter->WidgetToPosition);
+    }
+}
+
+void SuperContainer::_BindVirtualWidget(Element& element)
+{
+    std::shared_ptr<ListItem> widget;
+
+    for(auto iter = WidgetPool.begin(); iter != WidgetPool.end(); ++iter) {
+
+        if(iter->Selectable != element.Selectable)
+            continue;
+
+        if(!element.CreatedFrom->UpdateWidgetWithValues(*iter->Widget))
+            continue;
+
+        widget = iter->Widget;
+        WidgetPool.erase(iter);
+        break;
+    }
+
+    if(!widget) {
+
+        widget = element.CreatedFrom->CreateListItem(element.Selectable);
+
+        if(!widget)
+            throw std::runtime_error("Created Widget is null in SuperContainer");
+
+        widget->SetItemSize(SelectedItemSize);
+        Container.add(*widget);
+    }
+
+    widget->set_size_request(element.Width, element.Height);
+    _SetWidgetAdvancedSelection(*widget, element.Selectable.operator bool());
+
+    element.Widget = widget;
+
+    widget->SetActive(element.Active);
+
+    if(element.Selected)
+        widget->Select();
+
+    widget->show();
+}
+
+void SuperContainer::_UnbindVirtualWidget(Element& element)
+{
+    auto widget = element.Widget;
+    element.Widget.reset();
+
+    element.Selected = widget->IsSelected();
+    element.Active = widget->IsActive();
+
+    widget->hide();
+
+    // Reset the state for the next item that uses this widget
+    widget->Deselect();
+    widget->Activate();
+
+    WidgetPool.push_back(PooledWidget{widget, element.Selectable});
+}
 // ------------------------------------ //
 void SuperContainer::_SetWidgetAdvancedSelection(ListItem& widget, bool selectable)
 {
@@ -825,8 +1117,9 @@ void SuperContainer::_CheckPositions() const
                 LEVIATHAN_ASSERT(false, "SuperContainer::_CheckPositions: duplicate position");
             }
 
-            if(Positions[i].WidgetToPosition->Widget.get() ==
-                Positions[a].WidgetToPosition->Widget.get()) {
+            if(Positions[i].WidgetToPosition->Widget &&
+                Positions[i].WidgetToPosition->Widget.get() ==
+                    Positions[a].WidgetToPosition->Widget.get()) {
 
                 LEVIATHAN_ASSERT(
                     false, "SuperContainer::_CheckPositions: duplicate ListItem ptr");
@@ -1049,6 +1342,14 @@ void SuperContainer::_OnResize(Gtk::Allocation& allocation)
     }
 }
 
+void SuperContainer::_OnScrollChanged()
+{
+    if(!Virtualized || LayoutDirty)
+        return;
+
+    _UpdateVirtualWidgets();
+}
+
 bool SuperContainer::_OnMouseButtonPressed(GdkEventButton* event)
 {
     if(event->type == GDK_BUTTON_PRESS) {
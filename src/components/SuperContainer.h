@@ -7,13 +7,24 @@
 #include <gtkmm.h>
 
 #include <list>
+#include <tuple>
+#include <typeindex>
+#include <unordered_map>
 
 namespace DV {
 
 constexpr auto SUPERCONTAINER_MARGIN = 4;
 constexpr auto SUPERCONTAINER_PADDING = 2;
 
+//! In virtualized mode widgets are also created for items this many pixels above and below
+//! the visible area so that they are ready (and their thumbnails loaded) when scrolled to
+constexpr auto SUPERCONTAINER_VIRTUAL_PREFETCH = 512;
+
 //! \brief Holds ListItem derived widgets and arranges them in a scrollable box
+//!
+//! In virtualized mode (see SetVirtualized) the layout is calculated from the item sizes and
+//! widgets are only created for the items near the visible area. The widgets are recycled
+//! when scrolling.
 //! \todo Add tests for this class
 class SuperContainer : public Gtk::ScrolledWindow {
 protected:
@@ -21,26 +32,85 @@ protected:
     struct Element {
 
         //! \brief Automatically creates the widget from create
+        //! \param createWidget If false Widget is left empty, used in virtualized mode
         Element(std::shared_ptr<ResourceWithPreview> create,
-            const std::shared_ptr<ItemSelectable>& selectable) :
-            CreatedFrom(create)
+            const std::shared_ptr<ItemSelectable>& selectable, bool createWidget = true) :
+            CreatedFrom(create),
+            Selectable(selectable)
         {
+            if(!createWidget)
+                return;
+
             Widget = CreatedFrom->CreateListItem(selectable);
 
             if(!Widget)
                 throw std::runtime_error("Created Widget is null in Element");
         }
 
+        inline bool IsSelected() const
+        {
+            return Widget ? Widget->IsSelected() : Selected;
+        }
+
+        inline void Select()
+        {
+            if(Widget) {
+                Widget->Select();
+            } else if(Selectable && Selectable->Selectable && Active) {
+                Selected = true;
+            }
+        }
+
+        inline void Deselect()
+        {
+            if(Widget) {
+                Widget->Deselect();
+            } else {
+                Selected = false;
+            }
+        }
+
+        inline void SetActive(bool active)
+        {
+            if(Widget) {
+                Widget->SetActive(active);
+            } else {
+                Active = active;
+
+                if(!Active)
+                    Selected = false;
+            }
+        }
+
         std::shared_ptr<ResourceWithPreview> CreatedFrom;
 
+        std::shared_ptr<ItemSelectable> Selectable;
+
         //! The size Widget is set to be, This is used because Gtk is very lazy about
         //! calculating the sizes for widgets
         int32_t Width, Height;
 
+        //! Can be null in virtualized mode if this item isn't near the visible area
         std::shared_ptr<ListItem> Widget;
 
+        //! Selected and active states for when this has no Widget
+        bool Selected = false;
+        bool Active = true;
+
         //! Used to remove removed items when updating the list
         bool Keep = true;
+
+        //! Used in virtualized mode to find widgets that are no longer visible
+        size_t VisibleGeneration = 0;
+    };
+
+    //! \brief Unused widget that can be given to another item in virtualized mode
+    struct PooledWidget {
+
+        std::shared_ptr<ListItem> Widget;
+
+        //! The selectable the widget was created with, as it can't be changed afterwards
+        std::shared_ptr<ItemSelectable> Selectable;
     };
 
     //! \brief A calculated position to which and element can be added
@@ -122,8 +192,8 @@ public:
             // Empty positions can be just filled //
             if(!Positions[i].WidgetToPosition) {
 
-                _SetWidget(i, std::make_shared<Element>(*newIndex, selectable),
-                    selectable.operator bool());
+                _SetWidget(
+                    i, _CreateElement(*newIndex, selectable), selectable.operator bool());
                 continue;
             }
 
@@ -137,6 +207,13 @@ public:
 
             // Need to replace this one //
 
+            // Items without a widget just need to point to the new resource //
+            if(!Positions[i].WidgetToPosition->Widget) {
+
+                _ReplaceVirtualElement(i, *newIndex, selectable);
+                continue;
+            }
+
             // First try to update if the widget is the same type as the new one //
             if((**newIndex).UpdateWidgetWithValues(*Positions[i].WidgetToPosition->Widget)) {
 
@@ -149,8 +226,8 @@ public:
 
             // Insert a new widget here //
             _PushBackWidgets(i);
-            _SetWidget(i, std::make_shared<Element>(*newIndex, selectable),
-                selectable.operator bool());
+            _SetWidget(
+                i, _CreateElement(*newIndex, selectable), selectable.operator bool());
         }
 
 
@@ -206,6 +283,27 @@ public:
         UpdatePositioning();
     }
 
+    //! \brief Adds multiple items at the end with only one positioning update, doesn't sort
+    //! the items
+    template<class Iterator>
+    void AddItems(Iterator begin, Iterator end,
+        const std::shared_ptr<ItemSelectable>& selectable = nullptr)
+    {
+        if(begin == end)
+            return;
+
+        if(Positions.empty()) {
+            // Update initial width
+            LastWidthReflow = get_width();
+        }
+
+        for(; begin != end; ++begin)
+            _AddWidgetToEnd(*begin, selectable);
+
+        LayoutDirty = true;
+        UpdatePositioning();
+    }
+
     //! \brief Returns the currently selected items
     //!
     //! The items will be added to the inserter. Which can be an std::back_inserter or
@@ -219,7 +317,7 @@ public:
             if(!position.WidgetToPosition)
                 break;
 
-            if(position.WidgetToPosition->Widget->IsSelected())
+            if(position.WidgetToPosition->IsSelected())
                 inserter.push_back(position.WidgetToPosition->CreatedFrom);
         }
     }
@@ -266,16 +364,30 @@ public:
     //! \brief Returns True if contains no items
     bool IsEmpty() const;
 
+    //! \brief Calls func with all the item widgets
+    //! \note In virtualized mode only the items near the visible area have widgets
     template<class CallbackFuncT>
     void VisitAllWidgets(const CallbackFuncT& func)
     {
-        for(auto& position : Positions) {
+        VisitWidgetsFrom(0, func);
+    }
+
+    //! \brief Calls func with the item widgets starting from the item at index first
+    //!
+    //! Used to only visit the items added by the last AddItems call
+    template<class CallbackFuncT>
+    void VisitWidgetsFrom(size_t first, const CallbackFuncT& func)
+    {
+        for(size_t i = first; i < Positions.size(); ++i) {
+
+            auto& position = Positions[i];
 
             // Stop once empty position is reached //
             if(!position.WidgetToPosition)
                 break;
 
-            func(*position.WidgetToPosition->Widget);
+            if(position.WidgetToPosition->Widget)
+                func(*position.WidgetToPosition->Widget);
         }
     }
 
@@ -297,7 +409,7 @@ public:
                     std::find(begin, end, position.WidgetToPosition->CreatedFrom) != end;
             }
 
-            position.WidgetToPosition->Widget->SetActive(!setInactive);
+            position.WidgetToPosition->SetActive(!setInactive);
         }
     }
 
@@ -306,6 +418,23 @@ public:
     //! existing code and that's why that needs to be explicitly requested
     void Clear(bool deselect = false);
 
+    //! \brief Enables or disables the virtualized mode
+    //!
+    //! In virtualized mode only the items that are near the visible area have widgets, which
+    //! makes showing thousands of items fast. The items are sized by measuring a single widget
+    //! for each resource type. Selection callbacks are only called for items that have a
+    //! widget at the time.
+    //! \exception Leviathan::InvalidState if this isn't empty
+    void SetVirtualized(bool virtualized);
+
+    inline bool IsVirtualized() const
+    {
+        return Virtualized;
+    }
+
+    //! \returns The number of ListItem widgets that currently exist, including recycled ones
+    size_t CountCreatedWidgets() const;
+
     //! \brief Applies the positioning, will be called whenever Positions is changed
     void UpdatePositioning();
 
@@ -407,8 +536,32 @@ protected:
     GridPosition& _AddNewGridPosition(int32_t width, int32_t height);
 
     //! \brief Sets the size of a new widget
+    //!
+    //! In virtualized mode the size is measured once for each resource type
     void _SetWidgetSize(Element& widget);
 
+    //! \brief Creates an Element, without a widget in virtualized mode
+    std::shared_ptr<Element> _CreateElement(std::shared_ptr<ResourceWithPreview> item,
+        const std::shared_ptr<ItemSelectable>& selectable);
+
+    //! \brief Removes the widget of an element from the container, or in virtualized mode
+    //! moves it to WidgetPool
+    void _ReleaseElementWidget(Element& element);
+
+    //! \brief Points an element without a widget at index to a new resource
+    void _ReplaceVirtualElement(size_t index, std::shared_ptr<ResourceWithPreview> item,
+        const std::shared_ptr<ItemSelectable>& selectable);
+
+    //! \brief Creates or recycles widgets for the items near the visible area and releases the
+    //! widgets of other items
+    void _UpdateVirtualWidgets();
+
+    //! \brief Gives a widget to element, reusing one from WidgetPool if possible
+    void _BindVirtualWidget(Element& element);
+
+    //! \brief Moves the widget of element to WidgetPool
+    void _UnbindVirtualWidget(Element& element);
+
     //! \brief Sets keep to false on all the widgets
     void _SetKeepFalse();
 
@@ -451,6 +604,9 @@ protected:
     void _OnResize(Gtk::Allocation& allocation);
     bool _OnMouseButtonPressed(GdkEventButton* event);
 
+    //! \brief Updates the widgets in virtualized mode when scrolled or resized
+    void _OnScrollChanged();
+
 private:
     Gtk::Viewport View;
     Gtk::Fixed Container;
@@ -478,6 +634,25 @@ private:
     //! functions that only care about active elements can stop as soon as they encounter
     //! the first null
     std::vector<GridPosition> Positions;
+
+    // Virtualized mode variables //
+    bool Virtualized = false;
+
+    //! The elements that currently have a widget
+    std::vector<std::shared_ptr<Element>> BoundElements;
+
+    //! Hidden widgets waiting to be reused
+    std::vector<PooledWidget> WidgetPool;
+
+    //! Measured item sizes for each resource type
+    std::unordered_map<std::type_index, std::tuple<int32_t, int32_t>> VirtualItemSizes;
+
+    //! Incremented on each _UpdateVirtualWidgets call
+    size_t VisibleGeneration = 0;
+
+    //! The height of the tallest item, updated by UpdatePositioning. Used to find the first
+    //! visible item
+    int32_t TallestItem = 0;
 };
 
 } // namespace DV
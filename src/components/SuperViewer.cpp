@@ -66,6 +66,7 @@ void SuperViewer::_CommonCtor()
 SuperViewer::~SuperViewer()
 {
     DisplayedResource.reset();
+    _StopAnimationBuffer();
 }
 
 // ------------------------------------ //
@@ -76,6 +77,8 @@ void SuperViewer::SetImage(std::shared_ptr<Image> displayedResource, bool fastUn
     // Reset things //
     DisplayImage.reset();
     CachedDrawnImage.reset();
+    CachedDrawnLevel.reset();
+    _StopAnimationBuffer();
     IsImageReady = false;
     BumpImageLoadTimer = 0;
 
@@ -110,6 +113,8 @@ void SuperViewer::SetImage(std::shared_ptr<LoadedImage> alreadyloaded)
     IsInThumbnailMode = true;
     ForceOnlyThumbnail = true;
     CachedDrawnImage.reset();
+    CachedDrawnLevel.reset();
+    _StopAnimationBuffer();
 
     IsImageReady = false;
     BumpImageLoadTimer = 0;
@@ -129,6 +134,8 @@ void SuperViewer::RemoveImage()
     // Reset things //
     DisplayImage.reset();
     CachedDrawnImage.reset();
+    CachedDrawnLevel.reset();
+    _StopAnimationBuffer();
     IsImageReady = false;
 
     queue_draw();
@@ -276,25 +283,48 @@ bool SuperViewer::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
                 const auto now = ClockType::now();
                 const auto timeSinceFrame = now - LastFrame;
 
+                if (!AnimationFrames)
+                    _StartAnimationBuffer();
+
+                bool frameLate = false;
+
                 if (timeSinceFrame + std::chrono::milliseconds(3) >=
                     DisplayImage->GetAnimationTime(CurrentAnimationFrame))
                 {
-                    // Move to next frame //
-                    ++CurrentAnimationFrame;
-                    LastFrame = now;
-
-                    // Recreate the frame when rendering //
-                    CachedDrawnImage.reset();
-
                     // Loop
-                    if (CurrentAnimationFrame >= DisplayImage->GetFrameCount())
-                        CurrentAnimationFrame = 0;
+                    const auto nextFrame = (CurrentAnimationFrame + 1) % DisplayImage->GetFrameCount();
+
+                    // The frames are converted in the background so that playback doesn't
+                    // stutter while the main thread converts them
+                    auto frame = AnimationFrames->GetFrame(nextFrame);
+
+                    if (frame)
+                    {
+                        // Move to next frame //
+                        CurrentAnimationFrame = nextFrame;
+                        LastFrame = now;
+                        CachedDrawnFrame = frame;
+                    }
+                    else
+                    {
+                        // Keep showing the current frame until the next one is ready
+                        frameLate = true;
+                    }
+
+                    AnimationFrames->RequestConversion();
                 }
 
                 // Queue redraw for next frame //
-                _AddRedrawTimer(std::chrono::duration_cast<std::chrono::milliseconds>(
-                    DisplayImage->GetAnimationTime(CurrentAnimationFrame) - (now - LastFrame))
-                                    .count());
+                if (frameLate)
+                {
+                    _AddRedrawTimer(VIEWER_ANIMATION_FRAME_RETRY_MS);
+                }
+                else
+                {
+                    _AddRedrawTimer(std::chrono::duration_cast<std::chrono::milliseconds>(
+                        DisplayImage->GetAnimationTime(CurrentAnimationFrame) - (now - LastFrame))
+                                        .count());
+                }
             }
             else
             {
@@ -308,8 +338,22 @@ bool SuperViewer::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
                 }
             }
 
+            // Big images are drawn from a downscaled copy when zoomed out, which is much faster to
+            // draw than scaling down the full size image
+            CachedDrawnLevel.reset();
+
+            if (!IsMultiFrame && ImageZoom <= 0.5f)
+            {
+                DisplayImage->RequestPyramid();
+                CachedDrawnLevel = DisplayImage->GetPyramidLevel(ImageZoom);
+
+                // The full size pixels aren't needed until zoomed in again
+                if (CachedDrawnLevel)
+                    CachedDrawnImage.reset();
+            }
+
             // Draw positioned image //
-            if (!CachedDrawnImage)
+            if (!CachedDrawnImage && !CachedDrawnFrame && !CachedDrawnLevel)
             {
                 CachedDrawnImage = DisplayImage->CreateGtkImage(CurrentAnimationFrame);
 
@@ -330,11 +374,31 @@ bool SuperViewer::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
 
 void SuperViewer::_DrawCurrentImage(const Cairo::RefPtr<Cairo::Context>& cr) const
 {
-    LEVIATHAN_ASSERT(CachedDrawnImage, "CachedDrawnImage is invalid in draw current");
+    LEVIATHAN_ASSERT(
+        CachedDrawnImage || CachedDrawnFrame || CachedDrawnLevel, "CachedDrawnImage is invalid in draw current");
+
+    int width;
+    int height;
+
+    if (CachedDrawnFrame)
+    {
+        width = CachedDrawnFrame->get_width();
+        height = CachedDrawnFrame->get_height();
+    }
+    else if (CachedDrawnLevel)
+    {
+        // Positioning uses the full size
+        width = DisplayImage->GetWidth();
+        height = DisplayImage->GetHeight();
+    }
+    else
+    {
+        width = CachedDrawnImage->get_width();
+        height = CachedDrawnImage->get_height();
+    }
 
     // Move to right position //
-    const auto topLeft =
-        CalculateImageRenderTopLeft(CachedDrawnImage->get_width(), CachedDrawnImage->get_height(), ImageZoom);
+    const auto topLeft = CalculateImageRenderTopLeft(width, height, ImageZoom);
 
     const auto finalOffset = topLeft /*+ BaseOffset*/ /* + Point(50, 50)*/;
 
@@ -344,8 +408,27 @@ void SuperViewer::_DrawCurrentImage(const Cairo::RefPtr<Cairo::Context>& cr) con
     cr->scale(ImageZoom, ImageZoom);
 
     // Draw to a rectangle normally //
-    Gdk::Cairo::set_source_pixbuf(cr, CachedDrawnImage, 0, 0);
-    cr->rectangle(0, 0, CachedDrawnImage->get_width(), CachedDrawnImage->get_height());
+    if (CachedDrawnFrame)
+    {
+        cr->set_source(CachedDrawnFrame, 0, 0);
+    }
+    else if (CachedDrawnLevel)
+    {
+        // The copy is smaller than the full size image so it needs to be scaled up to match
+        cr->scale(static_cast<double>(width) / CachedDrawnLevel->get_width(),
+            static_cast<double>(height) / CachedDrawnLevel->get_height());
+
+        Gdk::Cairo::set_source_pixbuf(cr, CachedDrawnLevel, 0, 0);
+
+        width = CachedDrawnLevel->get_width();
+        height = CachedDrawnLevel->get_height();
+    }
+    else
+    {
+        Gdk::Cairo::set_source_pixbuf(cr, CachedDrawnImage, 0, 0);
+    }
+
+    cr->rectangle(0, 0, width, height);
     cr->fill();
 }
 
@@ -447,6 +530,8 @@ void SuperViewer::_OnNewImageReady()
     BaseOffset = Point(0, 0);
     DoingDrag = false;
     CachedDrawnImage.reset();
+    CachedDrawnLevel.reset();
+    _StopAnimationBuffer();
 
     if (ResetZoom)
         ImageZoom = 1.0f;
@@ -461,6 +546,7 @@ void SuperViewer::_SetLoadedImage(std::shared_ptr<LoadedImage> image)
 {
     DisplayImage = image;
     IsImageReady = false;
+    _StopAnimationBuffer();
 
     // Force redraw //
     queue_draw();
@@ -559,6 +645,8 @@ bool SuperViewer::_OnUnloadTimer()
     // Unload it //
     if (CachedDrawnImage)
         CachedDrawnImage.reset();
+    CachedDrawnLevel.reset();
+    _StopAnimationBuffer();
     HasUnloadTimer = false;
     return false;
 }
@@ -571,9 +659,43 @@ void SuperViewer::_OnUnMapped()
     if (DisplayedResource)
     {
         CachedDrawnImage.reset();
+        CachedDrawnLevel.reset();
+        _StopAnimationBuffer();
     }
 }
 
+// ------------------------------------ //
+void SuperViewer::_StartAnimationBuffer()
+{
+    const auto budget =
+        static_cast<size_t>(std::max(DualView::Get().GetSettings().GetAnimationBufferMegabytes(), 1)) * 1024 * 1024;
+
+    AnimationFrames =
+        std::make_shared<AnimationFrameBuffer>(DisplayImage->GetMagickImage(), budget, CurrentAnimationFrame);
+    AnimationFrames->RequestConversion();
+}
+
+void SuperViewer::_StopAnimationBuffer()
+{
+    CachedDrawnFrame.clear();
+
+    if (!AnimationFrames)
+        return;
+
+    AnimationFrames->Stop();
+
+    const auto stats = AnimationFrames->GetStats();
+
+    if (stats.Dropped > 0)
+    {
+        LOG_INFO("SuperViewer: animation frames were late " + std::to_string(stats.Dropped) + " times, shown: " +
+            std::to_string(stats.Shown) + ", converted: " + std::to_string(stats.Converted) +
+            ", buffer size: " + std::to_string(stats.Capacity));
+    }
+
+    AnimationFrames.reset();
+}
+
 // ------------------------------------ //
 bool SuperViewer::_OnMouseMove(GdkEventMotion* motion_event)
 {
@@ -7,6 +7,7 @@
 #include "Common/Types.h"
 #include "resources/Image.h"
 
+#include "AnimationFrameBuffer.h"
 #include "CacheManager.h"
 
 namespace DV
@@ -28,6 +29,9 @@ constexpr auto USE_EXTRA_VIEWER_LOGGING = false;
 // In milliseconds how often an image load priority is bumped. Works in increments of 100
 constexpr auto VIEWER_LOAD_BUMP_INTERVAL = 800;
 
+//! How often in milliseconds a due animation frame is checked again when it isn't converted yet
+constexpr auto VIEWER_ANIMATION_FRAME_RETRY_MS = 5;
+
 //! \brief Image viewing widget
 //!
 //! Manages drawing ImageMagick images with cairo
@@ -93,10 +97,10 @@ public:
     //! \brief Adds a notify event that gets called after SetImage is called
     void RegisterSetImageNotify(std::function<void()> callback);
 
-    //! \returns The image as pixbuf (if loaded)
+    //! \returns The image as pixbuf (if loaded), this can be a downscaled copy
     Glib::RefPtr<Gdk::Pixbuf> GetLoadedPixBuf() const
     {
-        return CachedDrawnImage;
+        return CachedDrawnImage ? CachedDrawnImage : CachedDrawnLevel;
     }
 
 protected:
@@ -116,7 +120,13 @@ protected:
     //! \note This can be called after the destructor if this was shown while being destroyed
     void _OnUnMapped();
 
-    //! \brief Draws the CachedDrawnImage with all the current settings
+    //! \brief Starts converting the frames of an animated DisplayImage in the background
+    void _StartAnimationBuffer();
+
+    //! \brief Stops the frame conversion for the previous animation and logs its stats
+    void _StopAnimationBuffer();
+
+    //! \brief Draws CachedDrawnFrame, CachedDrawnLevel or CachedDrawnImage with all the current settings
     void _DrawCurrentImage(const Cairo::RefPtr<Cairo::Context>& cr) const;
 
     //! \brief Draws a background image (if one is set)
@@ -169,6 +179,15 @@ private:
     //! Holds a cached version of DisplayImage. Prevents conversion happening on each frame
     Glib::RefPtr<Gdk::Pixbuf> CachedDrawnImage;
 
+    //! Converts the frames of animated images ahead of the current frame
+    std::shared_ptr<AnimationFrameBuffer> AnimationFrames;
+
+    //! The current animation frame from AnimationFrames, drawn instead of CachedDrawnImage when set
+    Cairo::RefPtr<Cairo::ImageSurface> CachedDrawnFrame;
+
+    //! Downscaled copy of DisplayImage drawn instead of CachedDrawnImage when zoomed out
+    Glib::RefPtr<Gdk::Pixbuf> CachedDrawnLevel;
+
     //! If not empty this is drawn before the image
     Glib::RefPtr<Gdk::Pixbuf> Background;
 
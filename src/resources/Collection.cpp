@@ -143,7 +143,7 @@ bool Collection::AddImage(std::shared_ptr<Image> image)
     if (!image || !IsInDatabase())
         return false;
 
-    return InDatabase->InsertImageToCollectionAG(*this, *image, GetLastShowOrder() + 1);
+    return InDatabase->InsertImageToCollectionAG(*this, *image, GetLastShowOrder() + DATABASE_SHOW_ORDER_GAP);
 }
 
 bool Collection::AddImage(std::shared_ptr<Image> image, DatabaseLockT& dblock)
@@ -151,7 +151,7 @@ bool Collection::AddImage(std::shared_ptr<Image> image, DatabaseLockT& dblock)
     if (!image || !IsInDatabase())
         return false;
 
-    return InDatabase->InsertImageToCollection(dblock, *this, *image, GetLastShowOrder(dblock) + 1);
+    return InDatabase->InsertImageToCollection(dblock, *this, *image, GetLastShowOrder(dblock) + DATABASE_SHOW_ORDER_GAP);
 }
 
 bool Collection::AddImage(std::shared_ptr<Image> image, int64_t order)
@@ -297,6 +297,15 @@ std::vector<std::shared_ptr<Image>> Collection::GetImages(int max /*= -1*/) cons
     return InDatabase->SelectImagesInCollection(*this, max);
 }
 
+void Collection::GetImagesPaged(
+    int pageSize, const std::function<bool(std::vector<std::shared_ptr<Image>>&)>& callback) const
+{
+    if (!IsInDatabase())
+        return;
+
+    InDatabase->SelectImagesInCollectionPaged(*this, pageSize, callback);
+}
+
 // ------------------------------------ //
 void Collection::_DoSave(Database& db)
 {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -114,6 +115,11 @@ public:
     //! \param max Maximum number of images to return (if only the first max images are wanted)
     std::vector<std::shared_ptr<Image>> GetImages(int max = -1) const;
 
+    //! \brief Loads the images in the collection in pages
+    //! \see Database::SelectImagesInCollectionPaged
+    void GetImagesPaged(
+        int pageSize, const std::function<bool(std::vector<std::shared_ptr<Image>>&)>& callback) const;
+
     inline auto GetIsPrivate() const
     {
         return IsPrivate;
@@ -12,8 +12,12 @@
 #include "SQLHelpers.h"
 
 #include "Exceptions.h"
+#include "base64.h"
 #include "json/json.h"
 
+#include <unordered_map>
+#include <unordered_set>
+
 using namespace DV;
 // ------------------------------------ //
 DatabaseAction::DatabaseAction() : DatabaseResource(true) {}
@@ -610,32 +614,70 @@ CollectionReorderAction::CollectionReorderAction(
     if(!parseFromStream(builder, sstream, &value, &errs))
         throw InvalidArgument("invalid json:" + errs);
 
-    {
-        const auto& oldOrder = value["old_order"];
+    TargetCollection = value["target"].asInt64();
 
-        OldOrder.reserve(oldOrder.size());
+    if(value.isMember("moves")) {
 
-        for(const auto& obj : oldOrder) {
+        if(!DecodeShowOrderMoves(base64_decode(value["moves"].asString()), Moves))
+            throw InvalidArgument("invalid encoded collection reorder moves");
 
-            const auto order = obj["order"].asInt64();
-            const auto image = obj["image"].asInt64();
+        LastShowOrder = value["last"].asInt64();
 
-            OldOrder.emplace_back(image, order);
-        }
+        return;
     }
 
-    TargetCollection = value["target"].asInt64();
+    // Stored by an older version that saved the full old and new order, these are converted
+    // to moves when migrating the database
+    const auto& oldOrder = value["old_order"];
+    const auto& newOrder = value["new_order"];
 
-    {
-        const auto& newOrder = value["new_order"];
+    if(oldOrder.empty()) {
 
-        NewOrder.reserve(newOrder.size());
+        // Not performed yet, the moves are calculated on redo
+        for(const auto& element : newOrder)
+            NewOrder.push_back(element.asInt64());
 
-        for(const auto& element : newOrder) {
+        return;
+    }
 
-            NewOrder.push_back(element.asInt64());
-        }
+    // The old orders were stored before show_orders had gaps, the migration to database
+    // version 28 multiplied the show_orders in collections by the gap
+    std::unordered_map<DBID, int64_t> oldOrders;
+
+    for(const auto& obj : oldOrder)
+        oldOrders[obj["image"].asInt64()] = obj["order"].asInt64() * DATABASE_SHOW_ORDER_GAP;
+
+    // Redo numbered the images in the new order from 1 and then the rest of the images in
+    // their old order
+    std::vector<DBID> order;
+    std::unordered_set<DBID> placed;
+
+    for(const auto& element : newOrder) {
+
+        const auto image = element.asInt64();
+
+        if(oldOrders.find(image) != oldOrders.end() && placed.insert(image).second)
+            order.push_back(image);
+    }
+
+    for(const auto& obj : oldOrder) {
+
+        const auto image = obj["image"].asInt64();
+
+        if(placed.insert(image).second)
+            order.push_back(image);
     }
+
+    for(size_t i = 0; i < order.size(); ++i) {
+
+        const auto previousOrder = oldOrders[order[i]];
+        const auto movedOrder = static_cast<int64_t>(i + 1) * DATABASE_SHOW_ORDER_GAP;
+
+        if(previousOrder != movedOrder)
+            Moves.push_back(ShowOrderMove{order[i], previousOrder, movedOrder});
+    }
+
+    LastShowOrder = static_cast<int64_t>(order.size()) * DATABASE_SHOW_ORDER_GAP;
 }
 
 CollectionReorderAction::~CollectionReorderAction()
@@ -655,24 +697,9 @@ void CollectionReorderAction::_Undo()
 
 void CollectionReorderAction::_SerializeCustomData(Json::Value& value) const
 {
-    Json::Value oldOrder;
-    oldOrder.resize(OldOrder.size());
-    for(size_t i = 0; i < oldOrder.size(); ++i) {
-        Json::Value element;
-        element["image"] = std::get<0>(OldOrder[i]);
-        element["order"] = std::get<1>(OldOrder[i]);
-        oldOrder[static_cast<unsigned>(i)] = element;
-    }
-
-    Json::Value newOrder;
-    newOrder.resize(NewOrder.size());
-    for(size_t i = 0; i < newOrder.size(); ++i) {
-        newOrder[static_cast<unsigned>(i)] = NewOrder[i];
-    }
-
-    value["old_order"] = oldOrder;
     value["target"] = TargetCollection;
-    value["new_order"] = newOrder;
+    value["moves"] = base64_encode(EncodeShowOrderMoves(Moves));
+    value["last"] = LastShowOrder;
 }
 // ------------------------------------ //
 std::string CollectionReorderAction::GenerateDescription() const
@@ -696,7 +723,7 @@ std::vector<std::shared_ptr<ResourceWithPreview>> CollectionReorderAction::LoadP
         return {};
 
     std::vector<std::shared_ptr<ResourceWithPreview>> result;
-    result.reserve(std::min<size_t>(max, NewOrder.size() + 1));
+    result.reserve(std::min<size_t>(max, Moves.size() + 1));
 
     max -= 1;
 
@@ -708,10 +735,11 @@ std::vector<std::shared_ptr<ResourceWithPreview>> CollectionReorderAction::LoadP
     if(casted)
         result.push_back(casted);
 
-    for(size_t i = 0; i < NewOrder.size() && i < static_cast<size_t>(max); ++i) {
+    // Show the moved images
+    for(size_t i = 0; i < Moves.size() && i < static_cast<size_t>(max); ++i) {
 
         auto casted = std::dynamic_pointer_cast<ResourceWithPreview>(
-            InDatabase->SelectImageByID(guard, NewOrder[i]));
+            InDatabase->SelectImageByID(guard, Moves[i].Image));
 
         if(casted)
             result.push_back(casted);
@@ -3,6 +3,7 @@
 #include "Common.h"
 #include "DatabaseResource.h"
 #include "ReversibleAction.h"
+#include "ShowOrder.h"
 
 namespace Json {
 class Value;
@@ -288,6 +289,12 @@ protected:
         OnMarkDirty();
     }
 
+    void SetImagesToDelete(std::vector<std::tuple<DBID, int64_t>>&& images)
+    {
+        ImagesToDelete = std::move(images);
+        OnMarkDirty();
+    }
+
 private:
     void _Redo() override;
     void _Undo() override;
@@ -323,14 +330,21 @@ public:
         return DATABASE_ACTION_TYPE::CollectionReorder;
     }
 
+    //! \note This is empty once the action has been performed, after that GetMoves contains
+    //! the changes
     const auto& GetNewOrder() const
     {
         return NewOrder;
     }
 
-    const auto& GetOldOrder() const
+    const auto& GetMoves() const
     {
-        return OldOrder;
+        return Moves;
+    }
+
+    auto GetLastShowOrder() const
+    {
+        return LastShowOrder;
     }
 
     auto GetTargetCollection() const
@@ -353,9 +367,11 @@ public:
 protected:
     void _OnPurged() override {}
 
-    void SetOldOrder(const std::vector<std::tuple<DBID, int64_t>>& oldorder)
+    void SetMoves(std::vector<ShowOrderMove>&& moves, int64_t lastShowOrder)
     {
-        OldOrder = oldorder;
+        Moves = std::move(moves);
+        LastShowOrder = lastShowOrder;
+        NewOrder.clear();
         OnMarkDirty();
     }
 
@@ -367,11 +383,16 @@ private:
 private:
     DBID TargetCollection;
 
-    //! The new order
+    //! The new order. Only used to calculate Moves when this is first performed
     std::vector<DBID> NewOrder;
 
-    //! The stored old order for undo purposes
-    std::vector<std::tuple<DBID, int64_t>> OldOrder;
+    //! The images whose show_order this changes. Redo and undo apply these directly so only
+    //! the moved images are stored. Renumbering the collection translates these to the new
+    //! show_orders
+    std::vector<ShowOrderMove> Moves;
+
+    //! The largest show_order in the collection after this was first performed
+    int64_t LastShowOrder = -1;
 };
 
 //! \brief Base class for single item delete action
@@ -249,25 +249,39 @@ std::string Image::CalculateFileHash() const
 {
     LEVIATHAN_ASSERT(!ResourcePath.empty(), "Image: ResourcePath is empty");
 
-    // Load file bytes //
-    std::string contents;
-    if(!Leviathan::FileSystem::ReadFileEntirely(ResourcePath, contents)) {
+    // The file is hashed in pieces to not need to load huge files entirely into memory
+    try {
+        return DualView::CalculateBase64EncodedFileHash(ResourcePath);
+    } catch(const Leviathan::InvalidArgument& e) {
         // TODO: if the file was just deleted, this shouldn't fail
+        e.PrintToLog();
         LEVIATHAN_ASSERT(0, "Failed to read file for hash calculation");
+        return "";
     }
-
-    return DualView::CalculateBase64EncodedHash(contents);
 }
 
 void Image::_DoHashCalculation()
 {
-    Hash = CalculateFileHash();
+    if(!KnownHash.empty()) {
+        Hash = std::move(KnownHash);
+        KnownHash.clear();
+    } else {
+        Hash = CalculateFileHash();
+    }
 
     LEVIATHAN_ASSERT(!Hash.empty(), "Image created an empty hash");
     LEVIATHAN_ASSERT(!ResourcePath.empty(), "Image: ResourcePath is empty");
 
     // Load the image size //
-    if(!CacheManager::GetImageSize(ResourcePath, Width, Height, Extension)) {
+    if(KnownHeader.Width > 0 && KnownHeader.Height > 0) {
+
+        Width = KnownHeader.Width;
+        Height = KnownHeader.Height;
+
+        if(Extension.empty())
+            Extension = KnownHeader.Format;
+
+    } else if(!CacheManager::GetImageSize(ResourcePath, Width, Height, Extension)) {
 
         HashError = "Failed to get image size from: " + ResourcePath;
         LOG_ERROR(HashError);
@@ -5,6 +5,7 @@
 #include <string>
 
 #include "DatabaseResource.h"
+#include "ImageProbe.h"
 #include "ResourceWithPreview.h"
 #include "TimeHelpers.h"
 #include "Exceptions.h"
@@ -86,6 +87,23 @@ public:
         return obj;
     }
 
+    //! \brief Creates a non-db version of an Image for a file whose hash and header were
+    //! already read, for example while downloading it
+    //!
+    //! The hash calculation still runs to check for duplicates but it doesn't read the file
+    //! \param hash Same as CalculateFileHash would return
+    //! \param info Size of the image, if Width is 0 the size is read from the file
+    //! \exception Leviathan::InvalidArgument if something is wrong with the file
+    static inline std::shared_ptr<Image> Create(const std::string& file, const std::string& name,
+        const std::string& importoverride, const std::string& hash, const ImageHeaderInfo& info)
+    {
+        auto obj = std::shared_ptr<Image>(new Image(file, name, importoverride));
+        obj->KnownHash = hash;
+        obj->KnownHeader = info;
+        obj->Init();
+        return obj;
+    }
+
     //! \brief Returns the full sized image
     virtual std::shared_ptr<LoadedImage> GetImage();
 
@@ -312,6 +330,10 @@ protected:
     std::string HashError;
     bool HashCalculateAttempted = false;
 
+    //! Used by _DoHashCalculation instead of reading the file if set
+    std::string KnownHash;
+    ImageHeaderInfo KnownHeader;
+
     int Height = 0;
     int Width = 0;
 
@@ -179,7 +179,6 @@ void AlreadyImportedImageDeleter::_RunTaskThread()
     std::filesystem::recursive_directory_iterator end;
 
     auto alive = GetAliveMarker();
-    std::string contents;
 
     auto& database = DualView::Get().GetDatabase();
 
@@ -229,14 +228,9 @@ void AlreadyImportedImageDeleter::_RunTaskThread()
 
             currentPath = iterator->path().string();
 
-            if (!Leviathan::FileSystem::ReadFileEntirely(currentPath, contents))
-            {
-                throw Exception("Failed to read contents of: " + currentPath);
-            }
-
             ++iterator;
 
-            const auto hash = DualView::CalculateBase64EncodedHash(contents);
+            const auto hash = DualView::CalculateBase64EncodedFileHash(currentPath);
 
             std::shared_ptr<Image> existing;
             {
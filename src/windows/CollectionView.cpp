@@ -26,6 +26,9 @@ CollectionView::CollectionView(_GtkWindow* window, Glib::RefPtr<Gtk::Builder> bu
     builder->get_widget_derived("ImageContainer", Container);
     LEVIATHAN_ASSERT(Container, "Invalid .glade file");
 
+    // Folders can contain a huge number of collections
+    Container->SetVirtualized(true);
+
     builder->get_widget("Path", PathEntry);
     LEVIATHAN_ASSERT(PathEntry, "Invalid .glade file");
 
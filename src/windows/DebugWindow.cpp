@@ -10,14 +10,21 @@
 
 #include "CacheManager.h"
 #include "Database.h"
+#include "WorkExecutor.h"
+
+#include <iomanip>
+#include <sstream>
 
 using namespace DV;
 
+constexpr auto EXECUTOR_STATS_UPDATE_INTERVAL_MS = 500;
+
 // ------------------------------------ //
 DebugWindow::DebugWindow(_GtkWindow* window, Glib::RefPtr<Gtk::Builder> builder) : Gtk::Window(window)
 {
     signal_delete_event().connect(sigc::mem_fun(*this, &DebugWindow::_OnClose));
 
+    signal_map().connect(sigc::mem_fun(*this, &DebugWindow::_OnShown));
     signal_unmap().connect(sigc::mem_fun(*this, &DebugWindow::_OnHidden));
 
     Gtk::Button* MakeBusy;
@@ -37,10 +44,19 @@ DebugWindow::DebugWindow(_GtkWindow* window, Glib::RefPtr<Gtk::Builder> builder)
     BUILDER_GET_WIDGET(TestInstanceCreation);
 
     TestInstanceCreation->signal_clicked().connect(sigc::mem_fun(*this, &DebugWindow::OnTestInstanceCreation));
+
+    BUILDER_GET_WIDGET(ExecutorStats);
+
+    Gtk::Button* ResetExecutorStats;
+
+    BUILDER_GET_WIDGET(ResetExecutorStats);
+
+    ResetExecutorStats->signal_clicked().connect(sigc::mem_fun(*this, &DebugWindow::OnResetExecutorStats));
 }
 
 DebugWindow::~DebugWindow()
 {
+    StatsTimer.disconnect();
 }
 
 // ------------------------------------ //
@@ -51,8 +67,24 @@ bool DebugWindow::_OnClose(GdkEventAny* event)
     return true;
 }
 
+void DebugWindow::_OnShown()
+{
+    UpdateExecutorStats();
+
+    StatsTimer.disconnect();
+    StatsTimer = Glib::signal_timeout().connect(
+        sigc::mem_fun(*this, &DebugWindow::_OnStatsTimer), EXECUTOR_STATS_UPDATE_INTERVAL_MS);
+}
+
 void DebugWindow::_OnHidden()
 {
+    StatsTimer.disconnect();
+}
+
+bool DebugWindow::_OnStatsTimer()
+{
+    UpdateExecutorStats();
+    return true;
 }
 
 // ------------------------------------ //
@@ -91,3 +123,37 @@ void DebugWindow::OnTestInstanceCreation()
     auto img1 = InternetImage::Create(
         ScanFoundImage(ProcessableURL("http://test.com/img.jpg", std::string(), "dualview")), false);
 }
+
+// ------------------------------------ //
+void DebugWindow::UpdateExecutorStats()
+{
+    auto& executor = DualView::Get().GetExecutor();
+
+    std::stringstream stream;
+    stream << std::fixed << std::setprecision(2);
+
+    for (const auto& stats : executor.GetStats())
+    {
+        stream << WorkExecutor::GetLaneName(stats.Lane);
+
+        if (stats.Lane == EXECUTOR_LANE::Worker)
+            stream << " (" << executor.GetWorkerCount() << " threads)";
+
+        stream << ": queued " << stats.QueueDepth << ", running " << stats.Running << ", done "
+               << stats.Completed << "\n  wait avg " << stats.AverageWaitMS << " ms, max " << stats.MaxWaitMS
+               << " ms, run avg " << stats.AverageRunMS << " ms";
+
+        if (stats.Lane == EXECUTOR_LANE::Worker)
+            stream << ", stolen " << stats.Steals;
+
+        stream << "\n";
+    }
+
+    ExecutorStats->set_text(stream.str());
+}
+
+void DebugWindow::OnResetExecutorStats()
+{
+    DualView::Get().GetExecutor().ResetStats();
+    UpdateExecutorStats();
+}
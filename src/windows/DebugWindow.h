@@ -23,12 +23,24 @@ public:
     //! Tests that objects don't leave traces. Needs to be ran with a leak detector
     void OnTestInstanceCreation();
 
+    //! Shows the current queue lengths and latencies of the WorkExecutor lanes
+    void UpdateExecutorStats();
+
+    void OnResetExecutorStats();
+
 private:
     bool _OnClose(GdkEventAny* event);
 
+    void _OnShown();
     void _OnHidden();
 
+    bool _OnStatsTimer();
+
 private:
+    Gtk::Label* ExecutorStats;
+
+    //! Refreshes the stats while this is visible
+    sigc::connection StatsTimer;
 };
 
 } // namespace DV
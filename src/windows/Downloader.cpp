@@ -528,26 +528,35 @@ dlretryfailedlable:
                     }
 
                     // Check type //
-                    try
+                    // Images whose end marker or header file size was checked while downloading
+                    // don't need to be decoded here. Anything that couldn't be checked is
+                    // decoded to catch cut off files
+                    if (!imagedl->IsRecognizedImage())
                     {
-                        Magick::Image testParse(imagedl->GetLocalFile());
+                        try
+                        {
+                            Magick::Image testParse(imagedl->GetLocalFile());
 
-                        const auto extension = testParse.magick();
+                            const auto extension = testParse.magick();
 
-                        if (extension.empty())
-                            throw Leviathan::Exception("testParse.magick() returned empty string");
-                    }
-                    catch (const std::exception& e)
-                    {
-                        LOG_ERROR("Downloader: Downloaded invalid image, exception: " + std::string(e.what()));
+                            if (extension.empty())
+                                throw Leviathan::Exception("testParse.magick() returned empty string");
+                        }
+                        catch (const std::exception& e)
+                        {
+                            LOG_ERROR("Downloader: Downloaded invalid image, exception: " + std::string(e.what()));
 
-                        boost::filesystem::remove(imagedl->GetLocalFile());
+                            boost::filesystem::remove(imagedl->GetLocalFile());
 
-                        goto dlretryfailedlable;
+                            goto dlretryfailedlable;
+                        }
                     }
 
+                    // The hash was calculated while downloading
                     auto newImage = Image::Create(imagedl->GetLocalFile(),
-                        DownloadManager::ExtractFileName(imagedl->GetURL()), imagedl->GetURL().GetURL());
+                        DownloadManager::ExtractFileName(imagedl->GetURL()), imagedl->GetURL().GetURL(),
+                        imagedl->GetFileHash(),
+                        imagedl->IsRecognizedImage() ? imagedl->GetImageInfo() : ImageHeaderInfo());
 
                     DownloadedImages.push_back(newImage);
                     LocalDLFiles.push_back(imagedl->GetLocalFile());
@@ -196,6 +196,8 @@ DuplicateFinderWindow::DuplicateFinderWindow() :
 
     // Setup non widget stuff
 
+    Calculator.SetWorkerCount(DualView::Get().GetSettings().GetSignatureCalculationThreads());
+
     // Status listener for signature calculation
     Calculator.SetStatusListener(
         std::bind(&DuplicateFinderWindow::_ReportSignatureCalculationStatus, this,
@@ -755,7 +757,9 @@ void DuplicateFinderWindow::_CheckScanStatus()
 
         const auto sensitivity = static_cast<int>(Sensitivity.get_value());
 
-        DualView::Get().QueueDBThreadFunction([=]() {
+        // This only locks the database while reading the signatures so this is ran on a worker
+        // to not block the database thread during the search
+        DualView::Get().QueueWorkerFunction([=]() {
             auto duplicates =
                 DualView::Get().GetDatabase().SelectPotentialImageDuplicates(sensitivity);
 
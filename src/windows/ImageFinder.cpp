@@ -3,6 +3,7 @@
 
 #include "Database.h"
 #include "DualView.h"
+#include "TagSearchIndex.h"
 
 #include "components/SuperContainer.h"
 #include "resources/Tags.h"
@@ -56,34 +57,47 @@ void ImageFinder::OnSearchChanged()
     _SetSearchingState(true);
 
     DualView::Get().QueueDBThreadFunction([=]() {
-        // Parse tag and then do stuff //
-        // TODO: separators
-        std::shared_ptr<AppliedTag> tags;
+        // Parse the search and then the tags in it //
+        std::unique_ptr<TagSearchNode> search;
         try {
-            tags = DualView::Get().ParseTagFromString(matchingPattern);
-
-            LEVIATHAN_ASSERT(tags, "tags is empty with non-empty string");
-
+            search = ParseTagSearch(matchingPattern);
         } catch(const Leviathan::InvalidArgument& e) {
 
             INVOKE_CHECK_ALIVE_MARKER(isalive);
 
-            _OnFailSearch(std::string("Invalid tag: ") + e.what());
+            _OnFailSearch(std::string("Invalid search: ") + e.what());
 
             return;
         }
 
-        const auto dbTag = DualView::Get().GetDatabase().SelectExistingAppliedTagIDAG(*tags);
+        std::string error;
+
+        search->ForEachTerm([&](TagSearchNode& term) {
+            if(!error.empty())
+                return;
+
+            try {
+                const auto tag = DualView::Get().ParseTagFromString(term.Text);
+
+                LEVIATHAN_ASSERT(tag, "tag is empty with non-empty string");
+
+                // Tags that no image has just don't match anything
+                term.TagID = DualView::Get().GetDatabase().SelectExistingAppliedTagIDAG(*tag);
+
+            } catch(const Leviathan::InvalidArgument& e) {
+                error = std::string("Invalid tag: ") + e.what();
+            }
+        });
 
-        if(dbTag == -1) {
+        if(!error.empty()) {
 
             INVOKE_CHECK_ALIVE_MARKER(isalive);
 
-            _OnFailSearch(std::string("No resource has tag: ") + tags->ToAccurateString());
+            _OnFailSearch(error);
             return;
         }
 
-        const auto images = DualView::Get().GetDatabase().SelectImageByTagAG(dbTag);
+        const auto images = DualView::Get().GetDatabase().SelectImagesByTagSearchAG(*search);
 
         auto loadedResources =
             std::make_shared<std::vector<std::shared_ptr<ResourceWithPreview>>>();
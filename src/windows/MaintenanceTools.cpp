@@ -16,9 +16,12 @@
 #include "resources/ImagePath.h"
 #include "resources/NetGallery.h"
 
+#include "CacheManager.h"
 #include "Database.h"
 #include "Exceptions.h"
+#include "FileSystem.h"
 #include "Settings.h"
+#include "ThumbnailPack.h"
 
 constexpr auto IMAGE_CHECK_REPORT_PROGRESS_EVERY_N = 200;
 constexpr auto MAX_MAINTENANCE_RESULTS = 10000;
@@ -219,6 +222,10 @@ MaintenanceTools::MaintenanceTools(_GtkWindow* window, Glib::RefPtr<Gtk::Builder
     BUILDER_GET_WIDGET(DeleteAllThumbnails);
     DeleteAllThumbnails->signal_clicked().connect(sigc::mem_fun(*this, &MaintenanceTools::StartDeleteThumbnails));
 
+    BUILDER_GET_WIDGET(ImportThumbnailsToPack);
+    ImportThumbnailsToPack->signal_clicked().connect(
+        sigc::mem_fun(*this, &MaintenanceTools::StartImportThumbnailsToPack));
+
     BUILDER_GET_WIDGET(FixOrphanedResources);
     FixOrphanedResources->signal_clicked().connect(
         sigc::mem_fun(*this, &MaintenanceTools::StartDeleteOrphanedResources));
@@ -320,6 +327,46 @@ void MaintenanceTools::StartDeleteThumbnails()
     _UpdateState();
 }
 
+void MaintenanceTools::StartImportThumbnailsToPack()
+{
+    if (RunTaskThread)
+    {
+        LOG_ERROR("Already doing an operation can't start a new maintenance operation");
+        return;
+    }
+
+    Stop(true);
+
+    auto& dualView = DualView::Get();
+
+    // Thumbnails need to be stored in the pack from now on, otherwise they would just be created again as files
+    if (!dualView.GetCacheManager().GetThumbnailPack())
+    {
+        try
+        {
+            dualView.GetCacheManager().EnableThumbnailPack(dualView.GetThumbnailPackFolder());
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR("Failed to open thumbnail pack: " + std::string(e.what()));
+            _InsertTextResult("Opening thumbnail pack failed: " + std::string(e.what()));
+            return;
+        }
+
+        dualView.GetSettings().SetUseThumbnailPack(true);
+    }
+
+    MaintenanceStatusLabel->set_text("Moving thumbnails into the thumbnail pack");
+    ProgressFraction = 0;
+
+    HasRunSomething = true;
+    RunTaskThread = true;
+    TaskRunning = true;
+    TaskThread = std::thread([this] { _RunTaskThread([this] { _RunImportThumbnailsToPack(); }); });
+
+    _UpdateState();
+}
+
 void MaintenanceTools::StartDeleteOrphanedResources()
 {
     if (RunTaskThread)
@@ -437,6 +484,7 @@ void MaintenanceTools::_UpdateState()
         MaintenanceCancelButton->set_sensitive(true);
         CheckAllExist->set_sensitive(false);
         DeleteAllThumbnails->set_sensitive(false);
+        ImportThumbnailsToPack->set_sensitive(false);
         FixOrphanedResources->set_sensitive(false);
         FixOrphanedImages->set_sensitive(false);
         DeleteImportedStagingFolderItems->set_sensitive(false);
@@ -446,6 +494,7 @@ void MaintenanceTools::_UpdateState()
         MaintenanceCancelButton->set_sensitive(false);
         CheckAllExist->set_sensitive(true);
         DeleteAllThumbnails->set_sensitive(true);
+        ImportThumbnailsToPack->set_sensitive(true);
         FixOrphanedResources->set_sensitive(true);
         FixOrphanedImages->set_sensitive(true);
         DeleteImportedStagingFolderItems->set_sensitive(true);
@@ -508,8 +557,8 @@ void MaintenanceTools::_RunFileExistCheck()
     int64_t total;
 
     {
-        GUARD_LOCK_OTHER(database);
-        total = static_cast<int64_t>(database.SelectImageCount(guard));
+        auto reader = database.AcquireReadLock();
+        total = static_cast<int64_t>(database.SelectImageCount(reader));
     }
 
     LOG_INFO("Total number of images: " + std::to_string(total));
@@ -525,8 +574,8 @@ void MaintenanceTools::_RunFileExistCheck()
             // Need to get a new batch
             try
             {
-                GUARD_LOCK_OTHER(database);
-                database.SelectImagePaths(guard, imageBatch, processed);
+                auto reader = database.AcquireReadLock();
+                database.SelectImagePaths(reader, imageBatch, processed);
             }
             catch (const Leviathan::Exception& e)
             {
@@ -653,11 +702,35 @@ void MaintenanceTools::_RunDeleteThumbnails()
 
     int64_t processed = 0;
 
-    // We can't use a directory iterator as that goes invalid when deleting stuff, so we just delete everything in one
-    // go and recreate the folder
-
     boost::system::error_code error;
-    bf::remove_all(thumbnailFolder, error);
+
+    if (const auto pack = DualView::Get().GetCacheManager().GetThumbnailPack(); pack)
+    {
+        // The pack keeps its segment files open so it needs to delete them itself
+        pack->Clear();
+
+        std::vector<bf::path> toDelete;
+
+        for (bf::directory_iterator iter(thumbnailFolder); iter != bf::directory_iterator(); ++iter)
+        {
+            if (!bf::equivalent(iter->path(), pack->GetFolder()))
+                toDelete.push_back(iter->path());
+        }
+
+        for (const auto& path : toDelete)
+        {
+            bf::remove_all(path, error);
+
+            if (error.failed())
+                break;
+        }
+    }
+    else
+    {
+        // We can't use a directory iterator as that goes invalid when deleting stuff, so we just delete everything in
+        // one go and recreate the folder
+        bf::remove_all(thumbnailFolder, error);
+    }
 
     if (error.failed())
     {
@@ -686,6 +759,111 @@ void MaintenanceTools::_RunDeleteThumbnails()
     LOG_INFO("Thumbnail deleting finished");
 }
 
+void MaintenanceTools::_RunImportThumbnailsToPack()
+{
+    namespace bf = boost::filesystem;
+
+    auto alive = GetAliveMarker();
+
+    const auto pack = DualView::Get().GetCacheManager().GetThumbnailPack();
+
+    if (!pack)
+    {
+        LOG_ERROR("Thumbnail pack is not enabled, can't import thumbnails");
+        return;
+    }
+
+    LOG_INFO("Started moving thumbnails into the thumbnail pack");
+
+    const auto thumbnailFolder = DV::DualView::Get().GetThumbnailFolder();
+
+    // Files are deleted after importing so they are all found first
+    std::vector<bf::path> files;
+
+    if (bf::is_directory(thumbnailFolder))
+    {
+        for (bf::directory_iterator iter(thumbnailFolder); iter != bf::directory_iterator(); ++iter)
+        {
+            if (bf::is_regular_file(iter->status()))
+                files.push_back(iter->path());
+        }
+    }
+
+    int64_t processed = 0;
+    int64_t imported = 0;
+    int64_t failed = 0;
+
+    for (const auto& file : files)
+    {
+        if (!RunTaskThread)
+            return;
+
+        const auto name = file.filename().string();
+
+        try
+        {
+            std::string data;
+
+            if (!Leviathan::FileSystem::ReadFileEntirely(file.string(), data))
+                throw Leviathan::InvalidArgument("can't read file");
+
+            // A thumbnail that is already packed has been created after enabling the pack so it is kept
+            if (!pack->Contains(name))
+            {
+                pack->Add(name, data.data(), data.size());
+                ++imported;
+            }
+
+            bf::remove(file);
+        }
+        catch (const std::exception& e)
+        {
+            LOG_WARNING("Failed to move thumbnail " + file.string() + " into pack: " + e.what());
+            ++failed;
+        }
+
+        ++processed;
+
+        if (processed % IMAGE_CHECK_REPORT_PROGRESS_EVERY_N == 0)
+        {
+            DualView::Get().InvokeFunction(
+                [=]
+                {
+                    INVOKE_CHECK_ALIVE_MARKER(alive);
+
+                    ProgressFraction =
+                        static_cast<float>((static_cast<double>(processed) / static_cast<double>(files.size())));
+                    MaintenanceStatusLabel->set_text("Moving thumbnails into the thumbnail pack");
+                    _UpdateState();
+                });
+        }
+    }
+
+    if (pack->ShouldCompact())
+    {
+        DualView::Get().InvokeFunction(
+            [=]
+            {
+                INVOKE_CHECK_ALIVE_MARKER(alive);
+                MaintenanceStatusLabel->set_text("Compacting the thumbnail pack");
+            });
+
+        pack->Compact();
+    }
+
+    DualView::Get().InvokeFunction(
+        [=]
+        {
+            INVOKE_CHECK_ALIVE_MARKER(alive);
+
+            _InsertTextResult("Moved " + std::to_string(imported) + " thumbnails into the thumbnail pack, " +
+                std::to_string(failed) + " failed. The pack has " + std::to_string(pack->GetCount()) +
+                " thumbnails");
+        });
+
+    LOG_INFO("Thumbnail pack import finished");
+}
+
 // ------------------------------------ //
 void MaintenanceTools::_RunDeleteOrphaned()
 {
@@ -704,8 +882,8 @@ void MaintenanceTools::_RunDeleteOrphaned()
     LOG_INFO("Detecting collections to purge");
 
     {
-        GUARD_LOCK_OTHER(database);
-        database.SelectIncorrectlyDeletedCollections(guard, collectionsToPurge);
+        auto reader = database.AcquireReadLock();
+        database.SelectIncorrectlyDeletedCollections(reader, collectionsToPurge);
     }
 
     LOG_INFO("Detecting images to purge");
@@ -721,8 +899,8 @@ void MaintenanceTools::_RunDeleteOrphaned()
         });
 
     {
-        GUARD_LOCK_OTHER(database);
-        database.SelectIncorrectlyDeletedImages(guard, imagesToPurge);
+        auto reader = database.AcquireReadLock();
+        database.SelectIncorrectlyDeletedImages(reader, imagesToPurge);
     }
 
     if (!RunTaskThread)
@@ -731,15 +909,15 @@ void MaintenanceTools::_RunDeleteOrphaned()
     LOG_INFO("Detecting net galleries to purge");
 
     {
-        GUARD_LOCK_OTHER(database);
-        database.SelectIncorrectlyDeletedNetGalleries(guard, netGalleriesToPurge);
+        auto reader = database.AcquireReadLock();
+        database.SelectIncorrectlyDeletedNetGalleries(reader, netGalleriesToPurge);
     }
 
     LOG_INFO("Detecting folders to purge");
 
     {
-        GUARD_LOCK_OTHER(database);
-        database.SelectIncorrectlyDeletedFolders(guard, foldersToPurge);
+        auto reader = database.AcquireReadLock();
+        database.SelectIncorrectlyDeletedFolders(reader, foldersToPurge);
     }
 
     if (!RunTaskThread)
@@ -966,8 +1144,8 @@ void MaintenanceTools::_RunFixOrphaned()
         });
 
     {
-        GUARD_LOCK_OTHER(database);
-        database.SelectOrphanedImages(guard, imagesToAddToUncategorized);
+        auto reader = database.AcquireReadLock();
+        database.SelectOrphanedImages(reader, imagesToAddToUncategorized);
     }
 
     if (!RunTaskThread)
@@ -1014,7 +1192,8 @@ void MaintenanceTools::_RunFixOrphaned()
                 GUARD_LOCK_OTHER(database);
 
                 // If we really cared about performance we would cache the order value between loops
-                const auto order = database.SelectCollectionLargestShowOrder(guard, *uncategorized) + 1;
+                const auto order =
+                    database.SelectCollectionLargestShowOrder(guard, *uncategorized) + DATABASE_SHOW_ORDER_GAP;
                 database.InsertImageToCollection(guard, uncategorized->GetID(), addToUncategorized, order);
             }
             catch (const Leviathan::Exception& e)
@@ -25,6 +25,7 @@ public:
 
     void StartImageExistCheck();
     void StartDeleteThumbnails();
+    void StartImportThumbnailsToPack();
     void StartDeleteOrphanedResources();
     void StartFixOrphanedResources();
 
@@ -49,6 +50,7 @@ private:
     void _RunTaskThread(const std::function<void()>& operation);
     void _RunFileExistCheck();
     void _RunDeleteThumbnails();
+    void _RunImportThumbnailsToPack();
     void _RunDeleteOrphaned();
     void _RunFixOrphaned();
 
@@ -61,6 +63,7 @@ private:
     Gtk::Button* MaintenanceCancelButton;
     Gtk::Button* CheckAllExist;
     Gtk::Button* DeleteAllThumbnails;
+    Gtk::Button* ImportThumbnailsToPack;
     Gtk::Button* FixOrphanedResources;
     Gtk::Button* FixOrphanedImages;
     Gtk::Button* DeleteImportedStagingFolderItems;
@@ -13,6 +13,9 @@
 #include "DualView.h"
 
 using namespace DV;
+
+//! Number of images loaded at once when first opening a collection
+constexpr auto COLLECTION_IMAGE_LOAD_PAGE_SIZE = 100;
 // ------------------------------------ //
 SingleCollection::SingleCollection(_GtkWindow* window, Glib::RefPtr<Gtk::Builder> builder) :
     Gtk::Window(window)
@@ -120,37 +123,93 @@ void SingleCollection::ReloadImages(Lock& guard)
 
     auto isalive = GetAliveMarker();
 
-    DualView::Get().QueueDBThreadFunction([this, isalive, collection]() {
-        auto images = collection->GetImages();
-
-        DualView::Get().InvokeFunction([this, isalive, images, collection]() {
-            INVOKE_CHECK_ALIVE_MARKER(isalive);
-
-            ImageContainer->SetShownItems(images.begin(), images.end(),
-                std::make_shared<ItemSelectable>([=](ListItem& item) {
-                    bool hasselected = ImageContainer->CountSelectedItems() > 0;
+    // Stop a previous load that is still running //
+    if(CurrentImageLoad)
+        CurrentImageLoad->store(false);
 
-                    // Enable buttons //
-                    DeleteSelected->set_sensitive(hasselected);
-                    OpenSelectedImporter->set_sensitive(hasselected);
-                }));
+    auto loadActive = std::make_shared<std::atomic<bool>>(true);
+    CurrentImageLoad = loadActive;
 
-            // This is probably really innefficient //
-            ImageContainer->VisitAllWidgets([&](ListItem& widget) {
-                auto* asimage = dynamic_cast<ImageListItem*>(&widget);
+    auto selectable = std::make_shared<ItemSelectable>([=](ListItem& item) {
+        bool hasselected = ImageContainer->CountSelectedItems() > 0;
 
-                if(!asimage)
-                    return;
-
-                asimage->SetCollection(collection);
-            });
+        // Enable buttons //
+        DeleteSelected->set_sensitive(hasselected);
+        OpenSelectedImporter->set_sensitive(hasselected);
+    });
 
-            StatusLabel->set_text(
-                "Collection \"" + collection->GetName() + "\" Has " +
-                Convert::ToString(images.size()) + " Images" +
-                (ShownCollection->IsDeleted() ? ". This collection is DELETED!" : ""));
+    // When nothing is shown yet the images are shown page by page as they are loaded. When
+    // reloading all are loaded first so that the existing widgets can be reused and the scroll
+    // position is kept
+    const bool showPages = ImageContainer->IsEmpty();
+
+    DualView::Get().QueueDBThreadFunction(
+        [this, isalive, collection, loadActive, selectable, showPages]() {
+            auto shownCount = std::make_shared<size_t>(0);
+            std::vector<std::shared_ptr<Image>> allImages;
+
+            const auto applyImages = [=](std::vector<std::shared_ptr<Image>> images,
+                                         bool replace, bool finished) {
+                DualView::Get().InvokeFunction([=]() {
+                    INVOKE_CHECK_ALIVE_MARKER(isalive);
+
+                    if(!loadActive->load())
+                        return;
+
+                    if(replace) {
+                        ImageContainer->SetShownItems(images.begin(), images.end(), selectable);
+                    } else {
+                        ImageContainer->AddItems(images.begin(), images.end(), selectable);
+                    }
+
+                    // Only the widgets of the new items need the collection set
+                    const size_t firstNew = replace ? 0 : *shownCount;
+
+                    *shownCount = replace ? images.size() : *shownCount + images.size();
+
+                    ImageContainer->VisitWidgetsFrom(firstNew, [&](ListItem& widget) {
+                        auto* asimage = dynamic_cast<ImageListItem*>(&widget);
+
+                        if(!asimage)
+                            return;
+
+                        asimage->SetCollection(collection);
+                    });
+
+                    if(!finished) {
+                        StatusLabel->set_text("Loading Collection... " +
+                                              Convert::ToString(*shownCount) + " Images so far");
+                        return;
+                    }
+
+                    StatusLabel->set_text("Collection \"" + collection->GetName() + "\" Has " +
+                                          Convert::ToString(*shownCount) + " Images" +
+                                          (ShownCollection->IsDeleted() ?
+                                                  ". This collection is DELETED!" :
+                                                  ""));
+                });
+            };
+
+            bool firstPage = true;
+
+            collection->GetImagesPaged(COLLECTION_IMAGE_LOAD_PAGE_SIZE,
+                [&](std::vector<std::shared_ptr<Image>>& page) {
+                    if(!loadActive->load())
+                        return false;
+
+                    if(!showPages) {
+                        allImages.insert(allImages.end(), page.begin(), page.end());
+                        return true;
+                    }
+
+                    applyImages(std::move(page), firstPage, false);
+                    firstPage = false;
+                    return true;
+                });
+
+            // The final update also clears the container if the collection is empty //
+            applyImages(std::move(allImages), !showPages || firstPage, true);
         });
-    });
 }
 // ------------------------------------ //
 void SingleCollection::StartRename()
@@ -7,6 +7,8 @@
 
 #include <gtkmm.h>
 
+#include <atomic>
+
 namespace DV {
 
 class SuperContainer;
@@ -66,6 +68,9 @@ private:
     Gtk::Label* StatusLabel;
 
     std::shared_ptr<Collection> ShownCollection;
+
+    //! Set to false to stop the current image load from showing any more images
+    std::shared_ptr<std::atomic<bool>> CurrentImageLoad;
 };
 
 } // namespace DV
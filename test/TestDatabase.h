@@ -14,6 +14,9 @@ class TestDatabase : public Database {
 public:
     TestDatabase() : Database(true) {}
 
+    //! \brief Uses a database file, for tests that need multiple connections
+    explicit TestDatabase(const std::string& file) : Database(file) {}
+
     std::shared_ptr<Image> InsertTestImage(const std::string& file, const std::string& hash)
     {
         GUARD_LOCK();
@@ -83,6 +86,11 @@ public:
     {
         return SQLiteDb;
     }
+
+    sqlite3* GetSignatureDB()
+    {
+        return PictureSignatureDb;
+    }
 };
 
 } // namespace DV
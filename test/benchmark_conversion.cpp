@@ -0,0 +1,111 @@
+// Measures how fast decoded images are converted to drawable pixbufs and Cairo surfaces
+//
+// Usage: ConversionBenchmark [image files...]
+// Without arguments the test data images and a generated large image are used
+#include "AnimationFrameBuffer.h"
+#include "CacheManager.h"
+
+#include <gtkmm.h>
+#include <Magick++.h>
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+using namespace DV;
+
+constexpr auto MINIMUM_BENCHMARK_SECONDS = 1.0;
+
+//! Size of the generated image, tall images have the most per row overhead
+constexpr auto GENERATED_IMAGE_WIDTH = 4000;
+constexpr auto GENERATED_IMAGE_HEIGHT = 6000;
+
+//! \brief Runs convert on all the frames until enough time has passed
+//! \returns Megapixels converted per second
+double Measure(std::vector<Magick::Image>& frames, const std::function<void(Magick::Image&)>& convert)
+{
+    size_t pixels = 0;
+    const auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{0};
+
+    do
+    {
+        for (auto& frame : frames)
+        {
+            convert(frame);
+            pixels += frame.columns() * frame.rows();
+        }
+
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < MINIMUM_BENCHMARK_SECONDS);
+
+    return pixels / 1000000.0 / elapsed.count();
+}
+
+void RunBenchmarks(const std::string& name, std::vector<Magick::Image>& frames)
+{
+    std::cout << name << " (" << frames.front().columns() << "x" << frames.front().rows() << ", "
+              << frames.size() << " frame(s), " << (frames.front().alpha() ? "alpha" : "no alpha") << ")\n";
+
+    const auto report = [&](const std::string& method, const std::function<void(Magick::Image&)>& convert)
+    {
+        std::cout << "  " << std::left << std::setw(20) << method << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(10) << Measure(frames, convert) << " MP/s\n";
+    };
+
+    report("pixbuf per row", [](Magick::Image& image) { LoadedImage::ConvertToPixbuf(image, false); });
+    report("pixbuf", [](Magick::Image& image) { LoadedImage::ConvertToPixbuf(image); });
+    report("cairo surface", [](Magick::Image& image) { AnimationFrameBuffer::ConvertFrame(image); });
+}
+
+int main(int argc, char* argv[])
+{
+    Magick::InitializeMagick(*argv);
+
+    // Initializes the gtkmm wrappers that creating pixbufs needs
+    auto app = Gtk::Application::create("com.boostslair.dualview.benchmark");
+
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i)
+        files.push_back(argv[i]);
+
+    if (files.empty())
+    {
+        files.push_back("data/7c2c2141cf27cb90620f80400c6bc3c4.jpg");
+        files.push_back("data/bird bathing.gif");
+
+        std::vector<Magick::Image> generated{Magick::Image(
+            Magick::Geometry(GENERATED_IMAGE_WIDTH, GENERATED_IMAGE_HEIGHT), Magick::Color("rgba(200,40,90,0.5)"))};
+        generated.front().alpha(true);
+
+        RunBenchmarks("generated", generated);
+
+        // Without alpha and with an odd width Gtk pads the pixbuf rows
+        std::vector<Magick::Image> padded{Magick::Image(
+            Magick::Geometry(GENERATED_IMAGE_WIDTH - 1, GENERATED_IMAGE_HEIGHT), Magick::Color("rgb(200,40,90)"))};
+        padded.front().alpha(false);
+
+        RunBenchmarks("generated padded", padded);
+    }
+
+    for (const auto& file : files)
+    {
+        std::shared_ptr<std::vector<Magick::Image>> frames;
+
+        try
+        {
+            LoadedImage::LoadImage(file, frames);
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "Failed to load " << file << ": " << e.what() << "\n";
+            return 1;
+        }
+
+        RunBenchmarks(file, *frames);
+    }
+
+    return 0;
+}
@@ -8,12 +8,14 @@
 #include "resources/Collection.h"
 #include "resources/Folder.h"
 #include "resources/Image.h"
+#include "resources/ImagePath.h"
 
 #include "Common/StringOperations.h"
 
 #include <boost/filesystem.hpp>
 #include <sqlite3.h>
 
+#include <future>
 #include <memory>
 #include <thread>
 
@@ -266,9 +268,9 @@ TEST_CASE("Directly using database for collection and image inserts", "[db]")
 
         REQUIRE(image4);
 
-        CHECK(collection->GetLastShowOrder(guard) == 5);
-        CHECK(collection->GetImageShowOrder(image, guard) == 1);
-        CHECK(collection->GetImageShowOrder(image2, guard) == 1);
+        CHECK(collection->GetLastShowOrder(guard) == DATABASE_SHOW_ORDER_GAP);
+        CHECK(collection->GetImageShowOrder(image, guard) == DATABASE_SHOW_ORDER_GAP);
+        CHECK(collection->GetImageShowOrder(image2, guard) == DATABASE_SHOW_ORDER_GAP);
         CHECK(collection->GetImageShowOrder(image3, guard) == 5);
         CHECK(collection->GetImageShowOrder(image4, guard) == -1);
     }
@@ -296,32 +298,35 @@ TEST_CASE("Directly using database for collection and image inserts", "[db]")
             CHECK(collection->AddImage(image3));
 
             CHECK(collection->GetImageCount() == 3);
-            CHECK(collection->GetLastShowOrder() == 3);
+            CHECK(collection->GetLastShowOrder() == 3 * DATABASE_SHOW_ORDER_GAP);
 
             CHECK(db.SelectImageShowIndexInCollection(*collection, *image1) == 0);
             CHECK(db.SelectImageShowIndexInCollection(*collection, *image2) == 1);
             CHECK(db.SelectImageShowIndexInCollection(*collection, *image3) == 2);
 
             CHECK(!db.SelectImageInCollectionByShowOrderAG(*collection, 0));
-            CHECK(*db.SelectImageInCollectionByShowOrderAG(*collection, 1) == *image1);
-            CHECK(*db.SelectImageInCollectionByShowOrderAG(*collection, 2) == *image2);
-            CHECK(*db.SelectImageInCollectionByShowOrderAG(*collection, 3) == *image3);
+            CHECK(!db.SelectImageInCollectionByShowOrderAG(*collection, 1));
+            CHECK(*db.SelectImageInCollectionByShowOrderAG(*collection, DATABASE_SHOW_ORDER_GAP) == *image1);
+            CHECK(*db.SelectImageInCollectionByShowOrderAG(*collection, 2 * DATABASE_SHOW_ORDER_GAP) == *image2);
+            CHECK(*db.SelectImageInCollectionByShowOrderAG(*collection, 3 * DATABASE_SHOW_ORDER_GAP) == *image3);
 
             CHECK(*db.SelectFirstImageInCollectionAG(*collection) == *image1);
             CHECK(*db.SelectLastImageInCollectionAG(*collection) == *image3);
 
 
             CHECK(*db.SelectNextImageInCollectionByShowOrder(*collection, 0) == *image1);
-            CHECK(*db.SelectNextImageInCollectionByShowOrder(*collection, 1) == *image2);
-            CHECK(*db.SelectNextImageInCollectionByShowOrder(*collection, 2) == *image3);
-            CHECK(!db.SelectNextImageInCollectionByShowOrder(*collection, 3));
+            CHECK(*db.SelectNextImageInCollectionByShowOrder(*collection, DATABASE_SHOW_ORDER_GAP) == *image2);
+            CHECK(*db.SelectNextImageInCollectionByShowOrder(*collection, DATABASE_SHOW_ORDER_GAP + 1) == *image2);
+            CHECK(*db.SelectNextImageInCollectionByShowOrder(*collection, 2 * DATABASE_SHOW_ORDER_GAP) == *image3);
+            CHECK(!db.SelectNextImageInCollectionByShowOrder(*collection, 3 * DATABASE_SHOW_ORDER_GAP));
 
 
             CHECK(!db.SelectPreviousImageInCollectionByShowOrder(*collection, 0));
-            CHECK(!db.SelectPreviousImageInCollectionByShowOrder(*collection, 1));
-            CHECK(*db.SelectPreviousImageInCollectionByShowOrder(*collection, 2) == *image1);
-            CHECK(*db.SelectPreviousImageInCollectionByShowOrder(*collection, 3) == *image2);
-            CHECK(*db.SelectPreviousImageInCollectionByShowOrder(*collection, 4) == *image3);
+            CHECK(!db.SelectPreviousImageInCollectionByShowOrder(*collection, DATABASE_SHOW_ORDER_GAP));
+            CHECK(*db.SelectPreviousImageInCollectionByShowOrder(*collection, 2 * DATABASE_SHOW_ORDER_GAP) == *image1);
+            CHECK(*db.SelectPreviousImageInCollectionByShowOrder(*collection, 3 * DATABASE_SHOW_ORDER_GAP) == *image2);
+            CHECK(*db.SelectPreviousImageInCollectionByShowOrder(*collection, 3 * DATABASE_SHOW_ORDER_GAP + 1) ==
+                  *image3);
         }
     }
 }
@@ -487,6 +492,47 @@ TEST_CASE("Directly using database for tag creating", "[db][tags]")
         CHECK(!db.SelectTagByAliasAG("test"));
     }
 
+    SECTION("Name or alias lookups see changes right away")
+    {
+        // Builds the dictionary before the changes
+        CHECK(db.SelectTagByNameOrAlias("captions"));
+        CHECK(!db.SelectTagByNameOrAlias("test tag"));
+
+        auto tag = db.InsertTag("test tag", "tag for testing", TAG_CATEGORY::META, false);
+
+        REQUIRE(tag);
+
+        CHECK(db.SelectTagByNameOrAlias("test tag") == tag);
+        CHECK(db.SelectTagByNameOrAlias("Test Tag") == tag);
+
+        tag->AddAlias("tt");
+
+        CHECK(db.SelectTagByNameOrAlias("tt") == tag);
+
+        tag->SetName("renamed tag");
+        tag->Save();
+
+        CHECK(!db.SelectTagByNameOrAlias("test tag"));
+        CHECK(db.SelectTagByNameOrAlias("renamed tag") == tag);
+
+        tag->RemoveAlias("tt");
+
+        CHECK(!db.SelectTagByNameOrAlias("tt"));
+    }
+
+    SECTION("Break rules and super aliases are found from the dictionary")
+    {
+        db.BuildTagDictionaryAG();
+
+        const auto exact = db.SelectTagBreakRuleByStr("*grab");
+        REQUIRE(exact);
+        CHECK(db.SelectTagBreakRuleByStr("grab") == exact);
+        CHECK(!db.SelectTagBreakRuleByStr("grabs"));
+
+        CHECK(db.SelectTagSuperAlias("Redhead") == "red hair");
+        CHECK(db.SelectTagSuperAlias("red hair").empty());
+    }
+
 
     SECTION("Tag with imply")
     {
@@ -1179,6 +1225,24 @@ TEST_CASE("Tag suggestions", "[db][tags]")
                   "white captions in black watermark") != suggestions.end());
     }
 
+    SECTION("Suggestions from the index")
+    {
+        std::vector<std::string> result;
+        db.SelectTagSuggestions(result, "grab", 10);
+
+        // Break rules are matched without the wildcard
+        CHECK(std::find(result.begin(), result.end(), "*grab") != result.end());
+
+        result.clear();
+        db.SelectTagSuggestions(result, "zebra stri", 10);
+        CHECK(result.empty());
+
+        db.InsertTag("zebra stripes", "", TAG_CATEGORY::DESCRIBE_CHARACTER_OBJECT, false);
+
+        db.SelectTagSuggestions(result, "Zebra Stri", 10);
+        CHECK(result == std::vector<std::string>{"zebra stripes"});
+    }
+
     // When there are tags like "humanoid figure" and "figure head" completion shouldn't
     // include "humanoid figure head"
     SECTION("Multi word tag doesn't complete extra stuff")
@@ -1238,3 +1302,110 @@ TEST_CASE("Tag suggestions", "[db][tags]")
         }
     }
 }
+
+//! \brief Removes the database files of the read connection tests
+void RemoveReadConnectionTestFiles()
+{
+    for (const auto* file :
+        {"test_read_connections.sqlite", "test_read_connections.sqlite-wal", "test_read_connections.sqlite-shm",
+            "test_read_connections_picture_signatures.sqlite",
+            "test_read_connections_picture_signatures.sqlite-wal",
+            "test_read_connections_picture_signatures.sqlite-shm"})
+    {
+        boost::filesystem::remove(file);
+    }
+}
+
+TEST_CASE("Read connections see a consistent snapshot", "[db][read]")
+{
+    RemoveReadConnectionTestFiles();
+
+    {
+        std::unique_ptr<Database> dbptr(new TestDatabase("test_read_connections.sqlite"));
+        DummyDualView dv(std::move(dbptr));
+        auto& db = static_cast<TestDatabase&>(dv.GetDatabase());
+
+        REQUIRE_NOTHROW(db.Init());
+        REQUIRE_NOTHROW(db.OpenReadConnections(2));
+        CHECK(db.GetReadConnectionCount() == 2);
+
+        REQUIRE(db.InsertTestImage("image1.jpg", "hash1"));
+
+        SECTION("Writes committed after the first read are not seen")
+        {
+            auto reader = db.AcquireReadLock();
+            REQUIRE(reader.IsPooled());
+
+            CHECK(db.SelectImageCount(reader) == 1);
+
+            REQUIRE(db.InsertTestImage("image2.jpg", "hash2"));
+
+            CHECK(db.SelectImageCount(reader) == 1);
+
+            std::vector<ImagePath> paths;
+            db.SelectImagePaths(reader, paths, 0);
+            CHECK(paths.size() == 1);
+
+            // Another reader sees the new image
+            CHECK(db.SelectImageCountAG() == 2);
+        }
+
+        SECTION("Uncommitted writes are not seen")
+        {
+            GUARD_LOCK_OTHER(db);
+
+            DoDBTransaction transaction(db, guard);
+
+            REQUIRE(db.InsertTestImage(guard, "image2.jpg", "hash2"));
+
+            // Reading through the main connection sees the transaction
+            DatabaseReadLock mainReader(db, guard);
+            CHECK(!mainReader.IsPooled());
+            CHECK(db.SelectImageCount(mainReader) == 2);
+
+            CHECK(db.SelectImageCountAG() == 1);
+        }
+
+        SECTION("Reads don't wait for the database lock")
+        {
+            GUARD_LOCK_OTHER(db);
+
+            auto count = std::async(std::launch::async, [&db]() { return db.SelectImageCountAG(); });
+
+            REQUIRE(count.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+            CHECK(count.get() == 1);
+        }
+
+        SECTION("Connections are reused")
+        {
+            for (int i = 0; i < 10; ++i)
+                CHECK(db.SelectImageCountAG() == 1);
+
+            auto reader1 = db.AcquireReadLock();
+            auto reader2 = db.AcquireReadLock();
+
+            CHECK(reader1.IsPooled());
+            CHECK(reader2.IsPooled());
+        }
+    }
+
+    RemoveReadConnectionTestFiles();
+}
+
+TEST_CASE("Reads use the main connection without read connections", "[db][read]")
+{
+    std::unique_ptr<Database> dbptr(new TestDatabase());
+    DummyDualView dv(std::move(dbptr));
+    auto& db = static_cast<TestDatabase&>(dv.GetDatabase());
+
+    REQUIRE_NOTHROW(db.Init());
+
+    CHECK(db.GetReadConnectionCount() == 0);
+    CHECK_THROWS_AS(db.OpenReadConnections(1), Leviathan::InvalidState);
+
+    REQUIRE(db.InsertTestImage("image1.jpg", "hash1"));
+
+    auto reader = db.AcquireReadLock();
+    CHECK(!reader.IsPooled());
+    CHECK(db.SelectImageCount(reader) == 1);
+}
@@ -14,6 +14,7 @@
 
 #include <Magick++.h>
 
+#include <cstring>
 #include <memory>
 #include <thread>
 
@@ -127,6 +128,201 @@ TEST_CASE("Gdk pixbuf creation works", "[image][gtk][.expensive]")
 
 
 
+//! \brief Checks that the whole frame and the row by row conversions give the same pixels
+void CheckConversionPathsMatch(Magick::Image& image)
+{
+    auto wholeFrame = LoadedImage::ConvertToPixbuf(image);
+    auto perRow = LoadedImage::ConvertToPixbuf(image, false);
+
+    REQUIRE(wholeFrame->get_width() == perRow->get_width());
+    REQUIRE(wholeFrame->get_height() == perRow->get_height());
+    REQUIRE(wholeFrame->get_rowstride() == perRow->get_rowstride());
+    REQUIRE(wholeFrame->get_n_channels() == perRow->get_n_channels());
+
+    const auto rowBytes = static_cast<size_t>(wholeFrame->get_width() * wholeFrame->get_n_channels());
+
+    for(int y = 0; y < wholeFrame->get_height(); ++y) {
+
+        const auto offset = static_cast<size_t>(y) * wholeFrame->get_rowstride();
+
+        if(std::memcmp(wholeFrame->get_pixels() + offset, perRow->get_pixels() + offset, rowBytes) != 0) {
+            INFO("Row " << y << " differs");
+            REQUIRE(false);
+        }
+    }
+}
+
+TEST_CASE("Whole frame pixbuf conversion matches the row by row one", "[image][gtk]")
+{
+    GetGtkFixture();
+
+    std::shared_ptr<std::vector<Magick::Image>> loaded;
+    REQUIRE_NOTHROW(LoadedImage::LoadImage("data/7c2c2141cf27cb90620f80400c6bc3c4.jpg", loaded));
+
+    Magick::Image image = loaded->front();
+    REQUIRE(!image.alpha());
+
+    SECTION("RGB with padded rows")
+    {
+        // 914 * 3 isn't a multiple of 4 so this uses the row by row path
+        REQUIRE(image.columns() == 914);
+        CheckConversionPathsMatch(image);
+    }
+
+    SECTION("RGB without padding")
+    {
+        image.crop(Magick::Geometry(912, image.rows(), 0, 0));
+        image.page(Magick::Geometry(0, 0));
+
+        REQUIRE(image.columns() * 3 % 4 == 0);
+        CheckConversionPathsMatch(image);
+    }
+
+    SECTION("RGBA")
+    {
+        image.alpha(true);
+        REQUIRE(image.alpha());
+
+        CheckConversionPathsMatch(image);
+    }
+
+    SECTION("Animated RGBA frames")
+    {
+        REQUIRE_NOTHROW(LoadedImage::LoadImage("data/bird bathing.gif", loaded));
+
+        for(auto& frame : *loaded) {
+            frame.alpha(true);
+            CheckConversionPathsMatch(frame);
+        }
+    }
+}
+
+//! \brief Exposes the loading functions CacheManager uses to set the image
+class PyramidTestImage : public LoadedImage {
+public:
+    PyramidTestImage() : LoadedImage("pyramid test") {}
+
+    using LoadedImage::_BuildPyramid;
+    using LoadedImage::OnLoadSuccess;
+    using LoadedImage::UnloadImage;
+};
+
+std::shared_ptr<std::vector<Magick::Image>> CreateTestFrames(size_t width, size_t height, size_t frames = 1)
+{
+    auto image = std::make_shared<std::vector<Magick::Image>>();
+
+    for(size_t i = 0; i < frames; ++i)
+        image->emplace_back(Magick::Geometry(width, height), Magick::Color("red"));
+
+    return image;
+}
+
+TEST_CASE("Downscaled copies are made of big single frame images", "[image][gtk]")
+{
+    GetGtkFixture();
+
+    CHECK(LoadedImage::WantsPyramid(*CreateTestFrames(4000, 3000)));
+    CHECK(LoadedImage::WantsPyramid(*CreateTestFrames(1000, PYRAMID_IMAGE_THRESHOLD)));
+
+    SECTION("Below the threshold")
+    {
+        CHECK(!LoadedImage::WantsPyramid(*CreateTestFrames(PYRAMID_IMAGE_THRESHOLD - 1, 1000)));
+    }
+
+    SECTION("Animated")
+    {
+        CHECK(!LoadedImage::WantsPyramid(*CreateTestFrames(4000, 3000, 2)));
+    }
+
+    SECTION("Small images don't get copies when requested")
+    {
+        DummyDualView dualview;
+
+        auto image = std::make_shared<PyramidTestImage>();
+        image->OnLoadSuccess(CreateTestFrames(800, 600));
+
+        image->RequestPyramid();
+
+        CHECK(!image->GetPyramidLevel(0.1f));
+    }
+}
+
+TEST_CASE("Downscaled copies are halved until they are small", "[image][gtk]")
+{
+    GetGtkFixture();
+
+    const auto frames = CreateTestFrames(4000, 3000);
+    const auto levels = LoadedImage::CreatePyramidLevels(frames->front());
+
+    // 500x375 would be smaller than PYRAMID_SMALLEST_LEVEL
+    REQUIRE(levels.size() == 2);
+
+    CHECK(levels[0]->get_width() == 2000);
+    CHECK(levels[0]->get_height() == 1500);
+    CHECK(levels[1]->get_width() == 1000);
+    CHECK(levels[1]->get_height() == 750);
+}
+
+TEST_CASE("Smallest downscaled copy with enough detail is picked", "[image][gtk]")
+{
+    GetGtkFixture();
+
+    const auto frames = CreateTestFrames(4000, 3000);
+
+    auto image = std::make_shared<PyramidTestImage>();
+    image->OnLoadSuccess(frames);
+
+    const auto sizeBefore = image->GetDecodedSize();
+
+    CHECK(!image->GetPyramidLevel(0.1f));
+
+    REQUIRE(image->_BuildPyramid(frames));
+
+    SECTION("Levels are picked by the needed width")
+    {
+        CHECK(!image->GetPyramidLevel(1.f));
+        CHECK(!image->GetPyramidLevel(0.6f));
+
+        // 4000 * 0.5 is exactly the first level
+        REQUIRE(image->GetPyramidLevel(0.5f));
+        CHECK(image->GetPyramidLevel(0.5f)->get_width() == 2000);
+
+        REQUIRE(image->GetPyramidLevel(0.3f));
+        CHECK(image->GetPyramidLevel(0.3f)->get_width() == 2000);
+
+        REQUIRE(image->GetPyramidLevel(0.25f));
+        CHECK(image->GetPyramidLevel(0.25f)->get_width() == 1000);
+
+        // Nothing smaller than the smallest level
+        REQUIRE(image->GetPyramidLevel(0.01f));
+        CHECK(image->GetPyramidLevel(0.01f)->get_width() == 1000);
+    }
+
+    SECTION("Decoded size includes the copies")
+    {
+        CHECK(image->GetDecodedSize() ==
+              sizeBefore + image->GetPyramidLevel(0.5f)->get_byte_length() +
+                  image->GetPyramidLevel(0.25f)->get_byte_length());
+    }
+
+    SECTION("Unloading releases the copies")
+    {
+        image->UnloadImage();
+
+        CHECK(!image->GetPyramidLevel(0.25f));
+        CHECK(image->GetDecodedSize() == 0);
+    }
+
+    SECTION("Copies of an unloaded image are discarded")
+    {
+        image->UnloadImage();
+
+        CHECK(!image->_BuildPyramid(frames));
+        CHECK(!image->GetPyramidLevel(0.25f));
+    }
+}
+
+
 TEST_CASE("Basic SuperContainer operations", "[components][gtk][.expensive]")
 {
     GetGtkFixture();
@@ -160,6 +356,66 @@ TEST_CASE("Basic SuperContainer operations", "[components][gtk][.expensive]")
 }
 
 
+TEST_CASE("Virtualized SuperContainer only creates visible widgets", "[components][gtk][.expensive]")
+{
+    GetGtkFixture();
+    DV::DummyDualView dualview;
+
+    Gtk::Window window;
+
+    DV::SuperContainer container;
+    container.SetVirtualized(true);
+
+    window.add(container);
+    window.show();
+
+    container.set_size_request(700, 500);
+
+    container.show();
+
+    auto image = DV::Image::Create("data/7c2c2141cf27cb90620f80400c6bc3c4.jpg");
+
+    std::vector<std::shared_ptr<DV::Image>> images(5000, image);
+
+    auto selectable = std::make_shared<DV::ItemSelectable>([](DV::ListItem& item) {});
+
+    container.SetShownItems(images.begin(), images.end(), selectable);
+
+    CHECK(container.CountItems() == images.size());
+    CHECK(container.CountRows() > 1);
+    CHECK(container.CountCreatedWidgets() > 0);
+    CHECK(container.CountCreatedWidgets() < 200);
+
+    SECTION("Selection is kept for items without widgets")
+    {
+        container.SelectAllItems();
+        CHECK(container.CountSelectedItems() == images.size());
+
+        container.DeselectFirstItem();
+        CHECK(container.CountSelectedItems() == images.size() - 1);
+
+        container.DeselectAllItems();
+        CHECK(container.CountSelectedItems() == 0);
+    }
+
+    SECTION("Scrolling reuses widgets")
+    {
+        const auto created = container.CountCreatedWidgets();
+
+        container.get_vadjustment()->set_upper(1000000);
+        container.get_vadjustment()->set_value(20000);
+
+        CHECK(container.CountCreatedWidgets() <= created * 2);
+    }
+
+    SECTION("Items can be replaced")
+    {
+        container.SetShownItems(images.begin(), images.begin() + 10, selectable);
+        CHECK(container.CountItems() == 10);
+        CHECK(container.CountCreatedWidgets() < 200);
+    }
+}
+
 TEST_CASE(
     "Creating collections and importing image", "[full][integration][.expensive][db][gtk]")
 {
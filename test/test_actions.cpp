@@ -393,6 +393,51 @@ TEST_CASE("Image removal from a collection can be undone", "[db][action]")
     }
 }
 
+TEST_CASE("Image removal from a collection can be undone after renumbering", "[db][action]")
+{
+    DummyDualView dv;
+    TestDatabase db;
+
+    REQUIRE_NOTHROW(db.Init());
+
+    auto collection = db.InsertCollectionAG("test collection", false);
+    REQUIRE(collection);
+
+    std::vector<std::shared_ptr<Image>> images;
+
+    for (int i = 0; i < 5; ++i)
+    {
+        auto image = db.InsertTestImage("image" + std::to_string(i), "hash" + std::to_string(i));
+        REQUIRE(image);
+        REQUIRE(collection->AddImage(image));
+        images.push_back(image);
+    }
+
+    auto undo = db.DeleteImagesFromCollection(*collection, {images[3]});
+    REQUIRE(undo);
+
+    // Inserting to the same gap until it runs out renumbers the collection
+    std::vector<std::shared_ptr<Image>> inserted;
+
+    for (int i = 0; i < 12; ++i)
+    {
+        auto image = db.InsertTestImage("inserted" + std::to_string(i), "hashinserted" + std::to_string(i));
+        REQUIRE(image);
+        REQUIRE(db.InsertImageToCollectionAG(*collection, *image, collection->GetImageShowOrder(images[1])));
+        inserted.push_back(image);
+    }
+
+    CHECK(collection->GetImageShowOrder(images[4]) != 5 * DATABASE_SHOW_ORDER_GAP);
+
+    CHECK(undo->Undo());
+
+    std::vector<std::shared_ptr<Image>> expected = {images[0]};
+    expected.insert(expected.end(), inserted.begin(), inserted.end());
+    expected.insert(expected.end(), images.begin() + 1, images.end());
+
+    CHECK(collection->GetImages() == expected);
+}
+
 TEST_CASE("Collection reorder can be undone", "[db][action]")
 {
     DummyDualView dv;
@@ -441,6 +486,187 @@ TEST_CASE("Collection reorder can be undone", "[db][action]")
 
         CHECK(collection->GetImages() == std::vector<std::shared_ptr<Image>>{image1, image2});
     }
+
+    SECTION("only the moved image is stored")
+    {
+        auto reorder = std::dynamic_pointer_cast<CollectionReorderAction>(undo);
+        REQUIRE(reorder);
+
+        CHECK(reorder->GetNewOrder().empty());
+        REQUIRE(reorder->GetMoves().size() == 1);
+        CHECK(reorder->GetMoves()[0].Image == image2->GetID());
+        CHECK(reorder->GetMoves()[0].OldOrder == 2 * DATABASE_SHOW_ORDER_GAP);
+    }
+
+    SECTION("redo after undo applies the moves")
+    {
+        CHECK(undo->Undo());
+        CHECK(undo->Redo());
+
+        CHECK(collection->GetImages() == std::vector<std::shared_ptr<Image>>{image2, image1});
+
+        CHECK(undo->Undo());
+        CHECK(collection->GetImages() == std::vector<std::shared_ptr<Image>>{image1, image2});
+    }
+
+    SECTION("images added after are kept at the end on undo")
+    {
+        auto image3 = db.InsertTestImage("image3", "hash3");
+        REQUIRE(image3);
+        REQUIRE(collection->AddImage(image3));
+
+        CHECK(undo->Undo());
+
+        CHECK(collection->GetImages() == std::vector<std::shared_ptr<Image>>{image1, image2, image3});
+    }
+}
+
+TEST_CASE("Collection reorder can be undone after renumbering", "[db][action]")
+{
+    DummyDualView dv;
+    TestDatabase db;
+
+    REQUIRE_NOTHROW(db.Init());
+
+    auto collection = db.InsertCollectionAG("test collection", false);
+    REQUIRE(collection);
+
+    std::vector<std::shared_ptr<Image>> images;
+
+    for (int i = 0; i < 5; ++i)
+    {
+        auto image = db.InsertTestImage("image" + std::to_string(i), "hash" + std::to_string(i));
+        REQUIRE(image);
+        REQUIRE(collection->AddImage(image));
+        images.push_back(image);
+    }
+
+    const std::vector<std::shared_ptr<Image>> moved = {images[4], images[0], images[1], images[2], images[3]};
+
+    auto undo = db.UpdateCollectionImagesOrder(*collection, moved);
+    REQUIRE(undo);
+
+    CHECK(collection->GetImages() == moved);
+
+    // Inserting to the same gap until it runs out renumbers the collection
+    std::vector<std::shared_ptr<Image>> inserted;
+
+    const auto insertUntilRenumbered = [&]()
+    {
+        const auto lastOrder = db.SelectImageIDsAndShowOrderInCollection(*collection).back();
+
+        for (int i = 0; i < 12; ++i)
+        {
+            auto image = db.InsertTestImage("inserted" + std::to_string(i), "hashinserted" + std::to_string(i));
+            REQUIRE(image);
+            REQUIRE(db.InsertImageToCollectionAG(*collection, *image, collection->GetImageShowOrder(images[2])));
+            inserted.push_back(image);
+        }
+
+        REQUIRE(db.SelectImageIDsAndShowOrderInCollection(*collection).back() != lastOrder);
+    };
+
+    const auto withInserted = [&](std::vector<std::shared_ptr<Image>> order)
+    {
+        order.insert(std::find(order.begin(), order.end(), images[2]), inserted.begin(), inserted.end());
+        return order;
+    };
+
+    SECTION("undo")
+    {
+        insertUntilRenumbered();
+
+        CHECK(undo->Undo());
+        CHECK(collection->GetImages() == withInserted(images));
+
+        CHECK(undo->Redo());
+        CHECK(collection->GetImages() == withInserted(moved));
+    }
+
+    SECTION("redo")
+    {
+        CHECK(undo->Undo());
+        CHECK(collection->GetImages() == images);
+
+        insertUntilRenumbered();
+
+        CHECK(undo->Redo());
+        CHECK(collection->GetImages() == withInserted(moved));
+
+        CHECK(undo->Undo());
+        CHECK(collection->GetImages() == withInserted(images));
+    }
+
+    SECTION("after loading from DB")
+    {
+        insertUntilRenumbered();
+
+        const auto id = undo->GetID();
+        undo.reset();
+
+        undo = db.SelectDatabaseActionByIDAG(id);
+        REQUIRE(undo);
+
+        CHECK(undo->Undo());
+        CHECK(collection->GetImages() == withInserted(images));
+    }
+}
+
+TEST_CASE("Collection reorder in the old format is converted to moves", "[db][action]")
+{
+    DummyDualView dv;
+    TestDatabase db;
+
+    REQUIRE_NOTHROW(db.Init());
+
+    auto image1 = db.InsertTestImage("image1", "hash1");
+    REQUIRE(image1);
+
+    auto image2 = db.InsertTestImage("image2", "hash2");
+    REQUIRE(image2);
+
+    auto image3 = db.InsertTestImage("image3", "hash3");
+    REQUIRE(image3);
+
+    auto collection = db.InsertCollectionAG("test collection", false);
+    REQUIRE(collection);
+
+    collection->AddImage(image1);
+    collection->AddImage(image2);
+    collection->AddImage(image3);
+
+    // Old format reorder that moved image3 first, before the show_orders had gaps
+    const auto id1 = std::to_string(image1->GetID());
+    const auto id2 = std::to_string(image2->GetID());
+    const auto id3 = std::to_string(image3->GetID());
+
+    const auto json = "{\"new_order\":[" + id3 + "," + id1 + "," + id2 + "],\"old_order\":[{\"image\":" + id1 +
+                      ",\"order\":1},{\"image\":" + id2 + ",\"order\":2},{\"image\":" + id3 +
+                      ",\"order\":3}],\"target\":" + std::to_string(collection->GetID()) + "}";
+
+    {
+        GUARD_LOCK_OTHER(db);
+        db.RunSQLAsPrepared(guard,
+            "INSERT INTO action_history (type, performed, json_data, description) VALUES (?1, 1, ?2, '');",
+            static_cast<int>(DATABASE_ACTION_TYPE::CollectionReorder), json);
+    }
+
+    const auto actions = db.SelectLatestDatabaseActions("", 1);
+    REQUIRE(actions.size() == 1);
+
+    auto reorder = std::dynamic_pointer_cast<CollectionReorderAction>(actions[0]);
+    REQUIRE(reorder);
+
+    CHECK(reorder->GetMoves() ==
+          std::vector<ShowOrderMove>{{image3->GetID(), 3 * DATABASE_SHOW_ORDER_GAP, 1 * DATABASE_SHOW_ORDER_GAP},
+              {image1->GetID(), 1 * DATABASE_SHOW_ORDER_GAP, 2 * DATABASE_SHOW_ORDER_GAP},
+              {image2->GetID(), 2 * DATABASE_SHOW_ORDER_GAP, 3 * DATABASE_SHOW_ORDER_GAP}});
+
+    CHECK(reorder->Redo());
+    CHECK(collection->GetImages() == std::vector<std::shared_ptr<Image>>{image3, image1, image2});
+
+    CHECK(reorder->Undo());
+    CHECK(collection->GetImages() == std::vector<std::shared_ptr<Image>>{image1, image2, image3});
 }
 
 TEST_CASE("NetGallery delete works", "[db][action]")
@@ -4,6 +4,7 @@
 #include "resources/DatabaseAction.h"
 
 #include "DummyLog.h"
+#include "ShowOrder.h"
 #include "TestDatabase.h"
 #include "TestDualView.h"
 
@@ -316,3 +317,310 @@ TEST_CASE("Collection delete with collection no longer in memory works", "[colle
         CHECK(!collection);
     }
 }
+
+TEST_CASE("Collection images are loaded in show order", "[collection][db]")
+{
+    DummyDualView dv;
+    TestDatabase db;
+
+    REQUIRE_NOTHROW(db.Init());
+
+    auto collection = db.InsertCollectionAG("Collection 1", false);
+    REQUIRE(collection);
+
+    std::vector<std::shared_ptr<Image>> images;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        auto image =
+            db.InsertTestImage("image" + std::to_string(i), "hash" + std::to_string(i));
+        REQUIRE(image);
+
+        REQUIRE(db.InsertImageToCollectionAG(collection->GetID(), *image, i + 1));
+        images.push_back(image);
+    }
+
+    {
+        // Inserting to a taken show order doesn't keep the order shared so the shared values are
+        // set directly
+        GUARD_LOCK_OTHER(db);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            // Some images share a show order
+            REQUIRE(db.UpdateCollectionImageShowOrder(guard, collection->GetID(), images[i]->GetID(), 10 - i / 2));
+        }
+    }
+
+    // Expected order is by show order and then by id
+    const std::vector<std::shared_ptr<Image>> expected = {images[8], images[9], images[6],
+        images[7], images[4], images[5], images[2], images[3], images[0], images[1]};
+
+    CHECK(collection->GetImages() == expected);
+
+    SECTION("Limit returns the first images")
+    {
+        CHECK(collection->GetImages(3) ==
+              std::vector<std::shared_ptr<Image>>{images[8], images[9], images[6]});
+    }
+
+    SECTION("Deleted images are skipped")
+    {
+        REQUIRE(db.DeleteImage(*images[6]));
+        REQUIRE(db.DeleteImage(*images[0]));
+
+        CHECK(collection->GetImages() ==
+              std::vector<std::shared_ptr<Image>>{images[8], images[9], images[7], images[4],
+                  images[5], images[2], images[3], images[1]});
+
+        CHECK(db.SelectFirstImageInCollectionAG(*collection) == images[8]);
+        CHECK(db.SelectLastImageInCollectionAG(*collection) == images[1]);
+        CHECK(db.SelectNextImageInCollectionByShowOrder(*collection, 6) == images[7]);
+        CHECK(db.SelectPreviousImageInCollectionByShowOrder(*collection, 7) == images[9]);
+
+        GUARD_LOCK_OTHER(db);
+        CHECK(db.SelectImagesInCollectionByShowOrder(guard, *collection, 8) ==
+              std::vector<std::shared_ptr<Image>>{images[4], images[5]});
+    }
+
+    SECTION("Paged loading returns the same images")
+    {
+        for (const int pageSize : {1, 3, 10, 100})
+        {
+            std::vector<std::shared_ptr<Image>> loaded;
+            int pages = 0;
+
+            collection->GetImagesPaged(pageSize, [&](std::vector<std::shared_ptr<Image>>& page) {
+                CHECK(page.size() <= static_cast<size_t>(pageSize));
+                loaded.insert(loaded.end(), page.begin(), page.end());
+                ++pages;
+                return true;
+            });
+
+            CHECK(loaded == expected);
+            CHECK(pages == (10 + pageSize - 1) / pageSize);
+        }
+    }
+
+    SECTION("Paged loading can be stopped")
+    {
+        int pages = 0;
+
+        collection->GetImagesPaged(2, [&](std::vector<std::shared_ptr<Image>>& page) {
+            ++pages;
+            return pages < 2;
+        });
+
+        CHECK(pages == 2);
+    }
+}
+
+TEST_CASE("Show order between picks a value in the gap", "[collection]")
+{
+    CHECK(ShowOrderBetween(std::nullopt, std::nullopt) == DATABASE_SHOW_ORDER_GAP);
+    CHECK(ShowOrderBetween(2048, std::nullopt) == 2048 + DATABASE_SHOW_ORDER_GAP);
+    CHECK(ShowOrderBetween(1024, 2048) == 1536);
+    CHECK(ShowOrderBetween(std::nullopt, 1024) == 512);
+    CHECK(ShowOrderBetween(10, 12) == 11);
+
+    SECTION("No space")
+    {
+        CHECK(!ShowOrderBetween(10, 11));
+        CHECK(!ShowOrderBetween(10, 10));
+        CHECK(!ShowOrderBetween(std::nullopt, 1));
+    }
+}
+
+TEST_CASE("Show order changes only move the out of order images", "[collection]")
+{
+    std::vector<ImageShowOrder> changes;
+
+    SECTION("Already in order")
+    {
+        CHECK(CalculateShowOrderChanges({{1, 1024}, {2, 2048}, {3, 3072}}, changes));
+        CHECK(changes.empty());
+    }
+
+    SECTION("Moving one image to the start")
+    {
+        CHECK(CalculateShowOrderChanges({{3, 3072}, {1, 1024}, {2, 2048}, {4, 4096}}, changes));
+        CHECK(changes == std::vector<ImageShowOrder>{{3, 512}});
+    }
+
+    SECTION("Moving one image to the middle")
+    {
+        CHECK(CalculateShowOrderChanges({{1, 1024}, {4, 4096}, {2, 2048}, {3, 3072}}, changes));
+        CHECK(changes == std::vector<ImageShowOrder>{{4, 1536}});
+    }
+
+    SECTION("Moving one image to the end")
+    {
+        CHECK(CalculateShowOrderChanges({{2, 2048}, {3, 3072}, {1, 1024}}, changes));
+        CHECK(changes == std::vector<ImageShowOrder>{{1, 3072 + DATABASE_SHOW_ORDER_GAP}});
+    }
+
+    SECTION("Multiple images in the same gap")
+    {
+        CHECK(CalculateShowOrderChanges(
+            {{1, 1000}, {5, 5000}, {6, 6000}, {2, 2000}, {3, 3000}, {4, 4000}, {7, 7000}}, changes));
+        CHECK(changes == std::vector<ImageShowOrder>{{5, 1333}, {6, 1666}});
+    }
+
+    SECTION("Too small gap")
+    {
+        CHECK(!CalculateShowOrderChanges({{1, 1}, {3, 3}, {2, 2}}, changes));
+
+        changes.clear();
+        CalculateEvenShowOrders({{1, 1}, {3, 3}, {2, 2}}, changes);
+        CHECK(changes == std::vector<ImageShowOrder>{{1, DATABASE_SHOW_ORDER_GAP},
+                             {3, 2 * DATABASE_SHOW_ORDER_GAP}, {2, 3 * DATABASE_SHOW_ORDER_GAP}});
+    }
+}
+
+TEST_CASE("Show order moves survive encoding", "[collection]")
+{
+    const std::vector<ShowOrderMove> moves = {{15, 5 * DATABASE_SHOW_ORDER_GAP, 512},
+        {16, 6 * DATABASE_SHOW_ORDER_GAP, 640}, {3, 1024, 768}, {1ll << 40, -1, 1ll << 50}};
+
+    const auto encoded = EncodeShowOrderMoves(moves);
+
+    // The small differences take one or two bytes each
+    CHECK(EncodeShowOrderMoves({moves[0], moves[1], moves[2]}).size() < 20);
+
+    std::vector<ShowOrderMove> decoded;
+    REQUIRE(DecodeShowOrderMoves(encoded, decoded));
+    CHECK(decoded == moves);
+
+    SECTION("Empty")
+    {
+        decoded.clear();
+        REQUIRE(DecodeShowOrderMoves(EncodeShowOrderMoves({}), decoded));
+        CHECK(decoded.empty());
+    }
+
+    SECTION("Invalid data is detected")
+    {
+        CHECK(!DecodeShowOrderMoves("", decoded));
+        CHECK(!DecodeShowOrderMoves(encoded.substr(0, encoded.size() - 1), decoded));
+        CHECK(!DecodeShowOrderMoves(encoded + "a", decoded));
+        CHECK(!DecodeShowOrderMoves("\x02" + encoded.substr(1), decoded));
+    }
+}
+
+TEST_CASE("Stored show orders are moved along when renumbering", "[collection]")
+{
+    const std::vector<ImageShowOrder> before = {{1, 10}, {2, 11}, {3, 5000}};
+
+    CHECK(TranslateRenumberedShowOrder(before, 11) == 2 * DATABASE_SHOW_ORDER_GAP);
+    CHECK(TranslateRenumberedShowOrder(before, 5000) == 3 * DATABASE_SHOW_ORDER_GAP);
+
+    SECTION("Between images")
+    {
+        const auto translated = TranslateRenumberedShowOrder(before, 2500);
+        CHECK(translated > 2 * DATABASE_SHOW_ORDER_GAP);
+        CHECK(translated < 3 * DATABASE_SHOW_ORDER_GAP);
+
+        CHECK(TranslateRenumberedShowOrder(before, 2500) < TranslateRenumberedShowOrder(before, 2600));
+    }
+
+    SECTION("Before the first and after the last image")
+    {
+        CHECK(TranslateRenumberedShowOrder(before, 5) == DATABASE_SHOW_ORDER_GAP / 2);
+        CHECK(TranslateRenumberedShowOrder(before, 5100) == 3 * DATABASE_SHOW_ORDER_GAP + 100);
+    }
+
+    SECTION("Shrunk gap doesn't round onto the images")
+    {
+        const std::vector<ImageShowOrder> large = {{1, 1024}, {2, 1000000}};
+
+        CHECK(TranslateRenumberedShowOrder(large, 1025) == DATABASE_SHOW_ORDER_GAP + 1);
+        CHECK(TranslateRenumberedShowOrder(large, 999999) == 2 * DATABASE_SHOW_ORDER_GAP - 1);
+    }
+
+    SECTION("Empty collection")
+    {
+        CHECK(TranslateRenumberedShowOrder({}, 100) == 100);
+    }
+}
+
+TEST_CASE("Collection show orders leave the other images alone", "[collection][db]")
+{
+    DummyDualView dv;
+    TestDatabase db;
+
+    REQUIRE_NOTHROW(db.Init());
+
+    auto collection = db.InsertCollectionAG("Collection 1", false);
+    REQUIRE(collection);
+
+    std::vector<std::shared_ptr<Image>> images;
+
+    for (int i = 0; i < 5; ++i)
+    {
+        auto image = db.InsertTestImage("image" + std::to_string(i), "hash" + std::to_string(i));
+        REQUIRE(image);
+        REQUIRE(collection->AddImage(image));
+        images.push_back(image);
+    }
+
+    const auto originalOrders = db.SelectImageIDsAndShowOrderInCollection(*collection);
+    REQUIRE(originalOrders.size() == 5);
+
+    SECTION("Inserting to a taken show order")
+    {
+        auto image = db.InsertTestImage("inserted", "hashinserted");
+        REQUIRE(image);
+
+        REQUIRE(db.InsertImageToCollectionAG(*collection, *image, collection->GetImageShowOrder(images[2])));
+
+        CHECK(collection->GetImages() == std::vector<std::shared_ptr<Image>>{
+                                             images[0], images[1], image, images[2], images[3], images[4]});
+
+        for (const auto& [id, order] : originalOrders)
+            CHECK(db.SelectImageShowOrderInCollectionAG(collection->GetID(), id) == order);
+    }
+
+    SECTION("Moving a single image changes one show order")
+    {
+        const std::vector<std::shared_ptr<Image>> moved = {images[0], images[3], images[1], images[2], images[4]};
+
+        auto undo = db.UpdateCollectionImagesOrder(*collection, moved);
+        REQUIRE(undo);
+
+        CHECK(collection->GetImages() == moved);
+
+        int changed = 0;
+
+        for (const auto& [id, order] : originalOrders)
+        {
+            if (db.SelectImageShowOrderInCollectionAG(collection->GetID(), id) != order)
+                ++changed;
+        }
+
+        CHECK(changed == 1);
+
+        CHECK(undo->Undo());
+        CHECK(collection->GetImages() == images);
+        CHECK(db.SelectImageIDsAndShowOrderInCollection(*collection) == originalOrders);
+    }
+
+    SECTION("Running out of space renumbers the collection")
+    {
+        {
+            GUARD_LOCK_OTHER(db);
+
+            for (int i = 0; i < 5; ++i)
+                REQUIRE(db.UpdateCollectionImageShowOrder(guard, collection->GetID(), images[i]->GetID(), i + 1));
+        }
+
+        auto image = db.InsertTestImage("inserted", "hashinserted");
+        REQUIRE(image);
+
+        REQUIRE(db.InsertImageToCollectionAG(*collection, *image, 2));
+
+        CHECK(collection->GetImages() == std::vector<std::shared_ptr<Image>>{
+                                             images[0], image, images[1], images[2], images[3], images[4]});
+
+        CHECK(collection->GetImageShowOrder(images[4]) == 5 * DATABASE_SHOW_ORDER_GAP);
+    }
+}
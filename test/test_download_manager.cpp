@@ -0,0 +1,476 @@
+#include "catch.hpp"
+
+#include "DownloadManager.h"
+
+#include "TestDualView.h"
+
+#include "FileSystem.h"
+
+#include <boost/filesystem.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DV;
+
+//! \brief Minimal HTTP/1.1 server with keep-alive for testing downloads
+//!
+//! Requests to "/<milliseconds>/<name>" wait that long and respond with name as the body. The
+//! first request for a name starting with "flaky" fails with 503. Content set with SetContent is
+//! sent instead of the name. Keeps count of the connections and the most requests that were
+//! handled at once
+class LocalHTTPServer
+{
+public:
+    LocalHTTPServer()
+    {
+        ListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        REQUIRE(ListenSocket >= 0);
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+
+        REQUIRE(bind(ListenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+        REQUIRE(listen(ListenSocket, 32) == 0);
+
+        socklen_t length = sizeof(address);
+        REQUIRE(getsockname(ListenSocket, reinterpret_cast<sockaddr*>(&address), &length) == 0);
+        Port = ntohs(address.sin_port);
+
+        AcceptThread = std::thread(&LocalHTTPServer::_RunAccept, this);
+    }
+
+    ~LocalHTTPServer()
+    {
+        Quit = true;
+        AcceptThread.join();
+
+        for (auto& thread : ConnectionThreads)
+            thread.join();
+
+        close(ListenSocket);
+    }
+
+    void SetContent(const std::string& name, std::string data)
+    {
+        std::lock_guard<std::mutex> lock(ContentMutex);
+        Content[name] = std::move(data);
+    }
+
+    std::string GetURL(int delay, const std::string& name) const
+    {
+        return "http://127.0.0.1:" + std::to_string(Port) + "/" + std::to_string(delay) + "/" + name;
+    }
+
+    std::atomic<int> Connections{0};
+    std::atomic<int> Requests{0};
+    std::atomic<int> MaxConcurrentRequests{0};
+
+private:
+    void _RunAccept()
+    {
+        while (!Quit)
+        {
+            pollfd pollData{ListenSocket, POLLIN, 0};
+
+            if (poll(&pollData, 1, 50) <= 0)
+                continue;
+
+            const int client = accept(ListenSocket, nullptr, nullptr);
+
+            if (client < 0)
+                continue;
+
+            ++Connections;
+            ConnectionThreads.emplace_back(&LocalHTTPServer::_RunConnection, this, client);
+        }
+    }
+
+    void _RunConnection(int client)
+    {
+        std::string received;
+
+        while (!Quit)
+        {
+            const auto headerEnd = received.find("\r\n\r\n");
+
+            if (headerEnd != std::string::npos)
+            {
+                const auto request = received.substr(0, headerEnd);
+                received.erase(0, headerEnd + 4);
+
+                if (!_HandleRequest(client, request))
+                    break;
+
+                continue;
+            }
+
+            pollfd pollData{client, POLLIN, 0};
+
+            if (poll(&pollData, 1, 50) <= 0)
+                continue;
+
+            char buffer[1024];
+            const auto read = recv(client, buffer, sizeof(buffer), 0);
+
+            // Closed by curl
+            if (read <= 0)
+                break;
+
+            received.append(buffer, read);
+        }
+
+        close(client);
+    }
+
+    bool _HandleRequest(int client, const std::string& request)
+    {
+        // "GET /delay/name HTTP/1.1"
+        const auto pathStart = request.find(' ') + 1;
+        const auto path = request.substr(pathStart, request.find(' ', pathStart) - pathStart);
+
+        const auto nameStart = path.find('/', 1);
+
+        if (nameStart == std::string::npos)
+            return false;
+
+        const auto delay = std::stoi(path.substr(1, nameStart - 1));
+        const auto body = path.substr(nameStart + 1);
+
+        ++Requests;
+
+        const auto concurrent = ++RunningRequests;
+
+        int previous = MaxConcurrentRequests;
+        while (concurrent > previous && !MaxConcurrentRequests.compare_exchange_weak(previous, concurrent))
+        {
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+
+        --RunningRequests;
+
+        if (body.find("flaky") == 0 && _FailFirstTime(body))
+        {
+            const std::string response = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n";
+            return send(client, response.data(), response.size(), MSG_NOSIGNAL) ==
+                static_cast<ssize_t>(response.size());
+        }
+
+        const auto data = _GetContent(body);
+
+        const auto response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: " +
+            std::to_string(data.size()) + "\r\n\r\n" + data;
+
+        return send(client, response.data(), response.size(), MSG_NOSIGNAL) ==
+            static_cast<ssize_t>(response.size());
+    }
+
+    bool _FailFirstTime(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(FailedOnceMutex);
+        return FailedOnce.insert(name).second;
+    }
+
+    std::string _GetContent(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(ContentMutex);
+
+        const auto found = Content.find(name);
+        return found != Content.end() ? found->second : name;
+    }
+
+private:
+    int ListenSocket = -1;
+    int Port = 0;
+
+    std::atomic<bool> Quit{false};
+    std::atomic<int> RunningRequests{0};
+
+    std::mutex FailedOnceMutex;
+    std::set<std::string> FailedOnce;
+
+    std::mutex ContentMutex;
+    std::map<std::string, std::string> Content;
+
+    std::thread AcceptThread;
+
+    //! Only modified by AcceptThread
+    std::vector<std::thread> ConnectionThreads;
+};
+
+//! \brief Collects the order in which downloads finish
+class FinishedDownloads
+{
+public:
+    void Watch(DownloadJob& job)
+    {
+        job.SetFinishCallback([this](DownloadJob& finishedJob, bool success) {
+            std::lock_guard<std::mutex> lock(Mutex);
+
+            Order.push_back(finishedJob.GetDownloadedBytes());
+
+            if (!success)
+                ++Failures;
+
+            Notify.notify_all();
+            return true;
+        });
+    }
+
+    bool WaitFor(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(Mutex);
+        return Notify.wait_for(lock, std::chrono::seconds(30), [&]() { return Order.size() >= count; });
+    }
+
+    std::mutex Mutex;
+    std::condition_variable Notify;
+
+    std::vector<std::string> Order;
+    int Failures = 0;
+};
+
+TEST_CASE("DownloadManager runs downloads in parallel over reused connections", "[downloads]")
+{
+    DummyDualView dv;
+    LocalHTTPServer server;
+    FinishedDownloads finished;
+
+    constexpr auto count = 16;
+
+    std::vector<std::shared_ptr<MemoryDLJob>> jobs;
+
+    {
+        DownloadManager manager(4, 4);
+
+        for (int i = 0; i < count; ++i)
+        {
+            auto job = std::make_shared<MemoryDLJob>(
+                ProcessableURL(server.GetURL(50, "file" + std::to_string(i)), true));
+            finished.Watch(*job);
+
+            manager.QueueDownload(job);
+            jobs.push_back(job);
+        }
+
+        REQUIRE(finished.WaitFor(count));
+    }
+
+    CHECK(finished.Failures == 0);
+
+    for (int i = 0; i < count; ++i)
+    {
+        CHECK(jobs[i]->IsReady());
+        CHECK(jobs[i]->GetDownloadedBytes() == "file" + std::to_string(i));
+    }
+
+    CHECK(server.Requests == count);
+    CHECK(server.MaxConcurrentRequests > 1);
+    CHECK(server.MaxConcurrentRequests <= 4);
+
+    // Each parallel transfer keeps using its connection
+    CHECK(server.Connections <= 4);
+}
+
+TEST_CASE("DownloadManager limits downloads per host", "[downloads]")
+{
+    DummyDualView dv;
+    LocalHTTPServer server;
+    FinishedDownloads finished;
+
+    constexpr auto count = 10;
+
+    {
+        DownloadManager manager(8, 2);
+
+        for (int i = 0; i < count; ++i)
+        {
+            auto job = std::make_shared<MemoryDLJob>(ProcessableURL(server.GetURL(30, std::to_string(i)), true));
+            finished.Watch(*job);
+            manager.QueueDownload(job);
+        }
+
+        REQUIRE(finished.WaitFor(count));
+    }
+
+    CHECK(finished.Failures == 0);
+    CHECK(server.MaxConcurrentRequests <= 2);
+}
+
+TEST_CASE("DownloadManager starts downloads in priority order", "[downloads]")
+{
+    DummyDualView dv;
+    LocalHTTPServer server;
+    FinishedDownloads finished;
+
+    {
+        DownloadManager manager(1, 1);
+
+        // Keeps the only transfer slot busy while the rest are queued
+        auto blocking = std::make_shared<MemoryDLJob>(ProcessableURL(server.GetURL(300, "blocking"), true));
+        finished.Watch(*blocking);
+        manager.QueueDownload(blocking, 1);
+
+        // Wait for the download thread to pop it
+        const auto start = std::chrono::steady_clock::now();
+        while (manager.CountActiveDownloads() < 1 &&
+            std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        for (int i = 0; i < 4; ++i)
+        {
+            auto job = std::make_shared<MemoryDLJob>(ProcessableURL(server.GetURL(0, "low"), true));
+            finished.Watch(*job);
+            manager.QueueDownload(job, 10);
+        }
+
+        auto important = std::make_shared<MemoryDLJob>(ProcessableURL(server.GetURL(0, "high"), true));
+        finished.Watch(*important);
+        manager.QueueDownload(important, 1000);
+
+        REQUIRE(finished.WaitFor(6));
+    }
+
+    REQUIRE(finished.Order.size() == 6);
+    CHECK(finished.Order[0] == "blocking");
+    CHECK(finished.Order[1] == "high");
+}
+
+TEST_CASE("DownloadManager retries failed downloads without blocking others", "[downloads]")
+{
+    DummyDualView dv;
+    LocalHTTPServer server;
+    FinishedDownloads finished;
+
+    {
+        DownloadManager manager(2, 2);
+
+        auto flaky = std::make_shared<MemoryDLJob>(ProcessableURL(server.GetURL(0, "flaky"), true));
+        finished.Watch(*flaky);
+        manager.QueueDownload(flaky, 100);
+
+        for (int i = 0; i < 5; ++i)
+        {
+            auto job = std::make_shared<MemoryDLJob>(ProcessableURL(server.GetURL(10, std::to_string(i)), true));
+            finished.Watch(*job);
+            manager.QueueDownload(job, 10);
+        }
+
+        REQUIRE(finished.WaitFor(6));
+
+        CHECK(flaky->IsReady());
+        CHECK(!flaky->HasFailed());
+    }
+
+    CHECK(finished.Failures == 0);
+
+    // The other downloads used the second slot while the failed one waited to be retried
+    REQUIRE(finished.Order.size() == 6);
+    CHECK(finished.Order.back() == "flaky");
+    CHECK(server.Requests == 7);
+}
+
+TEST_CASE("ImageFileDLJob streams downloads to a file", "[downloads]")
+{
+    DummyDualView dv;
+    LocalHTTPServer server;
+    FinishedDownloads finished;
+
+    const std::string collection = "download_test_collection";
+    boost::filesystem::remove_all(collection);
+
+    dv.GetSettings().SetPrivateCollection(collection, false);
+    boost::filesystem::create_directories(dv.GetSettings().GetStagingFolder());
+
+    std::string imageData;
+    REQUIRE(Leviathan::FileSystem::ReadFileEntirely("data/7c2c2141cf27cb90620f80400c6bc3c4.jpg", imageData));
+
+    server.SetContent("image.jpg", imageData);
+    server.SetContent("broken.jpg", imageData.substr(0, imageData.size() / 2));
+
+    // WebP has no end marker so the size in the RIFF header (92 + 8) is used to find cut off files
+    std::string webpData("RIFF\x5C\0\0\0WEBPVP8L\0\0\0\0\x2F\x63\x40\x0C\0", 25);
+    webpData.resize(100, '\0');
+
+    server.SetContent("image.webp", webpData);
+    server.SetContent("broken.webp", webpData.substr(0, 60));
+
+    auto image = std::make_shared<ImageFileDLJob>(ProcessableURL(server.GetURL(0, "image.jpg"), true));
+    finished.Watch(*image);
+
+    auto broken = std::make_shared<ImageFileDLJob>(ProcessableURL(server.GetURL(0, "broken.jpg"), true));
+    finished.Watch(*broken);
+
+    auto webp = std::make_shared<ImageFileDLJob>(ProcessableURL(server.GetURL(0, "image.webp"), true));
+    finished.Watch(*webp);
+
+    auto brokenWebp = std::make_shared<ImageFileDLJob>(ProcessableURL(server.GetURL(0, "broken.webp"), true));
+    finished.Watch(*brokenWebp);
+
+    {
+        DownloadManager manager;
+
+        manager.QueueDownload(image);
+        manager.QueueDownload(broken);
+        manager.QueueDownload(webp);
+        manager.QueueDownload(brokenWebp);
+
+        REQUIRE(finished.WaitFor(4));
+    }
+
+    CHECK(finished.Failures == 0);
+
+    // The data isn't kept in memory
+    CHECK(image->GetDownloadedBytes().empty());
+
+    std::string written;
+    REQUIRE(Leviathan::FileSystem::ReadFileEntirely(image->GetLocalFile(), written));
+    CHECK(written == imageData);
+
+    CHECK(image->GetFileHash() == DualView::CalculateBase64EncodedFileHash(image->GetLocalFile()));
+
+    ImageHeaderInfo info;
+    REQUIRE(ProbeImageFile(image->GetLocalFile(), info));
+
+    CHECK(image->IsRecognizedImage());
+    CHECK(image->GetImageInfo().Format == "JPEG");
+    CHECK(image->GetImageInfo().Width == info.Width);
+    CHECK(image->GetImageInfo().Height == info.Height);
+
+    CHECK(!broken->IsRecognizedImage());
+    CHECK(boost::filesystem::file_size(broken->GetLocalFile()) == imageData.size() / 2);
+
+    CHECK(webp->IsRecognizedImage());
+    CHECK(webp->GetImageInfo().Format == "WEBP");
+
+    // Cut off files need to be decoded before they are imported
+    CHECK(!brokenWebp->IsRecognizedImage());
+
+    // Temporary files are renamed
+    for (const auto& entry :
+        boost::filesystem::directory_iterator(dv.GetSettings().GetStagingFolder()))
+    {
+        CHECK(entry.path().extension() != ".part");
+    }
+
+    boost::filesystem::remove_all(collection);
+}
@@ -0,0 +1,231 @@
+#include "catch.hpp"
+
+#include "WorkExecutor.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace DV;
+
+//! \brief Waits until check returns true or a few seconds have passed
+template<class CheckT>
+bool WaitFor(CheckT check)
+{
+    const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    while (!check())
+    {
+        if (std::chrono::steady_clock::now() > end)
+            return false;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return true;
+}
+
+TEST_CASE("Executor runs worker tasks in priority order", "[executor]")
+{
+    WorkExecutor executor;
+
+    std::mutex mutex;
+    std::vector<int> order;
+
+    const auto record = [&](int value) {
+        return [&, value]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(value);
+        };
+    };
+
+    // Queued before starting so that the order only depends on the priorities
+    executor.Queue(EXECUTOR_LANE::Worker, record(1), 1);
+    executor.Queue(EXECUTOR_LANE::Worker, record(3), 3);
+    const auto bumped = executor.Queue(EXECUTOR_LANE::Worker, record(4), 0);
+    executor.Queue(EXECUTOR_LANE::Worker, record(2), 2);
+
+    bumped->SetPriority(10);
+
+    CHECK(executor.GetStats()[static_cast<size_t>(EXECUTOR_LANE::Worker)].QueueDepth == 4);
+
+    executor.StartWorkers(1);
+
+    REQUIRE(WaitFor([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return order.size() == 4;
+    }));
+
+    CHECK(order == std::vector<int>{4, 3, 2, 1});
+
+    const auto stats = executor.GetStats()[static_cast<size_t>(EXECUTOR_LANE::Worker)];
+    CHECK(stats.QueueDepth == 0);
+    CHECK(stats.Completed == 4);
+}
+
+TEST_CASE("Executor runs immediate tasks before default priority ones", "[executor]")
+{
+    WorkExecutor executor;
+
+    std::mutex mutex;
+    std::vector<int> order;
+
+    const auto record = [&](int value) {
+        return [&, value]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(value);
+        };
+    };
+
+    executor.Queue(EXECUTOR_LANE::Worker, record(1));
+    executor.Queue(EXECUTOR_LANE::Worker, record(2));
+    executor.Queue(EXECUTOR_LANE::Worker, record(3), EXECUTOR_PRIORITY_IMMEDIATE);
+    executor.Queue(EXECUTOR_LANE::Worker, record(4), EXECUTOR_PRIORITY_IMMEDIATE);
+
+    executor.StartWorkers(1);
+
+    REQUIRE(WaitFor([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return order.size() == 4;
+    }));
+
+    // The default priorities can differ if the clock ticked between queueing them
+    CHECK(order[0] == 3);
+    CHECK(order[1] == 4);
+    CHECK(std::set<int>(order.begin() + 2, order.end()) == std::set<int>{1, 2});
+}
+
+TEST_CASE("Executor workers steal tasks queued by another worker", "[executor]")
+{
+    WorkExecutor executor;
+    executor.StartWorkers(4);
+
+    REQUIRE(executor.GetWorkerCount() == 4);
+
+    constexpr auto taskCount = 64;
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::atomic<int> done{0};
+
+    executor.Queue(EXECUTOR_LANE::Worker, [&]() {
+        CHECK(executor.IsOnWorkerThread());
+
+        // All of these go to the queue of this worker
+        for (int i = 0; i < taskCount; ++i)
+        {
+            executor.Queue(EXECUTOR_LANE::Worker, [&]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    threads.insert(std::this_thread::get_id());
+                }
+
+                ++done;
+            });
+        }
+    });
+
+    REQUIRE(WaitFor([&]() { return done == taskCount; }));
+
+    CHECK(threads.size() > 1);
+    CHECK(executor.GetStats()[static_cast<size_t>(EXECUTOR_LANE::Worker)].Steals > 0);
+    CHECK(!executor.IsOnWorkerThread());
+}
+
+TEST_CASE("Executor database lane runs one task at a time", "[executor]")
+{
+    WorkExecutor executor;
+    executor.StartWorkers(2);
+    executor.StartDatabaseThread();
+
+    std::atomic<int> running{0};
+    std::atomic<int> maxRunning{0};
+    std::atomic<int> done{0};
+
+    for (int i = 0; i < 20; ++i)
+    {
+        executor.Queue(EXECUTOR_LANE::Database, [&]() {
+            const auto current = ++running;
+
+            if (current > maxRunning)
+                maxRunning = current;
+
+            CHECK(!executor.IsOnWorkerThread());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            --running;
+            ++done;
+        });
+    }
+
+    REQUIRE(WaitFor([&]() { return done == 20; }));
+
+    CHECK(maxRunning == 1);
+    CHECK(executor.GetStats()[static_cast<size_t>(EXECUTOR_LANE::Database)].Completed == 20);
+}
+
+TEST_CASE("Executor main lane runs on the calling thread", "[executor]")
+{
+    WorkExecutor executor;
+    executor.StartWorkers(2);
+
+    const auto caller = std::this_thread::get_id();
+    int ran = 0;
+
+    for (int i = 0; i < 5; ++i)
+    {
+        executor.Queue(EXECUTOR_LANE::Main, [&]() {
+            CHECK(std::this_thread::get_id() == caller);
+            ++ran;
+        });
+    }
+
+    CHECK(executor.RunMainLane(3) == 3);
+    CHECK(ran == 3);
+    CHECK(executor.GetStats()[static_cast<size_t>(EXECUTOR_LANE::Main)].QueueDepth == 2);
+
+    CHECK(executor.RunMainLane(10) == 2);
+    CHECK(ran == 5);
+
+    executor.ResetStats();
+    CHECK(executor.GetStats()[static_cast<size_t>(EXECUTOR_LANE::Main)].Completed == 0);
+}
+
+TEST_CASE("Executor keeps tasks over a restart", "[executor]")
+{
+    WorkExecutor executor;
+    executor.StartWorkers(2);
+
+    std::atomic<bool> release{false};
+    std::atomic<int> done{0};
+
+    // Keep both workers busy so that the other tasks stay queued
+    for (int i = 0; i < 2; ++i)
+    {
+        executor.Queue(EXECUTOR_LANE::Worker, [&]() {
+            while (!release)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+    }
+
+    REQUIRE(WaitFor([&]() { return executor.GetStats()[0].Running == 2; }));
+
+    for (int i = 0; i < 10; ++i)
+        executor.Queue(EXECUTOR_LANE::Worker, [&]() { ++done; });
+
+    std::thread stopper([&]() { executor.Stop(); });
+
+    release = true;
+    stopper.join();
+
+    CHECK(executor.GetWorkerCount() == 0);
+
+    executor.StartWorkers(3);
+
+    REQUIRE(WaitFor([&]() { return done == 10; }));
+}
@@ -0,0 +1,101 @@
+#include "catch.hpp"
+
+#include "FrameRing.h"
+
+#include <memory>
+
+using namespace DV;
+
+//! \brief Converts frames until the ring is full, like AnimationFrameBuffer does
+void FillRing(FrameRing<std::shared_ptr<int>>& ring)
+{
+    size_t frame;
+
+    while (ring.GetNextToConvert(frame))
+        ring.Store(frame, std::make_shared<int>(static_cast<int>(frame)));
+}
+
+TEST_CASE("Frame ring converts frames ahead of the playhead", "[animation]")
+{
+    FrameRing<std::shared_ptr<int>> ring(10, 3);
+
+    REQUIRE(ring.GetCapacity() == 3);
+    CHECK(ring.GetBufferedCount() == 0);
+
+    size_t frame;
+    REQUIRE(ring.GetNextToConvert(frame));
+    CHECK(frame == 0);
+
+    FillRing(ring);
+    CHECK(ring.GetBufferedCount() == 3);
+
+    SECTION("Taking the next frame frees a slot for a later frame")
+    {
+        auto taken = ring.Take(1);
+        REQUIRE(taken);
+        CHECK(*taken == 1);
+        CHECK(ring.GetPlayhead() == 1);
+        CHECK(ring.GetBufferedCount() == 2);
+
+        REQUIRE(ring.GetNextToConvert(frame));
+        CHECK(frame == 3);
+    }
+
+    SECTION("The ring wraps around to the first frame")
+    {
+        for (size_t i = 1; i < 10; ++i)
+        {
+            auto taken = ring.Take(i);
+            REQUIRE(taken);
+            CHECK(*taken == static_cast<int>(i));
+            FillRing(ring);
+        }
+
+        REQUIRE(ring.GetNextToConvert(frame) == false);
+
+        auto taken = ring.Take(0);
+        REQUIRE(taken);
+        CHECK(*taken == 0);
+
+        REQUIRE(ring.GetNextToConvert(frame));
+        CHECK(frame == 2);
+    }
+
+    SECTION("Jumping past the buffered frames clears them")
+    {
+        CHECK(!ring.Take(7));
+        CHECK(ring.GetBufferedCount() == 0);
+
+        REQUIRE(ring.GetNextToConvert(frame));
+        CHECK(frame == 7);
+    }
+
+    SECTION("Frames that were passed during conversion are not stored")
+    {
+        ring.Take(2);
+        ring.Store(1, std::make_shared<int>(1));
+
+        CHECK(ring.GetBufferedCount() == 1);
+    }
+}
+
+TEST_CASE("Frame ring keeps all frames when they fit", "[animation]")
+{
+    FrameRing<std::shared_ptr<int>> ring(4, 100);
+
+    REQUIRE(ring.GetCapacity() == 4);
+
+    FillRing(ring);
+
+    for (size_t i = 1; i < 9; ++i)
+    {
+        auto taken = ring.Take(i);
+        REQUIRE(taken);
+        CHECK(*taken == static_cast<int>(i % 4));
+    }
+
+    CHECK(ring.GetBufferedCount() == 4);
+
+    size_t frame;
+    CHECK(ring.GetNextToConvert(frame) == false);
+}
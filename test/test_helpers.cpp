@@ -65,6 +65,16 @@ TEST_CASE("Suggestions sort works correctly", "[sort][suggestion][db][helper]")
 
         CHECK(CompareSuggestionStrings(matchStr, "short rebel", "a really long rebel"));
     }
+
+    SECTION("Grouping keeps the ranked order") {
+        std::vector<std::string> suggestions{
+            "dark red", "red hair", "Red", "bright red", "redhead", "red"};
+
+        GroupSuggestions(suggestions.begin(), suggestions.end(), "Red");
+
+        CHECK(suggestions == std::vector<std::string>{
+                                 "Red", "red", "red hair", "redhead", "dark red", "bright red"});
+    }
 }
 
 TEST_CASE("File path comparison works", "[sort][helper]") {
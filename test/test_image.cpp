@@ -2,14 +2,23 @@
 
 #include "CacheManager.h"
 #include "DummyLog.h"
+#include "Exceptions.h"
+#include "FileSystem.h"
+#include "ImageCache.h"
+#include "ImageProbe.h"
 #include "Settings.h"
 #include "SignatureCalculator.h"
 #include "TestDualView.h"
+#include "ThumbnailPack.h"
 #include "resources/Image.h"
 
 #include <Magick++.h>
 #include <boost/filesystem.hpp>
 
+#include <chrono>
+#include <iostream>
+#include <thread>
+
 using namespace DV;
 
 TEST_CASE("Image getptr works", "[image][.expensive]")
@@ -35,6 +44,27 @@ TEST_CASE("File hash generation is correct", "[image][hash][.expensive]")
     CHECK(img->CalculateFileHash() == "II+O7pSQgH8BG_gWrc+bAetVgxJNrJNX4zhA4oWV+V0=");
 }
 
+TEST_CASE("Chunked file hash matches hashing the whole file", "[image][hash]")
+{
+    DummyDualView dummy;
+
+    for(const std::string file :
+        {"data/7c2c2141cf27cb90620f80400c6bc3c4.jpg", "data/bird bathing.gif"}) {
+
+        std::string contents;
+        REQUIRE(Leviathan::FileSystem::ReadFileEntirely(file, contents));
+
+        const auto expected = DualView::CalculateBase64EncodedHash(contents);
+
+        CHECK(DualView::CalculateBase64EncodedFileHash(file) == expected);
+        CHECK(DualView::CalculateBase64EncodedFileHash(file, 7) == expected);
+        CHECK(DualView::CalculateBase64EncodedFileHash(file, contents.size()) == expected);
+    }
+
+    CHECK_THROWS_AS(DualView::CalculateBase64EncodedFileHash("data/not a real file.png"),
+        Leviathan::InvalidArgument);
+}
+
 TEST_CASE("ImageMagick properly loads the test image", "[image][.expensive]")
 {
     SECTION("jpg")
@@ -225,6 +255,61 @@ TEST_CASE("Thumbnail is created in a different folder", "[image][.expensive]")
     REQUIRE(boost::filesystem::exists(path));
 }
 
+TEST_CASE("Thumbnail queued twice is generated once", "[image][thumbnail][.expensive]")
+{
+    TestDualView dualview("test_image.sqlite");
+
+    auto folder = boost::filesystem::path(dualview.GetThumbnailFolder());
+    boost::filesystem::remove_all(folder);
+    boost::filesystem::create_directories(folder);
+
+    auto& cache = dualview.GetCacheManager();
+
+    const std::string file = "data/7c2c2141cf27cb90620f80400c6bc3c4.jpg";
+    const std::string hash = "duplicate-thumbnail-test";
+
+    SECTION("As a file")
+    {
+        // Separate files are used when the pack isn't enabled
+        REQUIRE(!cache.GetThumbnailPack());
+    }
+
+    SECTION("In the pack")
+    {
+        cache.EnableThumbnailPack(dualview.GetThumbnailPackFolder());
+    }
+
+    const auto writesBefore =
+        cache.GetThumbnailStageTimings()[static_cast<size_t>(THUMBNAIL_STAGE::Write)].Count;
+
+    auto first = cache.LoadThumbImage(file, hash);
+    auto second = cache.LoadThumbImage(file, hash);
+
+    int failCount = 0;
+
+    while(!first->IsLoaded() || !second->IsLoaded()) {
+
+        ++failCount;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        // Fail after 30 seconds //
+        REQUIRE(failCount < 6000);
+    }
+
+    CHECK(first->IsValid());
+    CHECK(second->IsValid());
+
+    CHECK(cache.GetThumbnailStageTimings()[static_cast<size_t>(THUMBNAIL_STAGE::Write)].Count ==
+          writesBefore + 1);
+
+    if(const auto pack = cache.GetThumbnailPack(); pack) {
+        CHECK(pack->GetCount() == 1);
+        CHECK(!boost::filesystem::exists(folder / boost::filesystem::path(hash + ".jpg")));
+    } else {
+        CHECK(boost::filesystem::exists(folder / boost::filesystem::path(hash + ".jpg")));
+    }
+}
+
 TEST_CASE("Image signature calculation on non-db image works", "[image][hash][.expensive]")
 {
     DummyDualView dummy;
@@ -288,3 +373,310 @@ TEST_CASE("Non-animated extension detection works", "[image][thumbnail]")
                   extension) != ANIMATED_IMAGE_EXTENSIONS.end());
     }
 }
+
+TEST_CASE("Image cache evicts least recently used images over budget", "[image][cache]")
+{
+    ImageCache cache(1000, 10);
+
+    auto first = std::make_shared<LoadedImage>("first");
+    auto second = std::make_shared<LoadedImage>("second");
+    auto third = std::make_shared<LoadedImage>("third");
+
+    cache.Insert(first, "first", 400);
+    cache.Insert(second, "second", 400);
+
+    CHECK(cache.GetTotalBytes() == 800);
+
+    // Not allowed to be evicted while used
+    cache.Insert(third, "third", 400);
+    CHECK(cache.GetCount() == 3);
+
+    // Make first the most recently used
+    CHECK(cache.Get("first") == first);
+
+    second.reset();
+    first.reset();
+    third.reset();
+
+    cache.SetMemoryBudget(900);
+
+    CHECK(cache.GetCount() == 2);
+    CHECK(cache.GetTotalBytes() == 800);
+    CHECK(!cache.Get("second"));
+    CHECK(cache.Get("first"));
+    CHECK(cache.Get("third"));
+
+    SECTION("Size update evicts")
+    {
+        auto fourth = std::make_shared<LoadedImage>("fourth");
+        cache.Insert(fourth, "fourth");
+
+        CHECK(cache.GetCount() == 3);
+
+        REQUIRE(cache.UpdateSize(*fourth, 500));
+
+        // "first" was used before "third" so it is the oldest
+        CHECK(cache.GetCount() == 2);
+        CHECK(cache.GetTotalBytes() == 900);
+        CHECK(!cache.Get("first"));
+        CHECK(cache.Get("fourth") == fourth);
+    }
+
+    SECTION("Moving keeps the image")
+    {
+        cache.OnMoved("first", "moved");
+
+        CHECK(!cache.Get("first"));
+
+        auto moved = cache.Get("moved");
+        REQUIRE(moved);
+        CHECK(moved->GetPath() == "moved");
+    }
+
+    SECTION("Unused images can be cancelled")
+    {
+        auto queued = std::make_shared<LoadedImage>("queued");
+        cache.Insert(queued, "queued");
+
+        // Held by something else
+        auto holder = queued;
+        CHECK(!cache.RemoveIfUnused(queued, 1));
+
+        holder.reset();
+        CHECK(cache.RemoveIfUnused(queued, 1));
+        CHECK(!cache.Get("queued"));
+    }
+
+    SECTION("Count limit")
+    {
+        ImageCache small(1000, 2);
+
+        for(int i = 0; i < 5; ++i)
+            small.Insert(std::make_shared<LoadedImage>(std::to_string(i)), std::to_string(i));
+
+        CHECK(small.GetCount() == 2);
+        CHECK(small.Get("4"));
+        CHECK(small.Get("3"));
+    }
+}
+
+TEST_CASE("Image header probe reads test images", "[image][probe]")
+{
+    ImageHeaderInfo info;
+
+    SECTION("JPEG")
+    {
+        REQUIRE(ProbeImageFile("data/7c2c2141cf27cb90620f80400c6bc3c4.jpg", info));
+        CHECK(info.Format == "JPEG");
+        CHECK(info.Width == 914);
+        CHECK(info.Height == 1280);
+        CHECK(info.FrameCount == 1);
+    }
+
+    SECTION("GIF")
+    {
+        REQUIRE(ProbeImageFile("data/bird bathing.gif", info));
+        CHECK(info.Format == "GIF");
+        CHECK(info.Width == 250);
+        CHECK(info.Height == 250);
+
+        // Frames can't be counted from just the start of the file
+        CHECK(info.FrameCount == 0);
+
+        std::string data;
+        REQUIRE(Leviathan::FileSystem::ReadFileEntirely("data/bird bathing.gif", data));
+
+        REQUIRE(ProbeImageHeader(data.data(), data.size(), info) == IMAGE_PROBE_RESULT::Success);
+        CHECK(info.FrameCount == 142);
+        CHECK(HasImageEndMarker(data.data(), data.size(), data.size(), info));
+        CHECK(!HasImageEndMarker(data.data(), data.size() / 2, data.size() / 2, info));
+    }
+
+    SECTION("Not an image")
+    {
+        CHECK(!ProbeImageFile("data/wanted results.txt", info));
+    }
+}
+
+TEST_CASE("Image header probe reads handmade headers", "[image][probe]")
+{
+    ImageHeaderInfo info;
+
+    SECTION("PNG")
+    {
+        const std::string png("\x89PNG\r\n\x1A\n"
+                              "\0\0\0\x0DIHDR\0\0\x01\x2C\0\0\0\xC8\x08\x06\0\0\0\0\0\0\0"
+                              "\0\0\0\x08"
+                              "acTL\0\0\0\x05\0\0\0\0\0\0\0\0",
+            8 + 25 + 20);
+
+        REQUIRE(ProbeImageHeader(png.data(), png.size(), info) == IMAGE_PROBE_RESULT::Success);
+        CHECK(info.Format == "PNG");
+        CHECK(info.Width == 300);
+        CHECK(info.Height == 200);
+        CHECK(info.FrameCount == 5);
+
+        CHECK(ProbeImageHeader(png.data(), 20, info) == IMAGE_PROBE_RESULT::NeedMoreData);
+    }
+
+    SECTION("BMP")
+    {
+        std::string bmp(54, '\0');
+        bmp[0] = 'B';
+        bmp[1] = 'M';
+        bmp[14] = 40;
+
+        // Width 640, height -480 (top-down)
+        bmp[18] = static_cast<char>(0x80);
+        bmp[19] = 0x02;
+        bmp[22] = 0x20;
+        bmp[23] = static_cast<char>(0xFE);
+        bmp[24] = static_cast<char>(0xFF);
+        bmp[25] = static_cast<char>(0xFF);
+
+        REQUIRE(ProbeImageHeader(bmp.data(), bmp.size(), info) == IMAGE_PROBE_RESULT::Success);
+        CHECK(info.Format == "BMP");
+        CHECK(info.Width == 640);
+        CHECK(info.Height == 480);
+
+        // The file size isn't set so it can't be checked
+        CHECK(!HasImageEndMarker(bmp.data(), bmp.size(), bmp.size(), info));
+    }
+
+    SECTION("Truncated BMP")
+    {
+        std::string bmp(54, '\0');
+        bmp[0] = 'B';
+        bmp[1] = 'M';
+        bmp[14] = 40;
+        bmp[18] = 2;
+        bmp[22] = 2;
+
+        // File size of 70 bytes
+        bmp[2] = 70;
+
+        REQUIRE(ProbeImageHeader(bmp.data(), bmp.size(), info) == IMAGE_PROBE_RESULT::Success);
+        CHECK(info.FileSize == 70);
+        CHECK(!HasImageEndMarker(bmp.data(), bmp.size(), bmp.size(), info));
+
+        bmp.resize(70, '\0');
+        CHECK(HasImageEndMarker(bmp.data(), bmp.size(), bmp.size(), info));
+    }
+
+    SECTION("Lossless WebP")
+    {
+        std::string webp("RIFF\0\0\0\0WEBPVP8L\0\0\0\0\x2F", 21);
+
+        // 100x50 stored as width - 1 and height - 1 in 14 bits each
+        const uint32_t bits = 99 | (49 << 14);
+
+        for(int i = 0; i < 4; ++i)
+            webp.push_back(static_cast<char>((bits >> (i * 8)) & 0xFF));
+
+        webp.resize(40, '\0');
+
+        REQUIRE(ProbeImageHeader(webp.data(), webp.size(), info) == IMAGE_PROBE_RESULT::Success);
+        CHECK(info.Format == "WEBP");
+        CHECK(info.Width == 100);
+        CHECK(info.Height == 50);
+        CHECK(info.FrameCount == 1);
+
+        // The RIFF size is 0 so the whole file is just the RIFF header
+        CHECK(HasImageEndMarker(webp.data(), webp.size(), webp.size(), info));
+    }
+
+    SECTION("Truncated WebP")
+    {
+        // RIFF size of 92 makes the file 100 bytes
+        std::string webp("RIFF\x5C\0\0\0WEBPVP8L\0\0\0\0\x2F\x63\x40\x0C\0", 25);
+        webp.resize(60, '\0');
+
+        REQUIRE(ProbeImageHeader(webp.data(), webp.size(), info) == IMAGE_PROBE_RESULT::Success);
+        CHECK(info.FileSize == 100);
+        CHECK(!HasImageEndMarker(webp.data(), webp.size(), webp.size(), info));
+
+        // Only the end of the data is given when downloading
+        webp.resize(100, '\0');
+        CHECK(HasImageEndMarker(webp.data() + 90, 10, webp.size(), info));
+    }
+
+    SECTION("Animated WebP")
+    {
+        // VP8X with the animation flag and 1024x768 canvas
+        std::string webp("RIFF\0\0\0\0WEBPVP8X\x0A\0\0\0\x02\0\0\0\xFF\x03\0\xFF\x02\0", 30);
+
+        // Two frames with 2 bytes of data each
+        for(int i = 0; i < 2; ++i)
+            webp.append(std::string("ANMF\x02\0\0\0\0\0", 10));
+
+        const auto riffSize = static_cast<uint32_t>(webp.size() - 8);
+
+        for(int i = 0; i < 4; ++i)
+            webp[4 + i] = static_cast<char>((riffSize >> (i * 8)) & 0xFF);
+
+        REQUIRE(ProbeImageHeader(webp.data(), webp.size(), info) == IMAGE_PROBE_RESULT::Success);
+        CHECK(info.Width == 1024);
+        CHECK(info.Height == 768);
+        CHECK(info.FrameCount == 2);
+    }
+
+    SECTION("Truncated JPEG needs more data")
+    {
+        // Metadata segment that is longer than the data
+        std::string jpeg("\xFF\xD8\xFF\xE1\x10\x00", 6);
+        jpeg.resize(64, '\0');
+
+        CHECK(ProbeImageHeader(jpeg.data(), jpeg.size(), info) == IMAGE_PROBE_RESULT::NeedMoreData);
+
+        // Image data before the frame header
+        const std::string broken("\xFF\xD8\xFF\xDA\x00\x08\0\0\0\0\0\0", 12);
+        CHECK(ProbeImageHeader(broken.data(), broken.size(), info) == IMAGE_PROBE_RESULT::Unknown);
+    }
+}
+
+TEST_CASE("Image header probe is faster than Magick", "[image][probe][.expensive]")
+{
+    DummyDualView dummy;
+
+    const std::vector<std::string> files = {
+        "data/7c2c2141cf27cb90620f80400c6bc3c4.jpg", "data/bird bathing.gif"};
+
+    constexpr auto rounds = 20;
+
+    for(const auto& file : files) {
+
+        int magickWidth = 0;
+        int magickHeight = 0;
+        std::string extension;
+
+        const auto magickStart = std::chrono::steady_clock::now();
+
+        for(int i = 0; i < rounds; ++i) {
+            Magick::Image image(file);
+            magickWidth = image.columns();
+            magickHeight = image.rows();
+        }
+
+        const auto magickTime = std::chrono::steady_clock::now() - magickStart;
+
+        ImageHeaderInfo info;
+
+        const auto probeStart = std::chrono::steady_clock::now();
+
+        for(int i = 0; i < rounds; ++i)
+            REQUIRE(ProbeImageFile(file, info));
+
+        const auto probeTime = std::chrono::steady_clock::now() - probeStart;
+
+        CHECK(info.Width == magickWidth);
+        CHECK(info.Height == magickHeight);
+
+        std::cout << file << ": Magick: "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(magickTime).count() / rounds
+                  << " us, header probe: "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(probeTime).count() / rounds
+                  << " us\n";
+
+        CHECK(probeTime < magickTime);
+    }
+}
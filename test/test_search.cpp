@@ -3,7 +3,17 @@
 #include "TestDualView.h"
 #include "TestDatabase.h"
 
+#include "CompletionIndex.h"
+#include "TagSearchIndex.h"
+
 #include "resources/Collection.h"
+#include "resources/DatabaseAction.h"
+#include "resources/Image.h"
+#include "resources/Tags.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
 
 using namespace DV;
 
@@ -42,5 +52,459 @@ TEST_CASE("Collection name auto complete works", "[collection][search]") {
 
         CHECK(results == std::vector<std::string>{"Collection 1", "Collection 2"});
     }
+
+    SECTION("Collections with more images first")
+    {
+        collection2->AddImage(db.InsertTestImage("image1", "hash1"));
+        collection3->AddImage(db.InsertTestImage("image2", "hash2"));
+
+        // The image counts are loaded when the index is built
+        db.BuildCollectionCompletionsAG();
+
+        const auto results = db.SelectCollectionNamesByWildcard("collection");
+
+        CHECK(results ==
+            std::vector<std::string>{"Collection 2", "Collection 1", "Another collection"});
+    }
+
+    SECTION("Renamed and deleted collections")
+    {
+        REQUIRE(!db.SelectCollectionNamesByWildcard("Colle").empty());
+
+        REQUIRE(collection1->Rename("Renamed 1"));
+
+        CHECK(db.SelectCollectionNamesByWildcard("Collection 1").empty());
+        CHECK(db.SelectCollectionNamesByWildcard("named") == std::vector<std::string>{"Renamed 1"});
+
+        const auto action = db.DeleteCollection(*collection2);
+        REQUIRE(action);
+
+        CHECK(db.SelectCollectionNamesByWildcard("Collection 2").empty());
+
+        REQUIRE(action->Undo());
+
+        CHECK(db.SelectCollectionNamesByWildcard("Collection 2") ==
+            std::vector<std::string>{"Collection 2"});
+    }
+}
+
+TEST_CASE("Tag suggestions follow the current use counts", "[search][db][tags]")
+{
+    std::unique_ptr<Database> dbptr(new TestDatabase());
+    DummyDualView dv(std::move(dbptr));
+    auto& db = static_cast<TestDatabase&>(dv.GetDatabase());
+
+    REQUIRE_NOTHROW(db.Init());
+
+    auto image1 = db.InsertTestImage("image1.jpg", "hash1");
+    auto image2 = db.InsertTestImage("image2.jpg", "hash2");
+
+    REQUIRE(image1);
+    REQUIRE(image2);
+
+    REQUIRE(db.InsertTag("snarkle print", "", TAG_CATEGORY::DESCRIBE_CHARACTER_OBJECT, false));
+    REQUIRE(db.InsertTag("snarkle stripes", "", TAG_CATEGORY::DESCRIBE_CHARACTER_OBJECT, false));
+
+    db.BuildTagDictionaryAG();
+
+    const auto suggest = [&]() {
+        std::vector<std::string> result;
+        db.SelectTagSuggestions(result, "snarkle", 10);
+        return result;
+    };
+
+    // Unused tags closer in length to the pattern come first
+    CHECK(suggest() == std::vector<std::string>{"snarkle print", "snarkle stripes"});
+
+    REQUIRE(image1->GetTags()->Add(dv.ParseTagFromString("snarkle stripes")));
+
+    CHECK(suggest() == std::vector<std::string>{"snarkle stripes", "snarkle print"});
+
+    // The suggestions shown to the user keep the order
+    CHECK(dv.GetSuggestionsForTag("snarkle") ==
+          std::vector<std::string>{"snarkle stripes", "snarkle print"});
+
+    REQUIRE(image1->GetTags()->Add(dv.ParseTagFromString("snarkle print")));
+    REQUIRE(image2->GetTags()->Add(dv.ParseTagFromString("snarkle print")));
+
+    CHECK(suggest() == std::vector<std::string>{"snarkle print", "snarkle stripes"});
+
+    // Renaming rebuilds the dictionary, which keeps the counts
+    auto renamed = db.SelectTagByNameAG("snarkle stripes");
+    REQUIRE(renamed);
+    renamed->SetName("snarkle stripe");
+    renamed->Save();
+
+    CHECK(suggest() == std::vector<std::string>{"snarkle print", "snarkle stripe"});
+
+    REQUIRE(image1->GetTags()->RemoveText("snarkle print"));
+    REQUIRE(image2->GetTags()->RemoveText("snarkle print"));
+
+    CHECK(suggest() == std::vector<std::string>{"snarkle stripe", "snarkle print"});
+}
+
+TEST_CASE("Completion index finds texts containing the pattern", "[search]")
+{
+    CompletionIndex index;
+
+    index.Add("Red car", "red car", 1);
+    index.Add("Dark red", "dark red", 5);
+    index.Add("redhead", "redhead", 0);
+    index.Add("blue", "blue", 9);
+
+    SECTION("Prefix matches first then by uses")
+    {
+        std::vector<std::string> result;
+        index.Find(result, "red", 10);
+
+        CHECK(result == std::vector<std::string>{"Red car", "redhead", "Dark red"});
+    }
+
+    SECTION("Exact match first")
+    {
+        std::vector<std::string> result;
+        index.Find(result, "redhead", 10);
+
+        CHECK(result == std::vector<std::string>{"redhead"});
+
+        index.Add("redheads", "redheads", 10);
+
+        result.clear();
+        index.Find(result, "redhead", 10);
+
+        CHECK(result == std::vector<std::string>{"redhead", "redheads"});
+    }
+
+    SECTION("Short patterns and limits")
+    {
+        std::vector<std::string> result;
+        index.Find(result, "ed", 2);
+
+        CHECK(result == std::vector<std::string>{"Dark red", "Red car"});
+
+        result.clear();
+        index.Find(result, "xyz", 10);
+
+        CHECK(result.empty());
+    }
+
+    SECTION("Removed texts aren't found")
+    {
+        index.Remove("Red car");
+        index.Remove("not added");
+
+        std::vector<std::string> result;
+        index.Find(result, "red", 10);
+
+        CHECK(result == std::vector<std::string>{"redhead", "Dark red"});
+        CHECK(index.GetCount() == 3);
+
+        // The key can be changed by adding again
+        index.Add("Dark red", "crimson", 0);
+
+        result.clear();
+        index.Find(result, "red", 10);
+
+        CHECK(result == std::vector<std::string>{"redhead"});
+    }
+
+    SECTION("Use counts can be changed")
+    {
+        index.SetUses("redhead", 10);
+        index.SetUses("not added", 10);
+
+        std::vector<std::string> result;
+        index.Find(result, "red", 10);
+
+        CHECK(result == std::vector<std::string>{"redhead", "Red car", "Dark red"});
+        CHECK(index.GetCount() == 4);
+    }
+
+    SECTION("Removing many texts")
+    {
+        for (int i = 0; i < 3000; ++i)
+            index.Add("item " + std::to_string(i), "item " + std::to_string(i), i);
+
+        for (int i = 0; i < 2900; ++i)
+            index.Remove("item " + std::to_string(i));
+
+        CHECK(index.GetCount() == 104);
+
+        std::vector<std::string> result;
+        index.Find(result, "item 29", 3);
+
+        CHECK(result == std::vector<std::string>{"item 2999", "item 2998", "item 2997"});
+
+        result.clear();
+        index.Find(result, "red", 10);
+
+        CHECK(result.size() == 3);
+    }
+}
+
+TEST_CASE("Completion index is faster than scanning 200k texts", "[search][.expensive]")
+{
+    const std::vector<std::string> words = {"red", "blue", "hair", "long", "short", "car", "girl",
+        "boy", "tree", "water", "mark", "eye", "open", "closed", "smile", "dark", "light", "big",
+        "small", "cat"};
+
+    CompletionIndex index;
+    std::vector<std::string> texts;
+    std::mt19937 random(1);
+
+    for (int i = 0; i < 200000; ++i)
+    {
+        const auto text = words[random() % words.size()] + " " + words[random() % words.size()] + " " +
+            std::to_string(i);
+
+        index.Add(text, text, random() % 1000);
+        texts.push_back(text);
+    }
+
+    constexpr auto rounds = 20;
+
+    for (const std::string pattern : {"red", "red ha", "water mark", "smile 1999"})
+    {
+        std::vector<std::string> result;
+
+        const auto indexStart = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < rounds; ++i)
+        {
+            result.clear();
+            index.Find(result, pattern, 50);
+        }
+
+        const auto indexTime = std::chrono::steady_clock::now() - indexStart;
+
+        // Same as what a LIKE '%pattern%' query has to do
+        size_t scanMatches = 0;
+
+        const auto scanStart = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < rounds; ++i)
+        {
+            scanMatches = 0;
+
+            for (const auto& text : texts)
+            {
+                if (text.find(pattern) != std::string::npos)
+                    ++scanMatches;
+            }
+        }
+
+        const auto scanTime = std::chrono::steady_clock::now() - scanStart;
+
+        CHECK(result.size() == std::min<size_t>(scanMatches, 50));
+
+        std::cout << "\"" << pattern << "\": index: "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(indexTime).count() / rounds
+                  << " us, scan: "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(scanTime).count() / rounds
+                  << " us\n";
+
+        CHECK(indexTime < scanTime);
+    }
+}
+
+TEST_CASE("Tag search expressions are parsed", "[search][tags]")
+{
+    SECTION("Single multi word tag")
+    {
+        const auto search = ParseTagSearch("red  car");
+
+        REQUIRE(search);
+        CHECK(search->Type == TagSearchNode::TYPE::Term);
+        CHECK(search->Text == "red car");
+    }
+
+    SECTION("AND binds tighter than OR")
+    {
+        CHECK(ParseTagSearch("a AND b OR c")->ToString() == "((a AND b) OR c)");
+        CHECK(ParseTagSearch("a OR b AND c")->ToString() == "(a OR (b AND c))");
+    }
+
+    SECTION("Short operators")
+    {
+        CHECK(ParseTagSearch("red car, -blue | green")->ToString() ==
+              "((red car AND NOT blue) OR green)");
+        CHECK(ParseTagSearch("a & b")->ToString() == "(a AND b)");
+    }
+
+    SECTION("Dash inside a tag isn't NOT")
+    {
+        const auto search = ParseTagSearch("sci-fi");
+
+        CHECK(search->Type == TagSearchNode::TYPE::Term);
+        CHECK(search->Text == "sci-fi");
+    }
+
+    SECTION("Parentheses")
+    {
+        CHECK(ParseTagSearch("(a OR b) AND NOT (c OR d)")->ToString() ==
+              "((a OR b) AND NOT (c OR d))");
+    }
+
+    SECTION("Invalid expressions")
+    {
+        CHECK_THROWS_AS(ParseTagSearch(""), Leviathan::InvalidArgument);
+        CHECK_THROWS_AS(ParseTagSearch("a AND"), Leviathan::InvalidArgument);
+        CHECK_THROWS_AS(ParseTagSearch("(a OR b"), Leviathan::InvalidArgument);
+        CHECK_THROWS_AS(ParseTagSearch("a) OR b"), Leviathan::InvalidArgument);
+    }
+}
+
+//! \brief Parses search and sets term tag ids from single letter names ('a' is 1 etc.)
+std::unique_ptr<TagSearchNode> ParseTestSearch(const std::string& search)
+{
+    auto parsed = ParseTagSearch(search);
+
+    parsed->ForEachTerm([](TagSearchNode& term) {
+        term.TagID = term.Text.size() == 1 ? term.Text[0] - 'a' + 1 : -1;
+    });
+
+    return parsed;
 }
 
+TEST_CASE("Tag search index finds matching images", "[search][tags]")
+{
+    TagSearchIndex index;
+
+    // Tags: a = 1, b = 2, c = 3
+    index.Build({1, 2, 3, 4, 5},
+        {{1, 1}, {2, 1}, {3, 1}, {2, 2}, {3, 2}, {4, 2}, {3, 3}, {5, 3}, {1, 1}});
+
+    CHECK(index.GetImageCount() == 5);
+    CHECK(index.GetTagCount() == 3);
+    CHECK(index.GetImagesWithTag(1) == std::vector<DBID>{1, 2, 3});
+
+    SECTION("Basic operators")
+    {
+        CHECK(index.Search(*ParseTestSearch("a")) == std::vector<DBID>{1, 2, 3});
+        CHECK(index.Search(*ParseTestSearch("a AND b")) == std::vector<DBID>{2, 3});
+        CHECK(index.Search(*ParseTestSearch("a AND b AND c")) == std::vector<DBID>{3});
+        CHECK(index.Search(*ParseTestSearch("a OR c")) == std::vector<DBID>{1, 2, 3, 5});
+        CHECK(index.Search(*ParseTestSearch("NOT a")) == std::vector<DBID>{4, 5});
+        CHECK(index.Search(*ParseTestSearch("b AND NOT c")) == std::vector<DBID>{2, 4});
+        CHECK(index.Search(*ParseTestSearch("-a, -b")) == std::vector<DBID>{5});
+        CHECK(index.Search(*ParseTestSearch("(a OR c) AND NOT b")) == std::vector<DBID>{1, 5});
+    }
+
+    SECTION("Unknown tag matches nothing")
+    {
+        CHECK(index.Search(*ParseTestSearch("unknown")).empty());
+        CHECK(index.Search(*ParseTestSearch("a AND unknown")).empty());
+        CHECK(index.Search(*ParseTestSearch("a AND NOT unknown")) == std::vector<DBID>{1, 2, 3});
+    }
+
+    SECTION("Incremental updates")
+    {
+        index.AddTag(5, 1);
+        CHECK(index.Search(*ParseTestSearch("a AND c")) == std::vector<DBID>{3, 5});
+
+        index.RemoveTag(3, 3);
+        CHECK(index.Search(*ParseTestSearch("a AND c")) == std::vector<DBID>{5});
+
+        index.AddImage(6);
+        CHECK(index.Search(*ParseTestSearch("NOT a")) == std::vector<DBID>{4, 6});
+    }
+
+    SECTION("Deleted images are not found but keep their tags")
+    {
+        index.RemoveImage(2);
+        CHECK(index.Search(*ParseTestSearch("a")) == std::vector<DBID>{1, 3});
+        CHECK(index.Search(*ParseTestSearch("NOT c")) == std::vector<DBID>{1, 4});
+
+        index.AddImage(2);
+        CHECK(index.Search(*ParseTestSearch("a")) == std::vector<DBID>{1, 2, 3});
+
+        index.PurgeImage(2);
+        index.AddImage(2);
+        CHECK(index.Search(*ParseTestSearch("a")) == std::vector<DBID>{1, 3});
+    }
+
+    SECTION("Merging tags")
+    {
+        index.MergeTags(1, 3);
+
+        CHECK(index.GetTagCount() == 2);
+        CHECK(index.Search(*ParseTestSearch("a")) == std::vector<DBID>{1, 2, 3, 5});
+        CHECK(index.Search(*ParseTestSearch("c")).empty());
+    }
+}
+
+TEST_CASE("Images are found with multiple tags", "[search][db][tags]")
+{
+    std::unique_ptr<Database> dbptr(new TestDatabase());
+    DummyDualView dv(std::move(dbptr));
+    auto& db = static_cast<TestDatabase&>(dv.GetDatabase());
+
+    REQUIRE_NOTHROW(db.Init());
+
+    auto image1 = db.InsertTestImage("image1.jpg", "hash1");
+    auto image2 = db.InsertTestImage("image2.jpg", "hash2");
+    auto image3 = db.InsertTestImage("image3.jpg", "hash3");
+
+    REQUIRE(image1);
+    REQUIRE(image2);
+    REQUIRE(image3);
+
+    const auto hair = dv.ParseTagFromString("hair");
+    const auto uniform = dv.ParseTagFromString("uniform");
+    REQUIRE(hair);
+    REQUIRE(uniform);
+
+    CHECK(image1->GetTags()->Add(hair));
+    CHECK(image2->GetTags()->Add(hair));
+    CHECK(image2->GetTags()->Add(uniform));
+    CHECK(image3->GetTags()->Add(uniform));
+
+    const auto search = [&](const std::string& text) {
+        auto parsed = ParseTagSearch(text);
+
+        parsed->ForEachTerm([&](TagSearchNode& term) {
+            term.TagID = db.SelectExistingAppliedTagIDAG(*dv.ParseTagFromString(term.Text));
+        });
+
+        return db.SelectImageIDsByTagSearchAG(*parsed);
+    };
+
+    CHECK(search("hair") == std::vector<DBID>{image1->GetID(), image2->GetID()});
+    CHECK(search("hair AND uniform") == std::vector<DBID>{image2->GetID()});
+    CHECK(search("uniform AND NOT hair") == std::vector<DBID>{image3->GetID()});
+    CHECK(search("drawn").empty());
+
+    SECTION("Index is updated when tags change")
+    {
+        CHECK(image1->GetTags()->Add(uniform));
+        CHECK(search("hair AND uniform") == std::vector<DBID>{image1->GetID(), image2->GetID()});
+
+        CHECK(image2->GetTags()->RemoveText("hair"));
+        CHECK(search("hair AND uniform") == std::vector<DBID>{image1->GetID()});
+    }
+
+    SECTION("Deleted images aren't found")
+    {
+        auto undo = db.DeleteImage(*image2);
+        REQUIRE(undo);
+
+        CHECK(search("hair") == std::vector<DBID>{image1->GetID()});
+
+        CHECK(undo->Undo());
+        CHECK(search("hair") == std::vector<DBID>{image1->GetID(), image2->GetID()});
+    }
+
+    SECTION("Images are loaded")
+    {
+        auto parsed = ParseTagSearch("hair OR uniform");
+        parsed->ForEachTerm([&](TagSearchNode& term) {
+            term.TagID = db.SelectExistingAppliedTagIDAG(*dv.ParseTagFromString(term.Text));
+        });
+
+        const auto images = db.SelectImagesByTagSearchAG(*parsed);
+
+        REQUIRE(images.size() == 3);
+        CHECK(images[0] == image1);
+        CHECK(images[2] == image3);
+    }
+}
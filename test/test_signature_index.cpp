@@ -0,0 +1,261 @@
+#include "catch.hpp"
+
+#include "Database.h"
+#include "SignatureIndex.h"
+#include "TestDatabase.h"
+#include "TestDualView.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace DV;
+
+//! \brief Creates a random libpuzzle like signature
+std::string CreateTestSignature(std::mt19937& random, size_t length = 544)
+{
+    std::uniform_int_distribution<int> distribution(-2, 2);
+
+    std::string signature;
+    signature.resize(length);
+
+    for (auto& value : signature)
+        value = static_cast<char>(distribution(random));
+
+    return signature;
+}
+
+//! \brief The old SQL based matching logic for comparing against
+int CountMatchingWords(const std::string& first, const std::string& second)
+{
+    const auto words = std::min(SignatureIndex::CountWords(first.size()), SignatureIndex::CountWords(second.size()));
+
+    int matches = 0;
+
+    for (size_t i = 0; i < words; ++i)
+    {
+        if (first.substr(i, IMAGE_SIGNATURE_WORD_LENGTH) == second.substr(i, IMAGE_SIGNATURE_WORD_LENGTH))
+            ++matches;
+    }
+
+    return matches;
+}
+
+TEST_CASE("Signature index packs words correctly", "[signature]")
+{
+    std::mt19937 random(42);
+
+    const auto signature = CreateTestSignature(random);
+
+    SignatureIndex index;
+    REQUIRE(index.AddSignature(1, signature));
+    CHECK(!index.AddSignature(2, "too short"));
+
+    REQUIRE(index.GetImageCount() == 1);
+
+    for (size_t position = 0; position < IMAGE_SIGNATURE_WORD_COUNT; ++position)
+    {
+        uint32_t expected = 0;
+
+        for (size_t i = 0; i < IMAGE_SIGNATURE_WORD_LENGTH; ++i)
+        {
+            expected |= static_cast<uint32_t>(signature[position + i] + 2) << (i * SIGNATURE_INDEX_BITS_PER_VALUE);
+        }
+
+        CHECK(index.GetWord(0, position) == expected);
+    }
+}
+
+TEST_CASE("Signature index finds the same duplicates as word matching", "[signature]")
+{
+    std::mt19937 random(1234);
+
+    std::vector<std::tuple<DBID, std::string>> signatures;
+
+    // Some random images and variations of them
+    for (DBID id = 1; id <= 40; ++id)
+    {
+        if (id % 4 == 0)
+        {
+            auto modified = std::get<1>(signatures[signatures.size() - 2]);
+
+            // Change every 7th value
+            for (size_t i = 0; i < modified.size(); i += 7)
+                modified[i] = static_cast<char>(modified[i] == 2 ? -2 : modified[i] + 1);
+
+            signatures.emplace_back(id, modified);
+        }
+        else if (id % 5 == 0)
+        {
+            signatures.emplace_back(id, std::get<1>(signatures.back()));
+        }
+        else
+        {
+            signatures.emplace_back(id, CreateTestSignature(random));
+        }
+    }
+
+    const int sensitivity = 10;
+
+    SignatureIndex index;
+
+    // Insert out of order to make sure the index sorts things
+    for (auto iter = signatures.rbegin(); iter != signatures.rend(); ++iter)
+        index.AddSignature(std::get<0>(*iter), std::get<1>(*iter));
+
+    index.BuildPostings();
+
+    std::map<DBID, std::vector<std::tuple<DBID, int>>> expected;
+
+    for (size_t i = 0; i < signatures.size(); ++i)
+    {
+        for (size_t j = i + 1; j < signatures.size(); ++j)
+        {
+            const auto strength = CountMatchingWords(std::get<1>(signatures[i]), std::get<1>(signatures[j]));
+
+            if (strength >= sensitivity)
+                expected[std::get<0>(signatures[i])].emplace_back(std::get<0>(signatures[j]), strength);
+        }
+    }
+
+    REQUIRE(!expected.empty());
+
+    CHECK(index.FindPotentialDuplicates(sensitivity, 1) == expected);
+    CHECK(index.FindPotentialDuplicates(sensitivity, 4) == expected);
+
+    SECTION("Ignored pairs are filtered out")
+    {
+        const auto ignoredPrimary = expected.begin()->first;
+        const auto ignoredOther = std::get<0>(expected.begin()->second.front());
+
+        index.AddIgnoredPair(ignoredPrimary, ignoredOther);
+
+        const auto result = index.FindPotentialDuplicates(sensitivity);
+
+        const auto found = result.find(ignoredPrimary);
+
+        if (found != result.end())
+        {
+            for (const auto& duplicate : found->second)
+                CHECK(std::get<0>(duplicate) != ignoredOther);
+        }
+    }
+}
+
+TEST_CASE("Signature words are stored as integer keys", "[signature][db]")
+{
+    DummyDualView dv;
+    TestDatabase db;
+
+    REQUIRE_NOTHROW(db.Init());
+
+    std::mt19937 random(99);
+
+    std::vector<std::tuple<DBID, std::string>> signatures;
+    signatures.emplace_back(1, CreateTestSignature(random));
+    signatures.emplace_back(2, CreateTestSignature(random));
+
+    // Shorter than the full word count
+    signatures.emplace_back(3, CreateTestSignature(random, IMAGE_SIGNATURE_WORD_LENGTH + 4));
+
+    db.InsertImageSignaturesAG(signatures);
+
+    GUARD_LOCK_OTHER(db);
+
+    for (const auto& [id, signature] : signatures)
+    {
+        CHECK(db.SelectImageSignatureByID(guard, id) == signature);
+
+        const char str[] = "SELECT sig_word FROM picture_signature_words WHERE picture_id = ? ORDER BY sig_word;";
+
+        PreparedStatement statementObj(db.GetSignatureDB(), str, sizeof(str));
+
+        auto statementInUse = statementObj.Setup(id);
+
+        std::vector<int64_t> words;
+
+        while (statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW)
+            words.push_back(statementObj.GetColumnAsInt64(0));
+
+        REQUIRE(words.size() == SignatureIndex::CountWords(signature.size()));
+
+        // The lower bits need to match what the in-memory index uses
+        SignatureIndex index;
+        REQUIRE(index.AddSignature(id, signature));
+
+        for (size_t i = 0; i < words.size(); ++i)
+        {
+            CHECK(words[i] == SignatureIndex::CreateWordKey(signature, i));
+            CHECK(static_cast<size_t>(words[i] >> 32) == i);
+            CHECK(static_cast<uint32_t>(words[i] & 0xFFFFFFFF) == index.GetWord(0, i));
+        }
+    }
+}
+
+TEST_CASE("Signature word insert speed", "[signature][db][.expensive]")
+{
+    DummyDualView dv;
+    TestDatabase db;
+
+    REQUIRE_NOTHROW(db.Init());
+
+    constexpr auto imageCount = 2000;
+
+    std::mt19937 random(5);
+
+    std::vector<std::tuple<DBID, std::string>> signatures;
+
+    for (DBID id = 1; id <= imageCount; ++id)
+        signatures.emplace_back(id, CreateTestSignature(random));
+
+    const auto rows = static_cast<double>(imageCount * IMAGE_SIGNATURE_WORD_COUNT);
+
+    GUARD_LOCK_OTHER(db);
+
+    // The previous way of inserting signature words, one step per word with string keys
+    double legacyRate;
+    {
+        auto* sqlite = db.GetSignatureDB();
+
+        REQUIRE(sqlite3_exec(sqlite,
+                    "CREATE TEMP TABLE legacy_words (picture_id INTEGER NOT NULL, sig_word TEXT NOT NULL); "
+                    "CREATE INDEX temp.legacy_position_sig ON legacy_words(picture_id, sig_word);",
+                    nullptr, nullptr, nullptr) == SQLITE_OK);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        REQUIRE(sqlite3_exec(sqlite, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr) == SQLITE_OK);
+
+        for (const auto& [id, signature] : signatures)
+        {
+            const char str[] = "INSERT INTO legacy_words (picture_id, sig_word) VALUES (?, ?);";
+
+            PreparedStatement statementObj(sqlite, str, sizeof(str));
+
+            for (size_t i = 0; i < SignatureIndex::CountWords(signature.size()); ++i)
+            {
+                std::string finalKey = std::to_string(i) + "__" + signature.substr(i, IMAGE_SIGNATURE_WORD_LENGTH);
+                statementObj.StepAll(statementObj.Setup(id, finalKey));
+            }
+        }
+
+        REQUIRE(sqlite3_exec(sqlite, "COMMIT TRANSACTION;", nullptr, nullptr, nullptr) == SQLITE_OK);
+
+        legacyRate =
+            rows / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double batchRate;
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        db.InsertImageSignatures(guard, signatures);
+
+        batchRate = rows / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::cout << "Signature word inserts: per row string keys: " << static_cast<int64_t>(legacyRate)
+              << " rows/s, batched integer keys: " << static_cast<int64_t>(batchRate) << " rows/s\n";
+
+    CHECK(batchRate > legacyRate);
+}
@@ -0,0 +1,183 @@
+#include "catch.hpp"
+
+#include "PreparedStatement.h"
+#include "TestDatabase.h"
+#include "TestDualView.h"
+
+#include "resources/Image.h"
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <iostream>
+
+using namespace DV;
+
+//! \brief In-memory sqlite connection for the tests
+class TestConnection
+{
+public:
+    TestConnection()
+    {
+        REQUIRE(sqlite3_open(":memory:", &DB) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(DB, "CREATE TABLE numbers (value INTEGER);", nullptr, nullptr, nullptr) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(DB, "INSERT INTO numbers VALUES (1), (2), (3);", nullptr, nullptr, nullptr) ==
+            SQLITE_OK);
+    }
+
+    ~TestConnection()
+    {
+        sqlite3_close(DB);
+    }
+
+    sqlite3* DB = nullptr;
+};
+
+int64_t CountNumbersAbove(PreparedStatementCache& cache, int64_t limit)
+{
+    const char str[] = "SELECT COUNT(*) FROM numbers WHERE value > ?1;";
+
+    auto cachedStatement = cache.Get(str, sizeof(str));
+    auto& statementObj = *cachedStatement;
+
+    auto statementInUse = statementObj.Setup(limit);
+
+    REQUIRE(statementObj.Step(statementInUse) == PreparedStatement::STEP_RESULT::ROW);
+    return statementObj.GetColumnAsInt64(0);
+}
+
+TEST_CASE("Statement cache reuses statements", "[db][statement]")
+{
+    TestConnection connection;
+
+    {
+        PreparedStatementCache cache;
+        cache.SetDatabase(connection.DB);
+
+        CHECK(CountNumbersAbove(cache, 0) == 3);
+        CHECK(cache.GetMisses() == 1);
+        CHECK(cache.GetHits() == 0);
+        CHECK(cache.GetSize() == 1);
+
+        CHECK(CountNumbersAbove(cache, 1) == 2);
+        CHECK(CountNumbersAbove(cache, 2) == 1);
+        CHECK(cache.GetMisses() == 1);
+        CHECK(cache.GetHits() == 2);
+        CHECK(cache.GetSize() == 1);
+
+        SECTION("Same SQL used recursively gets a separate statement")
+        {
+            const char str[] = "SELECT value FROM numbers ORDER BY value;";
+
+            auto outer = cache.Get(str, sizeof(str));
+            auto outerInUse = outer->Setup();
+
+            REQUIRE(outer->Step(outerInUse) == PreparedStatement::STEP_RESULT::ROW);
+
+            {
+                auto inner = cache.Get(str, sizeof(str));
+                CHECK(&*inner != &*outer);
+
+                auto innerInUse = inner->Setup();
+                inner->StepAll(innerInUse);
+            }
+
+            // The outer statement is still in the middle of its results
+            REQUIRE(outer->Step(outerInUse) == PreparedStatement::STEP_RESULT::ROW);
+            CHECK(outer->GetColumnAsInt64(0) == 2);
+        }
+
+        SECTION("Least recently used statements are evicted")
+        {
+            cache.SetMaxSize(2);
+
+            for (const char* sql : {"SELECT 1;", "SELECT 2;", "SELECT 3;"})
+            {
+                auto statement = cache.Get(sql);
+                statement->StepAll(statement->Setup());
+            }
+
+            CHECK(cache.GetSize() == 2);
+            CHECK(cache.GetEvictions() == 2);
+
+            // The count statement was used first so it was removed
+            cache.ResetCounters();
+            CountNumbersAbove(cache, 0);
+            CHECK(cache.GetMisses() == 1);
+        }
+
+        SECTION("Size of 0 disables caching")
+        {
+            cache.SetMaxSize(0);
+            CHECK(cache.GetSize() == 0);
+
+            cache.ResetCounters();
+            CountNumbersAbove(cache, 0);
+            CountNumbersAbove(cache, 0);
+
+            CHECK(cache.GetMisses() == 2);
+            CHECK(cache.GetHits() == 0);
+        }
+    }
+
+    // Statements must be finalized when the cache is destroyed
+    CHECK(sqlite3_next_stmt(connection.DB, nullptr) == nullptr);
+}
+
+TEST_CASE("Database uses cached statements", "[db][statement]")
+{
+    std::unique_ptr<Database> dbptr(new TestDatabase());
+    DummyDualView dv(std::move(dbptr));
+    auto& db = static_cast<TestDatabase&>(dv.GetDatabase());
+
+    REQUIRE_NOTHROW(db.Init());
+
+    const auto image = db.InsertTestImage("image.jpg", "hash");
+    REQUIRE(image);
+
+    GUARD_LOCK_OTHER(db);
+
+    auto& cache = db.GetStatementCache(guard);
+    cache.ResetCounters();
+
+    CHECK(db.SelectImageByID(guard, image->GetID()) == image);
+    CHECK(db.SelectImageByID(guard, image->GetID()) == image);
+
+    CHECK(cache.GetHits() >= 1);
+}
+
+TEST_CASE("Statement cache speeds up selecting images", "[db][statement][.expensive]")
+{
+    std::unique_ptr<Database> dbptr(new TestDatabase());
+    DummyDualView dv(std::move(dbptr));
+    auto& db = static_cast<TestDatabase&>(dv.GetDatabase());
+
+    REQUIRE_NOTHROW(db.Init());
+
+    const auto image = db.InsertTestImage("image.jpg", "hash");
+    REQUIRE(image);
+
+    constexpr auto rounds = 100000;
+
+    GUARD_LOCK_OTHER(db);
+
+    const auto runSelects = [&]() {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < rounds; ++i)
+            REQUIRE(db.SelectImageByID(guard, image->GetID()));
+
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    };
+
+    db.SetStatementCacheSize(guard, 0);
+    const auto uncachedTime = runSelects();
+
+    db.SetStatementCacheSize(guard, DEFAULT_STATEMENT_CACHE_SIZE);
+    const auto cachedTime = runSelects();
+
+    std::cout << rounds << " SelectImageByID calls, without statement cache: " << uncachedTime.count()
+              << " ms, with cache: " << cachedTime.count() << " ms\n";
+
+    CHECK(cachedTime < uncachedTime);
+}
@@ -2,6 +2,13 @@
 
 #include "TaskListWithPriority.h"
 
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+
 using namespace DV;
 
 struct DummyTask {
@@ -200,3 +207,152 @@ TEST_CASE("Same priority tasks come out in insertion order", "[task]")
     CHECK(list.Pop(guard)->Task == task4);
     CHECK(list.Pop(guard)->Task == task1);
 }
+
+TEST_CASE("Task queue priority can be raised deep in the queue", "[task]")
+{
+    TaskListWithPriority<DummyTask> list;
+    GUARD_LOCK_OTHER(list);
+
+    std::vector<std::shared_ptr<TaskListWithPriority<DummyTask>::TaskItem>> tasks;
+
+    for(int i = 0; i < 1000; ++i)
+        tasks.push_back(list.Push(guard, DummyTask{i}, 10 + (i % 50)));
+
+    tasks[123]->SetPriority(100);
+    tasks[999]->SetPriority(99);
+
+    CHECK(list.Pop(guard)->Task == DummyTask{123});
+    CHECK(list.Pop(guard)->Task == DummyTask{999});
+
+    // Lowering priority moves the task to the end
+    tasks[49]->SetPriority(1);
+
+    PriorityValueT previous = 1000;
+    std::shared_ptr<TaskListWithPriority<DummyTask>::TaskItem> last;
+
+    while(auto task = list.Pop(guard)) {
+
+        CHECK(task->GetPriority() <= previous);
+        previous = task->GetPriority();
+        last = task;
+    }
+
+    REQUIRE(last);
+    CHECK(last->Task == DummyTask{49});
+}
+
+TEST_CASE("Task queue keeps insertion order for many same priority tasks", "[task]")
+{
+    TaskListWithPriority<DummyTask> list;
+    GUARD_LOCK_OTHER(list);
+
+    for(int i = 0; i < 500; ++i)
+        list.Push(guard, DummyTask{i}, 5);
+
+    for(int i = 0; i < 500; ++i)
+        CHECK(list.Pop(guard)->Task == DummyTask{i});
+}
+
+TEST_CASE("Task priority changes after popping don't affect the queue", "[task]")
+{
+    TaskListWithPriority<DummyTask> list;
+    GUARD_LOCK_OTHER(list);
+
+    const auto first = list.Push(guard, DummyTask{1}, 5);
+    list.Push(guard, DummyTask{2}, 4);
+    list.Push(guard, DummyTask{3}, 3);
+
+    REQUIRE(list.Pop(guard) == first);
+
+    first->SetPriority(100);
+
+    CHECK(list.GetSize(guard) == 2);
+    CHECK(list.Pop(guard)->Task == DummyTask{2});
+
+    SECTION("Pushing a task again uses the current priority")
+    {
+        list.Push(guard, first);
+
+        CHECK(list.Pop(guard) == first);
+        CHECK(list.Pop(guard)->Task == DummyTask{3});
+    }
+
+    SECTION("Cleared queue ignores changes")
+    {
+        list.Clear(guard);
+        first->SetPriority(200);
+
+        CHECK(list.Pop(guard) == nullptr);
+    }
+}
+
+TEST_CASE("Task priority can be changed from another thread", "[task]")
+{
+    TaskListWithPriority<DummyTask> list;
+
+    std::shared_ptr<TaskListWithPriority<DummyTask>::TaskItem> bumped;
+
+    {
+        GUARD_LOCK_OTHER(list);
+
+        for(int i = 0; i < 100; ++i) {
+            auto task = list.Push(guard, DummyTask{i}, i);
+
+            if(i == 10)
+                bumped = task;
+        }
+    }
+
+    std::thread([&]() { bumped->SetPriority(1000); }).join();
+
+    GUARD_LOCK_OTHER(list);
+    CHECK(list.Pop(guard) == bumped);
+    CHECK(list.Pop(guard)->Task == DummyTask{99});
+}
+
+TEST_CASE("Task queue throughput", "[task][.expensive]")
+{
+    constexpr auto count = 200000;
+
+    TaskListWithPriority<DummyTask> list;
+    GUARD_LOCK_OTHER(list);
+
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<PriorityValueT> priorities(0, 1000);
+
+    std::vector<std::shared_ptr<TaskListWithPriority<DummyTask>::TaskItem>> tasks;
+    tasks.reserve(count);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < count; ++i)
+        tasks.push_back(list.Push(guard, DummyTask{i}, priorities(random)));
+
+    const auto pushed = std::chrono::steady_clock::now();
+
+    // Like thumbnails being scrolled into view
+    for(int i = 0; i < count; i += 10)
+        tasks[i]->Bump();
+
+    PriorityValueT previous = std::numeric_limits<PriorityValueT>::max();
+    int popped = 0;
+    bool ordered = true;
+
+    while(auto task = list.Pop(guard)) {
+
+        ordered = ordered && task->GetPriority() <= previous;
+        previous = task->GetPriority();
+        ++popped;
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+
+    std::cout << count << " tasks, push: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(pushed - start).count()
+              << " ms, bump and pop: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - pushed).count()
+              << " ms\n";
+
+    CHECK(popped == count);
+    CHECK(ordered);
+}
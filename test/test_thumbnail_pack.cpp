@@ -0,0 +1,168 @@
+#include "catch.hpp"
+
+#include "ThumbnailPack.h"
+
+#include <boost/filesystem.hpp>
+
+using namespace DV;
+
+constexpr auto TEST_PACK_FOLDER = "test_thumbnail_pack/";
+
+//! \brief Makes sure the test pack folder is empty before and after a test
+class TestPackFolder
+{
+public:
+    TestPackFolder()
+    {
+        boost::filesystem::remove_all(TEST_PACK_FOLDER);
+    }
+
+    ~TestPackFolder()
+    {
+        boost::filesystem::remove_all(TEST_PACK_FOLDER);
+    }
+};
+
+std::string ReadThumbnail(const ThumbnailPack& pack, const std::string& name)
+{
+    std::string data;
+    REQUIRE(pack.Read(name, data));
+    return data;
+}
+
+TEST_CASE("Thumbnail pack stores and reads thumbnails", "[thumbnail]")
+{
+    TestPackFolder folder;
+
+    const std::string first = "first thumbnail data";
+    const std::string second(10000, 'x');
+
+    {
+        ThumbnailPack pack(TEST_PACK_FOLDER);
+
+        CHECK(pack.GetCount() == 0);
+        CHECK(!pack.Contains("hash1.jpg"));
+
+        pack.Add("hash1.jpg", first.data(), first.size());
+        pack.Add("hash2.gif", second.data(), second.size());
+
+        CHECK(pack.GetCount() == 2);
+        CHECK(pack.Contains("hash1.jpg"));
+        CHECK(ReadThumbnail(pack, "hash1.jpg") == first);
+        CHECK(ReadThumbnail(pack, "hash2.gif") == second);
+
+        std::string data;
+        CHECK(!pack.Read("missing.jpg", data));
+    }
+
+    SECTION("Thumbnails are found after reopening")
+    {
+        ThumbnailPack pack(TEST_PACK_FOLDER);
+
+        CHECK(pack.GetCount() == 2);
+        CHECK(ReadThumbnail(pack, "hash1.jpg") == first);
+        CHECK(ReadThumbnail(pack, "hash2.gif") == second);
+    }
+
+    SECTION("Replaced and removed thumbnails stay that way after reopening")
+    {
+        const std::string replacement = "replaced";
+
+        {
+            ThumbnailPack pack(TEST_PACK_FOLDER);
+
+            pack.Add("hash1.jpg", replacement.data(), replacement.size());
+            CHECK(pack.Remove("hash2.gif"));
+            CHECK(!pack.Remove("hash2.gif"));
+
+            CHECK(ReadThumbnail(pack, "hash1.jpg") == replacement);
+            CHECK(!pack.Contains("hash2.gif"));
+        }
+
+        ThumbnailPack pack(TEST_PACK_FOLDER);
+
+        CHECK(pack.GetCount() == 1);
+        CHECK(ReadThumbnail(pack, "hash1.jpg") == replacement);
+        CHECK(!pack.Contains("hash2.gif"));
+    }
+
+    SECTION("Broken record at the end is ignored")
+    {
+        {
+            ThumbnailPack pack(TEST_PACK_FOLDER);
+            pack.Add("partial.jpg", second.data(), second.size());
+        }
+
+        // Simulate a write that was interrupted
+        const auto segment = boost::filesystem::path(TEST_PACK_FOLDER) / "segment_000001.pack";
+        REQUIRE(boost::filesystem::exists(segment));
+        boost::filesystem::resize_file(segment, boost::filesystem::file_size(segment) - 100);
+
+        {
+            ThumbnailPack pack(TEST_PACK_FOLDER);
+
+            CHECK(pack.GetCount() == 2);
+            CHECK(!pack.Contains("partial.jpg"));
+
+            pack.Add("after.jpg", first.data(), first.size());
+        }
+
+        ThumbnailPack pack(TEST_PACK_FOLDER);
+        CHECK(ReadThumbnail(pack, "after.jpg") == first);
+        CHECK(ReadThumbnail(pack, "hash2.gif") == second);
+    }
+}
+
+TEST_CASE("Thumbnail pack starts new segments and compacts", "[thumbnail]")
+{
+    TestPackFolder folder;
+
+    const std::string data(1000, 'a');
+
+    ThumbnailPack pack(TEST_PACK_FOLDER, 4096);
+
+    for (int i = 0; i < 20; ++i)
+        pack.Add("thumb" + std::to_string(i) + ".jpg", data.data(), data.size());
+
+    CHECK(pack.GetSegmentCount() > 1);
+
+    for (int i = 0; i < 15; ++i)
+        pack.Remove("thumb" + std::to_string(i) + ".jpg");
+
+    CHECK(pack.GetCount() == 5);
+    CHECK(pack.ShouldCompact());
+
+    const auto sizeBefore = pack.GetTotalBytes();
+
+    pack.Compact();
+
+    CHECK(!pack.ShouldCompact());
+    CHECK(pack.GetTotalBytes() < sizeBefore);
+    CHECK(pack.GetTotalBytes() == pack.GetLiveBytes());
+    CHECK(pack.GetCount() == 5);
+
+    for (int i = 15; i < 20; ++i)
+        CHECK(ReadThumbnail(pack, "thumb" + std::to_string(i) + ".jpg") == data);
+
+    SECTION("Compacted pack is the same after reopening")
+    {
+        ThumbnailPack reopened(TEST_PACK_FOLDER, 4096);
+
+        CHECK(reopened.GetCount() == 5);
+        CHECK(!reopened.Contains("thumb0.jpg"));
+        CHECK(ReadThumbnail(reopened, "thumb19.jpg") == data);
+    }
+
+    SECTION("Clear removes everything")
+    {
+        pack.Clear();
+
+        CHECK(pack.GetCount() == 0);
+        CHECK(pack.GetTotalBytes() == 0);
+
+        pack.Add("new.jpg", data.data(), data.size());
+
+        ThumbnailPack reopened(TEST_PACK_FOLDER, 4096);
+        CHECK(reopened.GetCount() == 1);
+    }
+}